@@ -0,0 +1,136 @@
+/*
+ * ButtonInput.cpp
+ * Implementation of interrupt-driven button capture
+ */
+
+#include "ButtonInput.h"
+#include <driver/gpio.h>
+
+ButtonInput::ButtonInput()
+    : buttonCount(0), pendingHead(0), pendingCount(0),
+      edgesSeen(0), bouncesIgnored(0), edgesReconciled(0), actionsDropped(0),
+      pressesHandled(0), lastLatencyUs(0), maxLatencyUs(0), totalLatencyUs(0) {
+    memset(buttons, 0, sizeof(buttons));
+}
+
+void ButtonInput::begin(const uint8_t* buttonPins, uint8_t count) {
+    buttonCount = count < BUTTON_COUNT ? count : BUTTON_COUNT;
+    uint32_t now = micros();
+    
+    for (uint8_t i = 0; i < buttonCount; i++) {
+        buttons[i].pin = buttonPins[i];
+        pinMode(buttons[i].pin, INPUT_PULLUP);
+        buttons[i].down = digitalRead(buttons[i].pin) == LOW;
+        buttons[i].longReported = buttons[i].down;  // Held at boot: not a gesture
+        buttons[i].changedUs = now;
+        buttons[i].pressUs = now;
+    }
+}
+
+void IRAM_ATTR ButtonInput::onEdgeISR(uint8_t pin) {
+    for (uint8_t i = 0; i < buttonCount; i++) {
+        if (buttons[i].pin != pin) continue;
+        
+        ButtonEdge edge;
+        edge.button = i;
+        edge.pressed = gpio_get_level((gpio_num_t)pin) == 0;
+        edge.timeUs = micros();
+        edges.push(edge);       // Counts a drop when full
+        return;
+    }
+}
+
+bool ButtonInput::poll(ButtonAction& action) {
+    ButtonEdge edge;
+    while (edges.pop(edge)) {
+        edgesSeen++;
+        applyEdge(edge.button, edge.pressed, edge.timeUs);
+    }
+    
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < buttonCount; i++) {
+        Button& btn = buttons[i];
+        
+        // Settled level disagrees with the edge history: a release without an
+        // edge (disarmed wake interrupt) or a final bounce inside the window
+        bool level = digitalRead(btn.pin) == LOW;
+        if (level != btn.down && now - btn.changedUs >= BUTTON_DEBOUNCE_MS * 1000UL) {
+            edgesReconciled++;
+            applyEdge(i, level, now);
+        }
+        
+        if (btn.down && !btn.longReported && now - btn.pressUs >= BUTTON_LONG_PRESS_MS * 1000UL) {
+            btn.longReported = true;
+            emit(i, GESTURE_LONG_PRESS, 0, btn.pressUs);
+        }
+    }
+    
+    if (pendingCount == 0) return false;
+    
+    action = pending[pendingHead];
+    pendingHead = (pendingHead + 1) % BUTTON_ACTION_QUEUE_SIZE;
+    pendingCount--;
+    
+    if (action.gesture == GESTURE_PRESS) {
+        uint32_t latency = micros() - action.timeUs;
+        pressesHandled++;
+        lastLatencyUs = latency;
+        totalLatencyUs += latency;
+        if (latency > maxLatencyUs) {
+            maxLatencyUs = latency;
+        }
+    }
+    return true;
+}
+
+void ButtonInput::applyEdge(uint8_t index, bool pressed, uint32_t timeUs) {
+    Button& btn = buttons[index];
+    if (pressed == btn.down) return;    // Repeat of the current state
+    
+    if (timeUs - btn.changedUs < BUTTON_DEBOUNCE_MS * 1000UL) {
+        bouncesIgnored++;
+        return;
+    }
+    
+    btn.down = pressed;
+    btn.changedUs = timeUs;
+    if (!pressed) return;
+    
+    btn.pressUs = timeUs;
+    btn.longReported = false;
+    emit(index, GESTURE_PRESS, 0, timeUs);
+    
+    // Chord: other buttons that went down just before this one
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < buttonCount; i++) {
+        if (i != index && buttons[i].down &&
+            timeUs - buttons[i].pressUs <= BUTTON_CHORD_WINDOW_MS * 1000UL) {
+            mask |= 1 << i;
+        }
+    }
+    if (mask != 0) {
+        emit(index, GESTURE_CHORD, mask | (1 << index), timeUs);
+    }
+}
+
+void ButtonInput::emit(uint8_t index, ButtonGesture gesture, uint8_t chordMask, uint32_t timeUs) {
+    if (pendingCount >= BUTTON_ACTION_QUEUE_SIZE) {
+        actionsDropped++;
+        return;
+    }
+    
+    ButtonAction& action = pending[(pendingHead + pendingCount) % BUTTON_ACTION_QUEUE_SIZE];
+    action.button = index;
+    action.gesture = gesture;
+    action.chordMask = chordMask;
+    action.timeUs = timeUs;
+    pendingCount++;
+}
+
+void ButtonInput::printStats() {
+    unsigned long avgLatency = pressesHandled > 0 ? (unsigned long)(totalLatencyUs / pressesHandled) : 0;
+    DEBUG_PRINTF("   Edges: %u captured, %u bounces, %u reconciled | Drops: %u edges, %u actions\n",
+                 edgesSeen, bouncesIgnored, edgesReconciled, edges.getDropped(), actionsDropped);
+    DEBUG_PRINTF("   Press->action: last %u us, avg %lu us, max %u us (%u presses)\n",
+                 lastLatencyUs, avgLatency, maxLatencyUs, pressesHandled);
+}
@@ -0,0 +1,86 @@
+/*
+ * ButtonInput.h
+ * Interrupt-driven button capture
+ *
+ * GPIO edge interrupts push (button, edge, micros) into an SPSC ring, so a
+ * press is recorded even when the loop is busy and presses on several
+ * buttons at once are all kept in order. poll() runs on the loop task and
+ * does the rest: debouncing against the edge timestamps, reconciling with
+ * the pin level (level-triggered wake interrupts disarm after the press, so
+ * releases may have no edge), long-press and chord detection.
+ */
+
+#ifndef BUTTON_INPUT_H
+#define BUTTON_INPUT_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "SPSCQueue.h"
+
+enum ButtonGesture : uint8_t {
+    GESTURE_PRESS,          // Debounced press, reported on the press edge
+    GESTURE_LONG_PRESS,     // Still held after BUTTON_LONG_PRESS_MS
+    GESTURE_CHORD           // Pressed within BUTTON_CHORD_WINDOW_MS of another held button
+};
+
+// Raw edge as captured by the ISR
+struct ButtonEdge {
+    uint8_t button;         // Index into the pin list
+    bool pressed;           // Pin level after the edge (active LOW)
+    uint32_t timeUs;
+};
+
+struct ButtonAction {
+    uint8_t button;
+    ButtonGesture gesture;
+    uint8_t chordMask;      // Bit per button held together (GESTURE_CHORD only)
+    uint32_t timeUs;        // Edge timestamp the action is derived from
+};
+
+class ButtonInput {
+public:
+    ButtonInput();
+    void begin(const uint8_t* buttonPins, uint8_t count);
+    
+    // Called from the GPIO ISR on either edge
+    void onEdgeISR(uint8_t pin);
+    
+    // Loop task: returns the next debounced action, false when there is none
+    bool poll(ButtonAction& action);
+    
+    // Diagnostics
+    void printStats();
+
+private:
+    struct Button {
+        uint8_t pin;
+        bool down;
+        bool longReported;
+        uint32_t changedUs;     // Last accepted press/release
+        uint32_t pressUs;
+    };
+    
+    Button buttons[BUTTON_COUNT];
+    uint8_t buttonCount;
+    SPSCQueue<ButtonEdge, BUTTON_EDGE_QUEUE_SIZE> edges;    // ISR -> loop
+    
+    // Actions decoded but not yet returned (loop task only)
+    ButtonAction pending[BUTTON_ACTION_QUEUE_SIZE];
+    uint8_t pendingHead;
+    uint8_t pendingCount;
+    
+    // Diagnostics
+    uint32_t edgesSeen;
+    uint32_t bouncesIgnored;
+    uint32_t edgesReconciled;   // State changes found by level, not by edge
+    uint32_t actionsDropped;
+    uint32_t pressesHandled;
+    uint32_t lastLatencyUs;     // Press edge -> action returned to the caller
+    uint32_t maxLatencyUs;
+    uint64_t totalLatencyUs;
+    
+    void applyEdge(uint8_t index, bool pressed, uint32_t timeUs);
+    void emit(uint8_t index, ButtonGesture gesture, uint8_t chordMask, uint32_t timeUs);
+};
+
+#endif // BUTTON_INPUT_H
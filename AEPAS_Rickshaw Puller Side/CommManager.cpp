@@ -5,14 +5,32 @@
 
 #include "CommManager.h"
 #include "mbedtls/md.h"
+#include <time.h>
+
+// publish() refuses any packet larger than the buffer, so a signed drop_confirm
+// (~570 bytes with the scoring inputs) must fit with the longest topic
+static_assert(MQTT_BUFFER_SIZE >= MQTT_MAX_HEADER_SIZE + 2 + INBOUND_TOPIC_MAX_LEN + CONFIRM_PAYLOAD_MAX_LEN,
+              "Journaled confirmations must fit the MQTT packet buffer");
+static_assert(sizeof(MQTT_TOPIC_PICKUP_CONF) <= INBOUND_TOPIC_MAX_LEN &&
+              sizeof(MQTT_TOPIC_DROP_CONF) <= INBOUND_TOPIC_MAX_LEN &&
+              sizeof(MQTT_TOPIC_RIDE_RESUME) <= INBOUND_TOPIC_MAX_LEN,
+              "Confirmation topics must fit INBOUND_TOPIC_MAX_LEN");
+static_assert(MQTT_BUFFER_SIZE <= 0xFFFF, "setBufferSize() takes a uint16_t");
 
 CommManager* CommManager::instance = nullptr;
 
 CommManager::CommManager() : 
     mqttClient(wifiClient),
+    inboundNotify(nullptr),
     lastReconnectAttempt(0),
     lastHeartbeat(0),
     retryDelay(OFFLINE_RETRY_INITIAL),
+    wifiLinkUp(false),
+    mqttLinkUp(false),
+    bufferedEvents(0),
+    pendingConfirms(0),
+    lastDeliveryMs(0),
+    maxDeliveryMs(0),
     queueHead(0),
     queueTail(0),
     queueSize(0) {
@@ -31,6 +49,21 @@ void CommManager::begin() {
     mqttClient.setServer(MQTT_BROKER, MQTT_PORT);
     mqttClient.setCallback(staticMqttCallback);
     mqttClient.setKeepAlive(MQTT_KEEPALIVE);
+    if (!mqttClient.setBufferSize(MQTT_BUFFER_SIZE)) {
+        DEBUG_PRINTLN(F("[COMM] ERROR: MQTT buffer allocation failed, large publishes will fail"));
+    }
+    
+    // Stable identity so the broker can resume our persistent session
+    clientId = generateClientId();
+    willTopic = String(MQTT_TOPIC_LWT_PREFIX) + DRIVER_ID + "/status";
+    ackTopic = String(MQTT_TOPIC_ACK_PREFIX) + DRIVER_ID + "/ack";
+    DEBUG_PRINTF("[COMM] MQTT client ID: %s\n", clientId.c_str());
+    
+    // Confirmations not acknowledged before a reset are resent once connected
+    confirmJournal.begin();
+    
+    subscribeToRideNotifications();
+    addSubscription(ackTopic.c_str(), MQTT_SUBSCRIBE_QOS);
     
     DEBUG_PRINTLN(F("[COMM] Communication Manager initialized"));
 }
@@ -55,7 +88,9 @@ bool CommManager::connectWiFi() {
         DEBUG_PRINTLN(F("\n[COMM] WiFi connected"));
         DEBUG_PRINT(F("[COMM] IP: "));
         DEBUG_PRINTLN(WiFi.localIP());
+        configTime(0, 0, NTP_SERVER);   // SNTP runs in the background from here on
         resetRetryDelay();
+        refreshLinkState();
         return true;
     } else {
         DEBUG_PRINTLN(F("\n[COMM] WiFi connection failed"));
@@ -78,19 +113,28 @@ bool CommManager::connectMQTT() {
     
     DEBUG_PRINTLN(F("[COMM] Connecting to MQTT broker..."));
     
-    String clientId = generateClientId();
-    bool connected = false;
+    const char* username = strlen(MQTT_USERNAME) > 0 ? MQTT_USERNAME : nullptr;
+    const char* password = strlen(MQTT_USERNAME) > 0 ? MQTT_PASSWORD : nullptr;
     
-    if (strlen(MQTT_USERNAME) > 0) {
-        connected = mqttClient.connect(clientId.c_str(), MQTT_USERNAME, MQTT_PASSWORD);
-    } else {
-        connected = mqttClient.connect(clientId.c_str());
-    }
+    // Retained offline LWT; cleanSession=false lets the broker queue QoS 1
+    // offers across reconnects (subscriptions are still redone every time)
+    bool connected = mqttClient.connect(clientId.c_str(), username, password,
+                                        willTopic.c_str(), 1, true, MQTT_LWT_OFFLINE,
+                                        MQTT_CLEAN_SESSION);
     
     if (connected) {
         DEBUG_PRINTLN(F("[COMM] MQTT connected"));
-        subscribeToRideNotifications();
+        bool resumed = session.getStats().connects > 0;
+        session.onConnected(millis());
+        if (resumed) {
+            DEBUG_PRINTF("[COMM] Reconnected after %lu ms offline\n", session.getStats().lastGapMs);
+        }
+        
+        mqttClient.publish(willTopic.c_str(), MQTT_LWT_ONLINE, true);
+        resubscribePending();
+        confirmJournal.markAllDue();
         resetRetryDelay();
+        refreshLinkState();
         return true;
     } else {
         DEBUG_PRINT(F("[COMM] MQTT connection failed, rc="));
@@ -104,6 +148,10 @@ bool CommManager::isMQTTConnected() {
 }
 
 void CommManager::disconnect() {
+    // Graceful disconnect suppresses the LWT, so announce offline explicitly
+    if (mqttClient.connected()) {
+        mqttClient.publish(willTopic.c_str(), MQTT_LWT_OFFLINE, true);
+    }
     mqttClient.disconnect();
     WiFi.disconnect();
     DEBUG_PRINTLN(F("[COMM] Disconnected"));
@@ -112,6 +160,14 @@ void CommManager::disconnect() {
 void CommManager::update() {
     unsigned long currentTime = millis();
     
+    if (session.isConnected() && !isMQTTConnected()) {
+        onConnectionLost();
+    }
+    refreshLinkState();
+    
+    // Publish requests from the FSM/UI task (buffered below if offline)
+    processOutbox();
+    
     // Handle WiFi reconnection
     if (!isWiFiConnected()) {
         if (currentTime - lastReconnectAttempt >= retryDelay) {
@@ -142,25 +198,175 @@ void CommManager::update() {
         // Process MQTT messages
         mqttClient.loop();
         
-        // Send heartbeat
+        // Send heartbeat; a SUBSCRIBE that failed after CONNECT is retried with it
         if (currentTime - lastHeartbeat >= HEARTBEAT_INTERVAL) {
             sendHeartbeat();
+            if (session.hasPending()) {
+                resubscribePending();
+            }
             lastHeartbeat = currentTime;
         }
         
         // Process offline queue
-        if (hasBufferedEvents()) {
+        if (queueSize > 0) {
             processOfflineQueue();
         }
+        
+        // Confirmations still waiting for an ack
+        resendConfirmations();
     }
 }
 
 String CommManager::generateClientId() {
-    String clientId = MQTT_CLIENT_PREFIX;
-    clientId += DEVICE_ID;
-    clientId += "_";
-    clientId += String(random(0xffff), HEX);
-    return clientId;
+    // Must be identical across reboots/reconnects or the broker starts a new session
+    uint64_t mac = ESP.getEfuseMac();
+    char suffix[9];
+    snprintf(suffix, sizeof(suffix), "%06lx", (unsigned long)((mac >> 24) & 0xFFFFFF));
+    
+    String id = MQTT_CLIENT_PREFIX;
+    id += DEVICE_ID;
+    id += "_";
+    id += suffix;
+    return id;
+}
+
+void CommManager::refreshLinkState() {
+    wifiLinkUp.store(isWiFiConnected(), std::memory_order_release);
+    mqttLinkUp.store(mqttClient.connected(), std::memory_order_release);
+    bufferedEvents.store(queueSize, std::memory_order_relaxed);
+    pendingConfirms.store(confirmJournal.getCount(), std::memory_order_relaxed);
+    sharedStats.store(session.getStats());
+}
+
+void CommManager::processOutbox() {
+    OutboundRequest request;
+    while (outbox.pop(request)) {
+        String rideId = request.rideId;
+        switch (request.type) {
+            case EVENT_ACCEPT:
+                publishAccept(rideId, request.lat, request.lon);
+                break;
+            case EVENT_REJECT:
+                publishReject(rideId, request.text);
+                break;
+            case EVENT_CANCEL:
+                publishCancel(rideId, request.text);
+                break;
+            case EVENT_PICKUP:
+                publishPickupConfirm(rideId, request.lat, request.lon);
+                break;
+            case EVENT_DROP:
+                publishDropConfirm(rideId, request.lat, request.lon, request.score);
+                break;
+            case EVENT_STATUS:
+                publishStatus(request.text, request.lat, request.lon);
+                break;
+            case EVENT_LOCATION:
+                publishLocation(request.lat, request.lon);
+                break;
+            case EVENT_RESUME:
+                publishResume(rideId, request.text, request.lat, request.lon);
+                break;
+        }
+    }
+}
+
+bool CommManager::postRequest(const OutboundRequest& request) {
+    if (!outbox.push(request)) {
+        DEBUG_PRINTLN(F("[COMM] Outbound queue full, request dropped"));
+        return false;
+    }
+    return true;
+}
+
+void CommManager::dispatchInbound() {
+    InboundMessage message;
+    while (inbox.pop(message)) {
+        if (messageCallback) {
+            messageCallback(message.topic, message.payload);
+        }
+        
+        // Only this task writes the latency pair, so load/store is enough
+        uint32_t latency = millis() - message.receivedAt;
+        lastDeliveryMs.store(latency, std::memory_order_relaxed);
+        if (latency > maxDeliveryMs.load(std::memory_order_relaxed)) {
+            maxDeliveryMs.store(latency, std::memory_order_relaxed);
+        }
+    }
+}
+
+void CommManager::setInboundNotify(InboundNotify notify) {
+    inboundNotify = notify;
+}
+
+bool CommManager::isWiFiLinkUp() const {
+    return wifiLinkUp.load(std::memory_order_acquire);
+}
+
+bool CommManager::isMQTTLinkUp() const {
+    return mqttLinkUp.load(std::memory_order_acquire);
+}
+
+uint32_t CommManager::getDroppedRequests() const {
+    return outbox.getDropped();
+}
+
+uint16_t CommManager::getPendingSyncCount() const {
+    return outbox.size() + bufferedEvents.load(std::memory_order_relaxed) +
+           pendingConfirms.load(std::memory_order_relaxed);
+}
+
+uint32_t CommManager::getDroppedMessages() const {
+    return inbox.getDropped();
+}
+
+bool CommManager::takeDropAck(DeliveryAck& ack) {
+    return dropAcks.pop(ack);
+}
+
+MqttSessionStats CommManager::getSessionStats() const {
+    return sharedStats.load();
+}
+
+uint32_t CommManager::getLastDeliveryMs() const {
+    return lastDeliveryMs.load(std::memory_order_relaxed);
+}
+
+uint32_t CommManager::getMaxDeliveryMs() const {
+    return maxDeliveryMs.load(std::memory_order_relaxed);
+}
+
+bool CommManager::hasBufferedEvents() const {
+    return bufferedEvents.load(std::memory_order_relaxed) > 0;
+}
+
+SharedSessionStats::SharedSessionStats()
+    : connects(0), disconnects(0), subscribeRequests(0), messagesReceived(0),
+      lastGapMs(0), longestGapMs(0) {}
+
+void SharedSessionStats::store(const MqttSessionStats& stats) {
+    connects.store(stats.connects, std::memory_order_relaxed);
+    disconnects.store(stats.disconnects, std::memory_order_relaxed);
+    subscribeRequests.store(stats.subscribeRequests, std::memory_order_relaxed);
+    messagesReceived.store(stats.messagesReceived, std::memory_order_relaxed);
+    lastGapMs.store(stats.lastGapMs, std::memory_order_relaxed);
+    longestGapMs.store(stats.longestGapMs, std::memory_order_relaxed);
+}
+
+MqttSessionStats SharedSessionStats::load() const {
+    MqttSessionStats stats;
+    stats.connects = connects.load(std::memory_order_relaxed);
+    stats.disconnects = disconnects.load(std::memory_order_relaxed);
+    stats.subscribeRequests = subscribeRequests.load(std::memory_order_relaxed);
+    stats.messagesReceived = messagesReceived.load(std::memory_order_relaxed);
+    stats.lastGapMs = lastGapMs.load(std::memory_order_relaxed);
+    stats.longestGapMs = longestGapMs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void CommManager::onConnectionLost() {
+    session.onDisconnected(millis());
+    DEBUG_PRINTLN(F("[COMM] MQTT connection lost"));
 }
 
 String CommManager::signMessage(const String& payload) {
@@ -208,6 +414,136 @@ String CommManager::createJsonPayload(const char* eventType, JsonDocument& doc)
     return signedPayload;
 }
 
+String CommManager::makeIdempotencyKey(const String& rideId, const char* eventType) {
+    // Deterministic per ride and event so the backend can drop redeliveries
+    return String(DEVICE_ID) + "/" + rideId + "/" + eventType;
+}
+
+bool CommManager::mustDeliver(EventType type) {
+    return type == EVENT_PICKUP || type == EVENT_DROP || type == EVENT_RESUME;
+}
+
+const char* CommManager::topicFor(EventType type) {
+    switch (type) {
+        case EVENT_ACCEPT:   return MQTT_TOPIC_RIDE_ACCEPT;
+        case EVENT_REJECT:   return MQTT_TOPIC_RIDE_REJECT;
+        case EVENT_CANCEL:   return MQTT_TOPIC_RIDE_CANCEL;
+        case EVENT_PICKUP:   return MQTT_TOPIC_PICKUP_CONF;
+        case EVENT_DROP:     return MQTT_TOPIC_DROP_CONF;
+        case EVENT_STATUS:   return MQTT_TOPIC_STATUS;
+        case EVENT_LOCATION: return MQTT_TOPIC_LOCATION;
+        case EVENT_RESUME:   return MQTT_TOPIC_RIDE_RESUME;
+    }
+    return nullptr;
+}
+
+bool CommManager::deliverConfirmation(EventType type, const String& key, const String& payload) {
+    // Journaled before the first attempt: publishes are QoS 0 and the device may
+    // reset, so only the backend's ack for the key retires it
+    if (confirmJournal.add(type, key, payload)) {
+        resendConfirmations();
+        return isMQTTConnected();
+    }
+    
+    // Journal unavailable or the write failed: RAM buffer, which never evicts confirmations
+    if (!publishMessage(topicFor(type), payload)) {
+        bufferEvent(type, payload);
+        return false;
+    }
+    return true;
+}
+
+void CommManager::resendConfirmations() {
+    if (confirmJournal.getCount() == 0 || !isMQTTConnected()) {
+        return;
+    }
+    
+    // Best-effort: records the backend never acked stop after their send/age limit
+    confirmJournal.retireStale((uint32_t)time(nullptr));
+    
+    unsigned long now = millis();
+    for (uint8_t slot = 0; slot < CONFIRM_JOURNAL_SIZE; slot++) {
+        const ConfirmRecord* record = confirmJournal.getRecord(slot);
+        if (record == nullptr || !confirmJournal.isDue(slot, now)) continue;
+        
+        if (publishMessage(topicFor((EventType)record->type), record->payload)) {
+            confirmJournal.markSent(slot, now);
+            if (record->type == EVENT_DROP) {
+                requestBrokerEcho(record->key);
+            }
+        }
+    }
+}
+
+void CommManager::handleAck(const char* payload) {
+    StaticJsonDocument<256> doc;
+    if (deserializeJson(doc, payload)) {
+        DEBUG_PRINTLN(F("[COMM] Malformed ack ignored"));
+        return;
+    }
+    
+    // Our own echo: the broker has everything published before it on this
+    // connection, drop included. That settles the ledger entry like a PUBACK
+    // would; the record stays journaled until the backend acks it.
+    const char* echo = doc["echo"];
+    DeliveryAck ack;
+    if (echo != nullptr) {
+        if (parseDropKey(echo, ack) && dropAcks.push(ack)) {
+            DEBUG_PRINTF("[COMM] Broker has drop for ride %s\n", ack.rideId);
+        }
+        return;
+    }
+    
+    const char* key = doc["idempotency_key"];
+    if (key == nullptr) {
+        DEBUG_PRINTLN(F("[COMM] Ack without idempotency key ignored"));
+        return;
+    }
+    
+    // A drop ack also settles the ledger entry; if the FSM core can't take it
+    // now, keep the record so the resend draws another ack
+    if (parseDropKey(key, ack) && !dropAcks.push(ack)) {
+        DEBUG_PRINTLN(F("[COMM] Ack queue full, waiting for the next ack"));
+        return;
+    }
+    
+    if (!confirmJournal.acknowledge(key)) {
+        DEBUG_PRINTF("[COMM] Ack for unknown key: %s\n", key);
+    }
+}
+
+void CommManager::requestBrokerEcho(const char* key) {
+    // PubSubClient publishes QoS 0 only, so there is no PUBACK to wait for.
+    // We subscribe to our ack topic; a probe published to it after the drop
+    // comes back only once the broker has processed the drop (one client's
+    // publishes are handled in order). Needs publish rights on the ack topic.
+    StaticJsonDocument<128> doc;
+    doc["echo"] = key;
+    String payload;
+    serializeJson(doc, payload);
+    mqttClient.publish(ackTopic.c_str(), payload.c_str(), false);
+}
+
+bool CommManager::parseDropKey(const char* key, DeliveryAck& ack) {
+    // Inverse of makeIdempotencyKey(rideId, "drop"): DEVICE_ID/rideId/drop
+    static const char suffix[] = "/drop";
+    size_t prefixLen = strlen(DEVICE_ID) + 1;
+    size_t suffixLen = sizeof(suffix) - 1;
+    size_t keyLen = strlen(key);
+    
+    if (keyLen <= prefixLen + suffixLen ||
+        strncmp(key, DEVICE_ID, prefixLen - 1) != 0 || key[prefixLen - 1] != '/' ||
+        strcmp(key + keyLen - suffixLen, suffix) != 0) {
+        return false;
+    }
+    
+    size_t idLen = keyLen - prefixLen - suffixLen;
+    if (idLen >= sizeof(ack.rideId)) return false;
+    memcpy(ack.rideId, key + prefixLen, idLen);
+    ack.rideId[idLen] = '\0';
+    return true;
+}
+
 bool CommManager::publishMessage(const char* topic, const String& payload) {
     if (!isMQTTConnected()) {
         DEBUG_PRINTLN(F("[COMM] MQTT not connected, buffering message"));
@@ -280,34 +616,53 @@ bool CommManager::publishPickupConfirm(const String& rideId, double lat, double
     doc["latitude"] = lat;
     doc["longitude"] = lon;
     doc["status"] = "pickup_confirmed";
+    String key = makeIdempotencyKey(rideId, "pickup");
+    doc["idempotency_key"] = key;
     
     String payload = createJsonPayload("pickup_confirm", doc);
     
-    if (!publishMessage(MQTT_TOPIC_PICKUP_CONF, payload)) {
-        bufferEvent(EVENT_PICKUP, payload);
-        return false;
-    }
-    
-    return true;
+    return deliverConfirmation(EVENT_PICKUP, key, payload);
 }
 
-bool CommManager::publishDropConfirm(const String& rideId, double lat, double lon, float points, bool needsReview) {
-    StaticJsonDocument<512> doc;
+bool CommManager::publishDropConfirm(const String& rideId, double lat, double lon, const DropScore& score) {
+    bool needsReview = score.review != 0;
+    StaticJsonDocument<768> doc;
     doc["ride_id"] = rideId;
     doc["latitude"] = lat;
     doc["longitude"] = lon;
-    doc["points_awarded"] = points;
+    doc["points_awarded"] = score.centiPoints / 100.0f;
     doc["needs_review"] = needsReview;
     doc["status"] = needsReview ? "pending_review" : "completed";
+    String key = makeIdempotencyKey(rideId, "drop");
+    doc["idempotency_key"] = key;
+    
+    // Exact formula inputs, so the award can be re-scored and audited offline
+    JsonObject scoring = doc.createNestedObject("scoring");
+    scoring["expected_latitude"] = score.expectedLat;
+    scoring["expected_longitude"] = score.expectedLon;
+    scoring["drop_error_cm"] = score.dropErrorCm;
+    scoring["accuracy_centi"] = score.accuracyCenti;
+    scoring["centi_points"] = score.centiPoints;
+    scoring["review"] = score.review;
     
     String payload = createJsonPayload("drop_confirm", doc);
     
-    if (!publishMessage(MQTT_TOPIC_DROP_CONF, payload)) {
-        bufferEvent(EVENT_DROP, payload);
-        return false;
-    }
+    return deliverConfirmation(EVENT_DROP, key, payload);
+}
+
+bool CommManager::publishResume(const String& rideId, const String& state, double lat, double lon) {
+    StaticJsonDocument<512> doc;
+    doc["ride_id"] = rideId;
+    doc["state"] = state;
+    doc["latitude"] = lat;
+    doc["longitude"] = lon;
+    doc["status"] = "resumed";
+    String key = makeIdempotencyKey(rideId, "resume");
+    doc["idempotency_key"] = key;
     
-    return true;
+    String payload = createJsonPayload("ride_resume", doc);
+    
+    return deliverConfirmation(EVENT_RESUME, key, payload);
 }
 
 bool CommManager::publishStatus(const String& state, double lat, double lon) {
@@ -337,11 +692,35 @@ void CommManager::setMessageCallback(MessageCallback callback) {
 }
 
 void CommManager::subscribeToRideNotifications() {
-    if (mqttClient.subscribe(MQTT_TOPIC_RIDE_NOTIFY)) {
-        DEBUG_PRINTF("[COMM] Subscribed to: %s\n", MQTT_TOPIC_RIDE_NOTIFY);
-    } else {
-        DEBUG_PRINTF("[COMM] Failed to subscribe to: %s\n", MQTT_TOPIC_RIDE_NOTIFY);
+    addSubscription(MQTT_TOPIC_RIDE_NOTIFY, MQTT_SUBSCRIBE_QOS);
+}
+
+bool CommManager::addSubscription(const char* topic, uint8_t qos) {
+    if (!session.add(topic, qos)) {
+        DEBUG_PRINTF("[COMM] Subscription table full, cannot add: %s\n", topic);
+        return false;
     }
+    
+    if (isMQTTConnected()) {
+        resubscribePending();
+    }
+    return true;
+}
+
+void CommManager::resubscribePending() {
+    // Every CONNECT starts with all topics pending (see MqttSession.h)
+    session.subscribePending([this](const char* topic, uint8_t qos) {
+        if (mqttClient.subscribe(topic, qos)) {
+            DEBUG_PRINTF("[COMM] Subscribed to: %s (QoS %d)\n", topic, qos);
+            return true;
+        }
+        DEBUG_PRINTF("[COMM] Failed to subscribe to: %s\n", topic);
+        return false;
+    });
+}
+
+const String& CommManager::getClientId() const {
+    return clientId;
 }
 
 void CommManager::staticMqttCallback(char* topic, byte* payload, unsigned int length) {
@@ -357,17 +736,51 @@ void CommManager::mqttCallback(char* topic, byte* payload, unsigned int length)
     message[length] = '\0';
     
     DEBUG_PRINTF("[COMM] Message received [%s]: %s\n", topic, message);
+    session.onMessage();
     
-    if (messageCallback) {
-        messageCallback(topic, message);
+    // Delivery acks are consumed here on the network task
+    if (strcmp(topic, ackTopic.c_str()) == 0) {
+        handleAck(message);
+        return;
+    }
+    
+    if (length >= INBOUND_PAYLOAD_MAX_LEN) {
+        DEBUG_PRINTLN(F("[COMM] Message too large, dropped"));
+        return;
+    }
+    
+    // Hand off to the FSM/UI task; messageCallback runs there in dispatchInbound()
+    InboundMessage inbound;
+    strlcpy(inbound.topic, topic, sizeof(inbound.topic));
+    memcpy(inbound.payload, message, length + 1);
+    inbound.receivedAt = millis();
+    if (!inbox.push(inbound)) {
+        DEBUG_PRINTLN(F("[COMM] Inbound queue full, message dropped"));
+        return;
+    }
+    
+    if (inboundNotify) {
+        inboundNotify();
     }
 }
 
 void CommManager::bufferEvent(EventType type, const String& payload) {
     if (queueSize >= EVENT_QUEUE_MAX) {
+        // Drop the oldest event that may be lost; confirmations are never evicted
+        uint8_t victim = 0;
+        while (victim < queueSize && mustDeliver(eventQueue[(queueHead + victim) % EVENT_QUEUE_MAX].type)) {
+            victim++;
+        }
+        if (victim == queueSize) {
+            DEBUG_PRINTLN(F("[COMM] ERROR: Event queue full of confirmations, event dropped"));
+            return;
+        }
+        
         DEBUG_PRINTLN(F("[COMM] Event queue full, dropping oldest event"));
-        // Drop oldest event
-        queueHead = (queueHead + 1) % EVENT_QUEUE_MAX;
+        for (uint8_t i = victim; i + 1 < queueSize; i++) {
+            eventQueue[(queueHead + i) % EVENT_QUEUE_MAX] = eventQueue[(queueHead + i + 1) % EVENT_QUEUE_MAX];
+        }
+        queueTail = (queueTail + EVENT_QUEUE_MAX - 1) % EVENT_QUEUE_MAX;
         queueSize--;
     }
     
@@ -404,40 +817,23 @@ void CommManager::processOfflineQueue() {
         // Failed - increment retry count
         event.retryCount++;
         if (event.retryCount > 5) {
-            // Give up after 5 retries
-            DEBUG_PRINTLN(F("[COMM] Max retries reached, dropping event"));
             queueHead = (queueHead + 1) % EVENT_QUEUE_MAX;
             queueSize--;
+            
+            if (mustDeliver(event.type)) {
+                // Already committed on the device; rotate so it can't block the queue
+                DEBUG_PRINTLN(F("[COMM] Max retries reached, requeueing confirmation"));
+                addToQueue(event.type, event.payload);
+            } else {
+                // Give up after 5 retries
+                DEBUG_PRINTLN(F("[COMM] Max retries reached, dropping event"));
+            }
         }
     }
 }
 
 bool CommManager::sendQueuedEvent(BufferedEvent& event) {
-    const char* topic = nullptr;
-    
-    switch (event.type) {
-        case EVENT_ACCEPT:
-            topic = MQTT_TOPIC_RIDE_ACCEPT;
-            break;
-        case EVENT_REJECT:
-            topic = MQTT_TOPIC_RIDE_REJECT;
-            break;
-        case EVENT_CANCEL:
-            topic = MQTT_TOPIC_RIDE_CANCEL;
-            break;
-        case EVENT_PICKUP:
-            topic = MQTT_TOPIC_PICKUP_CONF;
-            break;
-        case EVENT_DROP:
-            topic = MQTT_TOPIC_DROP_CONF;
-            break;
-        case EVENT_STATUS:
-            topic = MQTT_TOPIC_STATUS;
-            break;
-        case EVENT_LOCATION:
-            topic = MQTT_TOPIC_LOCATION;
-            break;
-    }
+    const char* topic = topicFor(event.type);
     
     if (topic) {
         return publishMessage(topic, event.payload);
@@ -446,10 +842,6 @@ bool CommManager::sendQueuedEvent(BufferedEvent& event) {
     return false;
 }
 
-bool CommManager::hasBufferedEvents() const {
-    return queueSize > 0;
-}
-
 void CommManager::sendHeartbeat() {
     DEBUG_PRINTLN(F("[COMM] Sending heartbeat"));
     // Heartbeat will be sent with GPS location in main loop
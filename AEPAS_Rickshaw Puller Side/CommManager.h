@@ -12,6 +12,9 @@
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include "Config.h"
+#include "SPSCQueue.h"
+#include "ConfirmJournal.h"
+#include "MqttSession.h"
 
 // Event types for offline buffering
 enum EventType {
@@ -21,7 +24,8 @@ enum EventType {
     EVENT_PICKUP,
     EVENT_DROP,
     EVENT_STATUS,
-    EVENT_LOCATION
+    EVENT_LOCATION,
+    EVENT_RESUME
 };
 
 struct BufferedEvent {
@@ -31,8 +35,59 @@ struct BufferedEvent {
     uint8_t retryCount;
 };
 
+// MqttSessionStats mirrored for the FSM/UI task. Only the network task
+// stores (refreshLinkState), so every field reads whole; fields can be one
+// refresh apart, which is fine for the status print.
+struct SharedSessionStats {
+    std::atomic<uint32_t> connects;
+    std::atomic<uint32_t> disconnects;
+    std::atomic<uint32_t> subscribeRequests;
+    std::atomic<uint32_t> messagesReceived;
+    std::atomic<uint32_t> lastGapMs;
+    std::atomic<uint32_t> longestGapMs;
+    
+    SharedSessionStats();
+    void store(const MqttSessionStats& stats);
+    MqttSessionStats load() const;
+};
+
+// Points formula inputs and result for a drop. Sent with drop_confirm so a
+// verifier can re-score the ride with PointsFormula without the device.
+struct DropScore {
+    int32_t centiPoints;
+    int32_t dropErrorCm;        // Quantized drop error fed to the formula
+    int32_t accuracyCenti;      // Quantized GPS accuracy (HDOP x 100)
+    uint8_t review;             // PointsFormula::Review
+    double expectedLat;         // Expected drop point the error was measured from
+    double expectedLon;
+};
+
+// Publish request handed from the FSM/UI task to the network task
+struct OutboundRequest {
+    EventType type;
+    char rideId[RIDE_ID_MAX_LEN];
+    char text[32];          // Reject/cancel reason or FSM state name
+    double lat;
+    double lon;
+    DropScore score;        // EVENT_DROP only
+};
+
+// MQTT message handed from the network task to the FSM/UI task
+struct InboundMessage {
+    char topic[INBOUND_TOPIC_MAX_LEN];
+    char payload[INBOUND_PAYLOAD_MAX_LEN];
+    unsigned long receivedAt;
+};
+
+// Drop confirmation acknowledged by the backend or echoed back by the broker,
+// handed to the FSM/UI task
+struct DeliveryAck {
+    char rideId[RIDE_ID_MAX_LEN];
+};
+
 // Callback function types
 typedef std::function<void(const char* topic, const char* payload)> MessageCallback;
+typedef void (*InboundNotify)();  // Runs on the network task after a message is queued
 
 class CommManager {
 public:
@@ -52,18 +107,37 @@ public:
     bool publishReject(const String& rideId, const String& reason);
     bool publishCancel(const String& rideId, const String& reason);
     bool publishPickupConfirm(const String& rideId, double lat, double lon);
-    bool publishDropConfirm(const String& rideId, double lat, double lon, float points, bool needsReview);
+    bool publishDropConfirm(const String& rideId, double lat, double lon, const DropScore& score);
+    bool publishResume(const String& rideId, const String& state, double lat, double lon);
     bool publishStatus(const String& state, double lat, double lon);
     bool publishLocation(double lat, double lon);
     
     // Subscribe and message handling
     void setMessageCallback(MessageCallback callback);
     void subscribeToRideNotifications();
+    bool addSubscription(const char* topic, uint8_t qos);
+    
+    // Cross-core interface (FSM/UI task side; everything else runs on the network task)
+    bool postRequest(const OutboundRequest& request);
+    void dispatchInbound();
+    void setInboundNotify(InboundNotify notify);
+    bool isWiFiLinkUp() const;
+    bool isMQTTLinkUp() const;
+    uint32_t getDroppedRequests() const;
+    uint16_t getPendingSyncCount() const;   // Queued/buffered publishes + unacked confirmations
+    uint32_t getDroppedMessages() const;
+    bool takeDropAck(DeliveryAck& ack);
+    MqttSessionStats getSessionStats() const;
+    uint32_t getLastDeliveryMs() const;     // Message received -> callback returned (offer on screen)
+    uint32_t getMaxDeliveryMs() const;
+    bool hasBufferedEvents() const;
+    
+    // Session info
+    const String& getClientId() const;
     
     // Offline handling
     void bufferEvent(EventType type, const String& payload);
     void processOfflineQueue();
-    bool hasBufferedEvents() const;
     
     // Heartbeat
     void sendHeartbeat();
@@ -77,10 +151,32 @@ private:
     HTTPClient httpClient;
     
     MessageCallback messageCallback;
+    InboundNotify inboundNotify;
     unsigned long lastReconnectAttempt;
     unsigned long lastHeartbeat;
     unsigned long retryDelay;
     
+    // Persistent session state
+    String clientId;
+    String willTopic;
+    String ackTopic;
+    MqttSession session;
+    
+    // Cross-core queues and cached link state
+    SPSCQueue<OutboundRequest, OUTBOUND_QUEUE_SIZE> outbox;
+    SPSCQueue<InboundMessage, INBOUND_QUEUE_SIZE> inbox;
+    SPSCQueue<DeliveryAck, ACK_QUEUE_SIZE> dropAcks;
+    std::atomic<bool> wifiLinkUp;
+    std::atomic<bool> mqttLinkUp;
+    std::atomic<uint8_t> bufferedEvents;    // Snapshot of queueSize for core 1
+    std::atomic<uint8_t> pendingConfirms;   // Snapshot of the journal count for core 1
+    SharedSessionStats sharedStats;         // Snapshot of session.getStats() for core 1
+    std::atomic<uint32_t> lastDeliveryMs;   // Written by dispatchInbound() on core 1 only
+    std::atomic<uint32_t> maxDeliveryMs;
+    
+    // Pickup/drop/resume confirmations, persisted until the backend acks them
+    ConfirmJournal confirmJournal;
+    
     // Offline event queue
     BufferedEvent eventQueue[EVENT_QUEUE_MAX];
     uint8_t queueHead;
@@ -89,8 +185,20 @@ private:
     
     // Helper methods
     String generateClientId();
+    void resubscribePending();
+    void onConnectionLost();
+    void refreshLinkState();
+    void processOutbox();
     String signMessage(const String& payload);
     String createJsonPayload(const char* eventType, JsonDocument& doc);
+    String makeIdempotencyKey(const String& rideId, const char* eventType);
+    static bool mustDeliver(EventType type);
+    static const char* topicFor(EventType type);
+    bool deliverConfirmation(EventType type, const String& key, const String& payload);
+    void resendConfirmations();
+    void handleAck(const char* payload);
+    void requestBrokerEcho(const char* key);
+    static bool parseDropKey(const char* key, DeliveryAck& ack);
     bool publishMessage(const char* topic, const String& payload);
     void mqttCallback(char* topic, byte* payload, unsigned int length);
     static void staticMqttCallback(char* topic, byte* payload, unsigned int length);
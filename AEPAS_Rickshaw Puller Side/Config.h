@@ -24,6 +24,13 @@
 #define OLED_SCREEN_WIDTH       128
 #define OLED_SCREEN_HEIGHT      64
 #define OLED_I2C_ADDRESS        0x3C  // Common I2C address (try 0x3D if 0x3C fails)
+#define OLED_PAGE_COUNT         (OLED_SCREEN_HEIGHT / 8)   // 8-pixel rows per controller page
+#define OLED_I2C_CHUNK          64    // Data bytes per I2C transaction (Wire buffer is 128)
+#define SCREEN_MAX_FIELDS       4     // Dynamic field slots per retained screen layout
+#define DISPLAY_I2C_CLOCK_HZ    400000 // SSD1306 fast mode; many panels also run at 1 MHz
+#define DISPLAY_TASK_CORE       0     // Flush alongside the network task, off the UI core
+#define DISPLAY_TASK_STACK_SIZE 2048
+#define DISPLAY_TASK_PRIORITY   1
 
 // Physical Buttons (Active LOW with internal pull-up)
 #define BTN_ACCEPT_PIN          25    // Accept ride button
@@ -51,6 +58,7 @@
 #define WIFI_PASSWORD           "@2302122@"
 #define WIFI_TIMEOUT_MS         20000
 #define WIFI_RECONNECT_INTERVAL 30000
+#define NTP_SERVER              "pool.ntp.org"  // Wall clock for ledger and ride history timestamps
 
 // MQTT Configuration
 #define MQTT_BROKER             "broker.hivemq.com"  // Replace with your broker
@@ -60,6 +68,8 @@
 #define MQTT_PASSWORD           ""
 #define MQTT_CLIENT_PREFIX      "AERAS_RU_"
 #define MQTT_KEEPALIVE          60
+#define MQTT_CLEAN_SESSION      false // Persistent session: broker queues QoS 1 offers while we are offline
+#define MQTT_SUBSCRIBE_QOS      1     // QoS for ride notification subscriptions
 
 // MQTT Topics
 #define MQTT_TOPIC_RIDE_NOTIFY  "aeras/ride/notify"         // Subscribe: Incoming ride requests
@@ -68,8 +78,13 @@
 #define MQTT_TOPIC_RIDE_CANCEL  "aeras/ride/cancel"         // Publish: Driver cancellation
 #define MQTT_TOPIC_PICKUP_CONF  "aeras/ride/pickup"         // Publish: Pickup confirmation
 #define MQTT_TOPIC_DROP_CONF    "aeras/ride/drop"           // Publish: Drop confirmation
+#define MQTT_TOPIC_RIDE_RESUME  "aeras/ride/resume"         // Publish: Ride resumed after reset
 #define MQTT_TOPIC_STATUS       "aeras/device/status"       // Publish: Heartbeat/status
 #define MQTT_TOPIC_LOCATION     "aeras/device/location"     // Publish: GPS location
+#define MQTT_TOPIC_LWT_PREFIX   "aeras/driver/"             // Last Will: aeras/driver/{driverId}/status
+#define MQTT_TOPIC_ACK_PREFIX   "aeras/driver/"             // Subscribe: aeras/driver/{driverId}/ack (idempotency keys)
+#define MQTT_LWT_OFFLINE        "{\"status\":\"offline\"}"
+#define MQTT_LWT_ONLINE         "{\"status\":\"online\"}"
 
 // HTTP Fallback (if MQTT fails)
 #define HTTP_ENABLED            true
@@ -96,11 +111,56 @@
 #define HEARTBEAT_INTERVAL      30000   // 30 seconds
 #define GPS_UPDATE_INTERVAL     3000    // 3 seconds
 #define BUTTON_DEBOUNCE_MS      50      // Button debounce time
+#define BUTTON_LONG_PRESS_MS    1000    // Hold time reported as a long press
+#define BUTTON_CHORD_WINDOW_MS  150     // Presses this close together form a chord
 #define RIDE_TIMEOUT_MS         300000  // 5 minutes to accept ride
 #define ACCEPT_TIMEOUT_MS       30000   // 30 seconds to accept ride
+#define NEXT_RIDE_ENABLED       true    // Allow lining up the next ride before drop
 #define OFFLINE_RETRY_INITIAL   1000    // Initial retry delay
 #define OFFLINE_RETRY_MAX       60000   // Max retry delay (exponential backoff)
 #define EVENT_QUEUE_MAX         50      // Max buffered events
+#define FSM_EVENT_QUEUE_SIZE    8       // Max pending FSM events (button/GPS/network)
+#define PATTERN_MAX_STEPS       16      // Max on/off steps in one LED/buzzer sequence
+#define BUTTON_COUNT            4
+#define BUTTON_EDGE_QUEUE_SIZE  32      // Raw edges ISR -> loop (power of two)
+#define BUTTON_ACTION_QUEUE_SIZE 8      // Decoded presses/gestures awaiting readButtons()
+
+// Cooperative scheduler (loop() task periods)
+#define SCHEDULER_MAX_TASKS     12      // Max registered periodic/one-shot tasks
+#define SCHEDULER_MAX_SLEEP_MS  1000    // Upper bound on a single idle sleep
+#define COMM_UPDATE_INTERVAL    100     // MQTT loop / reconnect handling
+#define FSM_UPDATE_INTERVAL     100     // State machine refresh/timeouts
+#define UI_UPDATE_INTERVAL      200     // UI housekeeping (LED/buzzer run from PatternSequencer)
+#define BUTTON_POLL_INTERVAL    20      // Fallback poll; edges wake the loop immediately
+#define STATUS_PRINT_INTERVAL   10000   // Serial runtime report
+#define INBOUND_POLL_INTERVAL   100     // Fallback poll of the inbound message queue
+
+// Dual-core split: GPS ingest + network I/O on core 0, FSM/UI on core 1 (loop)
+#define NET_TASK_CORE           0
+#define NET_TASK_STACK_SIZE     8192
+#define NET_TASK_PRIORITY       1
+#define INBOUND_QUEUE_SIZE      4       // MQTT messages core 0 -> core 1 (power of two)
+#define OUTBOUND_QUEUE_SIZE     8       // Publish requests core 1 -> core 0 (power of two)
+#define ACK_QUEUE_SIZE          4       // Drop acks/broker echoes core 0 -> core 1 (power of two)
+#define GPS_FIX_QUEUE_SIZE      4       // GPS fixes core 0 -> core 1 (power of two)
+#define INBOUND_TOPIC_MAX_LEN   64
+#define INBOUND_PAYLOAD_MAX_LEN 256     // Larger offers are dropped before the hand-off
+// PubSubClient packet buffer (default 256): the largest publish is a journaled
+// confirmation; header (5) + topic length (2) + topic + payload
+#define MQTT_BUFFER_SIZE        (5 + 2 + INBOUND_TOPIC_MAX_LEN + CONFIRM_PAYLOAD_MAX_LEN)
+#define RIDE_ID_MAX_LEN         40
+
+// Idle power mode (automatic light sleep + WiFi modem sleep + GPS power save)
+#define POWER_SAVE_ENABLED      true
+#define POWER_IDLE_ENTER_MS     30000   // Time in STATE_IDLE before power saving starts
+#define POWER_UPDATE_INTERVAL   250     // Power mode evaluation period
+#define POWER_CPU_MAX_MHZ       240
+#define POWER_CPU_MIN_MHZ       80      // Lowest APB-safe frequency between sleeps
+#define IDLE_UI_UPDATE_INTERVAL 1000    // Nothing time-critical left in the UI task while idle
+#define IDLE_BUTTON_POLL_INTERVAL 200   // Presses wake the CPU via GPIO anyway
+#define IDLE_LOCATION_SAVE_M    50.0    // Only rewrite last location to flash after moving this far
+#define BUTTON_WAKE_BUDGET_MS   100     // Budget: button press -> handled while idle
+#define OFFER_LATENCY_BUDGET_MS 1000    // Budget: offer received -> ride screen drawn (DTIM wake not included)
 
 // ============================================================================
 // GPS CONFIGURATION
@@ -117,6 +177,7 @@
 #define DISTANCE_PICKUP_MAX     50.0    // Max distance for pickup confirmation
 #define DISTANCE_DROP_AUTO      50.0    // Auto-confirm drop within 50m
 #define DISTANCE_ADMIN_REVIEW   100.0   // Distance error threshold for admin review
+#define DISTANCE_NEXT_RIDE      500.0   // Offer the next ride within this distance of the drop
 
 // ============================================================================
 // POINTS CALCULATION
@@ -126,6 +187,12 @@
 #define POINTS_DIST_DIVISOR     10.0    // Distance penalty divisor (per 10m)
 #define POINTS_MIN              0.0     // Minimum points (can't go negative)
 
+// Trip odometer (PointsManager)
+#define TRIP_SMOOTHING          0.5     // Weight of a new fix in the position filter
+#define TRIP_MIN_STEP_M         5.0     // Jitter radius floor; smaller moves are not counted
+#define TRIP_HDOP_STEP_M        4.0     // Jitter radius per unit of HDOP
+#define TRIP_MAX_SPEED_MPS      15.0    // Faster implied motion is a GPS jump
+
 // ============================================================================
 // DEMO COORDINATES (CUET Area)
 // ============================================================================
@@ -156,6 +223,37 @@ const int DEMO_LOCATIONS_COUNT = sizeof(DEMO_LOCATIONS) / sizeof(DEMO_LOCATIONS[
 #define NVS_KEY_LAST_LAT        "last_lat"
 #define NVS_KEY_LAST_LON        "last_lon"
 #define NVS_KEY_DEVICE_ID       "device_id"
+#define NVS_KEY_RIDE_SLOT_A     "ride_a"    // Active ride checkpoint, slot A
+#define NVS_KEY_RIDE_SLOT_B     "ride_b"    // Active ride checkpoint, slot B
+#define NVS_LEDGER_NAMESPACE    "ledger"    // Points journal (PointsLedger)
+#define NVS_KEY_LEDGER_CKPT_A   "ckpt_a"    // Ledger total checkpoint, slot A
+#define NVS_KEY_LEDGER_CKPT_B   "ckpt_b"    // Ledger total checkpoint, slot B
+#define NVS_KEY_LEDGER_SYNC     "sync"      // Last entry confirmed to the backend
+#define LEDGER_CAPACITY         64          // Entries retained in the NVS ring
+#define LEDGER_CHECKPOINT_INTERVAL 16       // Entries between total checkpoints
+#define LEDGER_INDEX_SIZE       128         // Ride lookup hash table (power of two)
+#define NVS_CONFIRM_NAMESPACE   "confirm"   // Unacknowledged confirmations (ConfirmJournal)
+#define CONFIRM_JOURNAL_SIZE    4           // Pickup/drop/resume records held until acked
+#define CONFIRM_KEY_MAX_LEN     80          // Idempotency key incl. terminator
+#define CONFIRM_PAYLOAD_MAX_LEN 768         // Signed message incl. terminator
+#define CONFIRM_RESEND_MS       15000       // Resend interval while no ack has arrived
+#define CONFIRM_MAX_SENDS       8           // Sends per record and boot before giving up
+#define CONFIRM_MAX_AGE_S       86400       // Records older than this are given up (clock set)
+
+// Ride history log on the "ridelog" flash partition (partitions.csv)
+#define RIDE_HISTORY_PARTITION  "ridelog"
+#define RIDE_HISTORY_MAGIC      0x52484C31  // "RHL1"; bump with the RideRecord layout
+#define RIDE_HISTORY_MAX_SECTORS 16         // 64 KB partition
+#define RIDE_HISTORY_RECORD_SIZE 64
+#define RIDE_HISTORY_RECORDS_PER_SECTOR 63  // Slot 0 of each sector is the header
+#define CLOCK_VALID_AFTER       1577836800UL // 2020-01-01; earlier means SNTP has not set the clock
+#define RIDE_CHECKPOINT_VERSION 1           // Bump when RideCheckpoint layout changes
+#define RIDE_ADDRESS_MAX_LEN    48          // Addresses are truncated in the checkpoint
+
+// Write-back cache in front of NVS (LocalStore)
+#define STORE_UPDATE_INTERVAL   1000        // Commit policy check period
+#define STORE_COMMIT_INTERVAL_MS 300000     // Max age of an uncommitted location
+#define STORE_COMMIT_MAX_PENDING 20         // Commit after this many buffered changes
 
 // ============================================================================
 // DEBUGGING
@@ -163,6 +261,7 @@ const int DEMO_LOCATIONS_COUNT = sizeof(DEMO_LOCATIONS) / sizeof(DEMO_LOCATIONS[
 
 #define DEBUG_SERIAL            true
 #define SERIAL_BAUD_RATE        115200
+#define DISPLAY_SNAPSHOTS       false       // Dump each new screen as a PBM frame over serial
 
 // Debug macros
 #if DEBUG_SERIAL
@@ -188,7 +287,8 @@ enum SystemState {
     STATE_RIDE_ACTIVE,          // Ride in progress (passenger onboard)
     STATE_ENROUTE_TO_DROP,      // Traveling to drop location
     STATE_COMPLETED,            // Ride completed, processing points
-    STATE_OFFLINE_ERROR         // Network error, attempting reconnection
+    STATE_OFFLINE_ERROR,        // Network error, attempting reconnection
+    STATE_COUNT                 // Number of states (FSM table dimension)
 };
 
 // Convert state to string for debugging
@@ -0,0 +1,182 @@
+/*
+ * ConfirmJournal.cpp
+ * Implementation of the persistent confirmation store
+ */
+
+#include "ConfirmJournal.h"
+#include <esp32/rom/crc.h>
+#include <time.h>
+
+static_assert(CONFIRM_MAX_SENDS <= 0xFF, "Send counts are kept in a byte");
+
+ConfirmJournal::ConfirmJournal() : initialized(false), count(0), nextSequence(1), flashWrites(0) {
+    memset(records, 0, sizeof(records));
+    memset(lastSent, 0, sizeof(lastSent));
+    memset(sentOnce, 0, sizeof(sentOnce));
+    memset(sends, 0, sizeof(sends));
+}
+
+bool ConfirmJournal::begin() {
+    if (!prefs.begin(NVS_CONFIRM_NAMESPACE, false)) {
+        DEBUG_PRINTLN(F("[CONFIRM] ERROR: Failed to open NVS namespace"));
+        return false;
+    }
+    initialized = true;
+    
+    // Reload confirmations still waiting for an ack; torn records are dropped
+    char key[8];
+    for (uint8_t slot = 0; slot < CONFIRM_JOURNAL_SIZE; slot++) {
+        slotKey(slot, key);
+        ConfirmRecord& record = records[slot];
+        if (prefs.getBytesLength(key) != sizeof(record) ||
+            prefs.getBytes(key, &record, sizeof(record)) != sizeof(record) ||
+            record.crc != recordCrc(record) || record.key[0] == '\0') {
+            memset(&record, 0, sizeof(record));
+            continue;
+        }
+        count++;
+        if ((int32_t)(record.sequence - nextSequence) >= 0) {
+            nextSequence = record.sequence + 1;
+        }
+        DEBUG_PRINTF("[CONFIRM] Pending from before reset: %s\n", record.key);
+    }
+    
+    return true;
+}
+
+bool ConfirmJournal::add(uint8_t type, const String& key, const String& payload) {
+    if (!initialized) return false;
+    
+    if (key.length() >= CONFIRM_KEY_MAX_LEN || payload.length() >= CONFIRM_PAYLOAD_MAX_LEN) {
+        DEBUG_PRINTF("[CONFIRM] Message too long to journal: %s\n", key.c_str());
+        return false;
+    }
+    
+    int8_t slot = findSlot(key.c_str());
+    if (slot < 0) {
+        slot = findSlot("");
+        if (slot < 0) {
+            // Full: the newest confirmation is worth more than the oldest one
+            slot = findOldest();
+            DEBUG_PRINTF("[CONFIRM] Journal full, giving up on %s\n", records[slot].key);
+        } else {
+            count++;
+        }
+    }
+    
+    time_t now = time(nullptr);
+    ConfirmRecord& record = records[slot];
+    memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.sequence = nextSequence++;
+    record.createdAt = now > (time_t)CLOCK_VALID_AFTER ? (uint32_t)now : 0;
+    strlcpy(record.key, key.c_str(), sizeof(record.key));
+    strlcpy(record.payload, payload.c_str(), sizeof(record.payload));
+    record.crc = recordCrc(record);
+    sentOnce[slot] = false;
+    sends[slot] = 0;
+    
+    char nvsKey[8];
+    slotKey(slot, nvsKey);
+    flashWrites++;
+    if (prefs.putBytes(nvsKey, &record, sizeof(record)) != sizeof(record)) {
+        DEBUG_PRINTLN(F("[CONFIRM] ERROR: Record write failed"));
+        removeSlot(slot);
+        return false;
+    }
+    
+    return true;
+}
+
+bool ConfirmJournal::acknowledge(const char* key) {
+    if (key == nullptr || key[0] == '\0') return false;
+    
+    int8_t slot = findSlot(key);
+    if (slot < 0) return false;
+    
+    DEBUG_PRINTF("[CONFIRM] Acknowledged: %s\n", key);
+    removeSlot(slot);
+    return true;
+}
+
+uint8_t ConfirmJournal::retireStale(uint32_t unixNow) {
+    uint8_t retired = 0;
+    bool clockValid = unixNow > CLOCK_VALID_AFTER;
+    
+    for (uint8_t slot = 0; slot < CONFIRM_JOURNAL_SIZE; slot++) {
+        const ConfirmRecord& record = records[slot];
+        if (record.key[0] == '\0') continue;
+        
+        bool tooOld = clockValid && record.createdAt != 0 && unixNow - record.createdAt >= CONFIRM_MAX_AGE_S;
+        if (sends[slot] < CONFIRM_MAX_SENDS && !tooOld) continue;
+        
+        DEBUG_PRINTF("[CONFIRM] No ack after %u sends, giving up on %s\n", sends[slot], record.key);
+        removeSlot(slot);
+        retired++;
+    }
+    return retired;
+}
+
+uint8_t ConfirmJournal::getCount() const {
+    return count;
+}
+
+const ConfirmRecord* ConfirmJournal::getRecord(uint8_t slot) const {
+    if (slot >= CONFIRM_JOURNAL_SIZE || records[slot].key[0] == '\0') return nullptr;
+    return &records[slot];
+}
+
+bool ConfirmJournal::isDue(uint8_t slot, unsigned long now) const {
+    return !sentOnce[slot] || now - lastSent[slot] >= CONFIRM_RESEND_MS;
+}
+
+void ConfirmJournal::markSent(uint8_t slot, unsigned long now) {
+    lastSent[slot] = now;
+    sentOnce[slot] = true;
+    if (sends[slot] < 0xFF) sends[slot]++;
+}
+
+void ConfirmJournal::markAllDue() {
+    memset(sentOnce, 0, sizeof(sentOnce));
+}
+
+uint32_t ConfirmJournal::getFlashWrites() const {
+    return flashWrites;
+}
+
+int8_t ConfirmJournal::findSlot(const char* key) const {
+    for (uint8_t slot = 0; slot < CONFIRM_JOURNAL_SIZE; slot++) {
+        if (strcmp(records[slot].key, key) == 0) return slot;
+    }
+    return -1;
+}
+
+int8_t ConfirmJournal::findOldest() const {
+    int8_t oldest = -1;
+    for (uint8_t slot = 0; slot < CONFIRM_JOURNAL_SIZE; slot++) {
+        if (records[slot].key[0] == '\0') continue;
+        if (oldest < 0 || (int32_t)(records[slot].sequence - records[oldest].sequence) < 0) {
+            oldest = slot;
+        }
+    }
+    return oldest;
+}
+
+void ConfirmJournal::removeSlot(uint8_t slot) {
+    char nvsKey[8];
+    slotKey(slot, nvsKey);
+    flashWrites++;
+    prefs.remove(nvsKey);
+    memset(&records[slot], 0, sizeof(records[slot]));
+    sentOnce[slot] = false;
+    sends[slot] = 0;
+    count--;
+}
+
+void ConfirmJournal::slotKey(uint8_t slot, char* key) {
+    snprintf(key, 8, "c%u", slot);
+}
+
+uint32_t ConfirmJournal::recordCrc(const ConfirmRecord& record) {
+    return crc32_le(0, (const uint8_t*)&record, offsetof(ConfirmRecord, crc));
+}
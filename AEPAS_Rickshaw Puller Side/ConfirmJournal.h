@@ -0,0 +1,81 @@
+/*
+ * ConfirmJournal.h
+ * Persistent store for confirmations the backend must receive
+ *
+ * Pickup, drop and resume confirmations are written to one of
+ * CONFIRM_JOURNAL_SIZE CRC-protected NVS records before they are published,
+ * and stay there until the backend acknowledges their idempotency key on
+ * aeras/driver/{driverId}/ack. MQTT publishes are QoS 0, so a successful
+ * publish() proves nothing; the journal resends every CONFIRM_RESEND_MS
+ * until the ack arrives, including after a reset.
+ *
+ * Delivery is best-effort beyond that: a record is given up after
+ * CONFIRM_MAX_SENDS unacknowledged sends since boot or CONFIRM_MAX_AGE_S
+ * after it was written, and a full journal evicts its oldest record for a
+ * new one. A backend that never acks therefore costs a bounded number of
+ * resends instead of holding the sync badge and the radio forever.
+ */
+
+#ifndef CONFIRM_JOURNAL_H
+#define CONFIRM_JOURNAL_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "Config.h"
+
+struct ConfirmRecord {
+    uint8_t type;                           // EventType of the confirmation
+    uint8_t reserved[3];
+    uint32_t sequence;                      // Write order; the oldest is evicted when full
+    uint32_t createdAt;                     // Unix time when the clock is set, else 0
+    char key[CONFIRM_KEY_MAX_LEN];          // Idempotency key; empty = free slot
+    char payload[CONFIRM_PAYLOAD_MAX_LEN];  // Signed message, resent unchanged
+    uint32_t crc;                           // CRC32 of all preceding bytes
+};
+
+class ConfirmJournal {
+public:
+    ConfirmJournal();
+    bool begin();
+    
+    // Stores a confirmation (replacing one with the same key, else evicting
+    // the oldest when full). Returns false if the message is too long or the
+    // write failed
+    bool add(uint8_t type, const String& key, const String& payload);
+    
+    // Drops the confirmation with this key; false if it is not held
+    bool acknowledge(const char* key);
+    
+    // Gives up on records past their send or age limit; returns how many
+    uint8_t retireStale(uint32_t unixNow);
+    
+    uint8_t getCount() const;
+    const ConfirmRecord* getRecord(uint8_t slot) const;    // nullptr for a free slot
+    
+    // Resend pacing (RAM only; everything is due again after a reset)
+    bool isDue(uint8_t slot, unsigned long now) const;
+    void markSent(uint8_t slot, unsigned long now);
+    void markAllDue();
+    
+    uint32_t getFlashWrites() const;
+
+private:
+    Preferences prefs;
+    bool initialized;
+    
+    ConfirmRecord records[CONFIRM_JOURNAL_SIZE];    // RAM mirror of the NVS records
+    unsigned long lastSent[CONFIRM_JOURNAL_SIZE];
+    bool sentOnce[CONFIRM_JOURNAL_SIZE];
+    uint8_t sends[CONFIRM_JOURNAL_SIZE];    // Since boot; bounded by CONFIRM_MAX_SENDS
+    uint8_t count;
+    uint32_t nextSequence;
+    uint32_t flashWrites;
+    
+    int8_t findSlot(const char* key) const;
+    int8_t findOldest() const;
+    void removeSlot(uint8_t slot);
+    static void slotKey(uint8_t slot, char* key);
+    static uint32_t recordCrc(const ConfirmRecord& record);
+};
+
+#endif // CONFIRM_JOURNAL_H
@@ -0,0 +1,68 @@
+/*
+ * DisplayService.h
+ * Double-buffered asynchronous SSD1306 flush
+ *
+ * The UI draws into the Adafruit_SSD1306 buffer (back buffer) and calls
+ * submit(), which copies it into the front buffer and wakes a background
+ * task. The task diffs the frame against what the panel shows and sends
+ * only the changed page/column windows over I2C. A frame that is replaced
+ * before the task picks it up is skipped. After begin() the task owns the
+ * I2C bus.
+ */
+
+#ifndef DISPLAY_SERVICE_H
+#define DISPLAY_SERVICE_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_SSD1306.h>
+#include "Config.h"
+
+#define DISPLAY_FRAME_BYTES     (OLED_SCREEN_WIDTH * OLED_PAGE_COUNT)
+
+// Cost of one submitted frame relative to the previous one
+struct FrameDiff {
+    uint16_t bytes;     // Changed buffer bytes (upper bound on I2C pixel data)
+    uint16_t pixels;    // Pixels that flipped
+};
+
+class DisplayService {
+public:
+    DisplayService();
+    bool begin(Adafruit_SSD1306& display, uint8_t i2cAddress);
+    
+    // Queue the current back buffer for flushing (never blocks on I2C)
+    FrameDiff submit();
+    
+    // Diagnostics
+    void printStats();
+
+private:
+    Adafruit_SSD1306* display;
+    uint8_t address;
+    TaskHandle_t flushTask;
+    portMUX_TYPE lock;
+    
+    uint8_t frontBuffer[DISPLAY_FRAME_BYTES];   // Latest submitted frame
+    uint8_t flushBuffer[DISPLAY_FRAME_BYTES];   // Frame being sent (flush task only)
+    uint8_t panelBuffer[DISPLAY_FRAME_BYTES];   // What the panel shows (flush task only)
+    bool framePending;
+    bool panelValid;
+    
+    // Diagnostics (read without locking)
+    uint32_t framesSubmitted;
+    uint32_t framesFlushed;
+    uint32_t framesSkipped;     // Superseded before they were sent
+    uint32_t bytesFlushed;      // Pixel data bytes sent over I2C
+    uint16_t lastFlushBytes;
+    unsigned long lastFlushUs;
+    unsigned long maxFlushUs;
+    
+    static void taskEntry(void* arg);
+    void run();
+    bool takeFrame();
+    void flush();
+    void sendWindow(uint8_t page, uint8_t firstCol, uint8_t lastCol, const uint8_t* data);
+};
+
+#endif // DISPLAY_SERVICE_H
@@ -5,14 +5,183 @@
 
 #include "FSMController.h"
 
+// ============================================================================
+// STATE / TRANSITION TABLES
+// ============================================================================
+
+#define ON(guard, action, next) { guard, action, next }
+#define IGNORED                 { nullptr, nullptr, STATE_COUNT }
+#define TO_OFFLINE              { nullptr, nullptr, STATE_OFFLINE_ERROR }
+
+typedef FSMController F;
+
+// Rows: SystemState, columns: FSMEvent (same order as the enums)
+// Only IDLE/NOTIFIED go offline on NETWORK_LOST; a ride in progress keeps its
+// state (confirmations wait in the outbox) and the UI shows an offline badge
+constexpr F::Transition F::transitionTable[STATE_COUNT][EVT_COUNT] = {
+    // STATE_IDLE
+    {
+        ON(nullptr, nullptr, STATE_NOTIFIED),                           // RIDE_OFFER
+        IGNORED,                                                        // ACCEPT
+        IGNORED,                                                        // REJECT
+        IGNORED,                                                        // PICKUP
+        IGNORED,                                                        // DROP
+        IGNORED,                                                        // ARRIVED_PICKUP
+        IGNORED,                                                        // ARRIVED_DROP
+        IGNORED,                                                        // TIMEOUT
+        TO_OFFLINE,                                                     // NETWORK_LOST
+        IGNORED,                                                        // NETWORK_RESTORED
+        IGNORED                                                         // NEXT_RIDE
+    },
+    // STATE_NOTIFIED
+    {
+        IGNORED,                                                        // RIDE_OFFER
+        ON(&F::guardAccept, nullptr, STATE_ACCEPTED),                   // ACCEPT
+        ON(&F::guardReject, &F::actionRideRejected, STATE_IDLE),        // REJECT
+        IGNORED,                                                        // PICKUP
+        IGNORED,                                                        // DROP
+        IGNORED,                                                        // ARRIVED_PICKUP
+        IGNORED,                                                        // ARRIVED_DROP
+        ON(nullptr, &F::actionRideExpired, STATE_IDLE),                 // TIMEOUT
+        TO_OFFLINE,                                                     // NETWORK_LOST
+        IGNORED,                                                        // NETWORK_RESTORED
+        IGNORED                                                         // NEXT_RIDE
+    },
+    // STATE_ACCEPTED
+    {
+        IGNORED,                                                        // RIDE_OFFER
+        IGNORED,                                                        // ACCEPT
+        ON(&F::guardCancel, &F::actionRideCancelled, STATE_IDLE),       // REJECT
+        IGNORED,                                                        // PICKUP
+        IGNORED,                                                        // DROP
+        IGNORED,                                                        // ARRIVED_PICKUP
+        IGNORED,                                                        // ARRIVED_DROP
+        ON(nullptr, nullptr, STATE_ENROUTE_TO_PICKUP),                  // TIMEOUT
+        IGNORED,                                                        // NETWORK_LOST
+        IGNORED,                                                        // NETWORK_RESTORED
+        IGNORED                                                         // NEXT_RIDE
+    },
+    // STATE_ENROUTE_TO_PICKUP
+    {
+        IGNORED,                                                        // RIDE_OFFER
+        IGNORED,                                                        // ACCEPT
+        ON(&F::guardCancel, &F::actionRideCancelled, STATE_IDLE),       // REJECT
+        ON(&F::guardPickup, &F::actionPickupConfirmed, STATE_RIDE_ACTIVE), // PICKUP
+        IGNORED,                                                        // DROP
+        ON(nullptr, nullptr, STATE_ARRIVED_PICKUP),                     // ARRIVED_PICKUP
+        IGNORED,                                                        // ARRIVED_DROP
+        IGNORED,                                                        // TIMEOUT
+        IGNORED,                                                        // NETWORK_LOST
+        IGNORED,                                                        // NETWORK_RESTORED
+        IGNORED                                                         // NEXT_RIDE
+    },
+    // STATE_ARRIVED_PICKUP
+    {
+        IGNORED,                                                        // RIDE_OFFER
+        IGNORED,                                                        // ACCEPT
+        IGNORED,                                                        // REJECT
+        ON(&F::guardPickup, &F::actionPickupConfirmed, STATE_RIDE_ACTIVE), // PICKUP
+        IGNORED,                                                        // DROP
+        IGNORED,                                                        // ARRIVED_PICKUP
+        IGNORED,                                                        // ARRIVED_DROP
+        IGNORED,                                                        // TIMEOUT
+        IGNORED,                                                        // NETWORK_LOST
+        IGNORED,                                                        // NETWORK_RESTORED
+        IGNORED                                                         // NEXT_RIDE
+    },
+    // STATE_RIDE_ACTIVE
+    {
+        IGNORED,                                                        // RIDE_OFFER
+        IGNORED,                                                        // ACCEPT
+        IGNORED,                                                        // REJECT
+        IGNORED,                                                        // PICKUP
+        ON(&F::guardDrop, &F::actionDropConfirmed, STATE_COMPLETED),    // DROP
+        IGNORED,                                                        // ARRIVED_PICKUP
+        IGNORED,                                                        // ARRIVED_DROP
+        ON(nullptr, nullptr, STATE_ENROUTE_TO_DROP),                    // TIMEOUT
+        IGNORED,                                                        // NETWORK_LOST
+        IGNORED,                                                        // NETWORK_RESTORED
+        IGNORED                                                         // NEXT_RIDE
+    },
+    // STATE_ENROUTE_TO_DROP
+    {
+        ON(&F::guardNextRideOffer, &F::actionNextRideOffered, STATE_ENROUTE_TO_DROP), // RIDE_OFFER
+        ON(&F::guardAcceptNext, &F::actionNextRideAccepted, STATE_ENROUTE_TO_DROP), // ACCEPT
+        ON(&F::guardRejectNext, &F::actionNextRideRejected, STATE_ENROUTE_TO_DROP), // REJECT
+        IGNORED,                                                        // PICKUP
+        ON(&F::guardDrop, &F::actionDropConfirmed, STATE_COMPLETED),    // DROP
+        IGNORED,                                                        // ARRIVED_PICKUP
+        ON(&F::guardDrop, &F::actionDropConfirmed, STATE_COMPLETED),    // ARRIVED_DROP
+        IGNORED,                                                        // TIMEOUT
+        IGNORED,                                                        // NETWORK_LOST
+        IGNORED,                                                        // NETWORK_RESTORED
+        IGNORED                                                         // NEXT_RIDE
+    },
+    // STATE_COMPLETED
+    {
+        IGNORED,                                                        // RIDE_OFFER
+        IGNORED,                                                        // ACCEPT
+        IGNORED,                                                        // REJECT
+        IGNORED,                                                        // PICKUP
+        IGNORED,                                                        // DROP
+        IGNORED,                                                        // ARRIVED_PICKUP
+        IGNORED,                                                        // ARRIVED_DROP
+        ON(nullptr, &F::actionResetRide, STATE_IDLE),                   // TIMEOUT
+        IGNORED,                                                        // NETWORK_LOST
+        IGNORED,                                                        // NETWORK_RESTORED
+        ON(nullptr, &F::actionPromoteNextRide, STATE_ENROUTE_TO_PICKUP) // NEXT_RIDE
+    },
+    // STATE_OFFLINE_ERROR
+    {
+        IGNORED,                                                        // RIDE_OFFER
+        IGNORED,                                                        // ACCEPT
+        IGNORED,                                                        // REJECT
+        IGNORED,                                                        // PICKUP
+        IGNORED,                                                        // DROP
+        IGNORED,                                                        // ARRIVED_PICKUP
+        IGNORED,                                                        // ARRIVED_DROP
+        IGNORED,                                                        // TIMEOUT
+        IGNORED,                                                        // NETWORK_LOST
+        ON(&F::guardOnline, nullptr, STATE_CHECKPOINT),                 // NETWORK_RESTORED
+        IGNORED                                                         // NEXT_RIDE
+    }
+};
+
+// Entry, exit, refresh (interval ms), timeout (ms)
+constexpr F::StateDescriptor F::stateTable[STATE_COUNT] = {
+    /* IDLE              */ { &F::enterIdle,          nullptr, &F::refreshIdle,            5000, NO_TIMEOUT },
+    /* NOTIFIED          */ { &F::enterNotified,      nullptr, &F::refreshNotified,        1000, ACCEPT_TIMEOUT_MS },
+    /* ACCEPTED          */ { &F::enterAccepted,      nullptr, nullptr,                    0,    0 },
+    /* ENROUTE_TO_PICKUP */ { nullptr,                nullptr, &F::refreshEnrouteToPickup, 2000, NO_TIMEOUT },
+    /* ARRIVED_PICKUP    */ { &F::enterArrivedPickup, nullptr, &F::refreshArrivedPickup,   3000, NO_TIMEOUT },
+    /* RIDE_ACTIVE       */ { &F::enterRideActive,    nullptr, &F::refreshRideActive,      2000, 0 },
+    /* ENROUTE_TO_DROP   */ { nullptr,                nullptr, &F::refreshEnrouteToDrop,   2000, NO_TIMEOUT },
+    /* COMPLETED         */ { &F::enterCompleted,     nullptr, nullptr,                    0,    5000 },
+    /* OFFLINE_ERROR     */ { &F::enterOfflineError,  nullptr, &F::refreshOfflineError,    3000, NO_TIMEOUT }
+};
+
+#undef ON
+#undef IGNORED
+#undef TO_OFFLINE
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
 FSMController::FSMController(GPSManager& gps, CommManager& comm, UIManager& ui, 
                            PointsManager& points, LocalStore& store)
     : gpsManager(gps), commManager(comm), uiManager(ui), 
       pointsManager(points), localStore(store),
       currentState(STATE_IDLE), previousState(STATE_IDLE),
-      stateStartTime(0), lastStateUpdate(0),
+      stateStartTime(0), lastRefreshTime(0), refreshDue(true), timeoutPosted(false),
+      eventHead(0), eventCount(0), dispatching(false),
       hasActiveRide(false), rideNotificationTime(0),
-      rideAcceptTime(0), pickupConfirmTime(0) {
+      rideAcceptTime(0), pickupConfirmTime(0),
+      hasNextRide(false), nextRideAccepted(false), nextRideNotificationTime(0),
+      nextRideAcceptTime(0), nextRideOffers(0), chainedRides(0),
+      checkpointState(STATE_IDLE), resumePending(false),
+      resumedFromCheckpoint(false), recoveryMs(0),
+      savedLat(0), savedLon(0), hasSavedLocation(false) {
 }
 
 void FSMController::begin() {
@@ -20,174 +189,231 @@ void FSMController::begin() {
     
     currentState = STATE_IDLE;
     stateStartTime = millis();
-    lastStateUpdate = millis();
+    lastRefreshTime = stateStartTime;
+    refreshDue = true;
+    timeoutPosted = false;
+    eventHead = 0;
+    eventCount = 0;
+    hasSavedLocation = localStore.getLastLocation(savedLat, savedLon);
     
     DEBUG_PRINTLN(F("[FSM] FSM Controller initialized"));
     logStateTransition(STATE_IDLE, STATE_IDLE);
+    
+    // Pick the ride back up after a watchdog reset or brownout
+    RideCheckpoint checkpoint;
+    if (localStore.loadRideCheckpoint(checkpoint) && !resumeRide(checkpoint)) {
+        localStore.clearRideCheckpoint();
+    }
 }
 
 void FSMController::update() {
     unsigned long currentTime = millis();
+    const StateDescriptor& desc = stateTable[currentState];
     
-    // Update display and check for state-specific actions
-    switch (currentState) {
-        case STATE_IDLE:
-            handleIdleState();
-            break;
-        case STATE_NOTIFIED:
-            handleNotifiedState();
-            break;
-        case STATE_ACCEPTED:
-            handleAcceptedState();
-            break;
-        case STATE_ENROUTE_TO_PICKUP:
-            handleEnrouteToPickupState();
-            break;
-        case STATE_ARRIVED_PICKUP:
-            handleArrivedPickupState();
-            break;
-        case STATE_RIDE_ACTIVE:
-            handleRideActiveState();
-            break;
-        case STATE_ENROUTE_TO_DROP:
-            handleEnrouteToDropState();
-            break;
-        case STATE_COMPLETED:
-            handleCompletedState();
-            break;
-        case STATE_OFFLINE_ERROR:
-            handleOfflineErrorState();
-            break;
+    // Pull fixes parsed on the network task
+    gpsManager.processFixes();
+    if (currentState == STATE_RIDE_ACTIVE || currentState == STATE_ENROUTE_TO_DROP) {
+        pointsManager.addFix(gpsManager.getCurrentLocation());
+    }
+    
+    // Connectivity (rows that ignore NETWORK_LOST stay put)
+    if (!commManager.isWiFiLinkUp() &&
+        transitionTable[currentState][EVT_NETWORK_LOST].next != STATE_COUNT) {
+        postEvent(EVT_NETWORK_LOST);
     }
     
-    // Check for connectivity issues
-    if (!commManager.isWiFiConnected() && currentState != STATE_OFFLINE_ERROR) {
-        transitionToState(STATE_OFFLINE_ERROR);
+    // Periodic refresh (runs immediately after entering a state)
+    if (desc.onRefresh && desc.refreshMs > 0 &&
+        (refreshDue || currentTime - lastRefreshTime >= desc.refreshMs)) {
+        refreshDue = false;
+        lastRefreshTime = currentTime;
+        (this->*desc.onRefresh)();
+        
+        if (resumedFromCheckpoint && recoveryMs == 0) {
+            recoveryMs = currentTime;
+            DEBUG_PRINTF("[FSM] Ride screen restored %lu ms after reset\n", recoveryMs);
+        }
     }
     
-    lastStateUpdate = currentTime;
+    if (resumePending && commManager.isMQTTLinkUp()) {
+        reportResume();
+    }
+    
+    // State timeout
+    if (!timeoutPosted && desc.timeoutMs != NO_TIMEOUT &&
+        currentTime - stateStartTime >= desc.timeoutMs) {
+        timeoutPosted = true;
+        postEvent(EVT_TIMEOUT);
+    }
+    
+    processEvents();
 }
 
 SystemState FSMController::getCurrentState() const {
     return currentState;
 }
 
+const RideInfo* FSMController::getActiveRide() const {
+    return hasActiveRide ? &currentRide : nullptr;
+}
+
 void FSMController::setState(SystemState newState) {
     transitionToState(newState);
 }
 
+// ============================================================================
+// EVENT QUEUE
+// ============================================================================
+
+bool FSMController::postEvent(FSMEvent event) {
+    if (eventCount >= FSM_EVENT_QUEUE_SIZE) {
+        DEBUG_PRINTF("[FSM] Event queue full, dropping event %d\n", event);
+        return false;
+    }
+    
+    eventQueue[(eventHead + eventCount) % FSM_EVENT_QUEUE_SIZE] = event;
+    eventCount++;
+    return true;
+}
+
+void FSMController::processEvents() {
+    // Run-to-completion: events posted by guards/actions are handled after
+    // the current transition finishes
+    if (dispatching) return;
+    
+    dispatching = true;
+    while (eventCount > 0) {
+        FSMEvent event = eventQueue[eventHead];
+        eventHead = (eventHead + 1) % FSM_EVENT_QUEUE_SIZE;
+        eventCount--;
+        dispatch(event);
+    }
+    dispatching = false;
+}
+
+void FSMController::dispatch(FSMEvent event) {
+    const Transition& t = transitionTable[currentState][event];
+    
+    if (t.next == STATE_COUNT) {
+        return; // Not handled in this state
+    }
+    
+    if (t.guard && !(this->*t.guard)()) {
+        return;
+    }
+    
+    // A ride that was checkpointed carries on where it left off; an offer
+    // that was never accepted lapsed while offline and is dropped
+    SystemState next = t.next;
+    if (next == STATE_CHECKPOINT) {
+        if (hasActiveRide && checkpointState != STATE_IDLE) {
+            next = checkpointState;
+        } else {
+            next = STATE_IDLE;
+            if (hasActiveRide) {
+                resetRideData();
+            }
+        }
+    }
+    
+    const StateDescriptor& from = stateTable[currentState];
+    if (next != currentState && from.onExit) {
+        (this->*from.onExit)();
+    }
+    
+    if (t.action) {
+        (this->*t.action)();
+    }
+    
+    transitionToState(next);
+}
+
+// ============================================================================
+// EXTERNAL EVENTS
+// ============================================================================
+
 void FSMController::handleRideNotification(const char* payload) {
     DEBUG_PRINTF("[FSM] Ride notification received: %s\n", payload);
     
+    // Near the end of a trip, offers go to the next-ride slot instead
+    if (currentState == STATE_ENROUTE_TO_DROP && NEXT_RIDE_ENABLED) {
+        if (hasNextRide) {
+            DEBUG_PRINTLN(F("[FSM] Ignoring ride notification - next ride already queued"));
+            return;
+        }
+        
+        // Next leg starts where this ride ends
+        RideInfo offer;
+        if (!parseRideNotification(payload, offer, currentRide.dropLat, currentRide.dropLon)) {
+            return;
+        }
+        if (offer.rideId == lastOfferedRideId || offer.rideId == currentRide.rideId) {
+            DEBUG_PRINTLN(F("[FSM] Ignoring duplicate ride notification"));
+            return;
+        }
+        
+        nextRide = offer;
+        hasNextRide = true;
+        lastOfferedRideId = nextRide.rideId;
+        nextRideNotificationTime = millis();
+        postEvent(EVT_RIDE_OFFER);
+        processEvents();
+        return;
+    }
+    
     // Only accept new rides when idle
     if (currentState != STATE_IDLE) {
         DEBUG_PRINTLN(F("[FSM] Ignoring ride notification - not idle"));
         return;
     }
     
-    parseRideNotification(payload);
+    GPSData gpsData = gpsManager.getCurrentLocation();
+    RideInfo offer;
+    if (!parseRideNotification(payload, offer, gpsData.latitude, gpsData.longitude)) {
+        return;
+    }
     
-    if (hasActiveRide) {
-        rideNotificationTime = millis();
-        transitionToState(STATE_NOTIFIED);
-        uiManager.beepPattern(3, 200, 100);
+    if (offer.rideId == lastOfferedRideId) {
+        DEBUG_PRINTLN(F("[FSM] Ignoring duplicate ride notification"));
+        return;
     }
+    
+    currentRide = offer;
+    hasActiveRide = true;
+    lastOfferedRideId = currentRide.rideId;
+    rideNotificationTime = millis();
+    postEvent(EVT_RIDE_OFFER);
+    processEvents();
 }
 
 void FSMController::handleAcceptButton() {
     DEBUG_PRINTLN(F("[FSM] Accept button pressed"));
-    
-    if (currentState == STATE_NOTIFIED) {
-        // Send acceptance to backend
-        GPSData gpsData = gpsManager.getCurrentLocation();
-        
-        if (commManager.publishAccept(currentRide.rideId, gpsData.latitude, gpsData.longitude)) {
-            rideAcceptTime = millis();
-            transitionToState(STATE_ACCEPTED);
-            uiManager.setLED(LED_FAST_BLINK); // Yellow LED blinking
-        } else {
-            uiManager.showMessage("Accept failed!", 2000);
-        }
-    }
+    postEvent(EVT_ACCEPT);
+    processEvents();
 }
 
 void FSMController::handleRejectButton() {
     DEBUG_PRINTLN(F("[FSM] Reject button pressed"));
-    
-    if (currentState == STATE_NOTIFIED) {
-        // Send rejection to backend
-        if (commManager.publishReject(currentRide.rideId, "Driver rejected")) {
-            uiManager.showMessage("Ride rejected", 1000);
-            resetRideData();
-            transitionToState(STATE_IDLE);
-        } else {
-            uiManager.showMessage("Reject failed!", 2000);
-        }
-    } else if (currentState == STATE_ACCEPTED || currentState == STATE_ENROUTE_TO_PICKUP) {
-        // Cancel after accepting
-        if (commManager.publishCancel(currentRide.rideId, "Driver cancelled")) {
-            uiManager.showMessage("Ride cancelled", 1000);
-            resetRideData();
-            transitionToState(STATE_IDLE);
-        } else {
-            uiManager.showMessage("Cancel failed!", 2000);
-        }
-    }
+    postEvent(EVT_REJECT);
+    processEvents();
 }
 
 void FSMController::handlePickupButton() {
     DEBUG_PRINTLN(F("[FSM] Pickup confirm button pressed"));
-    
-    if (currentState == STATE_ARRIVED_PICKUP || currentState == STATE_ENROUTE_TO_PICKUP) {
-        GPSData gpsData = gpsManager.getCurrentLocation();
-        
-        // Check if within acceptable pickup range
-        if (isWithinPickupRange() || !gpsManager.isValid()) {
-            if (commManager.publishPickupConfirm(currentRide.rideId, gpsData.latitude, gpsData.longitude)) {
-                pickupConfirmTime = millis();
-                transitionToState(STATE_RIDE_ACTIVE);
-                uiManager.setLED(LED_ON); // Solid LED
-            } else {
-                uiManager.showMessage("Pickup confirm failed!", 2000);
-            }
-        } else {
-            double distance = getCurrentDistanceToPickup();
-            uiManager.showMessage("Too far from pickup: " + String((int)distance) + "m", 2000);
-        }
-    }
+    postEvent(EVT_PICKUP);
+    processEvents();
 }
 
 void FSMController::handleDropButton() {
     DEBUG_PRINTLN(F("[FSM] Drop confirm button pressed"));
-    
-    if (currentState == STATE_RIDE_ACTIVE || currentState == STATE_ENROUTE_TO_DROP) {
-        GPSData gpsData = gpsManager.getAveragedLocation();
-        
-        // Calculate final points
-        PointsResult result = pointsManager.calculateFinalPoints(
-            currentRide.dropLat, currentRide.dropLon,
-            gpsData.latitude, gpsData.longitude,
-            gpsData.hdop
-        );
-        
-        if (commManager.publishDropConfirm(currentRide.rideId, gpsData.latitude, gpsData.longitude, 
-                                          result.points, result.needsReview)) {
-            // Update local points if not pending review
-            if (!result.needsReview) {
-                localStore.addPoints(result.points);
-            }
-            localStore.incrementRideCount();
-            
-            // Show completion screen
-            uiManager.showCompletedScreen(result.points, result.needsReview);
-            
-            transitionToState(STATE_COMPLETED);
-        } else {
-            uiManager.showMessage("Drop confirm failed!", 2000);
-        }
-    }
+    postEvent(EVT_DROP);
+    processEvents();
 }
 
+// ============================================================================
+// STATE CHECKERS
+// ============================================================================
+
 bool FSMController::isWithinPickupRange() {
     if (!gpsManager.isValid()) return false;
     return gpsManager.isWithinRange(currentRide.pickupLat, currentRide.pickupLon, DISTANCE_PICKUP_MAX);
@@ -210,147 +436,421 @@ bool FSMController::shouldAutoConfirmDrop() {
 
 bool FSMController::hasRideTimedOut() {
     if (currentState == STATE_NOTIFIED) {
-        return (millis() - rideNotificationTime) > ACCEPT_TIMEOUT_MS;
+        return getTimeInState() > ACCEPT_TIMEOUT_MS;
     }
     return false;
 }
 
-void FSMController::handleIdleState() {
-    static unsigned long lastUpdate = 0;
+unsigned long FSMController::getTimeInState() const {
+    return millis() - stateStartTime;
+}
+
+uint32_t FSMController::getNextRideOffers() const {
+    return nextRideOffers;
+}
+
+uint32_t FSMController::getChainedRides() const {
+    return chainedRides;
+}
+
+unsigned long FSMController::getRecoveryMs() const {
+    return recoveryMs;
+}
+
+// ============================================================================
+// GUARDS
+// ============================================================================
+
+bool FSMController::guardAccept() {
+    GPSData gpsData = gpsManager.getCurrentLocation();
     
-    if (millis() - lastUpdate > 5000) { // Update every 5 seconds
-        GPSData gpsData = gpsManager.getCurrentLocation();
-        float points = localStore.getTotalPoints();
-        
-        uiManager.showIdleScreen(localStore.getDriverId(), gpsData.satellites, points);
-        uiManager.setLED(LED_SLOW_BLINK);
-        
-        // Save current location
-        if (gpsManager.isValid()) {
-            localStore.setLastLocation(gpsData.latitude, gpsData.longitude);
-        }
-        
-        lastUpdate = millis();
+    if (!requestPublish(currentRide, EVENT_ACCEPT, gpsData.latitude, gpsData.longitude)) {
+        uiManager.showMessage("Accept failed!", 2000);
+        return false;
     }
+    
+    rideAcceptTime = millis();
+    return true;
 }
 
-void FSMController::handleNotifiedState() {
-    // Check for timeout
-    if (hasRideTimedOut()) {
-        DEBUG_PRINTLN(F("[FSM] Ride notification timed out"));
-        uiManager.showMessage("Ride expired!", 2000);
-        resetRideData();
-        transitionToState(STATE_IDLE);
+bool FSMController::guardReject() {
+    if (!requestPublish(currentRide, EVENT_REJECT, 0, 0, "Driver rejected")) {
+        uiManager.showMessage("Reject failed!", 2000);
+        return false;
+    }
+    return true;
+}
+
+bool FSMController::guardCancel() {
+    if (!requestPublish(currentRide, EVENT_CANCEL, 0, 0, "Driver cancelled")) {
+        uiManager.showMessage("Cancel failed!", 2000);
+        return false;
+    }
+    return true;
+}
+
+bool FSMController::guardPickup() {
+    // Check if within acceptable pickup range
+    if (!isWithinPickupRange() && gpsManager.isValid()) {
+        double distance = getCurrentDistanceToPickup();
+        uiManager.showMessage("Too far from pickup: " + String((int)distance) + "m", 2000);
+        return false;
+    }
+    
+    // Committed locally; CommManager buffers it until the broker has it
+    GPSData gpsData = gpsManager.getCurrentLocation();
+    if (!queueRequest(currentRide, EVENT_PICKUP, gpsData.latitude, gpsData.longitude)) {
+        uiManager.showMessage("Pickup confirm failed!", 2000);
+        return false;
+    }
+    return true;
+}
+
+bool FSMController::guardDrop() {
+    GPSData gpsData = gpsManager.getAveragedLocation();
+    
+    // Calculate final points
+    lastPointsResult = pointsManager.calculateFinalPoints(
+        currentRide.dropLat, currentRide.dropLon,
+        gpsData.latitude, gpsData.longitude,
+        gpsData.hdop
+    );
+    
+    // Committed locally like pickup; delivery is retried in the background
+    DropScore score;
+    score.centiPoints = lastPointsResult.centiPoints;
+    score.dropErrorCm = lastPointsResult.dropErrorCm;
+    score.accuracyCenti = lastPointsResult.accuracyCenti;
+    score.review = lastPointsResult.review;
+    score.expectedLat = currentRide.dropLat;
+    score.expectedLon = currentRide.dropLon;
+    
+    if (!queueRequest(currentRide, EVENT_DROP, gpsData.latitude, gpsData.longitude, "", &score)) {
+        uiManager.showMessage("Drop confirm failed!", 2000);
+        return false;
+    }
+    return true;
+}
+
+bool FSMController::guardOnline() {
+    return commManager.isWiFiLinkUp() && commManager.isMQTTLinkUp();
+}
+
+bool FSMController::guardNextRideOffer() {
+    // Only worth lining up when this trip is nearly over
+    double distance = getCurrentDistanceToDrop();
+    if (distance >= 0 && distance <= DISTANCE_NEXT_RIDE) {
+        return true;
+    }
+    
+    DEBUG_PRINTF("[FSM] Next ride offer declined - %.0f m from drop\n", distance);
+    requestPublish(nextRide, EVENT_REJECT, 0, 0, "Driver on trip");
+    clearNextRide();
+    return false;
+}
+
+bool FSMController::guardAcceptNext() {
+    if (!hasNextRide || nextRideAccepted) {
+        return false;
+    }
+    
+    GPSData gpsData = gpsManager.getCurrentLocation();
+    if (!requestPublish(nextRide, EVENT_ACCEPT, gpsData.latitude, gpsData.longitude)) {
+        uiManager.showMessage("Accept failed!", 2000);
+        return false;
+    }
+    return true;
+}
+
+bool FSMController::guardRejectNext() {
+    if (!hasNextRide) {
+        return false;
+    }
+    
+    // Once accepted, backing out is a cancel for the backend
+    bool ok = nextRideAccepted
+        ? requestPublish(nextRide, EVENT_CANCEL, 0, 0, "Driver cancelled")
+        : requestPublish(nextRide, EVENT_REJECT, 0, 0, "Driver rejected");
+    if (!ok) {
+        uiManager.showMessage("Reject failed!", 2000);
+        return false;
+    }
+    return true;
+}
+
+bool FSMController::requestPublish(const RideInfo& ride, EventType type, double lat, double lon,
+                                   const char* text, const DropScore* score) {
+    // Publishing happens on the network task; fail fast here so the guard
+    // can still veto when the broker is unreachable
+    if (!commManager.isMQTTLinkUp()) {
+        return false;
+    }
+    
+    return queueRequest(ride, type, lat, lon, text, score);
+}
+
+bool FSMController::queueRequest(const RideInfo& ride, EventType type, double lat, double lon,
+                                 const char* text, const DropScore* score) {
+    // Only fails when the outbox is full
+    OutboundRequest request = {};
+    request.type = type;
+    strlcpy(request.rideId, ride.rideId.c_str(), sizeof(request.rideId));
+    strlcpy(request.text, text, sizeof(request.text));
+    request.lat = lat;
+    request.lon = lon;
+    if (score) {
+        request.score = *score;
+    }
+    
+    return commManager.postRequest(request);
+}
+
+// ============================================================================
+// TRANSITION ACTIONS
+// ============================================================================
+
+void FSMController::actionRideExpired() {
+    DEBUG_PRINTLN(F("[FSM] Ride notification timed out"));
+    uiManager.showMessage("Ride expired!", 2000);
+    resetRideData();
+}
+
+void FSMController::actionRideRejected() {
+    uiManager.showMessage("Ride rejected", 1000);
+    resetRideData();
+}
+
+void FSMController::actionRideCancelled() {
+    uiManager.showMessage("Ride cancelled", 1000);
+    resetRideData();
+}
+
+void FSMController::actionPickupConfirmed() {
+    pickupConfirmTime = millis();
+    pointsManager.startTrip(pickupConfirmTime);
+}
+
+void FSMController::actionDropConfirmed() {
+    // A drop replayed after a resume must not award the ride twice
+    if (localStore.hasRecordedRide(currentRide.rideId)) {
+        DEBUG_PRINTF("[FSM] Ride %s already in the ledger\n", currentRide.rideId.c_str());
         return;
     }
     
-    static unsigned long lastUpdate = 0;
-    if (millis() - lastUpdate > 1000) { // Update every second
-        uiManager.showRideNotification(currentRide);
-        uiManager.setLED(LED_FAST_BLINK);
-        lastUpdate = millis();
+    // Journaled either way; points pending review stay out of the total
+    localStore.recordRidePoints(currentRide.rideId, lastPointsResult.centiPoints, lastPointsResult.needsReview);
+    localStore.incrementRideCount();
+    localStore.commit();
+    
+    recordRideHistory();
+}
+
+void FSMController::recordRideHistory() {
+    GPSData gpsData = gpsManager.getAveragedLocation();
+    unsigned long now = millis();
+    
+    RideRecord record;
+    memset(&record, 0, sizeof(record));
+    record.rideHash = PointsLedger::hashRideId(currentRide.rideId);
+    record.acceptTime = unixTimeAt(rideAcceptTime);
+    record.pickupTime = pickupConfirmTime > 0 ? unixTimeAt(pickupConfirmTime) : 0;
+    record.dropTime = unixTimeAt(now);
+    record.pickupLat = lround(currentRide.pickupLat * 1e6);
+    record.pickupLon = lround(currentRide.pickupLon * 1e6);
+    record.dropLat = lround(gpsData.latitude * 1e6);
+    record.dropLon = lround(gpsData.longitude * 1e6);
+    record.centiPoints = lastPointsResult.centiPoints;
+    record.distanceM = (uint32_t)lastPointsResult.rideDistance;
+    record.durationS = lastPointsResult.rideDurationMs / 1000;
+    record.flags = lastPointsResult.needsReview ? RIDE_RECORD_REVIEW : 0;
+    
+    localStore.appendRideHistory(record);
+}
+
+uint32_t FSMController::unixTimeAt(unsigned long eventMs) {
+    // Convert a millis() stamp to wall time; 0 until SNTP has set the clock
+    time_t now = time(nullptr);
+    if (now < (time_t)CLOCK_VALID_AFTER) return 0;
+    return (uint32_t)now - (millis() - eventMs) / 1000;
+}
+
+void FSMController::actionResetRide() {
+    resetRideData();
+}
+
+void FSMController::actionNextRideOffered() {
+    DEBUG_PRINTF("[FSM] Next ride offered: %s\n", nextRide.rideId.c_str());
+    nextRideOffers++;
+    uiManager.beep(150);
+    refreshDue = true;
+}
+
+void FSMController::actionNextRideAccepted() {
+    DEBUG_PRINTF("[FSM] Next ride accepted: %s\n", nextRide.rideId.c_str());
+    nextRideAccepted = true;
+    nextRideAcceptTime = millis();
+    uiManager.showMessage("Next ride queued", 1000);
+    refreshDue = true;
+}
+
+void FSMController::actionNextRideRejected() {
+    uiManager.showMessage(nextRideAccepted ? "Next ride cancelled" : "Next ride rejected", 1000);
+    clearNextRide();
+    refreshDue = true;
+}
+
+void FSMController::actionPromoteNextRide() {
+    DEBUG_PRINTF("[FSM] Starting queued ride: %s\n", nextRide.rideId.c_str());
+    resetRideData();
+    currentRide = nextRide;
+    hasActiveRide = true;
+    rideNotificationTime = nextRideNotificationTime;
+    rideAcceptTime = nextRideAcceptTime;
+    chainedRides++;
+    clearNextRide();
+}
+
+// ============================================================================
+// ENTRY ACTIONS
+// ============================================================================
+
+void FSMController::enterIdle() {
+    // A queued ride can't survive an offline detour back to idle
+    if (hasNextRide) {
+        DEBUG_PRINTLN(F("[FSM] Dropping queued next ride"));
+        clearNextRide();
     }
+    uiManager.setLED(LED_SLOW_BLINK);
+}
+
+void FSMController::enterNotified() {
+    uiManager.setLED(LED_FAST_BLINK);
+    uiManager.beepPattern(3, 200, 100);
+}
+
+void FSMController::enterAccepted() {
+    uiManager.setLED(LED_FAST_BLINK);
+    uiManager.beep(200);
 }
 
-void FSMController::handleAcceptedState() {
-    // Immediately transition to enroute
-    transitionToState(STATE_ENROUTE_TO_PICKUP);
+void FSMController::enterArrivedPickup() {
+    uiManager.beepPattern(2, 300, 200);
 }
 
-void FSMController::handleEnrouteToPickupState() {
-    static unsigned long lastUpdate = 0;
+void FSMController::enterRideActive() {
+    uiManager.setLED(LED_ON);
+    uiManager.beep(500);
+}
+
+void FSMController::enterCompleted() {
+    uiManager.showCompletedScreen(lastPointsResult.points, lastPointsResult.needsReview);
+    uiManager.setLED(LED_SLOW_BLINK);
     
-    if (millis() - lastUpdate > 2000) { // Update every 2 seconds
-        double distance = getCurrentDistanceToPickup();
-        uiManager.showEnrouteToPickup(currentRide, distance);
-        
-        // Check if arrived at pickup
-        if (shouldAutoConfirmPickup()) {
-            DEBUG_PRINTLN(F("[FSM] Auto-arrived at pickup location"));
-            transitionToState(STATE_ARRIVED_PICKUP);
-        } else if (isWithinPickupRange()) {
-            DEBUG_PRINTLN(F("[FSM] Within pickup range"));
-            transitionToState(STATE_ARRIVED_PICKUP);
-        }
-        
-        lastUpdate = millis();
+    // Skip the idle round trip when the driver already took the next ride
+    if (hasNextRide && nextRideAccepted) {
+        postEvent(EVT_NEXT_RIDE);
     }
 }
 
-void FSMController::handleArrivedPickupState() {
-    static unsigned long lastUpdate = 0;
+void FSMController::enterOfflineError() {
+    uiManager.setLED(LED_FAST_BLINK);
+}
+
+// ============================================================================
+// REFRESH ACTIONS
+// ============================================================================
+
+void FSMController::refreshIdle() {
+    GPSData gpsData = gpsManager.getCurrentLocation();
+    float points = localStore.getTotalPoints();
     
-    if (millis() - lastUpdate > 3000) { // Update every 3 seconds
-        uiManager.showArrivedAtPickup(currentRide);
-        uiManager.setLED(LED_DOUBLE_BLINK);
-        
-        // Auto-confirm if GPS says we're very close
-        if (shouldAutoConfirmPickup()) {
-            DEBUG_PRINTLN(F("[FSM] Auto-confirming pickup"));
-            handlePickupButton(); // Trigger pickup confirmation
+    uiManager.showIdleScreen(localStore.getDriverId(), gpsData.satellites, points);
+    uiManager.setLED(LED_SLOW_BLINK);
+    
+    // Save current location (skip flash writes while parked)
+    if (gpsManager.isValid()) {
+        bool moved = !hasSavedLocation ||
+            GPSManager::calculateDistance(savedLat, savedLon, gpsData.latitude, gpsData.longitude) >= IDLE_LOCATION_SAVE_M;
+        if (moved) {
+            localStore.setLastLocation(gpsData.latitude, gpsData.longitude);
+            savedLat = gpsData.latitude;
+            savedLon = gpsData.longitude;
+            hasSavedLocation = true;
         }
-        
-        lastUpdate = millis();
     }
 }
 
-void FSMController::handleRideActiveState() {
-    static unsigned long lastUpdate = 0;
+void FSMController::refreshNotified() {
+    uiManager.showRideNotification(currentRide);
+    uiManager.setLED(LED_FAST_BLINK);
+}
+
+void FSMController::refreshEnrouteToPickup() {
+    double distance = getCurrentDistanceToPickup();
+    uiManager.showEnrouteToPickup(currentRide, distance);
     
-    if (millis() - lastUpdate > 2000) { // Update every 2 seconds
-        double distance = getCurrentDistanceToDrop();
-        uiManager.showRideActive(currentRide, distance);
-        uiManager.setLED(LED_ON);
-        
-        // Transition to enroute_to_drop (basically same state, but semantically different)
-        transitionToState(STATE_ENROUTE_TO_DROP);
-        
-        lastUpdate = millis();
+    // Check if arrived at pickup
+    if (isWithinPickupRange()) {
+        DEBUG_PRINTLN(F("[FSM] Within pickup range"));
+        postEvent(EVT_ARRIVED_PICKUP);
     }
 }
 
-void FSMController::handleEnrouteToDropState() {
-    static unsigned long lastUpdate = 0;
+void FSMController::refreshArrivedPickup() {
+    uiManager.showArrivedAtPickup(currentRide);
+    uiManager.setLED(LED_DOUBLE_BLINK);
     
-    if (millis() - lastUpdate > 2000) { // Update every 2 seconds
-        double distance = getCurrentDistanceToDrop();
-        uiManager.showRideActive(currentRide, distance);
-        
-        // Check if arrived at drop (auto-confirm if within range)
-        if (shouldAutoConfirmDrop()) {
-            DEBUG_PRINTLN(F("[FSM] Auto-confirming drop"));
-            handleDropButton(); // Trigger drop confirmation
-        }
-        
-        lastUpdate = millis();
+    // Auto-confirm if GPS says we're very close
+    if (shouldAutoConfirmPickup()) {
+        DEBUG_PRINTLN(F("[FSM] Auto-confirming pickup"));
+        postEvent(EVT_PICKUP);
     }
 }
 
-void FSMController::handleCompletedState() {
-    // Stay on completion screen for 5 seconds
-    if (millis() - stateStartTime > 5000) {
-        resetRideData();
-        transitionToState(STATE_IDLE);
+void FSMController::refreshRideActive() {
+    double distance = getCurrentDistanceToDrop();
+    uiManager.showRideActive(currentRide, distance);
+    uiManager.setLED(LED_ON);
+}
+
+void FSMController::refreshEnrouteToDrop() {
+    double distance = getCurrentDistanceToDrop();
+    
+    // Unanswered next-ride offers expire like regular ones
+    if (hasNextRide && !nextRideAccepted &&
+        millis() - nextRideNotificationTime > ACCEPT_TIMEOUT_MS) {
+        DEBUG_PRINTLN(F("[FSM] Next ride offer timed out"));
+        clearNextRide();
+    }
+    
+    if (hasNextRide && !nextRideAccepted) {
+        uiManager.showNextRideOffer(nextRide, distance);
+    } else {
+        uiManager.showRideActive(currentRide, distance);
+    }
+    
+    // Check if arrived at drop (auto-confirm if within range)
+    if (shouldAutoConfirmDrop()) {
+        DEBUG_PRINTLN(F("[FSM] Auto-confirming drop"));
+        postEvent(EVT_ARRIVED_DROP);
     }
 }
 
-void FSMController::handleOfflineErrorState() {
-    static unsigned long lastUpdate = 0;
+void FSMController::refreshOfflineError() {
+    uiManager.showErrorScreen("Network Error\nReconnecting...");
+    uiManager.setLED(LED_FAST_BLINK);
     
-    if (millis() - lastUpdate > 3000) {
-        uiManager.showErrorScreen("Network Error\nReconnecting...");
-        uiManager.setLED(LED_FAST_BLINK);
-        
-        // Check if back online
-        if (commManager.isWiFiConnected() && commManager.isMQTTConnected()) {
-            DEBUG_PRINTLN(F("[FSM] Back online"));
-            transitionToState(STATE_IDLE);
-        }
-        
-        lastUpdate = millis();
+    // Check if back online
+    if (guardOnline()) {
+        DEBUG_PRINTLN(F("[FSM] Back online"));
+        postEvent(EVT_NETWORK_RESTORED);
     }
 }
 
+// ============================================================================
+// UTILITY
+// ============================================================================
+
 void FSMController::transitionToState(SystemState newState) {
     if (currentState == newState) return;
     
@@ -358,37 +858,19 @@ void FSMController::transitionToState(SystemState newState) {
     
     previousState = currentState;
     currentState = newState;
+    
+    // Fresh timers for the new state
     stateStartTime = millis();
+    lastRefreshTime = stateStartTime;
+    refreshDue = true;
+    timeoutPosted = false;
     
-    // Perform state entry actions
-    switch (newState) {
-        case STATE_IDLE:
-            uiManager.setLED(LED_SLOW_BLINK);
-            break;
-        case STATE_NOTIFIED:
-            uiManager.setLED(LED_FAST_BLINK);
-            uiManager.beepPattern(3, 200, 100);
-            break;
-        case STATE_ACCEPTED:
-            uiManager.setLED(LED_FAST_BLINK);
-            uiManager.beep(200);
-            break;
-        case STATE_ARRIVED_PICKUP:
-            uiManager.beepPattern(2, 300, 200);
-            break;
-        case STATE_RIDE_ACTIVE:
-            uiManager.setLED(LED_ON);
-            uiManager.beep(500);
-            break;
-        case STATE_COMPLETED:
-            uiManager.setLED(LED_SLOW_BLINK);
-            break;
-        case STATE_OFFLINE_ERROR:
-            uiManager.setLED(LED_FAST_BLINK);
-            break;
-        default:
-            break;
+    const StateDescriptor& desc = stateTable[newState];
+    if (desc.onEntry) {
+        (this->*desc.onEntry)();
     }
+    
+    checkpointRide();
 }
 
 void FSMController::logStateTransition(SystemState from, SystemState to) {
@@ -396,55 +878,162 @@ void FSMController::logStateTransition(SystemState from, SystemState to) {
                 stateToString(from), stateToString(to));
 }
 
-void FSMController::parseRideNotification(const char* payload) {
+bool FSMController::parseRideNotification(const char* payload, RideInfo& ride,
+                                          double originLat, double originLon) {
     StaticJsonDocument<1024> doc;
     DeserializationError error = deserializeJson(doc, payload);
     
     if (error) {
         DEBUG_PRINTF("[FSM] JSON parse error: %s\n", error.c_str());
-        return;
+        return false;
     }
     
     // Extract ride information
-    currentRide.rideId = doc["ride_id"].as<String>();
-    currentRide.pickupAddress = doc["pickup_address"].as<String>();
-    currentRide.dropAddress = doc["drop_address"].as<String>();
-    currentRide.pickupLat = doc["pickup_lat"];
-    currentRide.pickupLon = doc["pickup_lon"];
-    currentRide.dropLat = doc["drop_lat"];
-    currentRide.dropLon = doc["drop_lon"];
+    ride.rideId = doc["ride_id"].as<String>();
+    ride.pickupAddress = doc["pickup_address"].as<String>();
+    ride.dropAddress = doc["drop_address"].as<String>();
+    ride.pickupLat = doc["pickup_lat"];
+    ride.pickupLon = doc["pickup_lon"];
+    ride.dropLat = doc["drop_lat"];
+    ride.dropLon = doc["drop_lon"];
     
     // Calculate distance to pickup
-    GPSData gpsData = gpsManager.getCurrentLocation();
-    currentRide.distanceToPickup = gpsManager.calculateDistance(
-        gpsData.latitude, gpsData.longitude,
-        currentRide.pickupLat, currentRide.pickupLon
+    ride.distanceToPickup = gpsManager.calculateDistance(
+        originLat, originLon,
+        ride.pickupLat, ride.pickupLon
     );
     
     // Calculate estimated points
-    currentRide.estimatedPoints = pointsManager.calculateEstimatedPoints(
-        currentRide.pickupLat, currentRide.pickupLon,
-        gpsData.latitude, gpsData.longitude
+    ride.estimatedPoints = pointsManager.calculateEstimatedPoints(
+        ride.pickupLat, ride.pickupLon,
+        originLat, originLon
     );
     
     // Calculate ETA
-    currentRide.eta = gpsManager.getETA(currentRide.pickupLat, currentRide.pickupLon);
-    
-    hasActiveRide = true;
+    ride.eta = gpsManager.getETA(ride.pickupLat, ride.pickupLon);
     
-    DEBUG_PRINTF("[FSM] Parsed ride: %s\n", currentRide.rideId.c_str());
-    DEBUG_PRINTF("[FSM] Pickup: %.6f, %.6f\n", currentRide.pickupLat, currentRide.pickupLon);
-    DEBUG_PRINTF("[FSM] Drop: %.6f, %.6f\n", currentRide.dropLat, currentRide.dropLon);
-    DEBUG_PRINTF("[FSM] Distance: %.2f m\n", currentRide.distanceToPickup);
-    DEBUG_PRINTF("[FSM] Est. Points: %.2f\n", currentRide.estimatedPoints);
+    DEBUG_PRINTF("[FSM] Parsed ride: %s\n", ride.rideId.c_str());
+    DEBUG_PRINTF("[FSM] Pickup: %.6f, %.6f\n", ride.pickupLat, ride.pickupLon);
+    DEBUG_PRINTF("[FSM] Drop: %.6f, %.6f\n", ride.dropLat, ride.dropLon);
+    DEBUG_PRINTF("[FSM] Distance: %.2f m\n", ride.distanceToPickup);
+    DEBUG_PRINTF("[FSM] Est. Points: %.2f\n", ride.estimatedPoints);
+    return true;
 }
 
 void FSMController::resetRideData() {
     hasActiveRide = false;
     currentRide = RideInfo();
+    resumePending = false;
     rideNotificationTime = 0;
     rideAcceptTime = 0;
     pickupConfirmTime = 0;
+    pointsManager.resetTrip();
+    
+    // Ride is over (completed, cancelled, rejected or expired)
+    discardCheckpoint();
+}
+
+void FSMController::checkpointRide() {
+    switch (currentState) {
+        // Stable ride states; ACCEPTED and RIDE_ACTIVE pass straight through
+        case STATE_ENROUTE_TO_PICKUP:
+        case STATE_ARRIVED_PICKUP:
+        case STATE_ENROUTE_TO_DROP:
+            break;
+            
+        case STATE_COMPLETED:
+            discardCheckpoint();
+            return;
+            
+        default:
+            return;     // IDLE/OFFLINE keep the record until the ride is reset
+    }
+    
+    if (checkpointState == currentState) {
+        return;
+    }
+    
+    unsigned long now = millis();
+    RideCheckpoint checkpoint;
+    memset(&checkpoint, 0, sizeof(checkpoint));
+    checkpoint.state = currentState;
+    strlcpy(checkpoint.rideId, currentRide.rideId.c_str(), sizeof(checkpoint.rideId));
+    strlcpy(checkpoint.pickupAddress, currentRide.pickupAddress.c_str(), sizeof(checkpoint.pickupAddress));
+    strlcpy(checkpoint.dropAddress, currentRide.dropAddress.c_str(), sizeof(checkpoint.dropAddress));
+    checkpoint.pickupLat = currentRide.pickupLat;
+    checkpoint.pickupLon = currentRide.pickupLon;
+    checkpoint.dropLat = currentRide.dropLat;
+    checkpoint.dropLon = currentRide.dropLon;
+    checkpoint.estimatedPoints = currentRide.estimatedPoints;
+    checkpoint.sinceAcceptMs = rideAcceptTime ? now - rideAcceptTime : 0;
+    checkpoint.sincePickupMs = pickupConfirmTime ? now - pickupConfirmTime : 0;
+    
+    if (localStore.saveRideCheckpoint(checkpoint)) {
+        checkpointState = currentState;
+    }
+}
+
+void FSMController::discardCheckpoint() {
+    if (checkpointState != STATE_IDLE) {
+        localStore.clearRideCheckpoint();
+        checkpointState = STATE_IDLE;
+    }
+}
+
+bool FSMController::resumeRide(const RideCheckpoint& checkpoint) {
+    SystemState state = (SystemState)checkpoint.state;
+    if (state != STATE_ENROUTE_TO_PICKUP && state != STATE_ARRIVED_PICKUP &&
+        state != STATE_ENROUTE_TO_DROP) {
+        DEBUG_PRINTF("[FSM] Ignoring checkpoint in unexpected state %u\n", checkpoint.state);
+        return false;
+    }
+    
+    DEBUG_PRINTF("[FSM] Resuming ride %s in %s\n", checkpoint.rideId, stateToString(state));
+    
+    // Time spent powered off is unknown; ages restart from the checkpoint
+    unsigned long now = millis();
+    currentRide = RideInfo();
+    currentRide.rideId = checkpoint.rideId;
+    currentRide.pickupAddress = checkpoint.pickupAddress;
+    currentRide.dropAddress = checkpoint.dropAddress;
+    currentRide.pickupLat = checkpoint.pickupLat;
+    currentRide.pickupLon = checkpoint.pickupLon;
+    currentRide.dropLat = checkpoint.dropLat;
+    currentRide.dropLon = checkpoint.dropLon;
+    currentRide.estimatedPoints = checkpoint.estimatedPoints;
+    currentRide.eta = -1.0;
+    hasActiveRide = true;
+    lastOfferedRideId = currentRide.rideId;
+    rideAcceptTime = now - checkpoint.sinceAcceptMs;
+    pickupConfirmTime = checkpoint.sincePickupMs ? now - checkpoint.sincePickupMs : 0;
+    if (pickupConfirmTime > 0) {
+        // Distance driven before the reset is not in the checkpoint
+        pointsManager.startTrip(pickupConfirmTime);
+    }
+    
+    checkpointState = state;    // Already on flash
+    resumedFromCheckpoint = true;
+    resumePending = true;
+    transitionToState(state);
+    return true;
+}
+
+void FSMController::reportResume() {
+    // Backend reconciles its ride record against the state we came back in
+    GPSData gpsData = gpsManager.getCurrentLocation();
+    if (requestPublish(currentRide, EVENT_RESUME, gpsData.latitude, gpsData.longitude,
+                       stateToString(currentState))) {
+        resumePending = false;
+        DEBUG_PRINTF("[FSM] Ride resume reported: %s\n", currentRide.rideId.c_str());
+    }
+}
+
+void FSMController::clearNextRide() {
+    hasNextRide = false;
+    nextRideAccepted = false;
+    nextRide = RideInfo();
+    nextRideNotificationTime = 0;
+    nextRideAcceptTime = 0;
 }
 
 double FSMController::getCurrentDistanceToPickup() {
@@ -467,7 +1056,4 @@ double FSMController::getCurrentDistanceToDrop() {
     );
 }
 
-void FSMController::updateDisplay() {
-    // Display update is handled in individual state handlers
-}
 
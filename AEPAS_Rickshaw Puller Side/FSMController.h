@@ -1,6 +1,12 @@
 /*
  * FSMController.h
  * Finite State Machine controller for ride workflow
+ *
+ * Table-driven: a compile-time transition table (state x event -> guard,
+ * action, next state) plus a per-state descriptor (entry/exit/refresh
+ * actions and timers). Events are queued in a bounded ring buffer and
+ * dispatched run-to-completion; dispatch is a direct table lookup with no
+ * allocation.
  */
 
 #ifndef FSM_CONTROLLER_H
@@ -15,73 +21,198 @@
 #include "PointsManager.h"
 #include "LocalStore.h"
 
+// Events driving the ride workflow
+enum FSMEvent : uint8_t {
+    EVT_RIDE_OFFER,         // Valid ride notification parsed
+    EVT_ACCEPT,             // Accept button
+    EVT_REJECT,             // Reject button (reject or cancel)
+    EVT_PICKUP,             // Pickup button or auto-confirm
+    EVT_DROP,               // Drop button
+    EVT_ARRIVED_PICKUP,     // GPS within pickup range
+    EVT_ARRIVED_DROP,       // GPS within auto-drop range
+    EVT_TIMEOUT,            // Current state's timer expired
+    EVT_NETWORK_LOST,       // WiFi dropped
+    EVT_NETWORK_RESTORED,   // WiFi + MQTT back
+    EVT_NEXT_RIDE,          // Drop done with a pre-accepted next ride queued
+    EVT_COUNT               // Number of events (FSM table dimension)
+};
+
 class FSMController {
 public:
-    FSMController(GPSManager& gps, CommManager& comm, UIManager& ui, 
+    FSMController(GPSManager& gps, CommManager& comm, UIManager& ui,
                  PointsManager& points, LocalStore& store);
-    
+
     void begin();
     void update();
-    
+
     // State management
     SystemState getCurrentState() const;
     void setState(SystemState newState);
-    
+    const RideInfo* getActiveRide() const;  // nullptr = no ride offered or in progress
+
+    // Event queue
+    bool postEvent(FSMEvent event);
+    void processEvents();
+
     // Event handlers
     void handleRideNotification(const char* payload);
     void handleAcceptButton();
     void handleRejectButton();
     void handlePickupButton();
     void handleDropButton();
-    
+
     // State checkers
     bool isWithinPickupRange();
     bool isWithinDropRange();
     bool shouldAutoConfirmPickup();
     bool shouldAutoConfirmDrop();
-    
+
     // Timeout management
     bool hasRideTimedOut();
+    unsigned long getTimeInState() const;
+    
+    // Back-to-back ride statistics
+    uint32_t getNextRideOffers() const;
+    uint32_t getChainedRides() const;
     
+    // Crash recovery (0 = booted without a ride to resume)
+    unsigned long getRecoveryMs() const;
+
 private:
+    typedef bool (FSMController::*Guard)();
+    typedef void (FSMController::*Action)();
+
+    struct Transition {
+        Guard guard;            // nullptr = always allowed
+        Action action;          // Runs between exit and entry
+        SystemState next;       // STATE_COUNT = event ignored in this state,
+                                // STATE_CHECKPOINT = back to the checkpointed ride
+    };
+
+    struct StateDescriptor {
+        Action onEntry;
+        Action onExit;
+        Action onRefresh;       // Periodic display/GPS work while in state
+        uint16_t refreshMs;     // 0 = no refresh
+        uint32_t timeoutMs;     // Posts EVT_TIMEOUT once; NO_TIMEOUT disables
+    };
+
+    static const uint32_t NO_TIMEOUT = 0xFFFFFFFFUL;
+    static const SystemState STATE_CHECKPOINT = (SystemState)(STATE_COUNT + 1);
+    static const Transition transitionTable[STATE_COUNT][EVT_COUNT];
+    static const StateDescriptor stateTable[STATE_COUNT];
+
     GPSManager& gpsManager;
     CommManager& commManager;
     UIManager& uiManager;
     PointsManager& pointsManager;
     LocalStore& localStore;
-    
+
     SystemState currentState;
     SystemState previousState;
+
+    // Per-state timers (reset on every state entry)
     unsigned long stateStartTime;
-    unsigned long lastStateUpdate;
-    
+    unsigned long lastRefreshTime;
+    bool refreshDue;
+    bool timeoutPosted;
+
+    // Bounded event queue
+    FSMEvent eventQueue[FSM_EVENT_QUEUE_SIZE];
+    uint8_t eventHead;
+    uint8_t eventCount;
+    bool dispatching;
+
     // Current ride information
     RideInfo currentRide;
     bool hasActiveRide;
+    String lastOfferedRideId;  // QoS 1 may redeliver an offer after reconnect
     unsigned long rideNotificationTime;
     unsigned long rideAcceptTime;
     unsigned long pickupConfirmTime;
+    PointsResult lastPointsResult;
+    
+    // Next ride offered while heading to drop (single slot)
+    RideInfo nextRide;
+    bool hasNextRide;
+    bool nextRideAccepted;
+    unsigned long nextRideNotificationTime;
+    unsigned long nextRideAcceptTime;
+    uint32_t nextRideOffers;
+    uint32_t chainedRides;
     
-    // State handlers
-    void handleIdleState();
-    void handleNotifiedState();
-    void handleAcceptedState();
-    void handleEnrouteToPickupState();
-    void handleArrivedPickupState();
-    void handleRideActiveState();
-    void handleEnrouteToDropState();
-    void handleCompletedState();
-    void handleOfflineErrorState();
+    // Active ride checkpoint in NVS
+    SystemState checkpointState;    // State last persisted, STATE_IDLE = none
+    bool resumePending;             // Resume not yet reported to the backend
+    bool resumedFromCheckpoint;
+    unsigned long recoveryMs;       // Boot to first resumed screen
     
+    // Last location written to flash (idle rewrites are distance-gated)
+    double savedLat;
+    double savedLon;
+    bool hasSavedLocation;
+
+    // Guards (may publish to the backend; returning false vetoes the transition)
+    bool guardAccept();
+    bool guardReject();
+    bool guardCancel();
+    bool guardPickup();
+    bool guardDrop();
+    bool guardOnline();
+    bool guardNextRideOffer();
+    bool guardAcceptNext();
+    bool guardRejectNext();
+
+    // Transition actions
+    void actionRideExpired();
+    void actionRideRejected();
+    void actionRideCancelled();
+    void actionPickupConfirmed();
+    void actionDropConfirmed();
+    void actionResetRide();
+    void actionNextRideOffered();
+    void actionNextRideAccepted();
+    void actionNextRideRejected();
+    void actionPromoteNextRide();
+
+    // Entry actions
+    void enterIdle();
+    void enterNotified();
+    void enterAccepted();
+    void enterArrivedPickup();
+    void enterRideActive();
+    void enterCompleted();
+    void enterOfflineError();
+
+    // Refresh actions
+    void refreshIdle();
+    void refreshNotified();
+    void refreshEnrouteToPickup();
+    void refreshArrivedPickup();
+    void refreshRideActive();
+    void refreshEnrouteToDrop();
+    void refreshOfflineError();
+
     // Utility
+    bool requestPublish(const RideInfo& ride, EventType type, double lat, double lon,
+                        const char* text = "", const DropScore* score = nullptr);
+    bool queueRequest(const RideInfo& ride, EventType type, double lat, double lon,
+                      const char* text = "", const DropScore* score = nullptr);
+    void dispatch(FSMEvent event);
     void transitionToState(SystemState newState);
     void logStateTransition(SystemState from, SystemState to);
-    void parseRideNotification(const char* payload);
+    bool parseRideNotification(const char* payload, RideInfo& ride,
+                               double originLat, double originLon);
     void resetRideData();
+    void clearNextRide();
+    void checkpointRide();
+    void discardCheckpoint();
+    bool resumeRide(const RideCheckpoint& checkpoint);
+    void reportResume();
+    void recordRideHistory();
+    static uint32_t unixTimeAt(unsigned long eventMs);
     double getCurrentDistanceToPickup();
     double getCurrentDistanceToDrop();
-    void updateDisplay();
 };
 
 #endif // FSM_CONTROLLER_H
-
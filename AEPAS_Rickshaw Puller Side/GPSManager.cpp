@@ -4,9 +4,9 @@
  */
 
 #include "GPSManager.h"
-#include <math.h>
+#include "GeoDistance.h"
 
-GPSManager::GPSManager() : bufferIndex(0), bufferFilled(false), lastUpdateTime(0), lastFixTime(0) {
+GPSManager::GPSManager() : lastUpdateTime(0), lastFixTime(0), bufferIndex(0), bufferFilled(false) {
     gpsSerial = &Serial2;
     
     // Initialize buffer
@@ -37,28 +37,27 @@ void GPSManager::update() {
     // Check if we have a valid location update
     if (gps.location.isValid() && gps.location.isUpdated()) {
         if (currentTime - lastUpdateTime >= GPS_UPDATE_MIN_INTERVAL) {
-            double lat = gps.location.lat();
-            double lon = gps.location.lng();
-            
-            // Add to moving average buffer
-            addToBuffer(lat, lon);
-            
-            // Update last valid fix
-            lastValidFix.latitude = lat;
-            lastValidFix.longitude = lon;
-            lastValidFix.altitude = gps.altitude.meters();
-            lastValidFix.speed = gps.speed.mps();
-            lastValidFix.course = gps.course.deg();
-            lastValidFix.satellites = gps.satellites.value();
-            lastValidFix.hdop = gps.hdop.hdop();
-            lastValidFix.valid = true;
-            lastValidFix.timestamp = currentTime;
+            GPSData fix;
+            fix.latitude = gps.location.lat();
+            fix.longitude = gps.location.lng();
+            fix.altitude = gps.altitude.meters();
+            fix.speed = gps.speed.mps();
+            fix.course = gps.course.deg();
+            fix.satellites = gps.satellites.value();
+            fix.hdop = gps.hdop.hdop();
+            fix.valid = true;
+            fix.timestamp = currentTime;
             
             lastUpdateTime = currentTime;
             lastFixTime = currentTime;
             
+            // Hand off to the FSM/UI task
+            if (!fixQueue.push(fix)) {
+                DEBUG_PRINTLN(F("[GPS] Fix queue full, fix dropped"));
+            }
+            
             DEBUG_PRINTF("[GPS] Fix: %.6f, %.6f | Sats: %d | HDOP: %.2f\n", 
-                        lat, lon, lastValidFix.satellites, lastValidFix.hdop);
+                        fix.latitude, fix.longitude, fix.satellites, fix.hdop);
         }
     }
     
@@ -68,6 +67,15 @@ void GPSManager::update() {
     }
 }
 
+void GPSManager::processFixes() {
+    GPSData fix;
+    while (fixQueue.pop(fix)) {
+        // Add to moving average buffer
+        addToBuffer(fix.latitude, fix.longitude);
+        lastValidFix = fix;
+    }
+}
+
 bool GPSManager::isValid() const {
     return lastValidFix.valid && (millis() - lastValidFix.timestamp < GPS_FIX_TIMEOUT);
 }
@@ -116,6 +124,37 @@ unsigned long GPSManager::getFixAge() const {
     return millis() - lastValidFix.timestamp;
 }
 
+void GPSManager::setPowerSave(bool enable) {
+    // reserved1 = 8, lpMode = 1 (power save) / 0 (continuous)
+    const uint8_t payload[] = {0x08, (uint8_t)(enable ? 0x01 : 0x00)};
+    sendUBX(0x06, 0x11, payload, sizeof(payload));
+    DEBUG_PRINTF("[GPS] Power save %s\n", enable ? "ON" : "OFF");
+}
+
+void GPSManager::sendUBX(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t length) {
+    uint8_t header[] = {0xB5, 0x62, msgClass, msgId, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8)};
+    
+    // 8-bit Fletcher checksum over class, id, length and payload
+    uint8_t ckA = 0, ckB = 0;
+    for (uint8_t i = 2; i < sizeof(header); i++) {
+        ckA += header[i];
+        ckB += ckA;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        ckA += payload[i];
+        ckB += ckA;
+    }
+    
+    gpsSerial->write(header, sizeof(header));
+    gpsSerial->write(payload, length);
+    gpsSerial->write(ckA);
+    gpsSerial->write(ckB);
+}
+
+uint32_t GPSManager::getDroppedFixes() const {
+    return fixQueue.getDropped();
+}
+
 void GPSManager::addToBuffer(double lat, double lon) {
     coordBuffer[bufferIndex].lat = lat;
     coordBuffer[bufferIndex].lon = lon;
@@ -148,18 +187,8 @@ void GPSManager::calculateAveragedCoordinates(double& avgLat, double& avgLon) co
 
 // Haversine formula for distance calculation
 double GPSManager::calculateDistance(double lat1, double lon1, double lat2, double lon2) {
-    const double R = 6371000.0; // Earth radius in meters
-    
-    double dLat = (lat2 - lat1) * PI / 180.0;
-    double dLon = (lon2 - lon1) * PI / 180.0;
-    
-    double a = sin(dLat / 2.0) * sin(dLat / 2.0) +
-               cos(lat1 * PI / 180.0) * cos(lat2 * PI / 180.0) *
-               sin(dLon / 2.0) * sin(dLon / 2.0);
-    
-    double c = 2.0 * atan2(sqrt(a), sqrt(1.0 - a));
-    
-    return R * c;
+    // Shared with the host re-scoring tool (GeoDistance.h)
+    return GeoDistance::haversine(lat1, lon1, lat2, lon2);
 }
 
 double GPSManager::getETA(double targetLat, double targetLon) const {
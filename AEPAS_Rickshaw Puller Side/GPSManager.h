@@ -9,6 +9,7 @@
 #include <Arduino.h>
 #include <TinyGPS++.h>
 #include "Config.h"
+#include "SPSCQueue.h"
 
 struct GPSData {
     double latitude;
@@ -26,7 +27,8 @@ class GPSManager {
 public:
     GPSManager();
     void begin();
-    void update();
+    void update();          // Network task: parse NMEA and queue new fixes
+    void processFixes();    // FSM/UI task: apply queued fixes (getters read this state)
     
     bool isValid() const;
     bool hasFix();  // Non-const: TinyGPSPlus value() is not const
@@ -38,6 +40,10 @@ public:
     double getSpeed() const;
     uint8_t getSatellites() const;
     unsigned long getFixAge() const;
+    uint32_t getDroppedFixes() const;
+    
+    // u-blox power save mode (UBX-CFG-RXM); NMEA keeps flowing at a lower duty
+    void setPowerSave(bool enable);
     
     // Calculate distance between two points (Haversine formula)
     static double calculateDistance(double lat1, double lon1, double lat2, double lon2);
@@ -51,8 +57,15 @@ public:
     void printDebugInfo();  // Non-const: calls hasFix() which is non-const
 
 private:
+    // Network task state
     TinyGPSPlus gps;
     HardwareSerial* gpsSerial;
+    unsigned long lastUpdateTime;
+    unsigned long lastFixTime;
+    
+    SPSCQueue<GPSData, GPS_FIX_QUEUE_SIZE> fixQueue;
+    
+    // FSM/UI task state
     
     // Moving average buffer
     struct CoordSample {
@@ -65,9 +78,8 @@ private:
     bool bufferFilled;
     
     GPSData lastValidFix;
-    unsigned long lastUpdateTime;
-    unsigned long lastFixTime;
     
+    void sendUBX(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t length);
     void addToBuffer(double lat, double lon);
     void calculateAveragedCoordinates(double& avgLat, double& avgLon) const;
 };
@@ -0,0 +1,36 @@
+/*
+ * GeoDistance.h
+ * Great-circle distance between two GPS fixes
+ *
+ * Header-only and free of Arduino dependencies, like PointsFormula.h, so
+ * host tools that re-score drops measure the drop error with the exact
+ * expression GPSManager uses on the device.
+ */
+
+#ifndef GEO_DISTANCE_H
+#define GEO_DISTANCE_H
+
+#include <math.h>
+
+namespace GeoDistance {
+
+constexpr double EARTH_RADIUS_M = 6371000.0;
+constexpr double GEO_PI = 3.1415926535897932384626433832795;    // Same value as Arduino's PI
+
+// Haversine distance in meters
+inline double haversine(double lat1, double lon1, double lat2, double lon2) {
+    double dLat = (lat2 - lat1) * GEO_PI / 180.0;
+    double dLon = (lon2 - lon1) * GEO_PI / 180.0;
+    
+    double a = sin(dLat / 2.0) * sin(dLat / 2.0) +
+               cos(lat1 * GEO_PI / 180.0) * cos(lat2 * GEO_PI / 180.0) *
+               sin(dLon / 2.0) * sin(dLon / 2.0);
+    
+    double c = 2.0 * atan2(sqrt(a), sqrt(1.0 - a));
+    
+    return EARTH_RADIUS_M * c;
+}
+
+}  // namespace GeoDistance
+
+#endif // GEO_DISTANCE_H
@@ -4,8 +4,21 @@
  */
 
 #include "LocalStore.h"
+#include <esp32/rom/crc.h>
+#include <esp_system.h>
+#include <nvs.h>
 
-LocalStore::LocalStore() : initialized(false) {
+// Target of the restart hook (there is one store per unit)
+static LocalStore* shutdownStore = nullptr;
+
+LocalStore::LocalStore()
+    : initialized(false), hasLocation(false), dirtyFields(0), pendingChanges(0), dirtySince(0),
+      flashWrites(0), commits(0), checkpointSequence(0), checkpointInSlotA(false) {
+    cache.totalPoints = 0.0;
+    cache.rideCount = 0;
+    cache.lastLatitude = 0.0;
+    cache.lastLongitude = 0.0;
+    cache.lastUpdate = 0;
 }
 
 void LocalStore::begin() {
@@ -19,10 +32,11 @@ void LocalStore::begin() {
     }
     
     initialized = true;
+    loadCache();
     DEBUG_PRINTLN(F("[STORE] Local Store initialized"));
     
     // Initialize default values if not set
-    if (!hasDriverId()) {
+    if (!prefs.isKey(NVS_KEY_DRIVER_ID)) {
         setDriverId(DRIVER_ID);
         DEBUG_PRINTLN(F("[STORE] Set default driver ID"));
     }
@@ -32,96 +46,300 @@ void LocalStore::begin() {
         DEBUG_PRINTLN(F("[STORE] Set default device ID"));
     }
     
-    if (!prefs.isKey(NVS_KEY_TOTAL_POINTS)) {
-        setTotalPoints(0.0);
-        DEBUG_PRINTLN(F("[STORE] Initialized points to 0"));
-    }
-    
     if (!prefs.isKey(NVS_KEY_RIDE_COUNT)) {
         setRideCount(0);
         DEBUG_PRINTLN(F("[STORE] Initialized ride count to 0"));
     }
+    commit();
+    
+    // The float total from older firmware seeds the ledger once
+    if (ledger.begin(llroundf(cache.totalPoints * 100.0f))) {
+        cache.totalPoints = ledger.getTotalCenti() / 100.0f;
+    }
+    
+    history.begin();
+    
+    // Flush pending values on esp_restart() (OTA, watchdog-free reboots)
+    shutdownStore = this;
+    esp_register_shutdown_handler(onShutdown);
+    
+    // Pick up the checkpoint sequence so new writes land in the older slot
+    RideCheckpoint checkpoint;
+    if (loadRideCheckpoint(checkpoint)) {
+        DEBUG_PRINTF("[STORE] Active ride checkpoint found: %s\n", checkpoint.rideId);
+    }
     
     printStorageInfo();
 }
 
+void LocalStore::loadCache() {
+    cache.driverId = prefs.getString(NVS_KEY_DRIVER_ID, DRIVER_ID);
+    cache.deviceId = prefs.getString(NVS_KEY_DEVICE_ID, DEVICE_ID);
+    cache.totalPoints = prefs.getFloat(NVS_KEY_TOTAL_POINTS, 0.0);
+    cache.rideCount = prefs.getUInt(NVS_KEY_RIDE_COUNT, 0);
+    
+    hasLocation = prefs.isKey(NVS_KEY_LAST_LAT) && prefs.isKey(NVS_KEY_LAST_LON);
+    cache.lastLatitude = hasLocation ? prefs.getDouble(NVS_KEY_LAST_LAT, 0.0) : 0.0;
+    cache.lastLongitude = hasLocation ? prefs.getDouble(NVS_KEY_LAST_LON, 0.0) : 0.0;
+    cache.lastUpdate = millis();
+    
+    dirtyFields = 0;
+    pendingChanges = 0;
+}
+
+void LocalStore::markDirty(uint8_t field) {
+    if (dirtyFields == 0) {
+        dirtySince = millis();
+    }
+    dirtyFields |= field;
+    pendingChanges++;
+    cache.lastUpdate = millis();
+}
+
+void LocalStore::update() {
+    if (!initialized || dirtyFields == 0) return;
+    
+    bool due = (dirtyFields & STORE_CRITICAL_FIELDS) ||
+               pendingChanges >= STORE_COMMIT_MAX_PENDING ||
+               millis() - dirtySince >= STORE_COMMIT_INTERVAL_MS;
+    if (due) {
+        commit();
+    }
+}
+
+bool LocalStore::commit() {
+    if (!initialized || dirtyFields == 0) return true;
+    
+    // Stage every dirty field on one handle and commit them together: one
+    // nvs_commit per pass instead of one per field (Preferences commits on
+    // every put). Encodings match Preferences, so loadCache() reads them back.
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        DEBUG_PRINTF("[STORE] ERROR: nvs_open failed: %s\n", esp_err_to_name(err));
+        dirtySince = millis();
+        return false;
+    }
+    
+    // A field that fails to stage stays dirty
+    uint8_t failed = 0;
+    if (dirtyFields & FIELD_DRIVER_ID) {
+        if (nvs_set_str(handle, NVS_KEY_DRIVER_ID, cache.driverId.c_str()) != ESP_OK) failed |= FIELD_DRIVER_ID;
+        flashWrites++;
+    }
+    if (dirtyFields & FIELD_DEVICE_ID) {
+        if (nvs_set_str(handle, NVS_KEY_DEVICE_ID, cache.deviceId.c_str()) != ESP_OK) failed |= FIELD_DEVICE_ID;
+        flashWrites++;
+    }
+    if (dirtyFields & FIELD_RIDE_COUNT) {
+        if (nvs_set_u32(handle, NVS_KEY_RIDE_COUNT, cache.rideCount) != ESP_OK) failed |= FIELD_RIDE_COUNT;
+        flashWrites++;
+    }
+    if (dirtyFields & FIELD_LOCATION) {
+        if (nvs_set_blob(handle, NVS_KEY_LAST_LAT, &cache.lastLatitude, sizeof(double)) != ESP_OK ||
+            nvs_set_blob(handle, NVS_KEY_LAST_LON, &cache.lastLongitude, sizeof(double)) != ESP_OK) {
+            failed |= FIELD_LOCATION;
+        }
+        flashWrites += 2;
+    }
+    
+    // Nothing staged is durable until the commit; if it fails, all stay dirty
+    err = nvs_commit(handle);
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        failed = dirtyFields;
+    }
+    
+    commits++;
+    DEBUG_PRINTF("[STORE] Committed fields 0x%02X (%u changes)\n", dirtyFields & ~failed, pendingChanges);
+    
+    dirtyFields = failed;
+    pendingChanges = 0;
+    if (failed) {
+        DEBUG_PRINTF("[STORE] ERROR: NVS write failed for fields 0x%02X\n", failed);
+        dirtySince = millis();
+        return false;
+    }
+    return true;
+}
+
+bool LocalStore::isDirty() const {
+    return dirtyFields != 0;
+}
+
+void LocalStore::onShutdown() {
+    if (shutdownStore) {
+        shutdownStore->commit();
+    }
+}
+
 void LocalStore::setDriverId(const String& id) {
     if (!initialized) return;
-    prefs.putString(NVS_KEY_DRIVER_ID, id);
+    cache.driverId = id;
+    markDirty(FIELD_DRIVER_ID);
     DEBUG_PRINTF("[STORE] Driver ID set: %s\n", id.c_str());
 }
 
 String LocalStore::getDriverId() {
     if (!initialized) return String(DRIVER_ID);
-    return prefs.getString(NVS_KEY_DRIVER_ID, DRIVER_ID);
+    return cache.driverId;
 }
 
 void LocalStore::setDeviceId(const String& id) {
     if (!initialized) return;
-    prefs.putString(NVS_KEY_DEVICE_ID, id);
+    cache.deviceId = id;
+    markDirty(FIELD_DEVICE_ID);
     DEBUG_PRINTF("[STORE] Device ID set: %s\n", id.c_str());
 }
 
 String LocalStore::getDeviceId() {
     if (!initialized) return String(DEVICE_ID);
-    return prefs.getString(NVS_KEY_DEVICE_ID, DEVICE_ID);
+    return cache.deviceId;
 }
 
-void LocalStore::setTotalPoints(float points) {
-    if (!initialized) return;
-    prefs.putFloat(NVS_KEY_TOTAL_POINTS, points);
-    DEBUG_PRINTF("[STORE] Total points set: %.2f\n", points);
+bool LocalStore::recordRidePoints(const String& rideId, int32_t centiPoints, bool needsReview) {
+    if (!initialized) return false;
+    
+    // One journal write per award; a ride already recorded is not counted again
+    if (!ledger.append(rideId, centiPoints, needsReview ? LEDGER_FLAG_REVIEW : 0)) {
+        return false;
+    }
+    
+    cache.totalPoints = ledger.getTotalCenti() / 100.0f;
+    DEBUG_PRINTF("[STORE] Recorded %.2f points%s, new total: %.2f\n", centiPoints / 100.0,
+                 needsReview ? " (pending review)" : "", cache.totalPoints);
+    return true;
+}
+
+bool LocalStore::hasRecordedRide(const String& rideId) const {
+    return ledger.contains(rideId);
 }
 
 float LocalStore::getTotalPoints() {
     if (!initialized) return 0.0;
-    return prefs.getFloat(NVS_KEY_TOTAL_POINTS, 0.0);
+    return cache.totalPoints;
 }
 
-void LocalStore::addPoints(float points) {
-    if (!initialized) return;
-    float current = getTotalPoints();
-    float newTotal = current + points;
-    setTotalPoints(newTotal);
-    DEBUG_PRINTF("[STORE] Added %.2f points, new total: %.2f\n", points, newTotal);
+bool LocalStore::markRideSynced(const String& rideId) {
+    if (!initialized) return false;
+    return ledger.acknowledge(rideId);
+}
+
+uint32_t LocalStore::getUnsyncedLedgerEntries() const {
+    return ledger.getUnsyncedCount();
 }
 
 void LocalStore::setRideCount(uint32_t count) {
     if (!initialized) return;
-    prefs.putUInt(NVS_KEY_RIDE_COUNT, count);
+    cache.rideCount = count;
+    markDirty(FIELD_RIDE_COUNT);
     DEBUG_PRINTF("[STORE] Ride count set: %u\n", count);
 }
 
 uint32_t LocalStore::getRideCount() {
     if (!initialized) return 0;
-    return prefs.getUInt(NVS_KEY_RIDE_COUNT, 0);
+    return cache.rideCount;
 }
 
 void LocalStore::incrementRideCount() {
     if (!initialized) return;
-    uint32_t current = getRideCount();
-    setRideCount(current + 1);
-    DEBUG_PRINTF("[STORE] Ride count incremented to: %u\n", current + 1);
+    setRideCount(cache.rideCount + 1);
+    DEBUG_PRINTF("[STORE] Ride count incremented to: %u\n", cache.rideCount);
 }
 
 void LocalStore::setLastLocation(double lat, double lon) {
     if (!initialized) return;
-    prefs.putDouble(NVS_KEY_LAST_LAT, lat);
-    prefs.putDouble(NVS_KEY_LAST_LON, lon);
+    cache.lastLatitude = lat;
+    cache.lastLongitude = lon;
+    hasLocation = true;
+    markDirty(FIELD_LOCATION);
     DEBUG_PRINTF("[STORE] Last location set: %.6f, %.6f\n", lat, lon);
 }
 
 bool LocalStore::getLastLocation(double& lat, double& lon) {
+    if (!initialized || !hasLocation) return false;
+    
+    lat = cache.lastLatitude;
+    lon = cache.lastLongitude;
+    
+    return (lat != 0.0 || lon != 0.0);
+}
+
+bool LocalStore::appendRideHistory(RideRecord& record) {
+    return history.append(record);
+}
+
+uint16_t LocalStore::countRidesOnDay(uint16_t day) {
+    return history.query(day, day, nullptr, 0);
+}
+
+uint32_t LocalStore::getRideHistoryCount() const {
+    return history.getRecordCount();
+}
+
+bool LocalStore::saveRideCheckpoint(RideCheckpoint& checkpoint) {
+    if (!initialized) return false;
+    
+    // Overwrite the older slot so the newest one survives a torn write
+    const char* key = checkpointInSlotA ? NVS_KEY_RIDE_SLOT_B : NVS_KEY_RIDE_SLOT_A;
+    checkpoint.version = RIDE_CHECKPOINT_VERSION;
+    checkpoint.reserved = 0;
+    checkpoint.sequence = ++checkpointSequence;
+    checkpoint.crc = checkpointCrc(checkpoint);
+    
+    flashWrites++;
+    if (prefs.putBytes(key, &checkpoint, sizeof(checkpoint)) != sizeof(checkpoint)) {
+        DEBUG_PRINTLN(F("[STORE] ERROR: Ride checkpoint write failed"));
+        return false;
+    }
+    
+    checkpointInSlotA = !checkpointInSlotA;
+    DEBUG_PRINTF("[STORE] Ride checkpoint #%u saved (%s, state %u)\n",
+                 checkpoint.sequence, key, checkpoint.state);
+    return true;
+}
+
+bool LocalStore::loadRideCheckpoint(RideCheckpoint& checkpoint) {
     if (!initialized) return false;
     
-    if (!hasLastLocation()) {
+    RideCheckpoint slotA, slotB;
+    bool validA = readCheckpointSlot(NVS_KEY_RIDE_SLOT_A, slotA);
+    bool validB = readCheckpointSlot(NVS_KEY_RIDE_SLOT_B, slotB);
+    if (!validA && !validB) {
         return false;
     }
     
-    lat = prefs.getDouble(NVS_KEY_LAST_LAT, 0.0);
-    lon = prefs.getDouble(NVS_KEY_LAST_LON, 0.0);
+    // Signed difference keeps the comparison right across sequence wrap
+    checkpointInSlotA = validA && (!validB || (int32_t)(slotA.sequence - slotB.sequence) > 0);
+    checkpoint = checkpointInSlotA ? slotA : slotB;
+    checkpointSequence = checkpoint.sequence;
     
-    return (lat != 0.0 || lon != 0.0);
+    return checkpoint.state != STATE_IDLE;
+}
+
+void LocalStore::clearRideCheckpoint() {
+    // An idle record supersedes the ride in one write
+    RideCheckpoint checkpoint;
+    memset(&checkpoint, 0, sizeof(checkpoint));
+    checkpoint.state = STATE_IDLE;
+    saveRideCheckpoint(checkpoint);
+}
+
+bool LocalStore::readCheckpointSlot(const char* key, RideCheckpoint& checkpoint) {
+    if (!prefs.isKey(key) || prefs.getBytesLength(key) != sizeof(checkpoint)) {
+        return false;
+    }
+    
+    prefs.getBytes(key, &checkpoint, sizeof(checkpoint));
+    if (checkpoint.version != RIDE_CHECKPOINT_VERSION || checkpoint.crc != checkpointCrc(checkpoint)) {
+        DEBUG_PRINTF("[STORE] Discarding invalid ride checkpoint in %s\n", key);
+        return false;
+    }
+    return true;
+}
+
+uint32_t LocalStore::checkpointCrc(const RideCheckpoint& checkpoint) {
+    return crc32_le(0, (const uint8_t*)&checkpoint, offsetof(RideCheckpoint, crc));
 }
 
 void LocalStore::clearAll() {
@@ -129,12 +347,14 @@ void LocalStore::clearAll() {
     
     DEBUG_PRINTLN(F("[STORE] Clearing all stored data..."));
     prefs.clear();
+    ledger.clear();
+    loadCache();
     
     // Reinitialize defaults
     setDriverId(DRIVER_ID);
     setDeviceId(DEVICE_ID);
-    setTotalPoints(0.0);
     setRideCount(0);
+    commit();
     
     DEBUG_PRINTLN(F("[STORE] All data cleared and reset"));
 }
@@ -168,6 +388,10 @@ void LocalStore::printStorageInfo() {
     DEBUG_PRINTF("Device ID: %s\n", getDeviceId().c_str());
     DEBUG_PRINTF("Total Points: %.2f\n", getTotalPoints());
     DEBUG_PRINTF("Ride Count: %u\n", getRideCount());
+    ledger.printInfo();
+    history.printStats();
+    DEBUG_PRINTF("Flash Writes: %u (%u/h), %u commits, dirty 0x%02X\n",
+                 getFlashWrites(), getFlashWritesPerHour(), commits, dirtyFields);
     
     double lat, lon;
     if (getLastLocation(lat, lon)) {
@@ -181,11 +405,23 @@ void LocalStore::printStorageInfo() {
 
 bool LocalStore::hasDriverId() {
     if (!initialized) return false;
-    return prefs.isKey(NVS_KEY_DRIVER_ID);
+    return cache.driverId.length() > 0;
 }
 
 bool LocalStore::hasLastLocation() {
     if (!initialized) return false;
-    return prefs.isKey(NVS_KEY_LAST_LAT) && prefs.isKey(NVS_KEY_LAST_LON);
+    return hasLocation;
+}
+
+uint32_t LocalStore::getFlashWrites() const {
+    return flashWrites + ledger.getFlashWrites();
+}
+
+uint32_t LocalStore::getFlashWritesPerHour() const {
+    // Rate since boot; boot-time defaults count towards the first hour
+    unsigned long uptime = millis();
+    uint32_t writes = getFlashWrites();
+    if (uptime < 60000UL) return writes;
+    return (uint32_t)((uint64_t)writes * 3600000ULL / uptime);
 }
 
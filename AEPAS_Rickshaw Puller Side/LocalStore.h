@@ -1,6 +1,14 @@
 /*
  * LocalStore.h
  * Persistent storage management using NVS (Non-Volatile Storage)
+ *
+ * Values are cached in RAM and read from there. Setters only mark the field
+ * dirty; dirty fields are written together by commit() under a single
+ * nvs_commit. update() calls it on a policy: counters and IDs on the next
+ * update, the last location after STORE_COMMIT_INTERVAL_MS or
+ * STORE_COMMIT_MAX_PENDING changes. Ride completion commits directly and a
+ * shutdown handler flushes on restart. Ride checkpoints and the points
+ * ledger bypass the cache.
  */
 
 #ifndef LOCAL_STORE_H
@@ -9,6 +17,8 @@
 #include <Arduino.h>
 #include <Preferences.h>
 #include "Config.h"
+#include "PointsLedger.h"
+#include "RideHistory.h"
 
 struct PersistentData {
     String driverId;
@@ -20,11 +30,48 @@ struct PersistentData {
     unsigned long lastUpdate;
 };
 
+// Fixed-layout record for the ride in progress. Two NVS slots are written
+// alternately; on load the valid slot with the highest sequence wins, so a
+// write torn by a reset leaves the previous checkpoint intact.
+struct RideCheckpoint {
+    uint8_t version;            // RIDE_CHECKPOINT_VERSION
+    uint8_t state;              // SystemState; STATE_IDLE = no active ride
+    uint16_t reserved;
+    uint32_t sequence;          // Monotonic across both slots
+    char rideId[RIDE_ID_MAX_LEN];
+    char pickupAddress[RIDE_ADDRESS_MAX_LEN];
+    char dropAddress[RIDE_ADDRESS_MAX_LEN];
+    double pickupLat;
+    double pickupLon;
+    double dropLat;
+    double dropLon;
+    float estimatedPoints;
+    uint32_t sinceAcceptMs;     // Age of the accept at checkpoint time
+    uint32_t sincePickupMs;     // Age of the pickup, 0 = not picked up
+    uint32_t crc;               // CRC32 of all preceding bytes
+};
+
+// Dirty bits for the cached fields
+enum StoreField : uint8_t {
+    FIELD_DRIVER_ID     = 1 << 0,
+    FIELD_DEVICE_ID     = 1 << 1,
+    FIELD_RIDE_COUNT    = 1 << 2,
+    FIELD_LOCATION      = 1 << 3
+};
+
+// Fields that must not wait for the timed commit
+#define STORE_CRITICAL_FIELDS   (FIELD_DRIVER_ID | FIELD_DEVICE_ID | FIELD_RIDE_COUNT)
+
 class LocalStore {
 public:
     LocalStore();
     void begin();
     
+    // Write-back policy; call periodically
+    void update();
+    bool commit();
+    bool isDirty() const;
+    
     // Driver data
     void setDriverId(const String& id);
     String getDriverId();
@@ -32,10 +79,12 @@ public:
     void setDeviceId(const String& id);
     String getDeviceId();
     
-    // Points and rides
-    void setTotalPoints(float points);
+    // Points (journaled in the ledger) and rides
+    bool recordRidePoints(const String& rideId, int32_t centiPoints, bool needsReview);
+    bool hasRecordedRide(const String& rideId) const;
     float getTotalPoints();
-    void addPoints(float points);
+    bool markRideSynced(const String& rideId);
+    uint32_t getUnsyncedLedgerEntries() const;
     
     void setRideCount(uint32_t count);
     uint32_t getRideCount();
@@ -45,6 +94,16 @@ public:
     void setLastLocation(double lat, double lon);
     bool getLastLocation(double& lat, double& lon);
     
+    // Ride history (raw flash log)
+    bool appendRideHistory(RideRecord& record);
+    uint16_t countRidesOnDay(uint16_t day);
+    uint32_t getRideHistoryCount() const;
+    
+    // Active ride checkpoint (double-buffered)
+    bool saveRideCheckpoint(RideCheckpoint& checkpoint);
+    bool loadRideCheckpoint(RideCheckpoint& checkpoint);
+    void clearRideCheckpoint();
+    
     // Utility
     void clearAll();
     PersistentData getAllData();
@@ -53,10 +112,36 @@ public:
     // Check if data exists
     bool hasDriverId();
     bool hasLastLocation();
+    
+    // Flash wear metrics (NVS value writes, including checkpoints)
+    uint32_t getFlashWrites() const;
+    uint32_t getFlashWritesPerHour() const;
 
 private:
     Preferences prefs;
     bool initialized;
+    PointsLedger ledger;
+    RideHistory history;
+    
+    // Write-back cache
+    PersistentData cache;
+    bool hasLocation;
+    uint8_t dirtyFields;
+    uint16_t pendingChanges;        // Setter calls since the last commit
+    unsigned long dirtySince;
+    
+    uint32_t flashWrites;
+    uint32_t commits;
+    
+    uint32_t checkpointSequence;
+    bool checkpointInSlotA;     // Slot holding the newest checkpoint
+    
+    void loadCache();
+    void markDirty(uint8_t field);
+    static void onShutdown();
+    
+    bool readCheckpointSlot(const char* key, RideCheckpoint& checkpoint);
+    static uint32_t checkpointCrc(const RideCheckpoint& checkpoint);
 };
 
 #endif // LOCAL_STORE_H
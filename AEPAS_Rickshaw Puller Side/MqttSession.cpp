@@ -0,0 +1,96 @@
+/*
+ * MqttSession.cpp
+ * Implementation of the MQTT subscription table and reconnect accounting
+ */
+
+#include "MqttSession.h"
+#include <string.h>
+
+MqttSession::MqttSession()
+    : count(0), connected(false), everConnected(false), disconnectTime(0) {
+    memset(subscriptions, 0, sizeof(subscriptions));
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool MqttSession::add(const char* topic, uint8_t qos) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (strcmp(subscriptions[i].topic, topic) == 0) {
+            return true; // Already tracked
+        }
+    }
+
+    if (count >= MQTT_MAX_SUBSCRIPTIONS) {
+        return false;
+    }
+
+    subscriptions[count++] = {topic, qos, false};
+    return true;
+}
+
+void MqttSession::onConnected(unsigned long now) {
+    connected = true;
+    stats.connects++;
+
+    if (everConnected) {
+        stats.lastGapMs = now - disconnectTime;
+        if (stats.lastGapMs > stats.longestGapMs) {
+            stats.longestGapMs = stats.lastGapMs;
+        }
+    }
+    everConnected = true;
+
+    // Whether the broker kept the session is unknown, so nothing is assumed held
+    for (uint8_t i = 0; i < count; i++) {
+        subscriptions[i].active = false;
+    }
+}
+
+void MqttSession::onDisconnected(unsigned long now) {
+    if (!connected) return;
+    connected = false;
+    disconnectTime = now;
+    stats.disconnects++;
+}
+
+bool MqttSession::isConnected() const {
+    return connected;
+}
+
+uint8_t MqttSession::subscribePending(const SubscribeFn& subscribe) {
+    uint8_t pending = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        Subscription& sub = subscriptions[i];
+        if (sub.active) continue;
+
+        stats.subscribeRequests++;
+        if (subscribe(sub.topic, sub.qos)) {
+            sub.active = true;
+        } else {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+bool MqttSession::hasPending() const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (!subscriptions[i].active) return true;
+    }
+    return false;
+}
+
+uint8_t MqttSession::getCount() const {
+    return count;
+}
+
+const Subscription& MqttSession::getSubscription(uint8_t index) const {
+    return subscriptions[index < count ? index : 0];
+}
+
+void MqttSession::onMessage() {
+    stats.messagesReceived++;
+}
+
+const MqttSessionStats& MqttSession::getStats() const {
+    return stats;
+}
@@ -0,0 +1,79 @@
+/*
+ * MqttSession.h
+ * Subscription table and reconnect accounting of the persistent MQTT session
+ *
+ * Free of Arduino dependencies, like PointsFormula.h, so the host flap
+ * simulation (host/mqtt_flap) runs the same reconnect policy against a
+ * broker model. PubSubClient does not expose the CONNACK session-present
+ * flag, and a broker can lose a persistent session long before its expiry
+ * (restart without persistence, failover, a takeover by a stale client).
+ * So every tracked subscription is sent again after every CONNECT.
+ * SUBSCRIBE is idempotent for a live session and leaves queued QoS 1
+ * messages alone, so this costs one packet per topic per reconnect.
+ *
+ * Not thread-safe: only the network task touches the session. CommManager
+ * mirrors the stats for the FSM/UI task (SharedSessionStats).
+ */
+
+#ifndef MQTT_SESSION_H
+#define MQTT_SESSION_H
+
+#include <stdint.h>
+#include <functional>
+
+#define MQTT_MAX_SUBSCRIPTIONS  4   // Tracked subscriptions
+
+// Tracked MQTT subscription
+struct Subscription {
+    const char* topic;
+    uint8_t qos;
+    bool active;        // SUBSCRIBE sent on the current connection
+};
+
+// Session statistics for reconnect / missed-offer analysis
+struct MqttSessionStats {
+    uint32_t connects;          // Successful CONNECTs since boot
+    uint32_t disconnects;       // Detected connection drops
+    uint32_t subscribeRequests; // SUBSCRIBE packets actually sent
+    uint32_t messagesReceived;  // Messages delivered to the callback
+    unsigned long lastGapMs;    // Duration of the most recent offline gap
+    unsigned long longestGapMs; // Longest offline gap since boot
+};
+
+class MqttSession {
+public:
+    // Sends one SUBSCRIBE; false if it could not be sent
+    typedef std::function<bool(const char* topic, uint8_t qos)> SubscribeFn;
+
+    MqttSession();
+
+    // Track a topic (the string must outlive the session); true if already tracked
+    bool add(const char* topic, uint8_t qos);
+
+    // Connection established / lost at `now` (ms)
+    void onConnected(unsigned long now);
+    void onDisconnected(unsigned long now);
+    bool isConnected() const;
+
+    // Sends SUBSCRIBE for every topic not yet sent on this connection;
+    // returns how many are still pending (send failed)
+    uint8_t subscribePending(const SubscribeFn& subscribe);
+    bool hasPending() const;
+
+    uint8_t getCount() const;
+    const Subscription& getSubscription(uint8_t index) const;
+
+    // A message reached the MQTT callback
+    void onMessage();
+    const MqttSessionStats& getStats() const;
+
+private:
+    Subscription subscriptions[MQTT_MAX_SUBSCRIPTIONS];
+    uint8_t count;
+    bool connected;
+    bool everConnected;
+    unsigned long disconnectTime;
+    MqttSessionStats stats;
+};
+
+#endif // MQTT_SESSION_H
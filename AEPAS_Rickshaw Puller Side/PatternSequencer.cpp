@@ -0,0 +1,125 @@
+/*
+ * PatternSequencer.cpp
+ * Implementation of the timer-driven LED/buzzer pattern engine
+ */
+
+#include "PatternSequencer.h"
+
+PatternSequencer::PatternSequencer() : timer(nullptr) {
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    for (uint8_t i = 0; i < PATTERN_CHANNEL_COUNT; i++) {
+        channels[i].pin = 0;
+        channels[i].count = 0;
+        channels[i].index = 0;
+        channels[i].repeat = false;
+        channels[i].playing = false;
+        channels[i].nextEdge = 0;
+    }
+}
+
+void PatternSequencer::begin(uint8_t ledPin, uint8_t buzzerPin) {
+    channels[PATTERN_LED].pin = ledPin;
+    channels[PATTERN_BUZZER].pin = buzzerPin;
+    
+    esp_timer_create_args_t args = {};
+    args.callback = &PatternSequencer::onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "patterns";
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+        DEBUG_PRINTLN(F("[UI] ERROR: Pattern timer creation failed"));
+        timer = nullptr;
+    }
+}
+
+void PatternSequencer::play(PatternChannel channel, const uint16_t* steps, uint8_t count, bool repeat) {
+    if (channel >= PATTERN_CHANNEL_COUNT || count == 0) return;
+    if (count > PATTERN_MAX_STEPS) count = PATTERN_MAX_STEPS;
+    
+    unsigned long now = millis();
+    portENTER_CRITICAL(&lock);
+    Channel& ch = channels[channel];
+    memcpy(ch.steps, steps, count * sizeof(uint16_t));
+    ch.count = count;
+    ch.index = 0;
+    ch.repeat = repeat;
+    ch.playing = true;
+    ch.nextEdge = now + ch.steps[0];
+    digitalWrite(ch.pin, HIGH);
+    rearm(now);
+    portEXIT_CRITICAL(&lock);
+}
+
+void PatternSequencer::set(PatternChannel channel, bool on) {
+    if (channel >= PATTERN_CHANNEL_COUNT) return;
+    
+    portENTER_CRITICAL(&lock);
+    Channel& ch = channels[channel];
+    ch.playing = false;
+    digitalWrite(ch.pin, on ? HIGH : LOW);
+    rearm(millis());
+    portEXIT_CRITICAL(&lock);
+}
+
+bool PatternSequencer::isPlaying(PatternChannel channel) const {
+    if (channel >= PATTERN_CHANNEL_COUNT) return false;
+    
+    portENTER_CRITICAL(&lock);
+    bool playing = channels[channel].playing;
+    portEXIT_CRITICAL(&lock);
+    return playing;
+}
+
+void PatternSequencer::onTimer(void* arg) {
+    static_cast<PatternSequencer*>(arg)->advance();
+}
+
+void PatternSequencer::advance() {
+    unsigned long now = millis();
+    
+    portENTER_CRITICAL(&lock);
+    for (uint8_t i = 0; i < PATTERN_CHANNEL_COUNT; i++) {
+        Channel& ch = channels[i];
+        
+        // Catch up on every edge that has passed (timer may fire late)
+        while (ch.playing && (long)(now - ch.nextEdge) >= 0) {
+            ch.index++;
+            if (ch.index >= ch.count) {
+                if (!ch.repeat) {
+                    ch.playing = false;
+                    digitalWrite(ch.pin, LOW);
+                    break;
+                }
+                ch.index = 0;
+            }
+            digitalWrite(ch.pin, (ch.index & 1) ? LOW : HIGH);
+            ch.nextEdge += ch.steps[ch.index];
+        }
+    }
+    rearm(now);
+    portEXIT_CRITICAL(&lock);
+}
+
+void PatternSequencer::rearm(unsigned long now) {
+    // Caller holds the lock, so play() and the timer task can't race here
+    if (timer == nullptr) return;
+    
+    bool active = false;
+    unsigned long nearest = 0;
+    for (uint8_t i = 0; i < PATTERN_CHANNEL_COUNT; i++) {
+        const Channel& ch = channels[i];
+        if (!ch.playing) continue;
+        
+        long remaining = (long)(ch.nextEdge - now);
+        unsigned long wait = remaining > 0 ? remaining : 0;
+        if (!active || wait < nearest) {
+            nearest = wait;
+            active = true;
+        }
+    }
+    
+    esp_timer_stop(timer);
+    if (active) {
+        esp_timer_start_once(timer, (uint64_t)nearest * 1000ULL);
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * PatternSequencer.h
+ * Timer-driven on/off sequences for the status LED and buzzer
+ *
+ * A pattern is a list of step durations in ms, starting with the output on
+ * and alternating on/off. A single esp_timer one-shot is armed for the
+ * nearest step edge across all channels, so nothing in loop() has to poll
+ * or delay() and the CPU can sleep between edges.
+ */
+
+#ifndef PATTERN_SEQUENCER_H
+#define PATTERN_SEQUENCER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "Config.h"
+
+enum PatternChannel : uint8_t {
+    PATTERN_LED,
+    PATTERN_BUZZER,
+    PATTERN_CHANNEL_COUNT
+};
+
+class PatternSequencer {
+public:
+    PatternSequencer();
+    void begin(uint8_t ledPin, uint8_t buzzerPin);
+    
+    // Replace the channel's pattern (steps are copied; count <= PATTERN_MAX_STEPS)
+    void play(PatternChannel channel, const uint16_t* steps, uint8_t count, bool repeat);
+    
+    // Hold a steady level, cancelling any pattern
+    void set(PatternChannel channel, bool on);
+    bool isPlaying(PatternChannel channel) const;
+
+private:
+    struct Channel {
+        uint8_t pin;
+        uint16_t steps[PATTERN_MAX_STEPS];
+        uint8_t count;
+        uint8_t index;          // Even = on, odd = off
+        bool repeat;
+        bool playing;
+        unsigned long nextEdge;
+    };
+    
+    Channel channels[PATTERN_CHANNEL_COUNT];
+    esp_timer_handle_t timer;
+    mutable portMUX_TYPE lock;  // loop() and the esp_timer task run on different cores
+    
+    static void onTimer(void* arg);
+    void advance();
+    void rearm(unsigned long now);
+};
+
+#endif // PATTERN_SEQUENCER_H
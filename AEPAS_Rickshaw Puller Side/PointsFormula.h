@@ -0,0 +1,89 @@
+/*
+ * PointsFormula.h
+ * Fixed-point points formula and review thresholds
+ *
+ * Header-only and free of Arduino dependencies so the backend (or a host
+ * re-scoring tool) can compile the exact same arithmetic. Inputs are
+ * quantized once: distances to centimetres and GPS accuracy to hundredths,
+ * rounded half away from zero. Everything after that is integer maths, so
+ * the same inputs give the same award on every platform.
+ *
+ *   points = max(POINTS_MIN, POINTS_BASE - distance / POINTS_DIST_DIVISOR)
+ *
+ * On the device the parameters come from Config.h; host builds define
+ * POINTS_BASE, POINTS_DIST_DIVISOR, POINTS_MIN, DISTANCE_ADMIN_REVIEW and
+ * GPS_ACCURACY_THRESHOLD themselves. All functions are C++11 constexpr.
+ */
+
+#ifndef POINTS_FORMULA_H
+#define POINTS_FORMULA_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include "Config.h"
+#endif
+
+namespace PointsFormula {
+
+enum Review : uint8_t {
+    REVIEW_NONE,
+    REVIEW_GPS_ACCURACY,        // Fix too poor to trust the drop position
+    REVIEW_DROP_DISTANCE        // Drop further than DISTANCE_ADMIN_REVIEW from the expected point
+};
+
+struct Award {
+    int32_t centiPoints;        // Points x 100
+    Review review;
+};
+
+// Quantization: value x scale, rounded half away from zero
+constexpr int32_t quantize(double value, int32_t scale) {
+    return (int32_t)(value * scale + (value < 0 ? -0.5 : 0.5));
+}
+
+constexpr int32_t toCentimetres(double meters) {
+    return quantize(meters, 100);
+}
+
+constexpr int32_t toCenti(double value) {
+    return quantize(value, 100);
+}
+
+// Parameters in fixed point
+constexpr int32_t BASE_CENTI = toCenti(POINTS_BASE);
+constexpr int32_t MIN_CENTI = toCenti(POINTS_MIN);
+constexpr int32_t DIVISOR_CM = toCentimetres(POINTS_DIST_DIVISOR);
+constexpr int32_t REVIEW_CM = toCentimetres(DISTANCE_ADMIN_REVIEW);
+constexpr int32_t ACCURACY_LIMIT_CENTI = toCenti(GPS_ACCURACY_THRESHOLD);
+
+static_assert(DIVISOR_CM > 0, "POINTS_DIST_DIVISOR must be positive");
+
+// Penalty in centi-points: distanceCm / DIVISOR_CM points, rounded half up
+constexpr int32_t penaltyCenti(int32_t distanceCm) {
+    return (int32_t)(((int64_t)distanceCm * 100 + DIVISOR_CM / 2) / DIVISOR_CM);
+}
+
+constexpr int32_t pointsCenti(int32_t distanceCm) {
+    return BASE_CENTI - penaltyCenti(distanceCm) > MIN_CENTI
+               ? BASE_CENTI - penaltyCenti(distanceCm)
+               : MIN_CENTI;
+}
+
+// Final award for a drop; rides held for review award nothing until approved
+constexpr Award score(int32_t dropErrorCm, int32_t accuracyCenti) {
+    return accuracyCenti > ACCURACY_LIMIT_CENTI ? Award{0, REVIEW_GPS_ACCURACY}
+         : dropErrorCm > REVIEW_CM              ? Award{0, REVIEW_DROP_DISTANCE}
+         : Award{pointsCenti(dropErrorCm), REVIEW_NONE};
+}
+
+// Spot checks that hold for any parameter set
+static_assert(pointsCenti(0) == (BASE_CENTI > MIN_CENTI ? BASE_CENTI : MIN_CENTI), "No penalty at zero distance");
+static_assert(pointsCenti(DIVISOR_CM) == pointsCenti(0) - 100 || pointsCenti(DIVISOR_CM) == MIN_CENTI,
+              "One divisor of distance costs one point");
+static_assert(score(0, ACCURACY_LIMIT_CENTI + 1).review == REVIEW_GPS_ACCURACY, "Poor fix goes to review");
+static_assert(score(REVIEW_CM + 1, 0).review == REVIEW_DROP_DISTANCE, "Far drop goes to review");
+
+}  // namespace PointsFormula
+
+#endif // POINTS_FORMULA_H
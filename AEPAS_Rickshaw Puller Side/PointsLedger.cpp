@@ -0,0 +1,354 @@
+/*
+ * PointsLedger.cpp
+ * Implementation of the append-only points journal
+ */
+
+#include "PointsLedger.h"
+#include <esp32/rom/crc.h>
+#include <time.h>
+
+static_assert(LEDGER_CHECKPOINT_INTERVAL < LEDGER_CAPACITY,
+              "Entries must be checkpointed before their slot is reused");
+static_assert(LEDGER_CAPACITY < 0xFF, "Index stores slot + 1 in a byte");
+static_assert(LEDGER_INDEX_SIZE > LEDGER_CAPACITY && (LEDGER_INDEX_SIZE & (LEDGER_INDEX_SIZE - 1)) == 0,
+              "Index size must be a power of two larger than the ledger");
+
+#define INDEX_EMPTY             0
+#define INDEX_DELETED           0xFF
+
+PointsLedger::PointsLedger()
+    : initialized(false), indexTombstones(0), headSequence(0), totalCenti(0),
+      checkpointSequence(0), checkpointInSlotA(false), syncedSequence(0), flashWrites(0) {
+    memset(entries, 0, sizeof(entries));
+    memset(index, 0, sizeof(index));
+}
+
+bool PointsLedger::begin(int64_t legacyCenti) {
+    if (!prefs.begin(NVS_LEDGER_NAMESPACE, false)) {
+        DEBUG_PRINTLN(F("[LEDGER] ERROR: Failed to open NVS namespace"));
+        return false;
+    }
+    initialized = true;
+    
+    // Running total up to the newest valid checkpoint
+    LedgerCheckpoint slotA, slotB;
+    bool validA = readCheckpointSlot(NVS_KEY_LEDGER_CKPT_A, slotA);
+    bool validB = readCheckpointSlot(NVS_KEY_LEDGER_CKPT_B, slotB);
+    if (validA || validB) {
+        checkpointInSlotA = validA && (!validB || (int32_t)(slotA.sequence - slotB.sequence) > 0);
+        const LedgerCheckpoint& checkpoint = checkpointInSlotA ? slotA : slotB;
+        checkpointSequence = checkpoint.sequence;
+        totalCenti = checkpoint.totalCenti;
+    }
+    
+    // Load the ring; slots that fail CRC or sit in the wrong place stay empty
+    char key[8];
+    for (uint8_t slot = 0; slot < LEDGER_CAPACITY; slot++) {
+        slotKey(slot, key);
+        LedgerEntry& entry = entries[slot];
+        if (prefs.getBytesLength(key) != sizeof(entry) ||
+            prefs.getBytes(key, &entry, sizeof(entry)) != sizeof(entry) ||
+            entry.crc != entryCrc(entry) || entry.sequence % LEDGER_CAPACITY != slot) {
+            memset(&entry, 0, sizeof(entry));
+        }
+    }
+    
+    // Replay the entries after the checkpoint in order, stopping at the first gap
+    headSequence = checkpointSequence;
+    for (;;) {
+        const LedgerEntry& entry = entries[(headSequence + 1) % LEDGER_CAPACITY];
+        if (entry.sequence != headSequence + 1) break;
+        if (!(entry.flags & LEDGER_FLAG_REVIEW)) {
+            totalCenti += entry.centiPoints;
+        }
+        headSequence++;
+    }
+    
+    // Anything past a gap is unreachable; drop it so a later replay can't pick it up
+    for (uint8_t slot = 0; slot < LEDGER_CAPACITY; slot++) {
+        if ((int32_t)(entries[slot].sequence - headSequence) > 0) {
+            DEBUG_PRINTF("[LEDGER] Discarding orphaned entry #%u\n", entries[slot].sequence);
+            slotKey(slot, key);
+            prefs.remove(key);
+            memset(&entries[slot], 0, sizeof(entries[slot]));
+        }
+    }
+    
+    if (!validA && !validB && headSequence == 0) {
+        // First boot with a ledger: carry over the old float total once
+        totalCenti = legacyCenti;
+        writeCheckpoint();
+        DEBUG_PRINTF("[LEDGER] Created, opening balance %.2f\n", legacyCenti / 100.0);
+    }
+    
+    syncedSequence = prefs.getUInt(NVS_KEY_LEDGER_SYNC, 0);
+    if ((int32_t)(syncedSequence - headSequence) > 0) {
+        syncedSequence = headSequence;
+    }
+    
+    rebuildIndex();
+    advanceSyncCursor();     // Acks flagged before a reset cut the cursor write short
+    return true;
+}
+
+bool PointsLedger::append(const String& rideId, int32_t centiPoints, uint8_t flags) {
+    if (!initialized) return false;
+    
+    uint32_t rideHash = hashRideId(rideId);
+    if (findSlot(rideHash) >= 0) {
+        DEBUG_PRINTF("[LEDGER] Ride %s already recorded\n", rideId.c_str());
+        return false;
+    }
+    
+    // The slot about to be reused must already be covered by a checkpoint
+    if (headSequence + 1 - checkpointSequence > LEDGER_CAPACITY && !writeCheckpoint()) {
+        DEBUG_PRINTLN(F("[LEDGER] ERROR: Checkpoint overdue, append refused"));
+        return false;
+    }
+    
+    LedgerEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.sequence = headSequence + 1;
+    entry.rideHash = rideHash;
+    entry.centiPoints = centiPoints;
+    time_t now = time(nullptr);
+    entry.timestamp = now > (time_t)CLOCK_VALID_AFTER ? (uint32_t)now : 0;
+    entry.flags = flags;
+    entry.crc = entryCrc(entry);
+    
+    uint8_t slot = entry.sequence % LEDGER_CAPACITY;
+    char key[8];
+    slotKey(slot, key);
+    flashWrites++;
+    if (prefs.putBytes(key, &entry, sizeof(entry)) != sizeof(entry)) {
+        DEBUG_PRINTLN(F("[LEDGER] ERROR: Entry write failed"));
+        return false;
+    }
+    
+    if (entries[slot].sequence != 0) {
+        indexRemove(entries[slot].rideHash, slot);
+    }
+    entries[slot] = entry;
+    indexInsert(rideHash, slot);
+    
+    // Tombstones lengthen probes; rebuilding now and then keeps lookups O(1) amortised
+    if (indexTombstones > LEDGER_CAPACITY / 2) {
+        rebuildIndex();
+    }
+    headSequence = entry.sequence;
+    if (!(flags & LEDGER_FLAG_REVIEW)) {
+        totalCenti += centiPoints;
+    }
+    
+    DEBUG_PRINTF("[LEDGER] #%u %s %+.2f%s\n", entry.sequence, rideId.c_str(), centiPoints / 100.0,
+                 (flags & LEDGER_FLAG_REVIEW) ? " (review)" : "");
+    
+    if (headSequence - checkpointSequence >= LEDGER_CHECKPOINT_INTERVAL) {
+        writeCheckpoint();
+    }
+    return true;
+}
+
+bool PointsLedger::contains(const String& rideId) const {
+    return findSlot(hashRideId(rideId)) >= 0;
+}
+
+int64_t PointsLedger::getTotalCenti() const {
+    return totalCenti;
+}
+
+uint32_t PointsLedger::getHeadSequence() const {
+    return headSequence;
+}
+
+uint32_t PointsLedger::getSyncedSequence() const {
+    return syncedSequence;
+}
+
+uint32_t PointsLedger::getUnsyncedCount() const {
+    return headSequence - syncedSequence;
+}
+
+bool PointsLedger::getEntry(uint32_t sequence, LedgerEntry& entry) const {
+    const LedgerEntry& stored = entries[sequence % LEDGER_CAPACITY];
+    if (sequence == 0 || stored.sequence != sequence) return false;
+    entry = stored;
+    return true;
+}
+
+bool PointsLedger::acknowledge(const String& rideId) {
+    if (!initialized) return false;
+    
+    int16_t slot = findSlot(hashRideId(rideId));
+    if (slot < 0) {
+        DEBUG_PRINTF("[LEDGER] Ack for ride %s not in the ledger\n", rideId.c_str());
+        return false;
+    }
+    
+    LedgerEntry& entry = entries[slot];
+    if ((entry.flags & LEDGER_FLAG_SYNCED) || (int32_t)(entry.sequence - syncedSequence) <= 0) {
+        return true;    // Repeated ack
+    }
+    
+    // Flag the entry itself so an ack that arrives out of order isn't lost
+    LedgerEntry updated = entry;
+    updated.flags |= LEDGER_FLAG_SYNCED;
+    updated.crc = entryCrc(updated);
+    
+    char key[8];
+    slotKey(slot, key);
+    flashWrites++;
+    if (prefs.putBytes(key, &updated, sizeof(updated)) != sizeof(updated)) {
+        DEBUG_PRINTLN(F("[LEDGER] ERROR: Ack write failed"));
+        return false;
+    }
+    entry = updated;
+    
+    advanceSyncCursor();
+    return true;
+}
+
+void PointsLedger::advanceSyncCursor() {
+    uint32_t sequence = syncedSequence;
+    
+    // Entries already overwritten in the ring can never be acked
+    if (headSequence - sequence > LEDGER_CAPACITY) {
+        DEBUG_PRINTF("[LEDGER] %u unacked entries left the ring\n",
+                     headSequence - sequence - LEDGER_CAPACITY);
+        sequence = headSequence - LEDGER_CAPACITY;
+    }
+    
+    LedgerEntry entry;
+    while (getEntry(sequence + 1, entry) && (entry.flags & LEDGER_FLAG_SYNCED)) {
+        sequence++;
+    }
+    if (sequence == syncedSequence) return;
+    
+    syncedSequence = sequence;
+    flashWrites++;
+    prefs.putUInt(NVS_KEY_LEDGER_SYNC, syncedSequence);
+}
+
+void PointsLedger::clear() {
+    if (!initialized) return;
+    
+    prefs.clear();
+    memset(entries, 0, sizeof(entries));
+    headSequence = 0;
+    totalCenti = 0;
+    checkpointSequence = 0;
+    syncedSequence = 0;
+    rebuildIndex();
+    writeCheckpoint();
+}
+
+uint32_t PointsLedger::getFlashWrites() const {
+    return flashWrites;
+}
+
+void PointsLedger::printInfo() {
+    DEBUG_PRINTF("Ledger: %u entries, total %.2f, checkpoint #%u, unsynced %u\n",
+                 headSequence, totalCenti / 100.0, checkpointSequence, getUnsyncedCount());
+}
+
+uint32_t PointsLedger::hashRideId(const String& rideId) {
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < rideId.length(); i++) {
+        hash ^= (uint8_t)rideId[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+bool PointsLedger::writeCheckpoint() {
+    // Overwrite the older slot so the newest one survives a torn write
+    const char* key = checkpointInSlotA ? NVS_KEY_LEDGER_CKPT_B : NVS_KEY_LEDGER_CKPT_A;
+    LedgerCheckpoint checkpoint;
+    memset(&checkpoint, 0, sizeof(checkpoint));
+    checkpoint.sequence = headSequence;
+    checkpoint.totalCenti = totalCenti;
+    checkpoint.crc = checkpointCrc(checkpoint);
+    
+    flashWrites++;
+    if (prefs.putBytes(key, &checkpoint, sizeof(checkpoint)) != sizeof(checkpoint)) {
+        DEBUG_PRINTLN(F("[LEDGER] ERROR: Checkpoint write failed"));
+        return false;
+    }
+    
+    checkpointInSlotA = !checkpointInSlotA;
+    checkpointSequence = headSequence;
+    return true;
+}
+
+bool PointsLedger::readCheckpointSlot(const char* key, LedgerCheckpoint& checkpoint) {
+    if (!prefs.isKey(key) || prefs.getBytesLength(key) != sizeof(checkpoint)) {
+        return false;
+    }
+    
+    prefs.getBytes(key, &checkpoint, sizeof(checkpoint));
+    if (checkpoint.crc != checkpointCrc(checkpoint)) {
+        DEBUG_PRINTF("[LEDGER] Discarding invalid checkpoint in %s\n", key);
+        return false;
+    }
+    return true;
+}
+
+int16_t PointsLedger::findSlot(uint32_t rideHash) const {
+    uint16_t pos = rideHash & (LEDGER_INDEX_SIZE - 1);
+    for (uint16_t probes = 0; probes < LEDGER_INDEX_SIZE; probes++) {
+        uint8_t value = index[pos];
+        if (value == INDEX_EMPTY) return -1;
+        if (value != INDEX_DELETED && entries[value - 1].rideHash == rideHash) {
+            return value - 1;
+        }
+        pos = (pos + 1) & (LEDGER_INDEX_SIZE - 1);
+    }
+    return -1;
+}
+
+void PointsLedger::indexInsert(uint32_t rideHash, uint8_t slot) {
+    uint16_t pos = rideHash & (LEDGER_INDEX_SIZE - 1);
+    while (index[pos] != INDEX_EMPTY && index[pos] != INDEX_DELETED) {
+        pos = (pos + 1) & (LEDGER_INDEX_SIZE - 1);
+    }
+    if (index[pos] == INDEX_DELETED) {
+        indexTombstones--;
+    }
+    index[pos] = slot + 1;
+}
+
+void PointsLedger::indexRemove(uint32_t rideHash, uint8_t slot) {
+    uint16_t pos = rideHash & (LEDGER_INDEX_SIZE - 1);
+    for (uint16_t probes = 0; probes < LEDGER_INDEX_SIZE; probes++) {
+        if (index[pos] == INDEX_EMPTY) return;
+        if (index[pos] == slot + 1) {
+            index[pos] = INDEX_DELETED;
+            indexTombstones++;
+            return;
+        }
+        pos = (pos + 1) & (LEDGER_INDEX_SIZE - 1);
+    }
+}
+
+void PointsLedger::rebuildIndex() {
+    memset(index, INDEX_EMPTY, sizeof(index));
+    indexTombstones = 0;
+    for (uint8_t slot = 0; slot < LEDGER_CAPACITY; slot++) {
+        if (entries[slot].sequence != 0) {
+            indexInsert(entries[slot].rideHash, slot);
+        }
+    }
+}
+
+void PointsLedger::slotKey(uint8_t slot, char* key) {
+    snprintf(key, 8, "e%u", slot);
+}
+
+uint32_t PointsLedger::entryCrc(const LedgerEntry& entry) {
+    return crc32_le(0, (const uint8_t*)&entry, offsetof(LedgerEntry, crc));
+}
+
+uint32_t PointsLedger::checkpointCrc(const LedgerCheckpoint& checkpoint) {
+    return crc32_le(0, (const uint8_t*)&checkpoint, offsetof(LedgerCheckpoint, crc));
+}
@@ -0,0 +1,101 @@
+/*
+ * PointsLedger.h
+ * Append-only journal of awarded points
+ *
+ * Each completed ride appends one CRC-protected entry (ride ID hash, points
+ * in hundredths, timestamp, review flag) to a ring of LEDGER_CAPACITY NVS
+ * records. Amounts are integers, so the total does not drift, and an award
+ * is a single write, so a reset cannot lose half of it. Every
+ * LEDGER_CHECKPOINT_INTERVAL entries the running total is checkpointed into
+ * one of two alternating slots; on boot the total is the newest valid
+ * checkpoint plus the entries after it. A RAM hash index over the retained
+ * entries answers "is this ride already recorded" in O(1), and a persisted
+ * sync cursor marks how far delivery is confirmed: each ack flags its entry,
+ * and the cursor moves over the acked entries in order. An ack is the
+ * backend's ack of the drop confirmation or, failing that, the broker
+ * echoing the probe published after it (see CommManager).
+ */
+
+#ifndef POINTS_LEDGER_H
+#define POINTS_LEDGER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "Config.h"
+
+#define LEDGER_FLAG_REVIEW      0x01    // Awaiting backend review; not in the total
+#define LEDGER_FLAG_SYNCED      0x02    // Drop confirmation acked by the backend or broker
+
+struct LedgerEntry {
+    uint32_t sequence;          // 1-based, 0 = empty slot
+    uint32_t rideHash;          // FNV-1a of the ride ID
+    int32_t centiPoints;        // Points x 100
+    uint32_t timestamp;         // Unix time when the clock is set, else 0
+    uint8_t flags;
+    uint8_t reserved[3];
+    uint32_t crc;               // CRC32 of all preceding bytes
+};
+
+struct LedgerCheckpoint {
+    uint32_t sequence;          // Last entry included in the total
+    uint32_t reserved;
+    int64_t totalCenti;
+    uint32_t crc;
+};
+
+class PointsLedger {
+public:
+    PointsLedger();
+    
+    // legacyCenti seeds the total when no ledger exists yet (float-total migration)
+    bool begin(int64_t legacyCenti);
+    
+    // Returns false for a ride already in the ledger or a failed write
+    bool append(const String& rideId, int32_t centiPoints, uint8_t flags);
+    bool contains(const String& rideId) const;
+    
+    int64_t getTotalCenti() const;
+    uint32_t getHeadSequence() const;
+    
+    // Backend sync cursor
+    uint32_t getSyncedSequence() const;
+    uint32_t getUnsyncedCount() const;
+    bool getEntry(uint32_t sequence, LedgerEntry& entry) const;
+    bool acknowledge(const String& rideId);
+    
+    void clear();
+    uint32_t getFlashWrites() const;
+    void printInfo();
+    
+    static uint32_t hashRideId(const String& rideId);
+
+private:
+    Preferences prefs;
+    bool initialized;
+    
+    LedgerEntry entries[LEDGER_CAPACITY];   // RAM mirror of the NVS ring
+    uint8_t index[LEDGER_INDEX_SIZE];       // rideHash -> slot + 1 (0 empty, 0xFF deleted)
+    uint16_t indexTombstones;
+    
+    uint32_t headSequence;
+    int64_t totalCenti;
+    uint32_t checkpointSequence;
+    bool checkpointInSlotA;     // Slot holding the newest checkpoint
+    uint32_t syncedSequence;
+    uint32_t flashWrites;
+    
+    bool writeCheckpoint();
+    void advanceSyncCursor();
+    bool readCheckpointSlot(const char* key, LedgerCheckpoint& checkpoint);
+    
+    int16_t findSlot(uint32_t rideHash) const;
+    void indexInsert(uint32_t rideHash, uint8_t slot);
+    void indexRemove(uint32_t rideHash, uint8_t slot);
+    void rebuildIndex();
+    
+    static void slotKey(uint8_t slot, char* key);
+    static uint32_t entryCrc(const LedgerEntry& entry);
+    static uint32_t checkpointCrc(const LedgerCheckpoint& checkpoint);
+};
+
+#endif // POINTS_LEDGER_H
@@ -5,7 +5,10 @@
 
 #include "PointsManager.h"
 
-PointsManager::PointsManager() {
+PointsManager::PointsManager()
+    : tripActive(false), hasAnchor(false), tripStartMs(0), lastFixMs(0),
+      filteredLat(0), filteredLon(0), anchorLat(0), anchorLon(0), anchorMs(0),
+      tripDistance(0), tripJumpsRejected(0) {
 }
 
 float PointsManager::calculateEstimatedPoints(double pickupLat, double pickupLon, 
@@ -14,7 +17,7 @@ float PointsManager::calculateEstimatedPoints(double pickupLat, double pickupLon
     double distance = GPSManager::calculateDistance(currentLat, currentLon, pickupLat, pickupLon);
     
     // Apply points formula
-    return applyPointsFormula(distance);
+    return applyPointsFormula(distance) / 100.0f;
 }
 
 PointsResult PointsManager::calculateFinalPoints(double expectedDropLat, double expectedDropLon,
@@ -24,6 +27,15 @@ PointsResult PointsManager::calculateFinalPoints(double expectedDropLat, double
     result.gpsAccuracy = gpsAccuracy;
     result.needsReview = false;
     result.reason = "OK";
+    result.centiPoints = 0;
+    result.points = 0.0;
+    
+    // Trip summary (informational; the award still depends on the drop error)
+    result.rideDistance = tripDistance;
+    result.rideDurationMs = tripActive ? millis() - tripStartMs : 0;
+    result.averageSpeed = result.rideDurationMs > 0 ? tripDistance / (result.rideDurationMs / 1000.0) : 0.0;
+    DEBUG_PRINTF("[POINTS] Trip: %.0f m in %lu s (avg %.1f m/s, %u jumps rejected)\n",
+                 result.rideDistance, result.rideDurationMs / 1000, result.averageSpeed, tripJumpsRejected);
     
     // Calculate actual distance error from expected drop location
     result.actualDistance = GPSManager::calculateDistance(
@@ -34,27 +46,29 @@ PointsResult PointsManager::calculateFinalPoints(double expectedDropLat, double
     DEBUG_PRINTF("[POINTS] Drop distance error: %.2f m\n", result.actualDistance);
     DEBUG_PRINTF("[POINTS] GPS accuracy: %.2f m\n", gpsAccuracy);
     
-    // Check GPS accuracy
-    if (!isGPSAccuracyAcceptable(gpsAccuracy)) {
-        result.needsReview = true;
-        result.reason = "GPS accuracy poor";
-        result.points = 0.0;
-        DEBUG_PRINTLN(F("[POINTS] GPS accuracy unacceptable, needs review"));
-        return result;
-    }
-    
-    // Check if drop location is within acceptable range
-    if (result.actualDistance > DISTANCE_ADMIN_REVIEW) {
-        result.needsReview = true;
-        result.reason = "Drop location far from expected";
-        result.points = 0.0;
-        DEBUG_PRINTLN(F("[POINTS] Distance error too large, needs review"));
-        return result;
+    // Review thresholds and formula in fixed point, so the backend can reproduce the award
+    result.dropErrorCm = PointsFormula::toCentimetres(result.actualDistance);
+    result.accuracyCenti = PointsFormula::toCenti(gpsAccuracy);
+    PointsFormula::Award award = PointsFormula::score(result.dropErrorCm, result.accuracyCenti);
+    result.review = award.review;
+    switch (award.review) {
+        case PointsFormula::REVIEW_GPS_ACCURACY:
+            result.needsReview = true;
+            result.reason = "GPS accuracy poor";
+            DEBUG_PRINTLN(F("[POINTS] GPS accuracy unacceptable, needs review"));
+            return result;
+        case PointsFormula::REVIEW_DROP_DISTANCE:
+            result.needsReview = true;
+            result.reason = "Drop location far from expected";
+            DEBUG_PRINTLN(F("[POINTS] Distance error too large, needs review"));
+            return result;
+        default:
+            break;
     }
     
-    // Calculate points based on distance error
     // Points Formula: BasePoints - (ActualDistance / 10m)
-    result.points = applyPointsFormula(result.actualDistance);
+    result.centiPoints = award.centiPoints;
+    result.points = award.centiPoints / 100.0f;
     
     DEBUG_PRINTF("[POINTS] Final points: %.2f\n", result.points);
     
@@ -86,7 +100,7 @@ bool PointsManager::validateDropLocation(double expectedLat, double expectedLon,
 }
 
 bool PointsManager::isGPSAccuracyAcceptable(double accuracy) {
-    return accuracy <= GPS_ACCURACY_THRESHOLD;
+    return PointsFormula::toCenti(accuracy) <= PointsFormula::ACCURACY_LIMIT_CENTI;
 }
 
 String PointsManager::getPointsBreakdown(const PointsResult& result) {
@@ -98,6 +112,11 @@ String PointsManager::getPointsBreakdown(const PointsResult& result) {
     breakdown += "\nGPS accuracy: ";
     breakdown += String(result.gpsAccuracy, 1);
     breakdown += " m";
+    breakdown += "\nTrip: ";
+    breakdown += String(result.rideDistance, 0);
+    breakdown += " m, ";
+    breakdown += String(result.rideDurationMs / 1000);
+    breakdown += " s";
     
     if (result.needsReview) {
         breakdown += "\nStatus: PENDING REVIEW";
@@ -110,16 +129,68 @@ String PointsManager::getPointsBreakdown(const PointsResult& result) {
     return breakdown;
 }
 
-float PointsManager::applyPointsFormula(double distanceMeters) {
-    // Formula: FinalPoints = max(0, BasePoints - (ActualDistance / 10m))
-    float penalty = distanceMeters / POINTS_DIST_DIVISOR;
-    float points = POINTS_BASE - penalty;
+void PointsManager::startTrip(unsigned long startMs) {
+    resetTrip();
+    tripActive = true;
+    tripStartMs = startMs;
+}
+
+void PointsManager::addFix(const GPSData& fix) {
+    if (!tripActive || !fix.valid || fix.timestamp == lastFixMs) return;
+    lastFixMs = fix.timestamp;
+    
+    if (!hasAnchor) {
+        filteredLat = anchorLat = fix.latitude;
+        filteredLon = anchorLon = fix.longitude;
+        anchorMs = fix.timestamp;
+        hasAnchor = true;
+        return;
+    }
+    
+    filteredLat += TRIP_SMOOTHING * (fix.latitude - filteredLat);
+    filteredLon += TRIP_SMOOTHING * (fix.longitude - filteredLon);
+    
+    // Movement only counts once it leaves the jitter radius around the last
+    // counted point, so a parked rickshaw accumulates nothing
+    double step = GPSManager::calculateDistance(anchorLat, anchorLon, filteredLat, filteredLon);
+    double radius = max(TRIP_MIN_STEP_M, fix.hdop * TRIP_HDOP_STEP_M);
+    if (step < radius) return;
+    
+    // A step faster than a rickshaw can go is a position jump, not travel
+    double seconds = (fix.timestamp - anchorMs) / 1000.0;
+    if (seconds > 0 && step / seconds > TRIP_MAX_SPEED_MPS) {
+        tripJumpsRejected++;
+        filteredLat = anchorLat;
+        filteredLon = anchorLon;
+        return;
+    }
     
-    // Ensure points don't go negative
-    points = max(points, (float)POINTS_MIN);
+    tripDistance += step;
+    anchorLat = filteredLat;
+    anchorLon = filteredLon;
+    anchorMs = fix.timestamp;
+}
+
+void PointsManager::resetTrip() {
+    tripActive = false;
+    hasAnchor = false;
+    tripStartMs = 0;
+    lastFixMs = 0;
+    tripDistance = 0;
+    tripJumpsRejected = 0;
+}
+
+double PointsManager::getTripDistance() const {
+    return tripDistance;
+}
+
+int32_t PointsManager::applyPointsFormula(double distanceMeters) {
+    // Formula: FinalPoints = max(0, BasePoints - (ActualDistance / 10m)), in hundredths
+    int32_t distanceCm = PointsFormula::toCentimetres(distanceMeters);
+    int32_t points = PointsFormula::pointsCenti(distanceCm);
     
-    DEBUG_PRINTF("[POINTS] Distance: %.2f m, Penalty: %.2f, Points: %.2f\n", 
-                distanceMeters, penalty, points);
+    DEBUG_PRINTF("[POINTS] Distance: %.2f m, Penalty: %.2f, Points: %.2f\n",
+                 distanceMeters, PointsFormula::penaltyCenti(distanceCm) / 100.0, points / 100.0);
     
     return points;
 }
@@ -9,13 +9,25 @@
 #include <Arduino.h>
 #include "Config.h"
 #include "GPSManager.h"
+#include "PointsFormula.h"
 
 struct PointsResult {
-    float points;
+    float points;               // centiPoints / 100, for display
+    int32_t centiPoints;        // Exact award (PointsFormula)
     bool needsReview;
     String reason;
-    double actualDistance;
+    double actualDistance;      // Drop error from the expected drop point
     double gpsAccuracy;
+    
+    // Exact formula inputs, for re-scoring off the device
+    int32_t dropErrorCm;
+    int32_t accuracyCenti;
+    PointsFormula::Review review;
+    
+    // Trip odometer (pickup -> drop)
+    double rideDistance;        // Filtered path length, meters
+    unsigned long rideDurationMs;
+    double averageSpeed;        // m/s
 };
 
 class PointsManager {
@@ -41,9 +53,28 @@ public:
     
     // Get points breakdown for display
     String getPointsBreakdown(const PointsResult& result);
+    
+    // Trip odometer: O(1) per fix, no trace kept
+    void startTrip(unsigned long startMs);
+    void addFix(const GPSData& fix);
+    void resetTrip();
+    double getTripDistance() const;
 
 private:
-    float applyPointsFormula(double distanceMeters);
+    int32_t applyPointsFormula(double distanceMeters);
+    
+    // Trip odometer state
+    bool tripActive;
+    bool hasAnchor;
+    unsigned long tripStartMs;
+    unsigned long lastFixMs;
+    double filteredLat;         // Smoothed position
+    double filteredLon;
+    double anchorLat;           // Last position counted into the distance
+    double anchorLon;
+    unsigned long anchorMs;
+    double tripDistance;
+    uint32_t tripJumpsRejected;
 };
 
 #endif // POINTS_MANAGER_H
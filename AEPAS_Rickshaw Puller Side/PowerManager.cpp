@@ -0,0 +1,215 @@
+/*
+ * PowerManager.cpp
+ * Implementation of the idle power mode
+ */
+
+#include "PowerManager.h"
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_wifi.h>
+#include <driver/gpio.h>
+
+static const uint8_t BUTTON_PINS[] = {BTN_ACCEPT_PIN, BTN_REJECT_PIN, BTN_PICKUP_PIN, BTN_DROP_PIN};
+
+PowerManager::PowerManager(GPSManager& gps) :
+    gpsManager(gps),
+    idleMode(false),
+    lightSleepAvailable(false),
+    lightSleepActive(false),
+    inIdleState(false),
+    idleStateSince(0),
+    lastSampleTime(0),
+    lastBlockedCore0(0),
+    lastBlockedCore1(0),
+    buttonEdgeTime(0),
+    buttonEdgePending(false) {
+    
+    stats = {0, 0, 0, 0, 0, 0};
+}
+
+void PowerManager::begin() {
+    DEBUG_PRINTLN(F("[PWR] Initializing power manager..."));
+    
+    // Probe with light sleep on: CONFIG_PM_ENABLE alone accepts a config
+    // without it, but light_sleep_enable also needs tickless idle. Without it
+    // idle mode falls back to modem sleep plus a lower CPU clock
+    lightSleepAvailable = configureLightSleep(true);
+    configureLightSleep(false);
+    if (!lightSleepAvailable) {
+        DEBUG_PRINTLN(F("[PWR] Automatic light sleep unavailable, using modem sleep only"));
+    }
+    
+    // GPS RX idles high; the first start bit of an NMEA sentence wakes us.
+    // UART2 cannot be a light sleep wake source itself on the ESP32.
+    gpio_wakeup_enable((gpio_num_t)GPS_RX_PIN, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    
+    lastSampleTime = millis();
+    DEBUG_PRINTLN(F("[PWR] Power manager initialized"));
+}
+
+bool PowerManager::update(SystemState state, unsigned long blockedMsCore0, unsigned long blockedMsCore1) {
+    unsigned long currentTime = millis();
+    
+    // The chip can only sleep while both cores are blocked, so the smaller
+    // blocked delta bounds the sleep time from above. Without light sleep
+    // the CPU stays clocked while blocked and counts as awake
+    if (idleMode) {
+        unsigned long elapsed = currentTime - lastSampleTime;
+        unsigned long blocked0 = blockedMsCore0 - lastBlockedCore0;
+        unsigned long blocked1 = blockedMsCore1 - lastBlockedCore1;
+        unsigned long slept = 0;
+        if (lightSleepActive) {
+            slept = blocked0 < blocked1 ? blocked0 : blocked1;
+        }
+        
+        stats.idleModeMs += elapsed;
+        stats.awakeMs += elapsed > slept ? elapsed - slept : 0;
+    }
+    lastSampleTime = currentTime;
+    lastBlockedCore0 = blockedMsCore0;
+    lastBlockedCore1 = blockedMsCore1;
+    
+    if (state != STATE_IDLE) {
+        inIdleState = false;
+        if (idleMode) {
+            exitIdleMode();
+            return true;
+        }
+        return false;
+    }
+    
+    if (!inIdleState) {
+        inIdleState = true;
+        idleStateSince = currentTime;
+    }
+    
+    if (POWER_SAVE_ENABLED && !idleMode && currentTime - idleStateSince >= POWER_IDLE_ENTER_MS) {
+        enterIdleMode();
+        return true;
+    }
+    
+    return false;
+}
+
+bool PowerManager::isIdleMode() const {
+    return idleMode;
+}
+
+void PowerManager::enterIdleMode() {
+    DEBUG_PRINTLN(F("[PWR] Entering idle power mode"));
+    idleMode = true;
+    stats.idleEntries++;
+    
+    esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+    gpsManager.setPowerSave(true);
+    setButtonWake(true);
+    
+    lightSleepActive = lightSleepAvailable && configureLightSleep(true);
+    if (!lightSleepActive) {
+        if (lightSleepAvailable) {
+            DEBUG_PRINTLN(F("[PWR] Light sleep refused, lowering CPU clock instead"));
+        }
+        setCpuFrequencyMhz(POWER_CPU_MIN_MHZ);
+    }
+}
+
+void PowerManager::exitIdleMode() {
+    DEBUG_PRINTLN(F("[PWR] Leaving idle power mode"));
+    idleMode = false;
+    
+    if (lightSleepActive) {
+        configureLightSleep(false);
+        lightSleepActive = false;
+    } else {
+        setCpuFrequencyMhz(POWER_CPU_MAX_MHZ);
+    }
+    
+    setButtonWake(false);
+    gpsManager.setPowerSave(false);
+    esp_wifi_set_ps(WIFI_PS_NONE);
+}
+
+bool PowerManager::configureLightSleep(bool enable) {
+    esp_pm_config_esp32_t config;
+    config.max_freq_mhz = POWER_CPU_MAX_MHZ;
+    config.min_freq_mhz = enable ? POWER_CPU_MIN_MHZ : POWER_CPU_MAX_MHZ;
+    config.light_sleep_enable = enable;
+    
+    return esp_pm_configure(&config) == ESP_OK;
+}
+
+void PowerManager::setButtonWake(bool enable) {
+    // GPIO wake on the ESP32 is level-only, so while idle the button
+    // interrupts become low-level and each one disarms itself after firing
+    for (uint8_t i = 0; i < sizeof(BUTTON_PINS); i++) {
+        gpio_num_t pin = (gpio_num_t)BUTTON_PINS[i];
+        if (enable) {
+            gpio_wakeup_enable(pin, GPIO_INTR_LOW_LEVEL);
+        } else {
+            gpio_wakeup_disable(pin);
+            gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+            gpio_intr_enable(pin);
+        }
+    }
+}
+
+void IRAM_ATTR PowerManager::onButtonEdgeISR(uint8_t pin) {
+    if (!buttonEdgePending) {
+        buttonEdgeTime = millis();
+        buttonEdgePending = true;
+    }
+    
+    if (idleMode) {
+        gpio_intr_disable((gpio_num_t)pin);
+    }
+}
+
+void PowerManager::rearmButtonWake() {
+    if (!idleMode) return;
+    
+    for (uint8_t i = 0; i < sizeof(BUTTON_PINS); i++) {
+        if (digitalRead(BUTTON_PINS[i]) == HIGH) {
+            gpio_intr_enable((gpio_num_t)BUTTON_PINS[i]);
+        }
+    }
+}
+
+void PowerManager::recordButtonHandled(bool pressed) {
+    if (!buttonEdgePending) return;
+    buttonEdgePending = false;
+    
+    // An edge that did not produce a press was bounce or release
+    if (!pressed) return;
+    
+    unsigned long latency = millis() - buttonEdgeTime;
+    stats.lastButtonWakeMs = latency;
+    if (latency > stats.maxButtonWakeMs) {
+        stats.maxButtonWakeMs = latency;
+    }
+    if (latency > BUTTON_WAKE_BUDGET_MS) {
+        stats.buttonWakeOverBudget++;
+        DEBUG_PRINTF("[PWR] Button wake latency %lu ms over budget\n", latency);
+    }
+}
+
+uint8_t PowerManager::getDutyCyclePercent() const {
+    if (stats.idleModeMs == 0) return 100;
+    return (uint8_t)((stats.awakeMs * 100UL) / stats.idleModeMs);
+}
+
+const PowerStats& PowerManager::getStats() const {
+    return stats;
+}
+
+void PowerManager::printStats() {
+    DEBUG_PRINTF("   Mode: %s | Light sleep: %s | Entries: %u\n",
+                 idleMode ? "IDLE" : "ACTIVE",
+                 lightSleepActive ? "active" : (lightSleepAvailable ? "auto" : "unavailable"),
+                 stats.idleEntries);
+    DEBUG_PRINTF("   Idle time: %lu s | Duty cycle: %u%%\n",
+                 stats.idleModeMs / 1000, getDutyCyclePercent());
+    DEBUG_PRINTF("   Button wake: last %lu ms, max %lu ms (budget %d ms, over %u)\n",
+                 stats.lastButtonWakeMs, stats.maxButtonWakeMs,
+                 BUTTON_WAKE_BUDGET_MS, stats.buttonWakeOverBudget);
+}
@@ -0,0 +1,72 @@
+/*
+ * PowerManager.h
+ * Idle power mode for the rickshaw unit
+ *
+ * After POWER_IDLE_ENTER_MS in STATE_IDLE the unit enables automatic light
+ * sleep (FreeRTOS sleeps whenever both cores are blocked), WiFi modem sleep
+ * (the radio wakes for DTIM beacons, so MQTT traffic still arrives) and GPS
+ * power save. Buttons and the GPS RX line are GPIO wake sources. Any other
+ * state restores full power.
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "GPSManager.h"
+
+struct PowerStats {
+    uint32_t idleEntries;
+    unsigned long idleModeMs;       // Total time spent in idle power mode
+    unsigned long awakeMs;          // Estimated CPU-awake time within idleModeMs
+    unsigned long lastButtonWakeMs; // Button edge -> press handled
+    unsigned long maxButtonWakeMs;
+    uint32_t buttonWakeOverBudget;
+};
+
+class PowerManager {
+public:
+    PowerManager(GPSManager& gps);
+    void begin();
+    
+    // Returns true when the power mode changed (callers retune task periods)
+    bool update(SystemState state, unsigned long blockedMsCore0, unsigned long blockedMsCore1);
+    bool isIdleMode() const;
+    
+    // Button wake path
+    void onButtonEdgeISR(uint8_t pin);
+    void rearmButtonWake();
+    void recordButtonHandled(bool pressed);
+    
+    // Metrics
+    uint8_t getDutyCyclePercent() const;
+    const PowerStats& getStats() const;
+    void printStats();
+
+private:
+    GPSManager& gpsManager;
+    
+    bool idleMode;
+    bool lightSleepAvailable;       // esp_pm_configure accepted light_sleep_enable at boot
+    bool lightSleepActive;          // Enabled for the current idle period
+    bool inIdleState;
+    unsigned long idleStateSince;
+    
+    // Duty cycle sampling
+    unsigned long lastSampleTime;
+    unsigned long lastBlockedCore0;
+    unsigned long lastBlockedCore1;
+    
+    volatile unsigned long buttonEdgeTime;
+    volatile bool buttonEdgePending;
+    
+    PowerStats stats;
+    
+    void enterIdleMode();
+    void exitIdleMode();
+    bool configureLightSleep(bool enable);
+    void setButtonWake(bool enable);
+};
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,259 @@
+/*
+ * RideHistory.cpp
+ * Implementation of the circular ride-history log
+ */
+
+#include "RideHistory.h"
+#include <esp32/rom/crc.h>
+
+static_assert(sizeof(RideRecord) == RIDE_HISTORY_RECORD_SIZE, "RideRecord must fill one slot");
+static_assert((RIDE_HISTORY_RECORDS_PER_SECTOR + 1) * RIDE_HISTORY_RECORD_SIZE <= SPI_FLASH_SEC_SIZE,
+              "Header slot plus records must fit in a sector");
+
+#define ERASED_WORD             0xFFFFFFFFUL
+
+RideHistory::RideHistory()
+    : partition(nullptr), sectorCount(0), headSector(0), nextSequence(1), recordCount(0) {
+    memset(sectors, 0, sizeof(sectors));
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool RideHistory::begin() {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         RIDE_HISTORY_PARTITION);
+    if (partition == nullptr) {
+        DEBUG_PRINTLN(F("[HIST] No ridelog partition; ride history disabled"));
+        return false;
+    }
+    
+    sectorCount = partition->size / SPI_FLASH_SEC_SIZE;
+    if (sectorCount > RIDE_HISTORY_MAX_SECTORS) sectorCount = RIDE_HISTORY_MAX_SECTORS;
+    if (sectorCount < 2) {
+        DEBUG_PRINTLN(F("[HIST] ERROR: ridelog partition needs at least two sectors"));
+        partition = nullptr;
+        return false;
+    }
+    
+    // Build the sector directory; the newest sector takes further appends
+    bool found = false;
+    unsigned long start = millis();
+    for (uint16_t s = 0; s < sectorCount; s++) {
+        SectorHeader header;
+        SectorInfo& info = sectors[s];
+        esp_partition_read(partition, (size_t)s * SPI_FLASH_SEC_SIZE, &header, sizeof(header));
+        
+        info.inUse = header.magic == RIDE_HISTORY_MAGIC && header.crc == headerCrc(header);
+        info.eraseCount = header.magic == RIDE_HISTORY_MAGIC ? header.eraseCount : 0;
+        if (!info.inUse) continue;
+        
+        info.sequence = header.sequence;
+        scanSector(s);
+        if (!found || (int32_t)(info.sequence - sectors[headSector].sequence) > 0) {
+            headSector = s;
+            found = true;
+        }
+    }
+    
+    if (!found && !openSector(0)) {
+        partition = nullptr;
+        return false;
+    }
+    
+    DEBUG_PRINTF("[HIST] %u records in %u sectors (scan %lu ms)\n",
+                 recordCount, sectorCount, millis() - start);
+    return true;
+}
+
+bool RideHistory::isAvailable() const {
+    return partition != nullptr;
+}
+
+bool RideHistory::append(RideRecord& record) {
+    if (partition == nullptr) return false;
+    unsigned long start = micros();
+    
+    // Full head sector: the log wraps onto the oldest sector
+    if (sectors[headSector].records >= RIDE_HISTORY_RECORDS_PER_SECTOR &&
+        !openSector((headSector + 1) % sectorCount)) {
+        stats.appendFailures++;
+        return false;
+    }
+    
+    SectorInfo& info = sectors[headSector];
+    record.sequence = nextSequence++;
+    record.day = dayOf(record.dropTime);
+    memset(record.reserved, 0, sizeof(record.reserved));
+    record.crc = recordCrc(record);
+    
+    // The slot counts as used even if programming fails part-way
+    esp_err_t err = esp_partition_write(partition, recordOffset(headSector, info.records),
+                                        &record, sizeof(record));
+    info.records++;
+    if (err != ESP_OK) {
+        DEBUG_PRINTF("[HIST] ERROR: Record write failed (%d)\n", err);
+        stats.appendFailures++;
+        return false;
+    }
+    noteRecord(info, record);
+    recordCount++;
+    
+    unsigned long elapsed = micros() - start;
+    stats.appends++;
+    stats.lastAppendUs = elapsed;
+    if (elapsed > stats.maxAppendUs) {
+        stats.maxAppendUs = elapsed;
+    }
+    return true;
+}
+
+uint16_t RideHistory::query(uint16_t fromDay, uint16_t toDay, RideRecord* out, uint16_t maxRecords) {
+    if (partition == nullptr) return 0;
+    unsigned long start = micros();
+    uint16_t matched = 0;
+    stats.sectorsRead = 0;
+    
+    // Walk back from the head; sectors are filled strictly in rotation
+    for (uint16_t n = 0; n < sectorCount; n++) {
+        uint16_t s = (headSector + sectorCount - n) % sectorCount;
+        const SectorInfo& info = sectors[s];
+        if (!info.inUse) break;
+        
+        bool overlaps = info.valid > 0 && info.firstDay <= toDay && info.lastDay >= fromDay;
+        bool undated = info.hasUndated && fromDay == 0;
+        if (!overlaps && !undated) continue;
+        
+        stats.sectorsRead++;
+        for (int16_t slot = info.records - 1; slot >= 0; slot--) {
+            RideRecord record;
+            esp_partition_read(partition, recordOffset(s, slot), &record, sizeof(record));
+            if (record.crc != recordCrc(record) || record.day < fromDay || record.day > toDay) {
+                continue;
+            }
+            if (out != nullptr && matched < maxRecords) {
+                out[matched] = record;
+            }
+            matched++;
+        }
+    }
+    
+    stats.lastQueryUs = micros() - start;
+    return matched;
+}
+
+uint32_t RideHistory::getRecordCount() const {
+    return recordCount;
+}
+
+const RideHistoryStats& RideHistory::getStats() const {
+    return stats;
+}
+
+void RideHistory::printStats() {
+    if (partition == nullptr) {
+        DEBUG_PRINTLN(F("History: not available"));
+        return;
+    }
+    
+    uint32_t minErase = sectors[0].eraseCount;
+    uint32_t maxErase = sectors[0].eraseCount;
+    for (uint16_t s = 1; s < sectorCount; s++) {
+        if (sectors[s].eraseCount < minErase) minErase = sectors[s].eraseCount;
+        if (sectors[s].eraseCount > maxErase) maxErase = sectors[s].eraseCount;
+    }
+    
+    DEBUG_PRINTF("History: %u records, head sector %u (%u/%u used)\n",
+                 recordCount, headSector, sectors[headSector].records, RIDE_HISTORY_RECORDS_PER_SECTOR);
+    DEBUG_PRINTF("History wear: erases %u-%u per sector, %u since boot\n",
+                 minErase, maxErase, stats.erases);
+    DEBUG_PRINTF("History timing: append last %lu us, max %lu us | query %lu us (%u sectors)\n",
+                 stats.lastAppendUs, stats.maxAppendUs, stats.lastQueryUs, stats.sectorsRead);
+}
+
+uint16_t RideHistory::dayOf(uint32_t unixTime) {
+    return unixTime >= CLOCK_VALID_AFTER ? (uint16_t)(unixTime / 86400UL) : 0;
+}
+
+bool RideHistory::openSector(uint16_t sector) {
+    SectorInfo& info = sectors[sector];
+    uint32_t sequence = sectors[headSector].inUse ? sectors[headSector].sequence + 1 : 1;
+    
+    // The oldest records go first, whether or not the erase succeeds
+    if (info.inUse) {
+        recordCount -= info.valid;
+        info.inUse = false;
+    }
+    
+    if (esp_partition_erase_range(partition, (size_t)sector * SPI_FLASH_SEC_SIZE, SPI_FLASH_SEC_SIZE) != ESP_OK) {
+        DEBUG_PRINTF("[HIST] ERROR: Erase of sector %u failed\n", sector);
+        return false;
+    }
+    stats.erases++;
+    
+    SectorHeader header;
+    header.magic = RIDE_HISTORY_MAGIC;
+    header.sequence = sequence;
+    header.eraseCount = info.eraseCount + 1;
+    header.crc = headerCrc(header);
+    if (esp_partition_write(partition, (size_t)sector * SPI_FLASH_SEC_SIZE, &header, sizeof(header)) != ESP_OK) {
+        DEBUG_PRINTF("[HIST] ERROR: Header write of sector %u failed\n", sector);
+        return false;
+    }
+    
+    info.sequence = sequence;
+    info.eraseCount = header.eraseCount;
+    info.records = 0;
+    info.valid = 0;
+    info.inUse = true;
+    info.firstDay = 0xFFFF;
+    info.lastDay = 0;
+    info.hasUndated = false;
+    headSector = sector;
+    return true;
+}
+
+void RideHistory::scanSector(uint16_t sector) {
+    SectorInfo& info = sectors[sector];
+    info.records = 0;
+    info.valid = 0;
+    info.firstDay = 0xFFFF;
+    info.lastDay = 0;
+    info.hasUndated = false;
+    
+    for (uint8_t slot = 0; slot < RIDE_HISTORY_RECORDS_PER_SECTOR; slot++) {
+        RideRecord record;
+        esp_partition_read(partition, recordOffset(sector, slot), &record, sizeof(record));
+        if (record.sequence == ERASED_WORD) break;
+        
+        info.records++;
+        if (record.crc != recordCrc(record)) continue;  // Torn write
+        
+        noteRecord(info, record);
+        recordCount++;
+        if ((int32_t)(record.sequence + 1 - nextSequence) > 0) {
+            nextSequence = record.sequence + 1;
+        }
+    }
+}
+
+void RideHistory::noteRecord(SectorInfo& info, const RideRecord& record) {
+    info.valid++;
+    if (record.day == 0) {
+        info.hasUndated = true;
+        return;
+    }
+    if (record.day < info.firstDay) info.firstDay = record.day;
+    if (record.day > info.lastDay) info.lastDay = record.day;
+}
+
+size_t RideHistory::recordOffset(uint16_t sector, uint8_t slot) const {
+    // Slot 0 of every sector holds the header
+    return (size_t)sector * SPI_FLASH_SEC_SIZE + (size_t)(slot + 1) * RIDE_HISTORY_RECORD_SIZE;
+}
+
+uint32_t RideHistory::recordCrc(const RideRecord& record) {
+    return crc32_le(0, (const uint8_t*)&record, offsetof(RideRecord, crc));
+}
+
+uint32_t RideHistory::headerCrc(const SectorHeader& header) {
+    return crc32_le(0, (const uint8_t*)&header, offsetof(SectorHeader, crc));
+}
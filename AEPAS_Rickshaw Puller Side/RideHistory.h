@@ -0,0 +1,112 @@
+/*
+ * RideHistory.h
+ * Circular ride-history log on a raw flash partition
+ *
+ * Completed rides are appended as fixed 64-byte records to the "ridelog"
+ * data partition (see partitions.csv). Each 4 KB sector holds a header and
+ * RIDE_HISTORY_RECORDS_PER_SECTOR records; records are programmed in place
+ * over erased flash, so a sector is erased only when the log wraps onto it.
+ * Sectors are used strictly in rotation, which spreads erases evenly, and
+ * each header carries the sector's sequence number and erase count. begin()
+ * scans the partition once into a RAM directory (record count and day range
+ * per sector) so queries by day only read the sectors that can match.
+ */
+
+#ifndef RIDE_HISTORY_H
+#define RIDE_HISTORY_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <time.h>
+#include "Config.h"
+
+#define RIDE_RECORD_REVIEW      0x01    // Points held for admin review
+
+struct RideRecord {
+    uint32_t sequence;          // Assigned by append(); 0xFFFFFFFF = erased slot
+    uint32_t rideHash;          // FNV-1a of the ride ID (same as the points ledger)
+    uint32_t acceptTime;        // Unix time, 0 when the clock was not set
+    uint32_t pickupTime;
+    uint32_t dropTime;
+    int32_t pickupLat;          // Microdegrees
+    int32_t pickupLon;
+    int32_t dropLat;
+    int32_t dropLon;
+    int32_t centiPoints;        // Points x 100
+    uint32_t distanceM;         // Filtered trip path length
+    uint32_t durationS;         // Pickup -> drop
+    uint16_t day;               // dropTime / 86400, 0 = unknown
+    uint8_t flags;
+    uint8_t reserved[9];
+    uint32_t crc;               // CRC32 of all preceding bytes
+};
+
+struct RideHistoryStats {
+    uint32_t appends;
+    uint32_t appendFailures;
+    unsigned long lastAppendUs;
+    unsigned long maxAppendUs;
+    unsigned long lastQueryUs;
+    uint32_t sectorsRead;       // By the last query
+    uint32_t erases;            // Since boot
+};
+
+class RideHistory {
+public:
+    RideHistory();
+    bool begin();
+    bool isAvailable() const;
+    
+    // Fills in sequence, day and crc
+    bool append(RideRecord& record);
+    
+    // Copies up to maxRecords matching records, newest first, and returns how
+    // many matched in total (pass out = nullptr to just count)
+    uint16_t query(uint16_t fromDay, uint16_t toDay, RideRecord* out, uint16_t maxRecords);
+    
+    uint32_t getRecordCount() const;
+    const RideHistoryStats& getStats() const;
+    void printStats();
+    
+    static uint16_t dayOf(uint32_t unixTime);
+
+private:
+    struct SectorHeader {
+        uint32_t magic;
+        uint32_t sequence;      // Increases by one per sector opened
+        uint32_t eraseCount;    // Lifetime erases of this sector
+        uint32_t crc;
+    };
+    
+    // RAM directory entry per sector
+    struct SectorInfo {
+        uint32_t sequence;
+        uint32_t eraseCount;
+        uint8_t records;        // Programmed slots, valid or not
+        uint8_t valid;          // Slots passing the CRC check
+        bool inUse;
+        uint16_t firstDay;      // Day range of the valid dated records
+        uint16_t lastDay;
+        bool hasUndated;        // Holds records written before the clock was set
+    };
+    
+    static_assert(sizeof(SectorHeader) <= RIDE_HISTORY_RECORD_SIZE, "Header must fit in slot 0");
+    
+    const esp_partition_t* partition;
+    uint16_t sectorCount;
+    SectorInfo sectors[RIDE_HISTORY_MAX_SECTORS];
+    uint16_t headSector;        // Sector receiving appends
+    uint32_t nextSequence;
+    uint32_t recordCount;       // Valid records currently retained
+    RideHistoryStats stats;
+    
+    bool openSector(uint16_t sector);
+    void scanSector(uint16_t sector);
+    void noteRecord(SectorInfo& info, const RideRecord& record);
+    size_t recordOffset(uint16_t sector, uint8_t slot) const;
+    
+    static uint32_t recordCrc(const RideRecord& record);
+    static uint32_t headerCrc(const SectorHeader& header);
+};
+
+#endif // RIDE_HISTORY_H
@@ -0,0 +1,77 @@
+/*
+ * SPSCQueue.h
+ * Fixed-capacity lock-free single-producer/single-consumer queue
+ *
+ * Used to pass typed events between the network task (core 0) and the
+ * FSM/UI loop (core 1). Exactly one task may push and exactly one task may
+ * pop. head and tail are free-running counters, so Capacity must be a power
+ * of two; the producer publishes a slot with a release store of tail and the
+ * consumer frees it with a release store of head.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint32_t Capacity>
+class SPSCQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SPSCQueue capacity must be a power of two");
+
+public:
+    SPSCQueue() : head(0), tail(0), dropped(0) {}
+
+    // Producer side: returns false (and counts a drop) when full
+    bool push(const T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) >= Capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: returns false when empty
+    bool pop(T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a third task (diagnostics only). head is
+    // read first so a pop in between cannot underflow; pops and pushes in
+    // between can overshoot, hence the clamp
+    uint32_t size() const {
+        uint32_t h = head.load(std::memory_order_acquire);
+        uint32_t n = tail.load(std::memory_order_acquire) - h;
+        return n < Capacity ? n : Capacity;
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    uint32_t capacity() const {
+        return Capacity;
+    }
+
+    uint32_t getDropped() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    T slots[Capacity];
+    std::atomic<uint32_t> head;     // Written by consumer only
+    std::atomic<uint32_t> tail;     // Written by producer only
+    std::atomic<uint32_t> dropped;  // Written by producer only
+};
+
+#endif // SPSC_QUEUE_H
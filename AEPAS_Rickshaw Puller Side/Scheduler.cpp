@@ -0,0 +1,189 @@
+/*
+ * Scheduler.cpp
+ * Implementation of the deadline-based cooperative scheduler
+ */
+
+#include "Scheduler.h"
+
+Scheduler::Scheduler() : taskCount(0), loopTask(nullptr), totalSleepMs(0) {
+}
+
+void Scheduler::begin() {
+    // setup() and loop() share the Arduino loop task; ISRs notify it directly
+    loopTask = xTaskGetCurrentTaskHandle();
+    DEBUG_PRINTLN(F("[SCHED] Scheduler initialized"));
+}
+
+int8_t Scheduler::addPeriodic(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t firstDelayMs) {
+    return addTask(name, callback, periodMs > 0 ? periodMs : 1, firstDelayMs);
+}
+
+int8_t Scheduler::addOneShot(const char* name, TaskCallback callback, uint32_t delayMs) {
+    return addTask(name, callback, 0, delayMs);
+}
+
+int8_t Scheduler::addTask(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t delayMs) {
+    // Reuse a finished one-shot slot before growing the table
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < taskCount; i++) {
+        if (!tasks[i].active) {
+            slot = i;
+            break;
+        }
+    }
+    
+    if (slot < 0) {
+        if (taskCount >= SCHEDULER_MAX_TASKS) {
+            DEBUG_PRINTF("[SCHED] Task table full, cannot add: %s\n", name);
+            return -1;
+        }
+        slot = taskCount++;
+    }
+    
+    Task& task = tasks[slot];
+    task.name = name;
+    task.callback = callback;
+    task.deadline = millis() + delayMs;
+    task.periodMs = periodMs;
+    task.active = true;
+    task.triggered = false;
+    task.stats = {0, 0, 0, 0, 0};
+    
+    return slot;
+}
+
+void Scheduler::cancel(int8_t taskId) {
+    if (taskId < 0 || taskId >= taskCount) return;
+    tasks[taskId].active = false;
+}
+
+void Scheduler::setPeriod(int8_t taskId, uint32_t periodMs) {
+    if (taskId < 0 || taskId >= taskCount || periodMs == 0) return;
+    
+    Task& task = tasks[taskId];
+    // Pull the deadline in if the new period is shorter
+    unsigned long now = millis();
+    if ((long)(task.deadline - (now + periodMs)) > 0) {
+        task.deadline = now + periodMs;
+    }
+    task.periodMs = periodMs;
+}
+
+void Scheduler::triggerNow(int8_t taskId) {
+    // Flag rather than deadline write so other tasks can call this too
+    if (taskId < 0 || taskId >= taskCount) return;
+    tasks[taskId].triggered = true;
+    wake();
+}
+
+void Scheduler::run() {
+    unsigned long now = millis();
+    
+    for (uint8_t i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        if (task.active && (task.triggered || (long)(now - task.deadline) >= 0)) {
+            task.triggered = false;
+            runTask(task, now);
+            now = millis();
+        }
+    }
+    
+    // Sleep until the nearest deadline; ISRs cut the wait short
+    unsigned long sleepMs = msUntilNextDeadline();
+    if (sleepMs > 0) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleepMs));
+        totalSleepMs += millis() - now;
+    }
+}
+
+void Scheduler::runTask(Task& task, unsigned long now) {
+    // Triggered runs can start before the deadline; only count real lateness
+    long late = (long)(now - task.deadline);
+    if (late > 0 && (unsigned long)late > task.stats.maxLateMs) {
+        task.stats.maxLateMs = late;
+    }
+    
+    unsigned long start = micros();
+    task.callback();
+    unsigned long elapsed = micros() - start;
+    
+    task.stats.runs++;
+    task.stats.totalRunUs += elapsed;
+    if (elapsed > task.stats.maxRunUs) {
+        task.stats.maxRunUs = elapsed;
+    }
+    
+    if (task.periodMs == 0) {
+        task.active = false;
+        return;
+    }
+    
+    if ((long)(now - task.deadline) < 0) {
+        return;  // Early triggered run, keep the pending deadline
+    }
+    
+    // Keep the original cadence; if we've fallen a full period behind,
+    // count an overrun and restart from now instead of bursting to catch up
+    task.deadline += task.periodMs;
+    unsigned long after = millis();
+    if ((long)(after - task.deadline) >= 0) {
+        task.stats.overruns++;
+        task.deadline = after + task.periodMs;
+    }
+}
+
+unsigned long Scheduler::msUntilNextDeadline() const {
+    unsigned long now = millis();
+    unsigned long nearest = SCHEDULER_MAX_SLEEP_MS;
+    
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        if (!task.active) continue;
+        if (task.triggered) return 0;
+        
+        long remaining = (long)(task.deadline - now);
+        if (remaining <= 0) return 0;
+        if ((unsigned long)remaining < nearest) {
+            nearest = remaining;
+        }
+    }
+    
+    return nearest;
+}
+
+void IRAM_ATTR Scheduler::triggerFromISR(int8_t taskId) {
+    if (loopTask == nullptr || taskId < 0 || taskId >= taskCount) return;
+    
+    tasks[taskId].triggered = true;
+    BaseType_t higherPriorityWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(loopTask, &higherPriorityWoken);
+    portYIELD_FROM_ISR(higherPriorityWoken);
+}
+
+void Scheduler::wake() {
+    if (loopTask == nullptr) return;
+    xTaskNotifyGive(loopTask);
+}
+
+const TaskStats* Scheduler::getStats(int8_t taskId) const {
+    if (taskId < 0 || taskId >= taskCount) return nullptr;
+    return &tasks[taskId].stats;
+}
+
+unsigned long Scheduler::getSleepMs() const {
+    return totalSleepMs;
+}
+
+void Scheduler::printStats() {
+    DEBUG_PRINTLN(F("=== Scheduler Tasks ==="));
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        if (!task.active && task.periodMs > 0) continue;
+        
+        unsigned long avgUs = task.stats.runs > 0 ? task.stats.totalRunUs / task.stats.runs : 0;
+        DEBUG_PRINTF("%-10s runs:%u overruns:%u late:%lums avg:%luus max:%luus\n",
+                     task.name, task.stats.runs, task.stats.overruns,
+                     task.stats.maxLateMs, avgUs, task.stats.maxRunUs);
+    }
+    DEBUG_PRINTF("Idle sleep: %lu ms of %lu ms uptime\n", totalSleepMs, millis());
+}
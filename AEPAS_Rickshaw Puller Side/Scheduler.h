@@ -0,0 +1,72 @@
+/*
+ * Scheduler.h
+ * Deadline-based cooperative scheduler for loop()
+ *
+ * Modules register periodic or one-shot tasks. run() executes every task
+ * whose deadline has passed, then blocks the loop task until the nearest
+ * deadline or until an ISR makes a task due with triggerFromISR(). Per-task
+ * lateness, run time and overrun counts are kept for diagnostics.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+typedef void (*TaskCallback)();
+
+struct TaskStats {
+    uint32_t runs;
+    uint32_t overruns;          // Periodic runs that missed their next deadline
+    unsigned long maxLateMs;    // Worst start delay past the deadline
+    unsigned long maxRunUs;     // Worst execution time
+    unsigned long totalRunUs;   // For average execution time
+};
+
+class Scheduler {
+public:
+    Scheduler();
+    void begin();
+    
+    // Task registration (returns task id, or -1 if the table is full)
+    int8_t addPeriodic(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t firstDelayMs = 0);
+    int8_t addOneShot(const char* name, TaskCallback callback, uint32_t delayMs);
+    void cancel(int8_t taskId);
+    void setPeriod(int8_t taskId, uint32_t periodMs);
+    void triggerNow(int8_t taskId);
+    
+    // Run due tasks, then sleep until the next deadline or an ISR wake
+    void run();
+    unsigned long msUntilNextDeadline() const;
+    
+    // Make a task due and wake the loop (safe to call from an ISR)
+    void triggerFromISR(int8_t taskId);
+    void wake();
+    
+    // Diagnostics
+    const TaskStats* getStats(int8_t taskId) const;
+    unsigned long getSleepMs() const;
+    void printStats();
+
+private:
+    struct Task {
+        const char* name;
+        TaskCallback callback;
+        unsigned long deadline;
+        uint32_t periodMs;      // 0 = one-shot
+        bool active;
+        volatile bool triggered;    // Set from an ISR or another task, run on next pass
+        TaskStats stats;
+    };
+    
+    Task tasks[SCHEDULER_MAX_TASKS];
+    uint8_t taskCount;
+    TaskHandle_t loopTask;
+    unsigned long totalSleepMs;
+    
+    int8_t addTask(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t delayMs);
+    void runTask(Task& task, unsigned long now);
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,79 @@
+/*
+ * ScreenTemplate.cpp
+ * Implementation of retained screen layouts
+ */
+
+#include "ScreenTemplate.h"
+
+ScreenTemplate::ScreenTemplate()
+    : currentLayout(0), valid(false),
+      layoutsRendered(0), fieldsRedrawn(0), fieldsSkipped(0) {
+}
+
+bool ScreenTemplate::matches(uint8_t layoutId, const String& key) const {
+    return valid && currentLayout == layoutId && currentKey == key;
+}
+
+bool ScreenTemplate::isLayout(uint8_t layoutId) const {
+    return valid && currentLayout == layoutId;
+}
+
+void ScreenTemplate::capture(Adafruit_SSD1306& display, uint8_t layoutId, const String& key) {
+    uint8_t* buffer = display.getBuffer();
+    if (buffer == nullptr) return;
+    
+    memcpy(layoutCache, buffer, sizeof(layoutCache));
+    currentLayout = layoutId;
+    currentKey = key;
+    valid = true;
+    layoutsRendered++;
+    
+    // Fields are blank in the captured layout, so every slot draws next time
+    for (uint8_t i = 0; i < SCREEN_MAX_FIELDS; i++) {
+        fieldValues[i] = String();
+    }
+}
+
+void ScreenTemplate::invalidate() {
+    valid = false;
+}
+
+bool ScreenTemplate::updateField(Adafruit_SSD1306& display, uint8_t slot, int16_t x, uint8_t page,
+                                 uint8_t width, uint8_t pages, const String& value) {
+    if (!valid || slot >= SCREEN_MAX_FIELDS) return true;
+    
+    if (fieldValues[slot].length() > 0 && fieldValues[slot] == value) {
+        fieldsSkipped++;
+        return false;
+    }
+    
+    restore(display, x, page, width, pages);
+    fieldValues[slot] = value;
+    fieldsRedrawn++;
+    return true;
+}
+
+void ScreenTemplate::restore(Adafruit_SSD1306& display, int16_t x, uint8_t page, uint8_t width, uint8_t pages) {
+    uint8_t* buffer = display.getBuffer();
+    if (!valid || buffer == nullptr) return;
+    
+    // SSD1306 buffer is page-major: one byte = 8 vertical pixels of a column
+    if (x < 0) x = 0;
+    if (x + width > OLED_SCREEN_WIDTH) width = OLED_SCREEN_WIDTH - x;
+    for (uint8_t p = page; p < page + pages && p < OLED_PAGE_COUNT; p++) {
+        uint16_t offset = p * OLED_SCREEN_WIDTH + x;
+        memcpy(buffer + offset, layoutCache + offset, width);
+    }
+}
+
+uint32_t ScreenTemplate::getLayoutsRendered() const {
+    return layoutsRendered;
+}
+
+uint32_t ScreenTemplate::getFieldsRedrawn() const {
+    return fieldsRedrawn;
+}
+
+uint32_t ScreenTemplate::getFieldsSkipped() const {
+    return fieldsSkipped;
+}
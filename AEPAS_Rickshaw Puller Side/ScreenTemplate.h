@@ -0,0 +1,55 @@
+/*
+ * ScreenTemplate.h
+ * Retained screen layout with field-level redraw
+ *
+ * A screen draws its static parts (labels, title, addresses) once and
+ * capture()s the result into a cached bitmap. Dynamic values live in
+ * page-aligned field boxes: updateField() restores the box from the cache
+ * and asks the caller to redraw it only when the value text changed.
+ * Everything else in the back buffer is left untouched between refreshes.
+ */
+
+#ifndef SCREEN_TEMPLATE_H
+#define SCREEN_TEMPLATE_H
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+#include "Config.h"
+
+class ScreenTemplate {
+public:
+    ScreenTemplate();
+    
+    // True when the back buffer still holds this layout for this key
+    bool matches(uint8_t layoutId, const String& key) const;
+    bool isLayout(uint8_t layoutId) const;
+    
+    // Cache the static layout just drawn into the back buffer
+    void capture(Adafruit_SSD1306& display, uint8_t layoutId, const String& key);
+    void invalidate();
+    
+    // Returns true (with the box cleared back to the layout) when the caller must redraw
+    bool updateField(Adafruit_SSD1306& display, uint8_t slot, int16_t x, uint8_t page,
+                     uint8_t width, uint8_t pages, const String& value);
+    
+    // Copy a page-aligned box from the cached layout back into the back buffer
+    void restore(Adafruit_SSD1306& display, int16_t x, uint8_t page, uint8_t width, uint8_t pages);
+    
+    // Diagnostics
+    uint32_t getLayoutsRendered() const;
+    uint32_t getFieldsRedrawn() const;
+    uint32_t getFieldsSkipped() const;
+
+private:
+    uint8_t layoutCache[OLED_SCREEN_WIDTH * OLED_PAGE_COUNT];
+    uint8_t currentLayout;
+    String currentKey;
+    bool valid;
+    String fieldValues[SCREEN_MAX_FIELDS];
+    
+    uint32_t layoutsRendered;
+    uint32_t fieldsRedrawn;
+    uint32_t fieldsSkipped;
+};
+
+#endif // SCREEN_TEMPLATE_H
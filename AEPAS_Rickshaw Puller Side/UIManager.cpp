@@ -6,19 +6,28 @@
 #include "UIManager.h"
 
 UIManager::UIManager() : 
-    display(OLED_SCREEN_WIDTH, OLED_SCREEN_HEIGHT, &Wire, -1),
+    display(OLED_SCREEN_WIDTH, OLED_SCREEN_HEIGHT, &Wire, -1, DISPLAY_I2C_CLOCK_HZ, DISPLAY_I2C_CLOCK_HZ),
     currentLEDPattern(LED_OFF),
-    lastLEDToggle(0),
-    ledState(false),
-    blinkCount(0),
-    buzzerActive(false),
-    buzzerEndTime(0),
     currentPage(PAGE_IDLE),
-    lastScreenUpdate(0) {
+    lastScreenUpdate(0),
+    pendingSyncCount(0),
+    offline(false),
+    lastPresentedPage(PAGE_COUNT) {
     
-    for (int i = 0; i < 4; i++) {
-        lastButtonPress[i] = 0;
-        buttonStates[i] = false;
+    memset(screenCosts, 0, sizeof(screenCosts));
+}
+
+static const char* pageName(ScreenPage page) {
+    switch (page) {
+        case PAGE_IDLE:              return "idle";
+        case PAGE_RIDE_NOTIFICATION: return "notify";
+        case PAGE_ENROUTE:           return "enroute";
+        case PAGE_ARRIVED:           return "arrived";
+        case PAGE_RIDE_ACTIVE:       return "ride";
+        case PAGE_NEXT_RIDE:         return "next";
+        case PAGE_COMPLETED:         return "completed";
+        case PAGE_ERROR:             return "error";
+        default:                     return "unknown";
     }
 }
 
@@ -27,7 +36,7 @@ void UIManager::begin() {
     
     // Initialize I2C (0.96" 4-pin OLED)
     Wire.begin(OLED_SDA_PIN, OLED_SCL_PIN);
-    Wire.setClock(400000);  // 400kHz I2C clock speed
+    Wire.setClock(DISPLAY_I2C_CLOCK_HZ);
     
     // Initialize OLED (I2C mode)
     if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS)) {
@@ -52,11 +61,12 @@ void UIManager::begin() {
     display.println(F("Initializing..."));
     display.display();
     
-    // Initialize buttons
-    pinMode(BTN_ACCEPT_PIN, INPUT_PULLUP);
-    pinMode(BTN_REJECT_PIN, INPUT_PULLUP);
-    pinMode(BTN_PICKUP_PIN, INPUT_PULLUP);
-    pinMode(BTN_DROP_PIN, INPUT_PULLUP);
+    // From here on the display task owns I2C; screens go through submit()
+    displayService.begin(display, OLED_I2C_ADDRESS);
+    
+    // Initialize buttons (order matches BUTTON_IDS)
+    const uint8_t buttonPins[] = {BTN_ACCEPT_PIN, BTN_REJECT_PIN, BTN_PICKUP_PIN, BTN_DROP_PIN};
+    buttons.begin(buttonPins, sizeof(buttonPins));
     
     // Initialize LED
     pinMode(LED_STATUS_PIN, OUTPUT);
@@ -66,39 +76,38 @@ void UIManager::begin() {
     pinMode(BUZZER_PIN, OUTPUT);
     digitalWrite(BUZZER_PIN, LOW);
     
+    patterns.begin(LED_STATUS_PIN, BUZZER_PIN);
+    
     DEBUG_PRINTLN(F("[UI] UI Manager initialized"));
     
     beepPattern(2, 100, 100); // Startup beep
 }
 
 void UIManager::update() {
-    updateLED();
-    
-    // Handle buzzer
-    if (buzzerActive && millis() >= buzzerEndTime) {
-        digitalWrite(BUZZER_PIN, LOW);
-        buzzerActive = false;
-    }
+    // LED and buzzer sequences advance on their own timer
+}
+
+void IRAM_ATTR UIManager::onButtonEdgeISR(uint8_t pin) {
+    buttons.onEdgeISR(pin);
 }
 
 ButtonState UIManager::readButtons() {
-    unsigned long currentTime = millis();
-    
-    // Check each button with debouncing
-    const uint8_t buttonPins[] = {BTN_ACCEPT_PIN, BTN_REJECT_PIN, BTN_PICKUP_PIN, BTN_DROP_PIN};
-    const ButtonState buttonIds[] = {BTN_ACCEPT, BTN_REJECT, BTN_PICKUP, BTN_DROP};
-    
-    for (int i = 0; i < 4; i++) {
-        bool pressed = !digitalRead(buttonPins[i]); // Active LOW
-        
-        if (pressed && !buttonStates[i] && (currentTime - lastButtonPress[i] > BUTTON_DEBOUNCE_MS)) {
-            buttonStates[i] = true;
-            lastButtonPress[i] = currentTime;
-            DEBUG_PRINTF("[UI] Button pressed: %d\n", buttonIds[i]);
-            beep();
-            return buttonIds[i];
-        } else if (!pressed) {
-            buttonStates[i] = false;
+    static const ButtonState BUTTON_IDS[] = {BTN_ACCEPT, BTN_REJECT, BTN_PICKUP, BTN_DROP};
+    
+    // Gestures are logged; presses are returned one per call in edge order
+    ButtonAction action;
+    while (buttons.poll(action)) {
+        switch (action.gesture) {
+            case GESTURE_PRESS:
+                DEBUG_PRINTF("[UI] Button pressed: %d\n", BUTTON_IDS[action.button]);
+                beep();
+                return BUTTON_IDS[action.button];
+            case GESTURE_LONG_PRESS:
+                DEBUG_PRINTF("[UI] Button long press: %d\n", BUTTON_IDS[action.button]);
+                break;
+            case GESTURE_CHORD:
+                DEBUG_PRINTF("[UI] Button chord: mask 0x%02X\n", action.chordMask);
+                break;
         }
     }
     
@@ -109,74 +118,60 @@ bool UIManager::isButtonPressed(uint8_t pin) {
     return !digitalRead(pin); // Active LOW
 }
 
-void UIManager::setLED(LEDPattern pattern) {
-    currentLEDPattern = pattern;
-    blinkCount = 0;
-    
-    if (pattern == LED_OFF) {
-        digitalWrite(LED_STATUS_PIN, LOW);
-        ledState = false;
-    } else if (pattern == LED_ON) {
-        digitalWrite(LED_STATUS_PIN, HIGH);
-        ledState = true;
-    }
+void UIManager::printButtonStats() {
+    buttons.printStats();
 }
 
-void UIManager::updateLED() {
-    unsigned long currentTime = millis();
-    uint16_t interval = 0;
+void UIManager::setLED(LEDPattern pattern) {
+    // States re-assert their pattern on every refresh; don't restart it
+    if (pattern == currentLEDPattern) return;
+    currentLEDPattern = pattern;
+    
+    // On/off step durations in ms, starting with the LED on
+    static const uint16_t SLOW_BLINK[] = {500, 500};              // 1 Hz
+    static const uint16_t FAST_BLINK[] = {100, 100};              // 5 Hz
+    static const uint16_t DOUBLE_BLINK[] = {100, 100, 100, 600};  // Two blinks, then a gap
     
-    switch (currentLEDPattern) {
+    switch (pattern) {
+        case LED_OFF:
+            patterns.set(PATTERN_LED, false);
+            break;
+        case LED_ON:
+            patterns.set(PATTERN_LED, true);
+            break;
         case LED_SLOW_BLINK:
-            interval = 500; // 1 Hz (500ms on, 500ms off)
+            patterns.play(PATTERN_LED, SLOW_BLINK, 2, true);
             break;
         case LED_FAST_BLINK:
-            interval = 100; // 5 Hz (100ms on, 100ms off)
+            patterns.play(PATTERN_LED, FAST_BLINK, 2, true);
             break;
         case LED_DOUBLE_BLINK:
-            // Implement double blink pattern
-            if (currentTime - lastLEDToggle >= 100) {
-                ledState = !ledState;
-                digitalWrite(LED_STATUS_PIN, ledState);
-                lastLEDToggle = currentTime;
-                blinkCount++;
-                
-                if (blinkCount >= 4) { // 2 blinks (4 toggles)
-                    blinkCount = 0;
-                    delay(500); // Gap before repeat
-                }
-            }
-            return;
-        default:
-            return;
-    }
-    
-    if (interval > 0 && (currentTime - lastLEDToggle >= interval)) {
-        ledState = !ledState;
-        digitalWrite(LED_STATUS_PIN, ledState);
-        lastLEDToggle = currentTime;
+            patterns.play(PATTERN_LED, DOUBLE_BLINK, 4, true);
+            break;
     }
 }
 
 void UIManager::beep(uint16_t duration) {
-    digitalWrite(BUZZER_PIN, HIGH);
-    buzzerActive = true;
-    buzzerEndTime = millis() + duration;
+    patterns.play(PATTERN_BUZZER, &duration, 1, false);
 }
 
 void UIManager::beepPattern(uint8_t count, uint16_t duration, uint16_t gap) {
-    for (uint8_t i = 0; i < count; i++) {
-        digitalWrite(BUZZER_PIN, HIGH);
-        delay(duration);
-        digitalWrite(BUZZER_PIN, LOW);
-        if (i < count - 1) {
-            delay(gap);
+    // Beeps alternate with gaps; the sequence ends on the last beep
+    uint16_t steps[PATTERN_MAX_STEPS];
+    uint8_t stepCount = 0;
+    for (uint8_t i = 0; i < count && stepCount + 1 < PATTERN_MAX_STEPS; i++) {
+        if (i > 0) {
+            steps[stepCount++] = gap;
         }
+        steps[stepCount++] = duration;
     }
+    
+    patterns.play(PATTERN_BUZZER, steps, stepCount, false);
 }
 
 void UIManager::clearDisplay() {
     display.clearDisplay();
+    screenTemplate.invalidate();
 }
 
 void UIManager::showIdleScreen(const String& driverName, uint8_t satellites, float points) {
@@ -206,7 +201,7 @@ void UIManager::showIdleScreen(const String& driverName, uint8_t satellites, flo
     display.print(F("Points: "));
     display.print(points, 1);
     
-    display.display();
+    present();
 }
 
 void UIManager::showRideNotification(const RideInfo& ride) {
@@ -236,32 +231,45 @@ void UIManager::showRideNotification(const RideInfo& ride) {
         display.print(formatETA(ride.eta));
     }
     
-    display.display();
+    present();
     beepPattern(3, 200, 100);
 }
 
 void UIManager::showEnrouteToPickup(const RideInfo& ride, double currentDistance) {
-    currentPage = PAGE_ENROUTE;
-    display.clearDisplay();
-    
-    display.setTextSize(1);
-    drawCenteredText("EN ROUTE TO PICKUP", 0);
-    
-    display.setCursor(0, 15);
-    display.print(F("Pickup:"));
-    display.setCursor(0, 25);
-    display.print(ride.pickupAddress.substring(0, 20));
+    // Static layout is drawn once per ride; refreshes only touch the fields
+    if (currentPage != PAGE_ENROUTE || !screenTemplate.matches(PAGE_ENROUTE, ride.rideId)) {
+        currentPage = PAGE_ENROUTE;
+        display.clearDisplay();
+        
+        display.setTextSize(1);
+        drawCenteredText("EN ROUTE TO PICKUP", 0);
+        
+        display.setCursor(0, 16);
+        display.print(F("Pickup:"));
+        display.setCursor(0, 24);
+        display.print(ride.pickupAddress.substring(0, 20));
+        
+        display.setCursor(0, 40);
+        display.print(F("Distance: "));
+        
+        screenTemplate.capture(display, PAGE_ENROUTE, ride.rideId);
+    }
     
-    display.setCursor(0, 40);
-    display.print(F("Distance: "));
-    display.print(formatDistance(currentDistance));
+    String distance = formatDistance(currentDistance);
+    if (screenTemplate.updateField(display, 0, 60, 5, 68, 1, distance)) {
+        display.setTextSize(1);
+        display.setCursor(60, 40);
+        display.print(distance);
+    }
     
     // Progress bar
     uint8_t progress = 100 - (uint8_t)((currentDistance / ride.distanceToPickup) * 100);
     progress = constrain(progress, 0, 100);
-    drawProgressBar(0, 55, 128, 8, progress);
+    if (screenTemplate.updateField(display, 1, 0, 7, OLED_SCREEN_WIDTH, 1, String(progress))) {
+        drawProgressBar(0, 56, 128, 8, progress);
+    }
     
-    display.display();
+    present();
 }
 
 void UIManager::showArrivedAtPickup(const RideInfo& ride) {
@@ -275,31 +283,67 @@ void UIManager::showArrivedAtPickup(const RideInfo& ride) {
     drawCenteredText("Press PICKUP to", 35);
     drawCenteredText("confirm passenger", 45);
     
-    display.display();
+    present();
     beepPattern(2, 300, 200);
 }
 
 void UIManager::showRideActive(const RideInfo& ride, double distanceToDrop) {
-    currentPage = PAGE_RIDE_ACTIVE;
+    if (currentPage != PAGE_RIDE_ACTIVE || !screenTemplate.matches(PAGE_RIDE_ACTIVE, ride.rideId)) {
+        currentPage = PAGE_RIDE_ACTIVE;
+        display.clearDisplay();
+        
+        display.setTextSize(1);
+        drawCenteredText("RIDE IN PROGRESS", 0);
+        
+        display.setCursor(0, 16);
+        display.print(F("Drop:"));
+        display.setCursor(0, 24);
+        display.print(ride.dropAddress.substring(0, 20));
+        
+        display.setCursor(0, 40);
+        display.print(F("Distance: "));
+        
+        display.setCursor(0, 48);
+        display.print(F("Pts: "));
+        display.print(ride.estimatedPoints, 1);
+        
+        screenTemplate.capture(display, PAGE_RIDE_ACTIVE, ride.rideId);
+    }
+    
+    String distance = formatDistance(distanceToDrop);
+    if (screenTemplate.updateField(display, 0, 60, 5, 68, 1, distance)) {
+        display.setTextSize(1);
+        display.setCursor(60, 40);
+        display.print(distance);
+    }
+    
+    present();
+}
+
+void UIManager::showNextRideOffer(const RideInfo& nextRide, double distanceToDrop) {
+    currentPage = PAGE_NEXT_RIDE;
     display.clearDisplay();
     
     display.setTextSize(1);
-    drawCenteredText("RIDE IN PROGRESS", 0);
+    drawCenteredText("NEXT RIDE?", 0);
     
     display.setCursor(0, 15);
-    display.print(F("Drop:"));
+    display.print(F("Pickup:"));
     display.setCursor(0, 25);
-    display.print(ride.dropAddress.substring(0, 20));
+    display.print(nextRide.pickupAddress.substring(0, 20));
     
-    display.setCursor(0, 40);
-    display.print(F("Distance: "));
+    display.setCursor(0, 35);
+    display.print(F("Pts: "));
+    display.print(nextRide.estimatedPoints, 1);
+    
+    display.setCursor(0, 45);
+    display.print(F("Drop in: "));
     display.print(formatDistance(distanceToDrop));
     
-    display.setCursor(0, 50);
-    display.print(F("Pts: "));
-    display.print(ride.estimatedPoints, 1);
+    display.setCursor(0, 55);
+    display.print(F("ACCEPT / REJECT"));
     
-    display.display();
+    present();
 }
 
 void UIManager::showCompletedScreen(float pointsAwarded, bool needsReview) {
@@ -320,7 +364,7 @@ void UIManager::showCompletedScreen(float pointsAwarded, bool needsReview) {
         drawCenteredText("(Pending Review)", 55);
     }
     
-    display.display();
+    present();
     beepPattern(4, 100, 100);
 }
 
@@ -334,7 +378,7 @@ void UIManager::showErrorScreen(const String& errorMsg) {
     display.setCursor(0, 30);
     display.print(errorMsg.substring(0, 20));
     
-    display.display();
+    present();
 }
 
 void UIManager::showConnectionStatus(bool wifi, bool mqtt, bool gps) {
@@ -347,11 +391,20 @@ void UIManager::showConnectionStatus(bool wifi, bool mqtt, bool gps) {
     display.print(gps ? "Y" : "N");
 }
 
+void UIManager::setPendingSync(uint16_t count) {
+    pendingSyncCount = count;
+}
+
+void UIManager::setOffline(bool linkDown) {
+    offline = linkDown;
+}
+
 void UIManager::showMessage(const String& msg, uint16_t duration) {
     display.clearDisplay();
+    screenTemplate.invalidate();
     display.setTextSize(1);
     drawCenteredText(msg, 28);
-    display.display();
+    displayService.submit();
     delay(duration);
 }
 
@@ -368,6 +421,91 @@ void UIManager::drawProgressBar(int16_t x, int16_t y, uint16_t width, uint16_t h
     }
 }
 
+void UIManager::present() {
+    int16_t x = OLED_SCREEN_WIDTH - 14;
+    
+    // Retained screens keep the back buffer, so undo the previous badges first
+    if (screenTemplate.isLayout(currentPage)) {
+        screenTemplate.restore(display, 0, 0, 14, 1);
+        screenTemplate.restore(display, x, 0, 14, 1);
+    }
+    
+    // Offline badge: the ride continues, confirmations wait for the link
+    if (offline) {
+        display.fillRect(0, 0, 14, 8, SSD1306_WHITE);
+        display.setTextSize(1);
+        display.setTextColor(SSD1306_BLACK);
+        display.setCursor(1, 0);
+        display.print(F("NW"));
+        display.setTextColor(SSD1306_WHITE);
+    }
+    
+    // Pending-sync badge: confirmations committed here but not yet delivered
+    if (pendingSyncCount > 0) {
+        display.fillRect(x, 0, 14, 8, SSD1306_WHITE);
+        display.setTextSize(1);
+        display.setTextColor(SSD1306_BLACK);
+        display.setCursor(x + 1, 0);
+        display.print('S');
+        display.print(pendingSyncCount > 9 ? '+' : (char)('0' + pendingSyncCount));
+        display.setTextColor(SSD1306_WHITE);
+    }
+    
+    FrameDiff diff = displayService.submit();
+    
+    ScreenCost& cost = screenCosts[currentPage];
+    cost.frames++;
+    cost.bytes += diff.bytes;
+    cost.pixels += diff.pixels;
+    if (diff.bytes > cost.maxBytes) {
+        cost.maxBytes = diff.bytes;
+    }
+
+#if DISPLAY_SNAPSHOTS
+    if (currentPage != lastPresentedPage) {
+        dumpSnapshot(currentPage);
+    }
+#endif
+    lastPresentedPage = currentPage;
+}
+
+void UIManager::dumpSnapshot(ScreenPage page) {
+    // Plain PBM (P1) of the back buffer; lit OLED pixels come out as 1 (black)
+    const uint8_t* buffer = display.getBuffer();
+    if (buffer == nullptr) return;
+    
+    char row[OLED_SCREEN_WIDTH + 1];
+    row[OLED_SCREEN_WIDTH] = '\0';
+    
+    DEBUG_PRINTF("[SNAP] begin %s\n", pageName(page));
+    DEBUG_PRINTF("P1\n# %s\n%d %d\n", pageName(page), OLED_SCREEN_WIDTH, OLED_SCREEN_HEIGHT);
+    for (uint8_t y = 0; y < OLED_SCREEN_HEIGHT; y++) {
+        const uint8_t* cells = buffer + (y / 8) * OLED_SCREEN_WIDTH;
+        uint8_t bit = 1 << (y & 7);
+        for (uint8_t x = 0; x < OLED_SCREEN_WIDTH; x++) {
+            row[x] = (cells[x] & bit) ? '1' : '0';
+        }
+        DEBUG_PRINTLN(row);
+    }
+    DEBUG_PRINTLN(F("[SNAP] end"));
+}
+
+void UIManager::printDisplayStats() {
+    displayService.printStats();
+    DEBUG_PRINTF("   Layouts: %u rendered | Fields: %u redrawn, %u unchanged\n",
+                 screenTemplate.getLayoutsRendered(), screenTemplate.getFieldsRedrawn(),
+                 screenTemplate.getFieldsSkipped());
+    
+    for (uint8_t i = 0; i < PAGE_COUNT; i++) {
+        const ScreenCost& cost = screenCosts[i];
+        if (cost.frames == 0) continue;
+        DEBUG_PRINTF("   %-10s %5u frames | avg %4lu B, %4lu px | max %4u B\n",
+                     pageName((ScreenPage)i), cost.frames,
+                     (unsigned long)(cost.bytes / cost.frames),
+                     (unsigned long)(cost.pixels / cost.frames), cost.maxBytes);
+    }
+}
+
 void UIManager::drawCenteredText(const String& text, int16_t y, uint8_t size) {
     display.setTextSize(size);
     int16_t x1, y1;
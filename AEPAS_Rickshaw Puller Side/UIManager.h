@@ -11,6 +11,10 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include "Config.h"
+#include "PatternSequencer.h"
+#include "DisplayService.h"
+#include "ScreenTemplate.h"
+#include "ButtonInput.h"
 
 // Button states
 enum ButtonState {
@@ -37,8 +41,18 @@ enum ScreenPage {
     PAGE_ENROUTE,
     PAGE_ARRIVED,
     PAGE_RIDE_ACTIVE,
+    PAGE_NEXT_RIDE,
     PAGE_COMPLETED,
-    PAGE_ERROR
+    PAGE_ERROR,
+    PAGE_COUNT
+};
+
+// Accumulated render cost of one screen page
+struct ScreenCost {
+    uint32_t frames;
+    uint32_t bytes;         // Changed buffer bytes over all frames
+    uint32_t pixels;        // Flipped pixels over all frames
+    uint16_t maxBytes;      // Most expensive single frame
 };
 
 struct RideInfo {
@@ -60,13 +74,14 @@ public:
     void begin();
     void update();
     
-    // Button handling
+    // Button handling (edges are captured by interrupt; one press per call)
+    void onButtonEdgeISR(uint8_t pin);
     ButtonState readButtons();
     bool isButtonPressed(uint8_t pin);
+    void printButtonStats();
     
-    // LED control
+    // LED control (patterns run from a timer; calls return immediately)
     void setLED(LEDPattern pattern);
-    void updateLED();
     
     // Buzzer control
     void beep(uint16_t duration = 100);
@@ -79,36 +94,42 @@ public:
     void showEnrouteToPickup(const RideInfo& ride, double currentDistance);
     void showArrivedAtPickup(const RideInfo& ride);
     void showRideActive(const RideInfo& ride, double distanceToDrop);
+    void showNextRideOffer(const RideInfo& nextRide, double distanceToDrop);
     void showCompletedScreen(float pointsAwarded, bool needsReview);
     void showErrorScreen(const String& errorMsg);
     void showConnectionStatus(bool wifi, bool mqtt, bool gps);
     
+    void setPendingSync(uint16_t count);
+    void setOffline(bool linkDown);
+    
     // Utility
     void showMessage(const String& msg, uint16_t duration = 2000);
     void drawProgressBar(int16_t x, int16_t y, uint16_t width, uint16_t height, uint8_t percent);
+    void printDisplayStats();
 
 private:
-    Adafruit_SSD1306 display;
+    Adafruit_SSD1306 display;       // Back buffer; DisplayService flushes it
+    DisplayService displayService;
+    ScreenTemplate screenTemplate;  // Retained layout for the en-route/ride screens
     
-    // Button debouncing
-    unsigned long lastButtonPress[4];
-    bool buttonStates[4];
+    // Button capture and debouncing
+    ButtonInput buttons;
     
-    // LED state
+    // LED and buzzer sequences
+    PatternSequencer patterns;
     LEDPattern currentLEDPattern;
-    unsigned long lastLEDToggle;
-    bool ledState;
-    uint8_t blinkCount;
-    
-    // Buzzer state
-    bool buzzerActive;
-    unsigned long buzzerEndTime;
     
     // Screen state
     ScreenPage currentPage;
     unsigned long lastScreenUpdate;
+    uint16_t pendingSyncCount;      // Shown as a badge on ride screens
+    bool offline;                   // Link down: badge instead of the error screen
+    ScreenPage lastPresentedPage;
+    ScreenCost screenCosts[PAGE_COUNT];
     
     // Helper methods
+    void present();
+    void dumpSnapshot(ScreenPage page);
     void drawCenteredText(const String& text, int16_t y, uint8_t size = 1);
     void drawRightAlignedText(const String& text, int16_t y, int16_t x, uint8_t size = 1);
     String formatDistance(double meters);
@@ -24,6 +24,8 @@
 #include "FSMController.h"
 #include "PointsManager.h"
 #include "LocalStore.h"
+#include "Scheduler.h"
+#include "PowerManager.h"
 
 // ============================================================================
 // GLOBAL OBJECTS
@@ -35,6 +37,16 @@ UIManager uiManager;
 PointsManager pointsManager;
 LocalStore localStore;
 FSMController fsmController(gpsManager, commManager, uiManager, pointsManager, localStore);
+PowerManager powerManager(gpsManager);
+// Core 1 (Arduino loop task): FSM, UI, buttons
+Scheduler scheduler;
+int8_t buttonTaskId = -1;
+int8_t uiTaskId = -1;
+int8_t inboundTaskId = -1;
+
+// Core 0: GPS ingest and network I/O
+Scheduler netScheduler;
+TaskHandle_t netTaskHandle = nullptr;
 
 // ============================================================================
 // FUNCTION DECLARATIONS
@@ -43,6 +55,9 @@ FSMController fsmController(gpsManager, commManager, uiManager, pointsManager, l
 void printSystemInfo();
 void printRuntimeStatus();
 void onMqttMessage(const char* topic, const char* payload);
+void registerTasks();
+void startNetworkTask();
+void handleButton(ButtonState button);
 
 // ============================================================================
 // CALLBACK FUNCTIONS
@@ -102,6 +117,7 @@ void setup() {
     // 4. Initialize Communication Manager (WiFi, MQTT)
     commManager.begin();
     commManager.setMessageCallback(onMqttMessage);
+    powerManager.begin();
     
     // Connect to WiFi
     uiManager.showMessage("Connecting WiFi...", 1000);
@@ -135,48 +151,59 @@ void setup() {
     // Show ready screen
     uiManager.showMessage("System Ready!", 1000);
     uiManager.setLED(LED_SLOW_BLINK);
+    
+    // Hand the loop over to the scheduler
+    registerTasks();
 }
 
 // ============================================================================
-// MAIN LOOP
+// SCHEDULED TASKS
 // ============================================================================
 
-void loop() {
-    static unsigned long lastGPSUpdate = 0;
-    static unsigned long lastCommUpdate = 0;
-    static unsigned long lastFSMUpdate = 0;
-    static unsigned long lastUIUpdate = 0;
-    static unsigned long lastStatusPublish = 0;
-    static unsigned long lastStatusPrint = 0;  // For serial status printing
-    
-    unsigned long currentTime = millis();
-    
-    // Update GPS (every 3 seconds or as configured)
-    if (currentTime - lastGPSUpdate >= GPS_UPDATE_INTERVAL) {
-        gpsManager.update();
-        lastGPSUpdate = currentTime;
-    }
-    
-    // Update Communication Manager (handles reconnection and message processing)
-    if (currentTime - lastCommUpdate >= 100) { // Check every 100ms
-        commManager.update();
-        lastCommUpdate = currentTime;
-    }
-    
-    // Update FSM Controller (main state machine logic)
-    if (currentTime - lastFSMUpdate >= 100) { // Check every 100ms
-        fsmController.update();
-        lastFSMUpdate = currentTime;
-    }
-    
-    // Update UI Manager (LED patterns, buzzer, etc.)
-    if (currentTime - lastUIUpdate >= 50) { // Check every 50ms
-        uiManager.update();
-        lastUIUpdate = currentTime;
+void taskGPS() {
+    gpsManager.update();
+}
+
+void taskComm() {
+    // Handles reconnection, message processing and queued publishes
+    commManager.update();
+}
+
+void taskInbound() {
+    // Delivers queued MQTT messages to onMqttMessage on this core
+    commManager.dispatchInbound();
+}
+
+void onInboundQueued() {
+    // Network task -> loop task
+    scheduler.triggerNow(inboundTaskId);
+}
+
+void taskFSM() {
+    // Main state machine logic
+    fsmController.update();
+}
+
+void taskUI() {
+    // LED patterns, buzzer, etc.
+    uiManager.setPendingSync(commManager.getPendingSyncCount());
+    uiManager.setOffline(!commManager.isWiFiLinkUp() || !commManager.isMQTTLinkUp());
+    uiManager.update();
+}
+
+void taskButtons() {
+    // Drain every queued press, not just the first
+    ButtonState button;
+    bool handled = false;
+    while ((button = uiManager.readButtons()) != BTN_NONE) {
+        handleButton(button);
+        handled = true;
     }
-    
-    // Handle button presses
-    ButtonState button = uiManager.readButtons();
+    powerManager.recordButtonHandled(handled);
+    powerManager.rearmButtonWake();
+}
+
+void handleButton(ButtonState button) {
     switch (button) {
         case BTN_ACCEPT:
             DEBUG_PRINTLN(F("🔵 [BUTTON] ACCEPT pressed"));
@@ -197,28 +224,105 @@ void loop() {
         default:
             break;
     }
-    
-    // Publish status/location periodically (heartbeat)
-    if (currentTime - lastStatusPublish >= HEARTBEAT_INTERVAL) {
-        if (commManager.isMQTTConnected() && gpsManager.isValid()) {
-            GPSData gpsData = gpsManager.getCurrentLocation();
-            commManager.publishStatus(
-                String(stateToString(fsmController.getCurrentState())),
-                gpsData.latitude,
-                gpsData.longitude
-            );
-        }
-        lastStatusPublish = currentTime;
+}
+
+void taskHeartbeat() {
+    // Publish status/location periodically (sent by the network task)
+    if (commManager.isMQTTLinkUp() && gpsManager.isValid()) {
+        GPSData gpsData = gpsManager.getCurrentLocation();
+        OutboundRequest request = {};
+        request.type = EVENT_STATUS;
+        strlcpy(request.text, stateToString(fsmController.getCurrentState()), sizeof(request.text));
+        request.lat = gpsData.latitude;
+        request.lon = gpsData.longitude;
+        commManager.postRequest(request);
     }
+}
+
+void networkTask(void* param) {
+    netScheduler.begin();
+    netScheduler.addPeriodic("gps", taskGPS, GPS_UPDATE_INTERVAL);
+    netScheduler.addPeriodic("comm", taskComm, COMM_UPDATE_INTERVAL);
     
-    // Print runtime status to Serial Monitor every 10 seconds
-    if (currentTime - lastStatusPrint >= 10000) {
-        printRuntimeStatus();
-        lastStatusPrint = currentTime;
+    for (;;) {
+        netScheduler.run();
+    }
+}
+
+/**
+ * Move GPS parsing and MQTT I/O (incl. HMAC signing) off the UI core so a
+ * slow broker or reconnect cannot stall buttons and display
+ */
+void startNetworkTask() {
+    commManager.setInboundNotify(onInboundQueued);
+    xTaskCreatePinnedToCore(networkTask, "net", NET_TASK_STACK_SIZE, nullptr,
+                            NET_TASK_PRIORITY, &netTaskHandle, NET_TASK_CORE);
+}
+
+void taskStore() {
+    // Batched NVS commits for the LocalStore cache
+    localStore.update();
+    
+    // A backend ack for a drop's idempotency key, or the broker echoing the
+    // probe sent after the drop, moves the ledger sync cursor
+    DeliveryAck ack;
+    while (commManager.takeDropAck(ack)) {
+        localStore.markRideSynced(ack.rideId);
     }
+}
+
+void taskPower() {
+    bool modeChanged = powerManager.update(fsmController.getCurrentState(),
+                                           netScheduler.getSleepMs(), scheduler.getSleepMs());
+    if (!modeChanged) return;
+    
+    // Fewer wakeups while parked; button edges still wake the CPU
+    bool idle = powerManager.isIdleMode();
+    scheduler.setPeriod(uiTaskId, idle ? IDLE_UI_UPDATE_INTERVAL : UI_UPDATE_INTERVAL);
+    scheduler.setPeriod(buttonTaskId, idle ? IDLE_BUTTON_POLL_INTERVAL : BUTTON_POLL_INTERVAL);
+}
+
+void IRAM_ATTR onButtonEdge(void* arg) {
+    uint8_t pin = (uint8_t)(uintptr_t)arg;
+    uiManager.onButtonEdgeISR(pin);
+    powerManager.onButtonEdgeISR(pin);
     
-    // Small delay to prevent watchdog issues
-    delay(10);
+    // Run the button task now instead of waiting for the next poll
+    scheduler.triggerFromISR(buttonTaskId);
+}
+
+/**
+ * Register module updates with the scheduler
+ */
+void registerTasks() {
+    scheduler.begin();
+    
+    inboundTaskId = scheduler.addPeriodic("inbound", taskInbound, INBOUND_POLL_INTERVAL);
+    scheduler.addPeriodic("fsm", taskFSM, FSM_UPDATE_INTERVAL);
+    uiTaskId = scheduler.addPeriodic("ui", taskUI, UI_UPDATE_INTERVAL);
+    buttonTaskId = scheduler.addPeriodic("buttons", taskButtons, BUTTON_POLL_INTERVAL);
+    scheduler.addPeriodic("heartbeat", taskHeartbeat, HEARTBEAT_INTERVAL, HEARTBEAT_INTERVAL);
+    scheduler.addPeriodic("status", printRuntimeStatus, STATUS_PRINT_INTERVAL, STATUS_PRINT_INTERVAL);
+    scheduler.addPeriodic("power", taskPower, POWER_UPDATE_INTERVAL);
+    scheduler.addPeriodic("store", taskStore, STORE_UPDATE_INTERVAL, STORE_UPDATE_INTERVAL);
+    
+    // Button edges (both directions) are queued with timestamps and wake the loop;
+    // the periodic poll remains as a fallback for long presses and missed releases
+    attachInterruptArg(digitalPinToInterrupt(BTN_ACCEPT_PIN), onButtonEdge, (void*)BTN_ACCEPT_PIN, CHANGE);
+    attachInterruptArg(digitalPinToInterrupt(BTN_REJECT_PIN), onButtonEdge, (void*)BTN_REJECT_PIN, CHANGE);
+    attachInterruptArg(digitalPinToInterrupt(BTN_PICKUP_PIN), onButtonEdge, (void*)BTN_PICKUP_PIN, CHANGE);
+    attachInterruptArg(digitalPinToInterrupt(BTN_DROP_PIN), onButtonEdge, (void*)BTN_DROP_PIN, CHANGE);
+    
+    startNetworkTask();
+}
+
+// ============================================================================
+// MAIN LOOP
+// ============================================================================
+
+void loop() {
+    // Runs due tasks, then sleeps until the next deadline or a button edge
+    scheduler.run();
 }
 
 // ============================================================================
@@ -247,6 +351,7 @@ void printSystemInfo() {
     
     if (commManager.isMQTTConnected()) {
         DEBUG_PRINTF("MQTT Broker: %s:%d\n", MQTT_BROKER, MQTT_PORT);
+        DEBUG_PRINTF("MQTT Client ID: %s\n", commManager.getClientId().c_str());
         DEBUG_PRINTLN(F("MQTT: Connected"));
     } else {
         DEBUG_PRINTLN(F("MQTT: Not connected"));
@@ -307,22 +412,37 @@ void printRuntimeStatus() {
     // FSM State
     SystemState currentState = fsmController.getCurrentState();
     DEBUG_PRINTF("🚦 FSM State: %s\n", stateToString(currentState));
+    DEBUG_PRINTF("   Next-ride offers: %u | Chained rides: %u\n",
+                 fsmController.getNextRideOffers(), fsmController.getChainedRides());
+    if (fsmController.getRecoveryMs() > 0) {
+        DEBUG_PRINTF("   Resumed ride after reset: screen restored in %lu ms\n",
+                     fsmController.getRecoveryMs());
+    }
     DEBUG_PRINTLN(F(""));
     
     // Network Status
     DEBUG_PRINTLN(F("🌐 Network Status:"));
-    if (commManager.isWiFiConnected()) {
+    if (commManager.isWiFiLinkUp()) {
         DEBUG_PRINTF("   WiFi: ✅ Connected | RSSI: %d dBm | IP: %s\n", 
                      WiFi.RSSI(), WiFi.localIP().toString().c_str());
     } else {
         DEBUG_PRINTLN(F("   WiFi: ❌ Disconnected"));
     }
     
-    if (commManager.isMQTTConnected()) {
+    if (commManager.isMQTTLinkUp()) {
         DEBUG_PRINTLN(F("   MQTT: ✅ Connected"));
     } else {
         DEBUG_PRINTLN(F("   MQTT: ❌ Disconnected"));
     }
+    MqttSessionStats session = commManager.getSessionStats();
+    DEBUG_PRINTF("   Session: %s | Connects: %u | Drops: %u | Msgs: %u\n",
+                 commManager.getClientId().c_str(), session.connects,
+                 session.disconnects, session.messagesReceived);
+    DEBUG_PRINTF("   Offline Gap: last %lu ms, longest %lu ms | SUBSCRIBEs: %u\n",
+                 session.lastGapMs, session.longestGapMs, session.subscribeRequests);
+    DEBUG_PRINTF("   Offer-to-screen: last %lu ms, max %lu ms (budget %d ms)\n",
+                 (unsigned long)commManager.getLastDeliveryMs(),
+                 (unsigned long)commManager.getMaxDeliveryMs(), OFFER_LATENCY_BUDGET_MS);
     DEBUG_PRINTLN(F(""));
     
     // GPS Status
@@ -348,6 +468,12 @@ void printRuntimeStatus() {
     DEBUG_PRINTF("   Driver ID: %s\n", localStore.getDriverId().c_str());
     DEBUG_PRINTF("   Total Points: %.2f\n", localStore.getTotalPoints());
     DEBUG_PRINTF("   Completed Rides: %u\n", localStore.getRideCount());
+    DEBUG_PRINTF("   Ledger: %u unsynced\n", localStore.getUnsyncedLedgerEntries());
+    time_t now = time(nullptr);
+    DEBUG_PRINTF("   History: %u rides logged, %u today\n", localStore.getRideHistoryCount(),
+                 now >= (time_t)CLOCK_VALID_AFTER ? localStore.countRidesOnDay(RideHistory::dayOf(now)) : 0);
+    DEBUG_PRINTF("   Flash Writes: %u (%u/h)%s\n", localStore.getFlashWrites(),
+                 localStore.getFlashWritesPerHour(), localStore.isDirty() ? " | commit pending" : "");
     DEBUG_PRINTLN(F(""));
     
     // Memory Status
@@ -364,6 +490,25 @@ void printRuntimeStatus() {
                  digitalRead(BTN_REJECT_PIN) ? "⚪" : "🔵",
                  digitalRead(BTN_PICKUP_PIN) ? "⚪" : "🔵",
                  digitalRead(BTN_DROP_PIN) ? "⚪" : "🔵");
+    uiManager.printButtonStats();
+    DEBUG_PRINTLN(F(""));
+    
+    // Display Status
+    DEBUG_PRINTLN(F("🖥️  Display:"));
+    uiManager.printDisplayStats();
+    DEBUG_PRINTLN(F(""));
+    
+    // Power Status
+    DEBUG_PRINTLN(F("🔋 Power:"));
+    powerManager.printStats();
+    DEBUG_PRINTLN(F(""));
+    
+    // Scheduler Status
+    scheduler.printStats();
+    netScheduler.printStats();
+    DEBUG_PRINTF("   Queue drops: inbound %u | outbound %u | gps %u\n",
+                 commManager.getDroppedMessages(), commManager.getDroppedRequests(),
+                 gpsManager.getDroppedFixes());
     DEBUG_PRINTLN(F(""));
     
     // Offline Queue Status
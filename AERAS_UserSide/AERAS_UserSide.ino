@@ -55,6 +55,7 @@
 #include "BuzzerController.h"
 #include "CommunicationManager.h"
 #include "FSMController.h"
+#include "Scheduler.h"
 
 // ========================================================================
 // GLOBAL CONSTANTS
@@ -68,12 +69,17 @@ const char* AVAILABLE_DESTINATIONS[] = {
     "RAOJAN"
 };
 
+// Ultrasonic array layout (config.h)
+const uint8_t ULTRASONIC_TRIGS[] = ULTRASONIC_TRIG_PINS;
+const uint8_t ULTRASONIC_ECHOS[] = ULTRASONIC_ECHO_PINS;
+const int8_t ULTRASONIC_BEARINGS[] = ULTRASONIC_BEARINGS_DEG;
+
 // ========================================================================
 // GLOBAL OBJECTS
 // ========================================================================
 
 // Hardware modules
-UltrasonicSensor ultrasonic(ULTRASONIC_TRIG_PIN, ULTRASONIC_ECHO_PIN);
+UltrasonicSensor ultrasonic(ULTRASONIC_TRIGS, ULTRASONIC_ECHOS, ULTRASONIC_BEARINGS, ULTRASONIC_SENSOR_COUNT);
 PrivilegeSensor privilegeSensor(PRIVILEGE_SENSOR_PIN);
 ButtonManager button(BUTTON_PIN, BUTTON_ACTIVE_LOW);
 OLEDDisplay display;
@@ -84,9 +90,12 @@ CommunicationManager comm;
 // FSM Controller
 FSMController* fsm = nullptr;
 
-// Timing for high-frequency updates
-unsigned long lastPrivilegeUpdate = 0;
-unsigned long lastDisplayUpdate = 0;
+// Cooperative scheduler driving loop()
+Scheduler scheduler;
+int8_t controlTaskId = -1;
+int8_t ultrasonicTaskId = -1;
+
+void registerTasks();
 
 // ========================================================================
 // SETUP
@@ -165,47 +174,83 @@ void setup() {
     
     // Print test case validation info
     printTestCaseInfo();
+    
+    // Hand the loop over to the scheduler
+    registerTasks();
 }
 
 // ========================================================================
-// MAIN LOOP
+// SCHEDULED TASKS
 // ========================================================================
 
-void loop() {
-    unsigned long currentTime = millis();
-    
-    // Update ultrasonic sensor (100ms interval)
+void taskPrivilege() {
+    // High frequency for accurate pulse detection
+    privilegeSensor.update();
+}
+
+void taskUltrasonic() {
     ultrasonic.update();
     
-    // Update privilege sensor (high frequency for accurate pulse detection)
-    if (currentTime - lastPrivilegeUpdate >= 1) {  // 1ms = 1kHz
-        privilegeSensor.update();
-        lastPrivilegeUpdate = currentTime;
+    // Follow the sensor's adaptive rate so results are picked up promptly
+    static uint32_t periodMs = ULTRASONIC_SAMPLE_INTERVAL;
+    if (ultrasonic.getSampleInterval() != periodMs) {
+        periodMs = ultrasonic.getSampleInterval();
+        scheduler.setPeriod(ultrasonicTaskId, periodMs);
     }
-    
-    // Update button
+}
+
+void taskControl() {
     button.update();
-    
-    // Update display (500ms interval)
-    if (currentTime - lastDisplayUpdate >= OLED_REFRESH_INTERVAL_MS) {
-        display.update();
-        lastDisplayUpdate = currentTime;
-    }
-    
-    // Update LEDs (for blinking)
-    leds.update();
-    
-    // Update buzzer (for tone management)
     buzzer.update();
-    
-    // Update communication (WiFi/MQTT)
+    fsm->update();
+}
+
+void taskLEDs() {
+    leds.update();
+}
+
+void taskDisplay() {
+    display.update();
+}
+
+void taskComm() {
     comm.update();
+}
+
+void taskStatus() {
+    scheduler.printStats();
+    DEBUG_PRINTLN("=== Display ===");
+    display.printStats();
+    DEBUG_PRINTLN("=== Ultrasonic ===");
+    ultrasonic.printStats();
+}
+
+void IRAM_ATTR onButtonEdge() {
+    // Handle the press now instead of waiting for the next control tick
+    scheduler.triggerFromISR(controlTaskId);
+}
+
+void registerTasks() {
+    scheduler.begin();
     
-    // Update FSM (main state machine)
-    fsm->update();
+    scheduler.addPeriodic("privilege", taskPrivilege, PRIVILEGE_UPDATE_INTERVAL_MS);
+    ultrasonicTaskId = scheduler.addPeriodic("ultrasonic", taskUltrasonic, ULTRASONIC_SAMPLE_INTERVAL);
+    controlTaskId = scheduler.addPeriodic("control", taskControl, CONTROL_UPDATE_INTERVAL_MS);
+    scheduler.addPeriodic("leds", taskLEDs, LED_UPDATE_INTERVAL_MS);
+    scheduler.addPeriodic("display", taskDisplay, OLED_REFRESH_INTERVAL_MS);
+    scheduler.addPeriodic("comm", taskComm, COMM_UPDATE_INTERVAL_MS);
+    scheduler.addPeriodic("status", taskStatus, STATUS_PRINT_INTERVAL_MS, STATUS_PRINT_INTERVAL_MS);
     
-    // Small delay to prevent watchdog issues
-    delay(1);
+    attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), onButtonEdge, CHANGE);
+}
+
+// ========================================================================
+// MAIN LOOP
+// ========================================================================
+
+void loop() {
+    // Runs due tasks, then sleeps until the next deadline or a button edge
+    scheduler.run();
 }
 
 // ========================================================================
@@ -0,0 +1,152 @@
+/**
+ * AERAS - Asynchronous Display Flush Service Implementation
+ */
+
+#include "DisplayService.h"
+
+DisplayService::DisplayService()
+    : display(nullptr), address(0), flushTask(nullptr),
+      framePending(false), panelValid(false),
+      framesSubmitted(0), framesFlushed(0), framesSkipped(0), bytesFlushed(0),
+      lastFlushBytes(0), lastFlushUs(0), maxFlushUs(0) {
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    memset(frontBuffer, 0, DISPLAY_FRAME_BYTES);
+}
+
+bool DisplayService::begin(Adafruit_SSD1306& oled, uint8_t i2cAddress) {
+    display = &oled;
+    address = i2cAddress;
+    Wire.setClock(DISPLAY_I2C_CLOCK_HZ);
+    
+    if (xTaskCreatePinnedToCore(taskEntry, "display", DISPLAY_TASK_STACK_SIZE, this,
+                                DISPLAY_TASK_PRIORITY, &flushTask, DISPLAY_TASK_CORE) != pdPASS) {
+        DEBUG_PRINTLN("[DISP] ERROR: Flush task creation failed, flushing inline");
+        flushTask = nullptr;
+        return false;
+    }
+    
+    DEBUG_PRINTF("[DISP] Display service started (I2C %lu Hz)\n", (unsigned long)DISPLAY_I2C_CLOCK_HZ);
+    return true;
+}
+
+FrameDiff DisplayService::submit() {
+    FrameDiff diff = {0, 0};
+    uint8_t* backBuffer = display ? display->getBuffer() : nullptr;
+    if (backBuffer == nullptr) return diff;  // display.begin() failed
+    
+    // Only submit() writes the front buffer, so it can be read here unlocked
+    for (uint16_t i = 0; i < DISPLAY_FRAME_BYTES; i++) {
+        uint8_t changed = backBuffer[i] ^ frontBuffer[i];
+        if (changed) {
+            diff.bytes++;
+            diff.pixels += __builtin_popcount(changed);
+        }
+    }
+    
+    portENTER_CRITICAL(&lock);
+    if (framePending) {
+        framesSkipped++;
+    }
+    memcpy(frontBuffer, backBuffer, DISPLAY_FRAME_BYTES);
+    framePending = true;
+    framesSubmitted++;
+    portEXIT_CRITICAL(&lock);
+    
+    if (flushTask) {
+        xTaskNotifyGive(flushTask);
+    } else if (takeFrame()) {
+        flush();
+    }
+    return diff;
+}
+
+void DisplayService::taskEntry(void* arg) {
+    static_cast<DisplayService*>(arg)->run();
+}
+
+void DisplayService::run() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (takeFrame()) {
+            flush();
+        }
+    }
+}
+
+bool DisplayService::takeFrame() {
+    // Copy out under the lock so the UI can submit again during the I2C transfer
+    portENTER_CRITICAL(&lock);
+    bool pending = framePending;
+    if (pending) {
+        memcpy(flushBuffer, frontBuffer, DISPLAY_FRAME_BYTES);
+        framePending = false;
+    }
+    portEXIT_CRITICAL(&lock);
+    return pending;
+}
+
+void DisplayService::flush() {
+    unsigned long start = micros();
+    uint16_t sent = 0;
+    
+    // Per 8-row page, send only the column span that differs from the panel
+    for (uint8_t page = 0; page < OLED_PAGE_COUNT; page++) {
+        const uint8_t* row = flushBuffer + page * OLED_WIDTH;
+        uint8_t* shown = panelBuffer + page * OLED_WIDTH;
+        
+        int16_t first = 0;
+        int16_t last = OLED_WIDTH - 1;
+        if (panelValid) {
+            while (first < OLED_WIDTH && row[first] == shown[first]) first++;
+            if (first == OLED_WIDTH) continue;
+            while (row[last] == shown[last]) last--;
+        }
+        
+        sendWindow(page, first, last, row + first);
+        memcpy(shown + first, row + first, last - first + 1);
+        sent += last - first + 1;
+    }
+    panelValid = true;
+    
+    unsigned long elapsed = micros() - start;
+    framesFlushed++;
+    bytesFlushed += sent;
+    lastFlushBytes = sent;
+    lastFlushUs = elapsed;
+    if (elapsed > maxFlushUs) {
+        maxFlushUs = elapsed;
+    }
+}
+
+void DisplayService::sendWindow(uint8_t page, uint8_t firstCol, uint8_t lastCol, const uint8_t* data) {
+    // Address window (horizontal addressing mode, set by display.begin())
+    Wire.beginTransmission(address);
+    Wire.write((uint8_t)0x00);      // Co = 0, D/C = 0: command stream
+    Wire.write((uint8_t)SSD1306_COLUMNADDR);
+    Wire.write(firstCol);
+    Wire.write(lastCol);
+    Wire.write((uint8_t)SSD1306_PAGEADDR);
+    Wire.write(page);
+    Wire.write(page);
+    Wire.endTransmission();
+    
+    uint16_t remaining = lastCol - firstCol + 1;
+    while (remaining > 0) {
+        uint16_t chunk = remaining < OLED_I2C_CHUNK ? remaining : OLED_I2C_CHUNK;
+        Wire.beginTransmission(address);
+        Wire.write((uint8_t)0x40);  // Co = 0, D/C = 1: data stream
+        Wire.write(data, chunk);
+        Wire.endTransmission();
+        data += chunk;
+        remaining -= chunk;
+    }
+}
+
+void DisplayService::printStats() {
+    unsigned long avgBytes = framesFlushed > 0 ? bytesFlushed / framesFlushed : 0;
+    DEBUG_PRINTF("   Frames: %u submitted, %u flushed, %u skipped\n",
+                 framesSubmitted, framesFlushed, framesSkipped);
+    DEBUG_PRINTF("   Bytes/frame: last %u, avg %lu of %d\n",
+                 lastFlushBytes, avgBytes, DISPLAY_FRAME_BYTES);
+    DEBUG_PRINTF("   Flush time: last %lu us, max %lu us\n", lastFlushUs, maxFlushUs);
+}
@@ -0,0 +1,105 @@
+/**
+ * AERAS - Asynchronous Display Flush Service
+ * 
+ * Features:
+ * - Double buffering: UI draws into the Adafruit_SSD1306 back buffer,
+ *   submit() copies it to the front buffer and returns
+ * - Background task sends the front buffer over I2C at DISPLAY_I2C_CLOCK_HZ
+ * - Only changed page/column windows are sent
+ * - Frames replaced before they are sent are skipped
+ * - The flush task owns the I2C bus after begin()
+ */
+
+#ifndef DISPLAY_SERVICE_H
+#define DISPLAY_SERVICE_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_SSD1306.h>
+#include "config.h"
+
+#define DISPLAY_FRAME_BYTES     (OLED_WIDTH * OLED_PAGE_COUNT)
+
+/**
+ * Cost of one submitted frame relative to the previous one
+ */
+struct FrameDiff {
+    uint16_t bytes;     // Changed buffer bytes (upper bound on I2C pixel data)
+    uint16_t pixels;    // Pixels that flipped
+};
+
+class DisplayService {
+private:
+    Adafruit_SSD1306* display;
+    uint8_t address;
+    TaskHandle_t flushTask;
+    portMUX_TYPE lock;
+    
+    uint8_t frontBuffer[DISPLAY_FRAME_BYTES];   // Latest submitted frame
+    uint8_t flushBuffer[DISPLAY_FRAME_BYTES];   // Frame being sent (flush task only)
+    uint8_t panelBuffer[DISPLAY_FRAME_BYTES];   // What the panel shows (flush task only)
+    bool framePending;
+    bool panelValid;
+    
+    // Diagnostics (read without locking)
+    uint32_t framesSubmitted;
+    uint32_t framesFlushed;
+    uint32_t framesSkipped;     // Superseded before they were sent
+    uint32_t bytesFlushed;      // Pixel data bytes sent over I2C
+    uint16_t lastFlushBytes;
+    unsigned long lastFlushUs;
+    unsigned long maxFlushUs;
+    
+    /**
+     * FreeRTOS entry point for the flush task
+     */
+    static void taskEntry(void* arg);
+    
+    /**
+     * Flush task loop: wait for a frame, then send it
+     */
+    void run();
+    
+    /**
+     * Move the pending front buffer into the flush buffer
+     * @return true if a frame was pending
+     */
+    bool takeFrame();
+    
+    /**
+     * Send the changed windows of the flush buffer to the panel
+     */
+    void flush();
+    
+    /**
+     * Set the column/page address window and stream its data
+     */
+    void sendWindow(uint8_t page, uint8_t firstCol, uint8_t lastCol, const uint8_t* data);
+
+public:
+    /**
+     * Constructor
+     */
+    DisplayService();
+    
+    /**
+     * Start the flush task
+     * @param display Initialized SSD1306 (its buffer is the back buffer)
+     * @param i2cAddress Panel I2C address
+     * @return true if the task started (otherwise submit() flushes inline)
+     */
+    bool begin(Adafruit_SSD1306& display, uint8_t i2cAddress);
+    
+    /**
+     * Queue the current back buffer for flushing (never blocks on I2C)
+     * @return Bytes and pixels that changed since the previous submit
+     */
+    FrameDiff submit();
+    
+    /**
+     * Print frame, byte and timing statistics
+     */
+    void printStats();
+};
+
+#endif // DISPLAY_SERVICE_H
@@ -25,6 +25,7 @@ void FSMController::begin() {
     
     // Start in IDLE state
     changeState(STATE_IDLE);
+    applySensingRate();
     
     DEBUG_PRINTLN("[FSM] ✓ Initialized");
 }
@@ -63,11 +64,27 @@ void FSMController::changeState(SystemState newState) {
     previousState = currentState;
     currentState = newState;
     stateEntryTime = millis();
+    applySensingRate();
     
     // Save state for power failure recovery
     saveState();
 }
 
+void FSMController::applySensingRate() {
+    // Sample slowly while nobody is there, fast while confirming presence
+    switch (currentState) {
+        case STATE_IDLE:
+            ultrasonic->setRate(ULTRASONIC_RATE_IDLE);
+            break;
+        case STATE_USER_DETECTED:
+            ultrasonic->setRate(ULTRASONIC_RATE_FAST);
+            break;
+        default:
+            ultrasonic->setRate(ULTRASONIC_RATE_NORMAL);
+            break;
+    }
+}
+
 unsigned long FSMController::getStateTime() {
     return millis() - stateEntryTime;
 }
@@ -80,6 +80,11 @@ private:
      */
     void changeState(SystemState newState);
     
+    /**
+     * Match the ultrasonic sampling rate to the current state
+     */
+    void applySensingRate();
+    
     /**
      * Get time in current state (ms)
      */
@@ -7,15 +7,18 @@
 OLEDDisplay::OLEDDisplay() 
     : display(nullptr), lastRefreshTime(0), currentScreen(""),
       cachedDistance(0), cachedStatus(""), cachedDestination(""),
-      cachedPrivilege(false) {
+      cachedPrivilege(false), framesChanged(0), framesUnchanged(0),
+      bytesChanged(0), pixelsChanged(0), maxFrameBytes(0) {
 }
 
 bool OLEDDisplay::begin() {
     // Create display object
-    display = new Adafruit_SSD1306(OLED_WIDTH, OLED_HEIGHT, &Wire, -1);
+    display = new Adafruit_SSD1306(OLED_WIDTH, OLED_HEIGHT, &Wire, -1,
+                                   DISPLAY_I2C_CLOCK_HZ, DISPLAY_I2C_CLOCK_HZ);
     
     // Initialize I2C
     Wire.begin(OLED_SDA_PIN, OLED_SCL_PIN);
+    Wire.setClock(DISPLAY_I2C_CLOCK_HZ);
     
     // Initialize display
     if (!display->begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS)) {
@@ -36,6 +39,9 @@ bool OLEDDisplay::begin() {
     drawCenteredText("Initializing...", 50, 1);
     display->display();
     
+    // From here on the display task owns I2C; screens go through submit()
+    displayService.begin(*display, OLED_ADDRESS);
+    
     DEBUG_PRINTLN("[OLED] ✓ Initialized");
     
     delay(2000);  // Show startup screen
@@ -45,6 +51,7 @@ bool OLEDDisplay::begin() {
 
 void OLEDDisplay::clearDisplay() {
     display->clearDisplay();
+    screenTemplate.invalidate();
 }
 
 void OLEDDisplay::drawCenteredText(const char* text, uint8_t y, uint8_t textSize) {
@@ -74,8 +81,59 @@ void OLEDDisplay::update() {
 }
 
 void OLEDDisplay::forceRefresh() {
-    display->display();
+    FrameDiff diff = displayService.submit();
     lastRefreshTime = millis();
+    
+    if (diff.bytes == 0) {
+        framesUnchanged++;
+        return;
+    }
+    framesChanged++;
+    bytesChanged += diff.bytes;
+    pixelsChanged += diff.pixels;
+    if (diff.bytes > maxFrameBytes) {
+        maxFrameBytes = diff.bytes;
+    }
+
+#if DISPLAY_SNAPSHOTS
+    if (currentScreen != lastSnapshotScreen) {
+        dumpSnapshot(currentScreen);
+    }
+#endif
+    lastSnapshotScreen = currentScreen;
+}
+
+void OLEDDisplay::dumpSnapshot(const String& label) {
+    // Lit OLED pixels come out as 1 (black in PBM)
+    const uint8_t* buffer = display->getBuffer();
+    if (buffer == nullptr) return;
+    
+    char row[OLED_WIDTH + 1];
+    row[OLED_WIDTH] = '\0';
+    
+    DEBUG_PRINTF("[SNAP] begin %s\n", label.c_str());
+    DEBUG_PRINTF("P1\n# %s\n%d %d\n", label.c_str(), OLED_WIDTH, OLED_HEIGHT);
+    for (uint8_t y = 0; y < OLED_HEIGHT; y++) {
+        const uint8_t* cells = buffer + (y / 8) * OLED_WIDTH;
+        uint8_t bit = 1 << (y & 7);
+        for (uint8_t x = 0; x < OLED_WIDTH; x++) {
+            row[x] = (cells[x] & bit) ? '1' : '0';
+        }
+        DEBUG_PRINTLN(row);
+    }
+    DEBUG_PRINTLN("[SNAP] end");
+}
+
+void OLEDDisplay::printStats() {
+    displayService.printStats();
+    DEBUG_PRINTF("   Layouts: %u rendered | Fields: %u redrawn, %u unchanged\n",
+                 screenTemplate.getLayoutsRendered(), screenTemplate.getFieldsRedrawn(),
+                 screenTemplate.getFieldsSkipped());
+    
+    unsigned long avgBytes = framesChanged > 0 ? bytesChanged / framesChanged : 0;
+    unsigned long avgPixels = framesChanged > 0 ? pixelsChanged / framesChanged : 0;
+    DEBUG_PRINTF("   Frames: %u changed, %u unchanged | avg %lu B, %lu px | max %u B\n",
+                 framesChanged, framesUnchanged, avgBytes, avgPixels, maxFrameBytes);
 }
 
 void OLEDDisplay::showIdle() {
@@ -96,29 +154,34 @@ void OLEDDisplay::showIdle() {
     display->print("Block: ");
     display->println(DEFAULT_BLOCK_ID);
     
-    forceRefresh();
     currentScreen = "IDLE";
+    forceRefresh();
     
     DEBUG_PRINTLN("[OLED] Screen: IDLE");
 }
 
 void OLEDDisplay::showUserDetected(float distance) {
-    clearDisplay();
-    drawTitleBar("User Detected");
-    
-    display->setTextSize(1);
-    display->setCursor(5, 20);
-    display->println("Please remain");
-    display->setCursor(5, 30);
-    display->println("in position...");
+    // Static part is drawn once; refreshes only redraw the distance
+    if (currentScreen != "USER_DETECTED" || !screenTemplate.isLayout(LAYOUT_USER_DETECTED)) {
+        clearDisplay();
+        drawTitleBar("User Detected");
+        
+        display->setTextSize(1);
+        display->setCursor(5, 20);
+        display->println("Please remain");
+        display->setCursor(5, 30);
+        display->println("in position...");
+        
+        screenTemplate.capture(*display, LAYOUT_USER_DETECTED, "");
+        currentScreen = "USER_DETECTED";
+    }
     
-    display->setTextSize(2);
     char distStr[16];
     snprintf(distStr, sizeof(distStr), "%.1f cm", distance);
-    drawCenteredText(distStr, 45, 2);
-    
-    forceRefresh();
-    currentScreen = "USER_DETECTED";
+    if (screenTemplate.updateField(*display, 0, 0, 6, OLED_WIDTH, 2, distStr)) {
+        drawCenteredText(distStr, 48, 2);
+        forceRefresh();
+    }
     cachedDistance = distance;
 }
 
@@ -133,8 +196,8 @@ void OLEDDisplay::showPrivilegeCheck() {
     display->setTextSize(2);
     drawCenteredText("...", 50, 2);
     
-    forceRefresh();
     currentScreen = "PRIVILEGE_CHECK";
+    forceRefresh();
     
     DEBUG_PRINTLN("[OLED] Screen: PRIVILEGE_CHECK");
 }
@@ -157,8 +220,8 @@ void OLEDDisplay::showPrivilegeResult(bool verified, const char* reason) {
         display->println(reason);
     }
     
-    forceRefresh();
     currentScreen = verified ? "PRIVILEGE_OK" : "PRIVILEGE_DENIED";
+    forceRefresh();
     cachedPrivilege = verified;
     
     DEBUG_PRINTF("[OLED] Screen: PRIVILEGE_%s\n", verified ? "OK" : "DENIED");
@@ -177,8 +240,8 @@ void OLEDDisplay::showWaitingForConfirm(const char* destination) {
     display->setTextSize(2);
     drawCenteredText(destination, 45, 1);
     
-    forceRefresh();
     currentScreen = "WAITING_CONFIRM";
+    forceRefresh();
     cachedDestination = destination;
     
     DEBUG_PRINTF("[OLED] Screen: WAITING_CONFIRM to %s\n", destination);
@@ -193,8 +256,8 @@ void OLEDDisplay::showRequestSent() {
     drawCenteredText("available", 35, 1);
     drawCenteredText("rickshaw...", 45, 1);
     
-    forceRefresh();
     currentScreen = "REQUEST_SENT";
+    forceRefresh();
     
     DEBUG_PRINTLN("[OLED] Screen: REQUEST_SENT");
 }
@@ -211,8 +274,8 @@ void OLEDDisplay::showOfferIncoming() {
     display->setCursor(5, 55);
     display->println("Please wait...");
     
-    forceRefresh();
     currentScreen = "OFFER_INCOMING";
+    forceRefresh();
     
     DEBUG_PRINTLN("[OLED] Screen: OFFER_INCOMING");
 }
@@ -228,8 +291,8 @@ void OLEDDisplay::showRideAccepted() {
     drawCenteredText("Rickshaw is", 40, 1);
     drawCenteredText("on the way!", 50, 1);
     
-    forceRefresh();
     currentScreen = "RIDE_ACCEPTED";
+    forceRefresh();
     
     DEBUG_PRINTLN("[OLED] Screen: RIDE_ACCEPTED");
 }
@@ -248,8 +311,8 @@ void OLEDDisplay::showRideRejected(const char* reason) {
     display->setCursor(5, 55);
     display->println("Please try again");
     
-    forceRefresh();
     currentScreen = "RIDE_REJECTED";
+    forceRefresh();
     
     DEBUG_PRINTF("[OLED] Screen: RIDE_REJECTED - %s\n", reason);
 }
@@ -265,8 +328,8 @@ void OLEDDisplay::showError(const char* error) {
     display->setCursor(5, 55);
     display->println("Please retry");
     
-    forceRefresh();
     currentScreen = "ERROR";
+    forceRefresh();
     
     DEBUG_PRINTF("[OLED] Screen: ERROR - %s\n", error);
 }
@@ -288,7 +351,7 @@ void OLEDDisplay::showMessage(const char* line1, const char* line2, const char*
         drawCenteredText(line3, 45, 1);
     }
     
-    forceRefresh();
     currentScreen = "MESSAGE";
+    forceRefresh();
 }
 
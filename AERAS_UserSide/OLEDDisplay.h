@@ -8,6 +8,7 @@
  * - High contrast for sunlight readability
  * - Status messages, distance, privilege status
  * - Backend updates display
+ * - Flushed asynchronously by DisplayService (only changed regions)
  */
 
 #ifndef OLED_DISPLAY_H
@@ -18,10 +19,19 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include "config.h"
+#include "DisplayService.h"
+#include "ScreenTemplate.h"
 
 class OLEDDisplay {
 private:
-    Adafruit_SSD1306* display;
+    Adafruit_SSD1306* display;      // Back buffer; DisplayService flushes it
+    DisplayService displayService;
+    ScreenTemplate screenTemplate;  // Retained layout for frequently refreshed screens
+    
+    // Layout ids for screenTemplate
+    enum Layout : uint8_t {
+        LAYOUT_USER_DETECTED = 1
+    };
     unsigned long lastRefreshTime;
     
     // Display content cache
@@ -31,6 +41,14 @@ private:
     String cachedDestination;
     bool cachedPrivilege;
     
+    // Render cost of submitted frames
+    uint32_t framesChanged;
+    uint32_t framesUnchanged;       // Periodic refreshes with nothing new
+    uint32_t bytesChanged;
+    uint32_t pixelsChanged;
+    uint16_t maxFrameBytes;
+    String lastSnapshotScreen;
+    
     /**
      * Clear display and prepare for new content
      */
@@ -45,6 +63,12 @@ private:
      * Draw title bar
      */
     void drawTitleBar(const char* title);
+    
+    /**
+     * Dump the back buffer as a plain PBM (P1) image over serial
+     * @param label Screen name written into the PBM comment
+     */
+    void dumpSnapshot(const String& label);
 
 public:
     /**
@@ -65,10 +89,15 @@ public:
     void update();
     
     /**
-     * Force immediate display refresh
+     * Force immediate display refresh (queued to the flush task)
      */
     void forceRefresh();
     
+    /**
+     * Print display flush and render cost statistics
+     */
+    void printStats();
+    
     /**
      * Show idle/waiting screen
      */
@@ -0,0 +1,284 @@
+/**
+ * AERAS - Presence Tracker Implementation
+ */
+
+#include "PresenceTracker.h"
+
+#include <math.h>
+#include <string.h>
+
+PresenceTracker::PresenceTracker(const PresenceParams& initialParams)
+    : channelCount(1) {
+    setParams(initialParams);
+    int8_t straightOut = 0;
+    configure(&straightOut, 1);
+}
+
+void PresenceTracker::configure(const int8_t* bearingsDeg, uint8_t count) {
+    if (count < 1) count = 1;
+    if (count > PRESENCE_MAX_CHANNELS) count = PRESENCE_MAX_CHANNELS;
+    
+    channelCount = count;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        channels[i].bearingDeg = bearingsDeg[i];
+    }
+    reset();
+}
+
+void PresenceTracker::setParams(const PresenceParams& newParams) {
+    params = newParams;
+    if (params.filterSize < 1) params.filterSize = 1;
+    if (params.filterSize > PRESENCE_MAX_FILTER) params.filterSize = PRESENCE_MAX_FILTER;
+    reset();
+}
+
+const PresenceParams& PresenceTracker::getParams() const {
+    return params;
+}
+
+void PresenceTracker::reset() {
+    for (uint8_t i = 0; i < PRESENCE_MAX_CHANNELS; i++) {
+        Channel& ch = channels[i];
+        memset(ch.distanceBuffer, 0, sizeof(ch.distanceBuffer));
+        ch.bufferIndex = 0;
+        ch.bufferFilled = false;
+        ch.medianDistance = 0;
+        ch.missedEchoes = 0;
+    }
+    fusedDistance = 0;
+    fusedBearing = 0;
+    fusedValid = false;
+    resetPresence();
+}
+
+void PresenceTracker::sortArray(float* arr, uint8_t size) {
+    // Insertion sort: few elements, often nearly sorted
+    for (uint8_t i = 1; i < size; i++) {
+        float value = arr[i];
+        uint8_t j = i;
+        while (j > 0 && arr[j - 1] > value) {
+            arr[j] = arr[j - 1];
+            j--;
+        }
+        arr[j] = value;
+    }
+}
+
+float PresenceTracker::median5(float a, float b, float c, float d, float e) {
+    // Compare-exchange: x gets the smaller value, y the larger
+    #define US_SORT2(x, y) { float lo = fminf(x, y); y = fmaxf(x, y); x = lo; }
+    US_SORT2(a, b); US_SORT2(d, e); US_SORT2(a, d);
+    US_SORT2(b, e); US_SORT2(b, c); US_SORT2(c, d);
+    US_SORT2(b, c);
+    #undef US_SORT2
+    return c;
+}
+
+float PresenceTracker::computeMedian(const Channel& ch) const {
+    if (!ch.bufferFilled) {
+        // Not enough samples yet, return last valid reading
+        return ch.distanceBuffer[ch.bufferIndex > 0 ? ch.bufferIndex - 1 : 0];
+    }
+    
+    if (params.filterSize == 5) {
+        return median5(ch.distanceBuffer[0], ch.distanceBuffer[1], ch.distanceBuffer[2],
+                       ch.distanceBuffer[3], ch.distanceBuffer[4]);
+    }
+    
+    // Copy buffer for sorting (preserve original)
+    float sortedBuffer[PRESENCE_MAX_FILTER];
+    memcpy(sortedBuffer, ch.distanceBuffer, params.filterSize * sizeof(float));
+    
+    // Sort and return median
+    sortArray(sortedBuffer, params.filterSize);
+    
+    return sortedBuffer[params.filterSize / 2];
+}
+
+bool PresenceTracker::inZone(float distance) const {
+    return (distance >= params.minRangeCm &&
+            distance <= params.maxRangeCm);
+}
+
+void PresenceTracker::addSample(uint8_t channel, float distance) {
+    if (channel >= channelCount) return;
+    Channel& ch = channels[channel];
+    
+    if (distance >= 0) {
+        ch.missedEchoes = 0;
+        pushReading(ch, distance);
+        return;
+    }
+    
+    // A timeout means nothing within range, but single dropouts are common
+    // on a standing person. Only a run long enough to outvote the median
+    // reaches the filter (the whole run at once); ignoring timeouts entirely
+    // would hold the median of a target that walked off indefinitely.
+    uint8_t majority = params.filterSize / 2 + 1;
+    uint8_t readings = 1;
+    if (ch.missedEchoes < majority) {
+        if (++ch.missedEchoes < majority) return;
+        readings = majority;    // The run so far
+    }
+    for (uint8_t i = 0; i < readings; i++) {
+        pushReading(ch, params.maxRangeCm + 1);
+    }
+}
+
+void PresenceTracker::pushReading(Channel& ch, float distance) {
+    // Add to filter buffer
+    ch.distanceBuffer[ch.bufferIndex] = distance;
+    ch.bufferIndex = (ch.bufferIndex + 1) % params.filterSize;
+    
+    if (ch.bufferIndex == 0) {
+        ch.bufferFilled = true;
+    }
+    
+    // Filter once per sample; getDistance()/isUserInZone() read the fused value
+    ch.medianDistance = computeMedian(ch);
+}
+
+void PresenceTracker::fuse() {
+    // Nearest in-zone reading is the user; fall back to the nearest reading
+    // overall so an empty zone still reports a distance. A tracked user is
+    // looked for at the bearing of the current window first.
+    bool tracking = presenceDetected && channelCount > 1;
+    float nearest = 0;
+    float nearestInZone = 0;
+    float nearestOnTrack = 0;
+    bool found = false;
+    bool foundInZone = false;
+    bool foundOnTrack = false;
+    fusedValid = false;
+    
+    for (uint8_t i = 0; i < channelCount; i++) {
+        const Channel& ch = channels[i];
+        if (!found || ch.medianDistance < nearest) {
+            nearest = ch.medianDistance;
+            found = true;
+        }
+        if (!ch.bufferFilled) continue;
+        fusedValid = true;
+        if (!inZone(ch.medianDistance)) continue;
+        if (!foundInZone || ch.medianDistance < nearestInZone) {
+            nearestInZone = ch.medianDistance;
+            foundInZone = true;
+        }
+        if (tracking && fabsf(ch.bearingDeg - lastStableBearing) <= params.bearingToleranceDeg &&
+            (!foundOnTrack || ch.medianDistance < nearestOnTrack)) {
+            nearestOnTrack = ch.medianDistance;
+            foundOnTrack = true;
+        }
+    }
+    float anchor = foundOnTrack ? nearestOnTrack : nearestInZone;
+    fusedDistance = foundInZone ? anchor : nearest;
+    
+    // Bearing: neighbours seeing the same target at about the same range
+    // share it, which puts an off-axis user between two transducers
+    float bearingSum = 0;
+    uint8_t bearingCount = 0;
+    for (uint8_t i = 0; i < channelCount && foundInZone; i++) {
+        const Channel& ch = channels[i];
+        if (!ch.bufferFilled || !inZone(ch.medianDistance)) continue;
+        if (fabsf(ch.medianDistance - anchor) > params.fusionWindowCm) continue;
+        if (foundOnTrack && fabsf(ch.bearingDeg - lastStableBearing) > params.bearingToleranceDeg) continue;
+        bearingSum += ch.bearingDeg;
+        bearingCount++;
+    }
+    fusedBearing = bearingCount > 0 ? bearingSum / bearingCount : 0;
+}
+
+void PresenceTracker::startWindow(uint32_t currentTime) {
+    presenceStartTime = currentTime;
+    lastStableDistance = fusedDistance;
+    lastStableBearing = fusedBearing;
+}
+
+PresenceEvent PresenceTracker::update(uint32_t currentTime) {
+    fuse();
+    
+    // Check if user is in valid detection zone
+    if (!inZone(fusedDistance)) {
+        // User moved away or out of range
+        bool wasDetected = presenceDetected;
+        resetPresence();
+        return wasDetected ? PRESENCE_LEFT : PRESENCE_NONE;
+    }
+    
+    if (!presenceDetected) {
+        // Start tracking presence
+        presenceDetected = true;
+        startWindow(currentTime);
+        return PRESENCE_STARTED;
+    }
+    
+    // Check if distance and bearing are stable (within tolerance of the
+    // stable reading); a person walking across the array at a steady range
+    // only fails the bearing test
+    if (fabsf(fusedDistance - lastStableDistance) <= params.toleranceCm &&
+        fabsf(fusedBearing - lastStableBearing) <= params.bearingToleranceDeg) {
+        return PRESENCE_NONE;
+    }
+    
+    // Movement detected, reset timer
+    startWindow(currentTime);
+    return PRESENCE_MOVED;
+}
+
+bool PresenceTracker::isPresenceConfirmed(uint32_t now) const {
+    if (!presenceDetected) {
+        return false;
+    }
+    
+    return now - presenceStartTime >= params.presenceTimeMs;
+}
+
+uint32_t PresenceTracker::getPresenceTime(uint32_t now) const {
+    if (!presenceDetected) {
+        return 0;
+    }
+    return now - presenceStartTime;
+}
+
+bool PresenceTracker::isUserInZone() const {
+    if (!fusedValid) {
+        return false;
+    }
+    
+    return inZone(fusedDistance);
+}
+
+float PresenceTracker::getDistance() const {
+    return fusedDistance;
+}
+
+float PresenceTracker::getBearing() const {
+    return fusedBearing;
+}
+
+float PresenceTracker::getStableDistance() const {
+    return lastStableDistance;
+}
+
+float PresenceTracker::getStableBearing() const {
+    return lastStableBearing;
+}
+
+uint8_t PresenceTracker::getChannelCount() const {
+    return channelCount;
+}
+
+float PresenceTracker::getChannelDistance(uint8_t channel) const {
+    return channel < channelCount ? channels[channel].medianDistance : 0;
+}
+
+int8_t PresenceTracker::getChannelBearing(uint8_t channel) const {
+    return channel < channelCount ? channels[channel].bearingDeg : 0;
+}
+
+void PresenceTracker::resetPresence() {
+    presenceDetected = false;
+    presenceStartTime = 0;
+    lastStableDistance = 0;
+    lastStableBearing = 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * AERAS - Presence Tracker
+ *
+ * Platform-free core of the ultrasonic presence detection:
+ * - Per-transducer median filter
+ * - Fusion of the transducers into one distance and a bearing
+ * - Stable-presence timer against an explicit clock, gated on range and on
+ *   a consistent bearing so someone sweeping across the array never confirms
+ *
+ * UltrasonicSensor owns the hardware and feeds it samples. The host replay
+ * harness (host/presence_replay) runs recorded traces through the same code
+ * with a virtual clock, so no Arduino or ESP-IDF headers may be used here.
+ */
+
+#ifndef PRESENCE_TRACKER_H
+#define PRESENCE_TRACKER_H
+
+#include <stdint.h>
+
+#define PRESENCE_MAX_CHANNELS   4   // Transducers per tracker
+#define PRESENCE_MAX_FILTER     9   // Largest median window
+
+/**
+ * Detection parameters (the ULTRASONIC_* values of config.h on the device)
+ */
+struct PresenceParams {
+    uint32_t presenceTimeMs;    // Stable time before presence is confirmed
+    float toleranceCm;          // Movement allowed without restarting the timer
+    float minRangeCm;           // Detection zone
+    float maxRangeCm;
+    uint8_t filterSize;         // Median window, 1..PRESENCE_MAX_FILTER
+    float fusionWindowCm;       // Transducers this close to the nearest share its bearing
+    float bearingToleranceDeg;  // Bearing change allowed without restarting the timer
+};
+
+/**
+ * What one tracking step changed
+ */
+enum PresenceEvent {
+    PRESENCE_NONE,              // Nothing changed (stable, or still empty)
+    PRESENCE_STARTED,           // Entered the zone, timer started
+    PRESENCE_MOVED,             // Moved beyond range or bearing tolerance, timer restarted
+    PRESENCE_LEFT               // Left the zone
+};
+
+class PresenceTracker {
+private:
+    /**
+     * One transducer: mounting angle and its median filter
+     */
+    struct Channel {
+        int8_t bearingDeg;          // Mounting angle, 0 = straight out
+        float distanceBuffer[PRESENCE_MAX_FILTER];
+        uint8_t bufferIndex;
+        bool bufferFilled;
+        float medianDistance;       // Filter output, recomputed once per new sample
+        uint8_t missedEchoes;       // Consecutive timeouts
+    };
+    
+    Channel channels[PRESENCE_MAX_CHANNELS];
+    uint8_t channelCount;
+    PresenceParams params;
+    
+    // Fused estimate over all transducers
+    float fusedDistance;
+    float fusedBearing;
+    bool fusedValid;
+    
+    // Presence detection state
+    uint32_t presenceStartTime;
+    bool presenceDetected;
+    float lastStableDistance;
+    float lastStableBearing;
+    
+    /**
+     * Add a reading to the filter window and recompute the median
+     */
+    void pushReading(Channel& ch, float distance);
+    
+    /**
+     * Apply median filter to reduce noise
+     * @return Filtered distance in cm
+     */
+    float computeMedian(const Channel& ch) const;
+    
+    /**
+     * Combine the per-transducer medians into one distance and bearing.
+     * While a presence is tracked, readings at its bearing win over nearer
+     * ones elsewhere, so someone passing at another bearing does not
+     * restart a waiting user's timer.
+     */
+    void fuse();
+    
+    /**
+     * Restart the presence timer at the current fused estimate
+     */
+    void startWindow(uint32_t currentTime);
+
+public:
+    /**
+     * Constructor (one transducer straight out)
+     * @param initialParams Detection parameters
+     */
+    explicit PresenceTracker(const PresenceParams& initialParams);
+    
+    /**
+     * Set the transducer layout; clears the filters and presence state
+     * @param bearingsDeg Mounting angle per transducer, 0 = straight out
+     * @param count Number of transducers (at most PRESENCE_MAX_CHANNELS)
+     */
+    void configure(const int8_t* bearingsDeg, uint8_t count);
+    
+    /**
+     * Replace the detection parameters; clears the filters and presence state
+     */
+    void setParams(const PresenceParams& newParams);
+    
+    const PresenceParams& getParams() const;
+    
+    /**
+     * Add a reading to a transducer's filter
+     * @param channel Transducer index
+     * @param distance Raw distance in cm, or -1 for a timeout
+     */
+    void addSample(uint8_t channel, float distance);
+    
+    /**
+     * Fuse the filters and advance presence tracking
+     * @param currentTime Time of the newest sample (ms)
+     * @return What changed
+     */
+    PresenceEvent update(uint32_t currentTime);
+    
+    /**
+     * Check if presence has been stable for presenceTimeMs
+     * @param now Current time on the same clock as update()
+     */
+    bool isPresenceConfirmed(uint32_t now) const;
+    
+    /**
+     * Get time user has been present (ms), 0 if nobody is
+     */
+    uint32_t getPresenceTime(uint32_t now) const;
+    
+    /**
+     * Check a distance against the detection zone
+     */
+    bool inZone(float distance) const;
+    
+    /**
+     * Check if the fused distance is in the detection zone
+     */
+    bool isUserInZone() const;
+    
+    float getDistance() const;
+    float getBearing() const;
+    float getStableDistance() const;
+    float getStableBearing() const;
+    uint8_t getChannelCount() const;
+    float getChannelDistance(uint8_t channel) const;
+    int8_t getChannelBearing(uint8_t channel) const;
+    
+    /**
+     * Median of 5 with an optimal 7-comparator selection network
+     * (the filter's default path; public for the host median tests)
+     */
+    static float median5(float a, float b, float c, float d, float e);
+    
+    /**
+     * Sort array for median calculation (window sizes other than 5)
+     */
+    static void sortArray(float* arr, uint8_t size);
+    
+    /**
+     * Reset presence detection state (filters keep their samples)
+     */
+    void resetPresence();
+    
+    /**
+     * Clear the filters, the fused estimate and presence state
+     */
+    void reset();
+};
+
+#endif // PRESENCE_TRACKER_H
@@ -0,0 +1,145 @@
+/**
+ * AERAS - Deadline-Based Cooperative Scheduler
+ * 
+ * Features:
+ * - Periodic and one-shot tasks with millisecond deadlines
+ * - Loop task sleeps until the nearest deadline
+ * - Early wake from interrupts (task notification)
+ * - Per-task lateness, run time and overrun statistics
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+typedef void (*TaskCallback)();
+
+struct TaskStats {
+    uint32_t runs;
+    uint32_t overruns;          // Periodic runs that missed their next deadline
+    unsigned long maxLateMs;    // Worst start delay past the deadline
+    unsigned long maxRunUs;     // Worst execution time
+    unsigned long totalRunUs;   // For average execution time
+};
+
+class Scheduler {
+private:
+    struct Task {
+        const char* name;
+        TaskCallback callback;
+        unsigned long deadline;
+        uint32_t periodMs;      // 0 = one-shot
+        bool active;
+        volatile bool triggered;    // Set from an ISR or another task, run on next pass
+        TaskStats stats;
+    };
+    
+    Task tasks[SCHEDULER_MAX_TASKS];
+    uint8_t taskCount;
+    TaskHandle_t loopTask;
+    unsigned long totalSleepMs;
+    
+    /**
+     * Claim a task slot (reusing finished one-shots first)
+     * @return Task id, or -1 if the table is full
+     */
+    int8_t addTask(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t delayMs);
+    
+    /**
+     * Execute one task, record stats and compute its next deadline
+     */
+    void runTask(Task& task, unsigned long now);
+
+public:
+    /**
+     * Constructor
+     */
+    Scheduler();
+    
+    /**
+     * Initialize scheduler (call from setup(), binds to the loop task)
+     */
+    void begin();
+    
+    /**
+     * Register a periodic task
+     * @param name Short label for statistics
+     * @param callback Function to run
+     * @param periodMs Interval between runs
+     * @param firstDelayMs Delay before the first run
+     * @return Task id, or -1 if the table is full
+     */
+    int8_t addPeriodic(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t firstDelayMs = 0);
+    
+    /**
+     * Register a task that runs once after a delay
+     * @param name Short label for statistics
+     * @param callback Function to run
+     * @param delayMs Delay before the run
+     * @return Task id, or -1 if the table is full
+     */
+    int8_t addOneShot(const char* name, TaskCallback callback, uint32_t delayMs);
+    
+    /**
+     * Stop a task
+     * @param taskId Id returned at registration
+     */
+    void cancel(int8_t taskId);
+    
+    /**
+     * Change a periodic task's interval
+     * @param taskId Id returned at registration
+     * @param periodMs New interval
+     */
+    void setPeriod(int8_t taskId, uint32_t periodMs);
+    
+    /**
+     * Make a task due immediately
+     * @param taskId Id returned at registration
+     */
+    void triggerNow(int8_t taskId);
+    
+    /**
+     * Run due tasks, then sleep until the next deadline or a wake (call in loop)
+     */
+    void run();
+    
+    /**
+     * Time until the nearest task deadline
+     * @return Milliseconds (capped at SCHEDULER_MAX_SLEEP_MS)
+     */
+    unsigned long msUntilNextDeadline() const;
+    
+    /**
+     * Make a task due and wake the loop (ISR-safe)
+     * @param taskId Id returned at registration
+     */
+    void triggerFromISR(int8_t taskId);
+    
+    /**
+     * Wake the loop early (task context)
+     */
+    void wake();
+    
+    /**
+     * Get statistics for a task
+     * @param taskId Id returned at registration
+     * @return Stats, or nullptr for an invalid id
+     */
+    const TaskStats* getStats(int8_t taskId) const;
+    
+    /**
+     * Get total time spent sleeping
+     * @return Milliseconds
+     */
+    unsigned long getSleepMs() const;
+    
+    /**
+     * Print per-task statistics
+     */
+    void printStats();
+};
+
+#endif // SCHEDULER_H
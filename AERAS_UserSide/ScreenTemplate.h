@@ -0,0 +1,84 @@
+/**
+ * AERAS - Retained Screen Layout
+ * 
+ * Features:
+ * - Static layout (labels, title bar) drawn once and cached as a bitmap
+ * - Dynamic values in page-aligned field boxes
+ * - A field is restored from the cache and redrawn only when its text changes
+ */
+
+#ifndef SCREEN_TEMPLATE_H
+#define SCREEN_TEMPLATE_H
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+#include "config.h"
+
+class ScreenTemplate {
+private:
+    uint8_t layoutCache[OLED_WIDTH * OLED_PAGE_COUNT];
+    uint8_t currentLayout;
+    String currentKey;
+    bool valid;
+    String fieldValues[SCREEN_MAX_FIELDS];
+    
+    uint32_t layoutsRendered;
+    uint32_t fieldsRedrawn;
+    uint32_t fieldsSkipped;
+
+public:
+    /**
+     * Constructor
+     */
+    ScreenTemplate();
+    
+    /**
+     * Check whether the back buffer still holds a layout
+     * @param layoutId Caller-defined layout number
+     * @param key Content the static layout depends on
+     * @return true if the layout can be reused
+     */
+    bool matches(uint8_t layoutId, const String& key) const;
+    
+    /**
+     * Check the layout regardless of key
+     */
+    bool isLayout(uint8_t layoutId) const;
+    
+    /**
+     * Cache the static layout just drawn into the back buffer
+     */
+    void capture(Adafruit_SSD1306& display, uint8_t layoutId, const String& key);
+    
+    /**
+     * Forget the cached layout (call when something else drew the screen)
+     */
+    void invalidate();
+    
+    /**
+     * Prepare a field box for redraw if its value changed
+     * @param slot Field slot (0..SCREEN_MAX_FIELDS-1)
+     * @param x Left column
+     * @param page First 8-row page
+     * @param width Box width in pixels
+     * @param pages Box height in pages
+     * @param value Text the field will show
+     * @return true if the box was restored and the caller must draw the value
+     */
+    bool updateField(Adafruit_SSD1306& display, uint8_t slot, int16_t x, uint8_t page,
+                     uint8_t width, uint8_t pages, const String& value);
+    
+    /**
+     * Copy a page-aligned box from the cached layout into the back buffer
+     */
+    void restore(Adafruit_SSD1306& display, int16_t x, uint8_t page, uint8_t width, uint8_t pages);
+    
+    /**
+     * Statistics
+     */
+    uint32_t getLayoutsRendered() const;
+    uint32_t getFieldsRedrawn() const;
+    uint32_t getFieldsSkipped() const;
+};
+
+#endif // SCREEN_TEMPLATE_H
@@ -4,177 +4,348 @@
 
 #include "UltrasonicSensor.h"
 
-UltrasonicSensor::UltrasonicSensor(uint8_t trig, uint8_t echo) 
-    : trigPin(trig), echoPin(echo), bufferIndex(0), bufferFilled(false),
-      presenceStartTime(0), presenceDetected(false), lastStableDistance(0),
-      lastSampleTime(0) {
-    // Initialize buffer
-    for (uint8_t i = 0; i < ULTRASONIC_FILTER_SIZE; i++) {
-        distanceBuffer[i] = 0;
+static_assert(ULTRASONIC_MAX_SENSORS <= PRESENCE_MAX_CHANNELS, "ULTRASONIC_MAX_SENSORS exceeds the tracker");
+static_assert(ULTRASONIC_FILTER_SIZE <= PRESENCE_MAX_FILTER, "ULTRASONIC_FILTER_SIZE exceeds the tracker");
+
+PresenceParams UltrasonicSensor::configParams() {
+    PresenceParams params;
+    params.presenceTimeMs = ULTRASONIC_PRESENCE_TIME;
+    params.toleranceCm = ULTRASONIC_ACCURACY_TOLERANCE;
+    params.minRangeCm = ULTRASONIC_MIN_RANGE_CM;
+    params.maxRangeCm = ULTRASONIC_MAX_RANGE_CM;
+    params.filterSize = ULTRASONIC_FILTER_SIZE;
+    params.fusionWindowCm = ULTRASONIC_FUSION_WINDOW_CM;
+    params.bearingToleranceDeg = ULTRASONIC_BEARING_TOLERANCE_DEG;
+    return params;
+}
+
+UltrasonicSensor::UltrasonicSensor(uint8_t trig, uint8_t echo)
+    : channelCount(1), triggerTimer(nullptr), activeChannel(0), triggerUs(0), riseUs(0),
+      echoPending(false), rate(ULTRASONIC_RATE_NORMAL), intervalMs(ULTRASONIC_SAMPLE_INTERVAL),
+      burstRemaining(0), detectStartMs(0), tracker(configParams()),
+      echoCount(0), timeoutCount(0), triggerCount(0), lastDetectMs(0), clockSource(millis) {
+    captureLock = portMUX_INITIALIZER_UNLOCKED;
+    initChannel(0, trig, echo, 0);
+}
+
+UltrasonicSensor::UltrasonicSensor(const uint8_t* trigPins, const uint8_t* echoPins,
+                                   const int8_t* bearingsDeg, uint8_t count)
+    : channelCount(constrain(count, 1, ULTRASONIC_MAX_SENSORS)), triggerTimer(nullptr),
+      activeChannel(0), triggerUs(0), riseUs(0),
+      echoPending(false), rate(ULTRASONIC_RATE_NORMAL), intervalMs(ULTRASONIC_SAMPLE_INTERVAL),
+      burstRemaining(0), detectStartMs(0), tracker(configParams()),
+      echoCount(0), timeoutCount(0), triggerCount(0), lastDetectMs(0), clockSource(millis) {
+    captureLock = portMUX_INITIALIZER_UNLOCKED;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        initChannel(i, trigPins[i], echoPins[i], bearingsDeg[i]);
     }
+    tracker.configure(bearingsDeg, channelCount);
+}
+
+void UltrasonicSensor::initChannel(uint8_t index, uint8_t trig, uint8_t echo, int8_t bearingDeg) {
+    Channel& ch = channels[index];
+    ch.owner = this;
+    ch.index = index;
+    ch.trigPin = trig;
+    ch.echoPin = echo;
+    ch.bearingDeg = bearingDeg;
+    ch.echoWidthUs = 0;
+    ch.echoDoneUs = 0;
+    ch.echoReady = false;
 }
 
 void UltrasonicSensor::begin() {
-    pinMode(trigPin, OUTPUT);
-    pinMode(echoPin, INPUT);
-    digitalWrite(trigPin, LOW);
+    for (uint8_t i = 0; i < channelCount; i++) {
+        Channel& ch = channels[i];
+        pinMode(ch.trigPin, OUTPUT);
+        pinMode(ch.echoPin, INPUT);
+        digitalWrite(ch.trigPin, LOW);
+        
+        // Echo width is timed by the pin interrupt instead of pulseIn(), so
+        // nothing busy-waits for the echo
+        attachInterruptArg(digitalPinToInterrupt(ch.echoPin), onEchoEdge, &ch, CHANGE);
+    }
+    
+    esp_timer_create_args_t args = {};
+    args.callback = &UltrasonicSensor::onTriggerTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "ultrasonic";
+    if (esp_timer_create(&args, &triggerTimer) != ESP_OK) {
+        DEBUG_PRINTLN("[ULTRASONIC] ✗ Trigger timer failed, triggering from update()");
+        triggerTimer = nullptr;
+    }
+    applyInterval(intervalMs);
     
-    DEBUG_PRINTLN("[ULTRASONIC] Initialized");
+    DEBUG_PRINTF("[ULTRASONIC] Initialized (%u sensor(s))\n", channelCount);
 }
 
-float UltrasonicSensor::readRawDistance() {
-    // Send trigger pulse
-    digitalWrite(trigPin, LOW);
-    delayMicroseconds(2);
-    digitalWrite(trigPin, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(trigPin, LOW);
-    
-    // Read echo pulse (timeout after 30ms = ~5m max)
-    unsigned long duration = pulseIn(echoPin, HIGH, 30000);
+void UltrasonicSensor::applyInterval(uint32_t roundMs) {
+    intervalMs = roundMs;
+    if (triggerTimer == nullptr) return;
     
-    if (duration == 0) {
-        return -1;  // Timeout or no echo
+    // Transducers take turns, so each gets roundMs / N unless that would
+    // let one echo overlap the next trigger. Only one echo is ever in
+    // flight, so sensing load stays flat as N grows.
+    uint32_t slotMs = max((uint32_t)(roundMs / channelCount), (uint32_t)ULTRASONIC_SLOT_MIN_MS);
+    esp_timer_stop(triggerTimer);
+    if (esp_timer_start_periodic(triggerTimer, slotMs * 1000ULL) != ESP_OK) {
+        DEBUG_PRINTLN("[ULTRASONIC] ✗ Trigger timer restart failed");
     }
+}
+
+void UltrasonicSensor::setRate(UltrasonicRate newRate) {
+    if (newRate == rate && burstRemaining == 0) return;
     
-    // Calculate distance: duration(us) / 58.0 = cm
-    // Speed of sound: 343 m/s = 0.0343 cm/us
-    // Distance = (duration * 0.0343) / 2
-    float distance = duration / 58.0;
+    rate = newRate;
+    burstRemaining = 0;
+    switch (rate) {
+        case ULTRASONIC_RATE_IDLE:
+            applyInterval(ULTRASONIC_IDLE_INTERVAL);
+            break;
+        case ULTRASONIC_RATE_FAST:
+            applyInterval(ULTRASONIC_FAST_INTERVAL);
+            break;
+        default:
+            applyInterval(ULTRASONIC_SAMPLE_INTERVAL);
+            break;
+    }
+    DEBUG_PRINTF("[ULTRASONIC] Rate %d: %lu ms\n", rate, (unsigned long)intervalMs);
+}
+
+uint32_t UltrasonicSensor::getSampleInterval() const {
+    return max(intervalMs, (uint32_t)(ULTRASONIC_SLOT_MIN_MS * channelCount));
+}
+
+void UltrasonicSensor::updateBurst(bool rawInZone, unsigned long currentTime) {
+    if (isUserInZone()) {
+        if (detectStartMs != 0) {
+            lastDetectMs = currentTime - detectStartMs;
+            detectStartMs = 0;
+        }
+    } else if (rawInZone) {
+        if (detectStartMs == 0) {
+            detectStartMs = currentTime;
+        }
+        // Something showed up while idling: fill the filter at the fast
+        // rate instead of waiting several slow periods for the median
+        if (rate == ULTRASONIC_RATE_IDLE && burstRemaining == 0) {
+            burstRemaining = ULTRASONIC_BURST_SAMPLES * channelCount;
+            applyInterval(ULTRASONIC_FAST_INTERVAL);
+            DEBUG_PRINTLN("[ULTRASONIC] Echo while idle, sampling burst");
+        }
+    } else {
+        detectStartMs = 0;
+    }
+}
+
+void UltrasonicSensor::onTriggerTimer(void* arg) {
+    static_cast<UltrasonicSensor*>(arg)->fireTrigger();
+}
+
+void IRAM_ATTR UltrasonicSensor::onEchoEdge(void* arg) {
+    Channel* ch = static_cast<Channel*>(arg);
+    ch->owner->captureEdge(ch->index);
+}
+
+void UltrasonicSensor::fireTrigger() {
+    portENTER_CRITICAL(&captureLock);
+    if (echoPending) {
+        timeoutCount++;  // Previous cycle never saw a falling edge
+    }
+    uint8_t next = (activeChannel + 1) % channelCount;
+    activeChannel = next;
+    echoPending = true;
+    triggerCount++;
+    riseUs = 0;
+    triggerUs = esp_timer_get_time();
+    portEXIT_CRITICAL(&captureLock);
     
-    return distance;
+    // The 10us trigger pulse is the only busy-wait left per sample
+    uint8_t trigPin = channels[next].trigPin;
+    digitalWrite(trigPin, HIGH);
+    delayMicroseconds(10);
+    digitalWrite(trigPin, LOW);
 }
 
-void UltrasonicSensor::sortArray(float* arr, uint8_t size) {
-    // Simple bubble sort for small array
-    for (uint8_t i = 0; i < size - 1; i++) {
-        for (uint8_t j = 0; j < size - i - 1; j++) {
-            if (arr[j] > arr[j + 1]) {
-                float temp = arr[j];
-                arr[j] = arr[j + 1];
-                arr[j + 1] = temp;
-            }
+void IRAM_ATTR UltrasonicSensor::captureEdge(uint8_t index) {
+    int64_t now = esp_timer_get_time();
+    Channel& ch = channels[index];
+    bool high = digitalRead(ch.echoPin);
+    
+    portENTER_CRITICAL_ISR(&captureLock);
+    // Edges on a transducer that was not triggered are cross-talk
+    if (echoPending && index == activeChannel) {
+        if (high) {
+            riseUs = now;
+        } else if (riseUs != 0) {
+            ch.echoWidthUs = (uint32_t)(now - riseUs);
+            ch.echoDoneUs = now;
+            ch.echoReady = true;
+            echoPending = false;
         }
     }
+    portEXIT_CRITICAL_ISR(&captureLock);
 }
 
-float UltrasonicSensor::getMedianFilteredDistance() {
-    if (!bufferFilled) {
-        // Not enough samples yet, return last valid reading
-        return distanceBuffer[bufferIndex > 0 ? bufferIndex - 1 : 0];
+bool UltrasonicSensor::takeMeasurement(Channel& ch, float& distance, unsigned long& sampleTime) {
+    int64_t now = esp_timer_get_time();
+    bool finished = false;
+    uint32_t widthUs = 0;
+    
+    portENTER_CRITICAL(&captureLock);
+    if (ch.echoReady) {
+        widthUs = ch.echoWidthUs;
+        sampleTime = (unsigned long)(ch.echoDoneUs / 1000);
+        ch.echoReady = false;
+        finished = true;
+    } else if (echoPending && ch.index == activeChannel && now - triggerUs > ULTRASONIC_ECHO_TIMEOUT_US) {
+        // No echo (or it never ended) within the sensor's range window
+        sampleTime = (unsigned long)(now / 1000);
+        echoPending = false;
+        timeoutCount++;
+        finished = true;
     }
+    portEXIT_CRITICAL(&captureLock);
     
-    // Copy buffer for sorting (preserve original)
-    float sortedBuffer[ULTRASONIC_FILTER_SIZE];
-    memcpy(sortedBuffer, distanceBuffer, sizeof(distanceBuffer));
+    if (!finished) {
+        return false;
+    }
     
-    // Sort and return median
-    sortArray(sortedBuffer, ULTRASONIC_FILTER_SIZE);
+    if (widthUs == 0 || widthUs > ULTRASONIC_ECHO_TIMEOUT_US) {
+        distance = -1;
+        return true;
+    }
     
-    return sortedBuffer[ULTRASONIC_FILTER_SIZE / 2];
+    // Calculate distance: duration(us) / 58.0 = cm
+    // Speed of sound: 343 m/s = 0.0343 cm/us
+    // Distance = (duration * 0.0343) / 2
+    distance = widthUs / 58.0;
+    echoCount++;
+    return true;
 }
 
 void UltrasonicSensor::update() {
-    unsigned long currentTime = millis();
+    bool sampled = false;
+    bool rawInZone = false;
+    unsigned long currentTime = 0;
     
-    // Check if it's time to sample
-    if (currentTime - lastSampleTime < ULTRASONIC_SAMPLE_INTERVAL) {
-        return;
+    // Drain every transducer; at most one result each per slot round
+    for (uint8_t i = 0; i < channelCount; i++) {
+        float rawDistance;
+        unsigned long sampleTime;
+        if (!takeMeasurement(channels[i], rawDistance, sampleTime)) {
+            continue;
+        }
+        
+        processSample(channels[i], rawDistance, sampleTime, rawInZone);
+        currentTime = sampleTime;
+        sampled = true;
     }
     
-    lastSampleTime = currentTime;
-    
-    // Read raw distance
-    float rawDistance = readRawDistance();
-    
-    if (rawDistance < 0) {
-        DEBUG_PRINTLN("[ULTRASONIC] Read timeout");
+    if (!sampled) {
+        if (triggerTimer == nullptr && !echoPending) {
+            fireTrigger();
+        }
         return;
     }
     
-    // Add to filter buffer
-    distanceBuffer[bufferIndex] = rawDistance;
-    bufferIndex = (bufferIndex + 1) % ULTRASONIC_FILTER_SIZE;
+    finishPass(currentTime, rawInZone);
+}
+
+void UltrasonicSensor::injectSample(uint8_t channel, float distance, unsigned long timeMs) {
+    if (channel >= channelCount) return;
     
-    if (bufferIndex == 0) {
-        bufferFilled = true;
-    }
+    bool rawInZone = false;
+    processSample(channels[channel], distance, timeMs, rawInZone);
+    finishPass(timeMs, rawInZone);
+}
+
+void UltrasonicSensor::setClock(ClockSource source) {
+    clockSource = source ? source : millis;
+}
+
+void UltrasonicSensor::processSample(Channel& ch, float rawDistance, unsigned long sampleTime, bool& rawInZone) {
+#if ULTRASONIC_TRACE
+    // Same fields injectSample() takes, for replaying captured sessions
+    DEBUG_PRINTF("[US] %lu,%u,%.1f\n", sampleTime, ch.index, rawDistance);
+#endif
     
-    // Get filtered distance
-    float filteredDistance = getMedianFilteredDistance();
+    // Timeouts use up the burst too, or a stray echo on an empty block
+    // would leave it sampling at the fast rate
+    if (burstRemaining > 0 && --burstRemaining == 0) {
+        // Burst over; stay fast only if the FSM asks for it
+        applyInterval(ULTRASONIC_IDLE_INTERVAL);
+    }
     
-    DEBUG_PRINTF("[ULTRASONIC] Raw: %.1f cm, Filtered: %.1f cm\n", 
-                 rawDistance, filteredDistance);
+    tracker.addSample(ch.index, rawDistance);
+    if (rawDistance < 0) {
+        DEBUG_PRINTF("[ULTRASONIC] S%u Read timeout\n", ch.index);
+        return;
+    }
     
-    // Check if user is in valid detection zone
-    if (filteredDistance >= ULTRASONIC_MIN_RANGE_CM && 
-        filteredDistance <= ULTRASONIC_MAX_RANGE_CM) {
-        
-        // Check for stable presence (within tolerance of last reading)
-        if (!presenceDetected) {
-            // Start tracking presence
-            presenceDetected = true;
-            presenceStartTime = currentTime;
-            lastStableDistance = filteredDistance;
-            DEBUG_PRINTF("[ULTRASONIC] User detected at %.1f cm\n", filteredDistance);
-        } else {
-            // Check if distance is stable (within tolerance)
-            float distanceDelta = abs(filteredDistance - lastStableDistance);
-            
-            if (distanceDelta <= ULTRASONIC_ACCURACY_TOLERANCE) {
-                // Still present and stable
-                unsigned long presenceTime = currentTime - presenceStartTime;
-                DEBUG_PRINTF("[ULTRASONIC] Stable presence: %lu ms\n", presenceTime);
-            } else {
-                // Movement detected, reset timer
-                DEBUG_PRINTF("[ULTRASONIC] Movement detected: delta=%.1f cm, resetting\n", 
-                           distanceDelta);
-                presenceStartTime = currentTime;
-                lastStableDistance = filteredDistance;
-            }
-        }
-    } else {
-        // User moved away or out of range
-        if (presenceDetected) {
+    rawInZone |= tracker.inZone(rawDistance);
+    DEBUG_PRINTF("[ULTRASONIC] S%u Raw: %.1f cm, Filtered: %.1f cm\n",
+                 ch.index, rawDistance, tracker.getChannelDistance(ch.index));
+}
+
+void UltrasonicSensor::finishPass(unsigned long currentTime, bool rawInZone) {
+    PresenceEvent event = tracker.update(currentTime);
+    updateBurst(rawInZone, currentTime);
+    logPresence(event, currentTime);
+}
+
+void UltrasonicSensor::logPresence(PresenceEvent event, unsigned long currentTime) {
+    switch (event) {
+        case PRESENCE_STARTED:
+            DEBUG_PRINTF("[ULTRASONIC] User detected at %.1f cm, bearing %.0f deg\n",
+                         tracker.getDistance(), tracker.getBearing());
+            break;
+        case PRESENCE_MOVED:
+            DEBUG_PRINTF("[ULTRASONIC] Movement detected: now %.1f cm, resetting\n",
+                         tracker.getDistance());
+            break;
+        case PRESENCE_LEFT:
             DEBUG_PRINTLN("[ULTRASONIC] User left zone");
-        }
-        resetPresence();
+            break;
+        default:
+            if (tracker.isUserInZone()) {
+                DEBUG_PRINTF("[ULTRASONIC] Stable presence: %lu ms\n",
+                             (unsigned long)tracker.getPresenceTime(currentTime));
+            }
+            break;
     }
 }
 
 bool UltrasonicSensor::isPresenceConfirmed() {
-    if (!presenceDetected) {
-        return false;
-    }
-    
-    unsigned long presenceTime = millis() - presenceStartTime;
-    return presenceTime >= ULTRASONIC_PRESENCE_TIME;
+    return tracker.isPresenceConfirmed(clockSource());
 }
 
 float UltrasonicSensor::getDistance() {
-    return getMedianFilteredDistance();
+    return tracker.getDistance();
+}
+
+float UltrasonicSensor::getBearing() {
+    return tracker.getBearing();
 }
 
 bool UltrasonicSensor::isUserInZone() {
-    if (!bufferFilled) {
-        return false;
-    }
-    
-    float distance = getMedianFilteredDistance();
-    return (distance >= ULTRASONIC_MIN_RANGE_CM && 
-            distance <= ULTRASONIC_MAX_RANGE_CM);
+    return tracker.isUserInZone();
 }
 
 void UltrasonicSensor::resetPresence() {
-    presenceDetected = false;
-    presenceStartTime = 0;
-    lastStableDistance = 0;
+    tracker.resetPresence();
 }
 
 unsigned long UltrasonicSensor::getPresenceTime() {
-    if (!presenceDetected) {
-        return 0;
-    }
-    return millis() - presenceStartTime;
+    return tracker.getPresenceTime(clockSource());
 }
 
+void UltrasonicSensor::printStats() {
+    DEBUG_PRINTF("   Echoes: %u, timeouts: %u, triggers: %u\n", echoCount, timeoutCount, triggerCount);
+    DEBUG_PRINTF("   Rate %d: %lu ms | Last detect: %lu ms\n", rate, (unsigned long)intervalMs, lastDetectMs);
+    for (uint8_t i = 0; i < channelCount; i++) {
+        DEBUG_PRINTF("   S%u (%d deg): %.1f cm\n", i, channels[i].bearingDeg, tracker.getChannelDistance(i));
+    }
+    DEBUG_PRINTF("   Fused: %.1f cm at %.0f deg\n", tracker.getDistance(), tracker.getBearing());
+}
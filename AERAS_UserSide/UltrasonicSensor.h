@@ -7,68 +7,202 @@
  * - Movement and instability handling
  * - Multiple person detection tolerance
  * - ±5cm accuracy validation
+ * - Non-blocking ranging: timer-fired trigger, echo timed by GPIO interrupt
+ * - Array of up to ULTRASONIC_MAX_SENSORS transducers, triggered one at a
+ *   time (no echo cross-talk), fused into one distance and a bearing
+ * - Adaptive rate: slow while idle, burst on first echo, fast while confirming
+ * - Replayable: samples can be injected with a virtual clock, and raw
+ *   samples logged (ULTRASONIC_TRACE) in the same form
+ *
+ * Filtering, fusion and presence timing live in PresenceTracker, which has
+ * no hardware dependencies and also runs in the host replay harness.
  */
 
 #ifndef ULTRASONIC_SENSOR_H
 #define ULTRASONIC_SENSOR_H
 
 #include <Arduino.h>
+#include <esp_timer.h>
 #include "config.h"
+#include "PresenceTracker.h"
+
+// Sampling rate, chosen by the FSM per state
+enum UltrasonicRate {
+    ULTRASONIC_RATE_IDLE,       // Empty block: slow duty cycle
+    ULTRASONIC_RATE_NORMAL,
+    ULTRASONIC_RATE_FAST        // Presence confirmation window
+};
+
+// Time source for presence timing (millis() unless replaying a trace)
+typedef unsigned long (*ClockSource)();
 
 class UltrasonicSensor {
 private:
-    uint8_t trigPin;
-    uint8_t echoPin;
+    /**
+     * One transducer: pins, its own median filter and echo result slot
+     */
+    struct Channel {
+        UltrasonicSensor* owner;    // Echo ISR argument
+        uint8_t index;
+        uint8_t trigPin;
+        uint8_t echoPin;
+        int8_t bearingDeg;          // Mounting angle, 0 = straight out
+        
+        // Finished echo (written by the ISR, consumed by update())
+        volatile uint32_t echoWidthUs;
+        volatile int64_t echoDoneUs;
+        volatile bool echoReady;
+    };
+    
+    Channel channels[ULTRASONIC_MAX_SENSORS];
+    uint8_t channelCount;
+    
+    // Echo capture: one transducer in flight at a time
+    esp_timer_handle_t triggerTimer;
+    portMUX_TYPE captureLock;
+    volatile uint8_t activeChannel; // Last triggered transducer
+    volatile int64_t triggerUs;     // When its trigger pulse was sent
+    volatile int64_t riseUs;        // Echo rising edge, 0 until seen
+    volatile bool echoPending;      // Triggered, echo not finished yet
+    
+    // Rate control
+    UltrasonicRate rate;
+    uint32_t intervalMs;            // Current round interval (all transducers)
+    uint8_t burstRemaining;         // Fast samples left in an idle wake-up burst
+    unsigned long detectStartMs;    // First in-zone echo not yet confirmed by the filter
     
-    // Filter buffer for median calculation
-    float distanceBuffer[ULTRASONIC_FILTER_SIZE];
-    uint8_t bufferIndex;
-    bool bufferFilled;
+    // Filters, fusion and presence timing
+    PresenceTracker tracker;
     
-    // Presence detection state
-    unsigned long presenceStartTime;
-    bool presenceDetected;
-    float lastStableDistance;
+    // Diagnostics
+    uint32_t echoCount;
+    uint32_t timeoutCount;
+    volatile uint32_t triggerCount;     // Pings sent (sensing energy)
+    unsigned long lastDetectMs;         // First echo -> filtered distance in zone
+    
+    ClockSource clockSource;
+    
+    /**
+     * Set up a transducer slot
+     */
+    void initChannel(uint8_t index, uint8_t trig, uint8_t echo, int8_t bearingDeg);
+    
+    /**
+     * Trigger timer callback (esp_timer task)
+     */
+    static void onTriggerTimer(void* arg);
     
-    // Timing
-    unsigned long lastSampleTime;
+    /**
+     * Echo pin change interrupt
+     */
+    static void IRAM_ATTR onEchoEdge(void* arg);
+    
+    /**
+     * Send a 10us trigger pulse on the next transducer and arm the echo capture
+     */
+    void fireTrigger();
+    
+    /**
+     * Timestamp an echo edge (ISR context)
+     * @param index Transducer whose echo pin changed
+     */
+    void IRAM_ATTR captureEdge(uint8_t index);
+    
+    /**
+     * Take the result of the last finished ranging cycle of a transducer
+     * @param ch Transducer
+     * @param distance Distance in cm, or -1 on timeout
+     * @param sampleTime When the cycle finished (millis() time base)
+     * @return true if a cycle finished since the last call
+     */
+    bool takeMeasurement(Channel& ch, float& distance, unsigned long& sampleTime);
+    
+    /**
+     * Filter one raw sample (echo, timeout or injected)
+     * @param rawInZone Set if the sample lies inside the detection zone
+     */
+    void processSample(Channel& ch, float rawDistance, unsigned long sampleTime, bool& rawInZone);
     
     /**
-     * Read raw distance from ultrasonic sensor
-     * @return Distance in cm, or -1 on error/timeout
+     * Fuse, rate-control and presence-track after one or more samples
      */
-    float readRawDistance();
+    void finishPass(unsigned long currentTime, bool rawInZone);
     
     /**
-     * Apply median filter to reduce noise
-     * @return Filtered distance in cm
+     * Restart the trigger timer for a round interval
      */
-    float getMedianFilteredDistance();
+    void applyInterval(uint32_t roundMs);
     
     /**
-     * Sort array for median calculation
+     * Start or end the idle wake-up burst
+     * @param rawInZone A sample in this pass was inside the detection zone
      */
-    void sortArray(float* arr, uint8_t size);
+    void updateBurst(bool rawInZone, unsigned long currentTime);
+    
+    /**
+     * Log what a presence tracking step changed
+     */
+    void logPresence(PresenceEvent event, unsigned long currentTime);
+    
+    /**
+     * Detection parameters from config.h
+     */
+    static PresenceParams configParams();
 
 public:
     /**
-     * Constructor
+     * Constructor (single transducer)
      * @param trig Trigger pin
      * @param echo Echo pin
      */
     UltrasonicSensor(uint8_t trig, uint8_t echo);
     
+    /**
+     * Constructor (transducer array)
+     * @param trigPins Trigger pin per transducer
+     * @param echoPins Echo pin per transducer
+     * @param bearingsDeg Mounting angle per transducer, 0 = straight out
+     * @param count Number of transducers (at most ULTRASONIC_MAX_SENSORS)
+     */
+    UltrasonicSensor(const uint8_t* trigPins, const uint8_t* echoPins,
+                     const int8_t* bearingsDeg, uint8_t count);
+    
     /**
      * Initialize sensor
      */
     void begin();
     
     /**
-     * Update sensor reading (call in loop)
+     * Consume finished measurements (call in loop)
      * Should be called at least every ULTRASONIC_SAMPLE_INTERVAL ms
      */
     void update();
     
+    /**
+     * Feed a recorded sample through the same path as a live echo
+     * @param channel Transducer index
+     * @param distance Distance in cm, or -1 for a timeout
+     * @param timeMs Sample time on the clock given to setClock()
+     */
+    void injectSample(uint8_t channel, float distance, unsigned long timeMs);
+    
+    /**
+     * Replace the presence-timing clock (e.g. a virtual clock for replay)
+     * @param source Function returning milliseconds
+     */
+    void setClock(ClockSource source);
+    
+    /**
+     * Select the sampling rate (idle / normal / fast)
+     */
+    void setRate(UltrasonicRate newRate);
+    
+    /**
+     * Get the current interval between samples of one transducer
+     * @return Milliseconds
+     */
+    uint32_t getSampleInterval() const;
+    
     /**
      * Check if user presence is continuously detected for required duration
      * @return true if user present for >= 3 seconds
@@ -77,10 +211,16 @@ public:
     
     /**
      * Get current filtered distance
-     * @return Distance in cm
+     * @return Distance in cm (nearest transducer reading)
      */
     float getDistance();
     
+    /**
+     * Get direction of the detected user
+     * @return Degrees relative to the block, 0 = straight out
+     */
+    float getBearing();
+    
     /**
      * Check if user is in valid detection zone
      * @return true if distance is within 0.5m to 10m
@@ -97,7 +237,11 @@ public:
      * Get time user has been present (ms)
      */
     unsigned long getPresenceTime();
+    
+    /**
+     * Print echo/timeout/trigger counters and detection latency
+     */
+    void printStats();
 };
 
 #endif // ULTRASONIC_SENSOR_H
-
@@ -19,6 +19,13 @@
 #define ULTRASONIC_TRIG_PIN     25
 #define ULTRASONIC_ECHO_PIN     26
 
+// Ultrasonic array: one entry per transducer, the first is the one above.
+// Bearings are mounting angles in degrees (0 = straight out, + = right).
+#define ULTRASONIC_SENSOR_COUNT 1
+#define ULTRASONIC_TRIG_PINS    { ULTRASONIC_TRIG_PIN }
+#define ULTRASONIC_ECHO_PINS    { ULTRASONIC_ECHO_PIN }
+#define ULTRASONIC_BEARINGS_DEG { 0 }
+
 // Privilege Verification Sensor (Photodiode/Phototransistor)
 #define PRIVILEGE_SENSOR_PIN    34  // Analog input (ADC1_CH6)
 
@@ -40,6 +47,13 @@
 #define OLED_WIDTH              128
 #define OLED_HEIGHT             64
 #define OLED_ADDRESS            0x3C
+#define OLED_PAGE_COUNT         (OLED_HEIGHT / 8)  // 8-pixel rows per controller page
+#define OLED_I2C_CHUNK          64  // Data bytes per I2C transaction (Wire buffer is 128)
+#define SCREEN_MAX_FIELDS       4   // Dynamic field slots per retained screen layout
+#define DISPLAY_I2C_CLOCK_HZ    400000  // SSD1306 fast mode; many panels also run at 1 MHz
+#define DISPLAY_TASK_CORE       0   // Flush off the loop() core
+#define DISPLAY_TASK_STACK_SIZE 2048
+#define DISPLAY_TASK_PRIORITY   1
 
 // ============================================================================
 // TIMING CONSTANTS (milliseconds)
@@ -47,10 +61,14 @@
 
 // Ultrasonic Detection
 #define ULTRASONIC_SAMPLE_INTERVAL      100   // Sample every 100ms
+#define ULTRASONIC_IDLE_INTERVAL        400   // Empty block (STATE_IDLE)
+#define ULTRASONIC_FAST_INTERVAL        40    // Confirmation window and idle wake-up burst
+#define ULTRASONIC_BURST_SAMPLES        ULTRASONIC_FILTER_SIZE  // Fast samples after a first echo while idle
 #define ULTRASONIC_PRESENCE_TIME        3000  // 3 seconds continuous presence
 #define ULTRASONIC_MAX_RANGE_CM         1000  // 10 meters
 #define ULTRASONIC_MIN_RANGE_CM         50    // 0.5 meters
 #define ULTRASONIC_ACCURACY_TOLERANCE   5     // ±5 cm
+#define ULTRASONIC_ECHO_TIMEOUT_US      30000 // No echo within 30ms (~5m) = timeout
 
 // Privilege Verification
 #define PRIVILEGE_CHECK_DURATION        1000  // Max 1 second to verify
@@ -78,6 +96,15 @@
 // Display Refresh
 #define OLED_REFRESH_INTERVAL_MS        500   // Max 2 seconds, use 500ms for responsiveness
 
+// Cooperative Scheduler (loop() task periods)
+#define SCHEDULER_MAX_TASKS             12    // Max registered periodic/one-shot tasks
+#define SCHEDULER_MAX_SLEEP_MS          1000  // Upper bound on a single idle sleep
+#define PRIVILEGE_UPDATE_INTERVAL_MS    1     // 1kHz edge sampling
+#define CONTROL_UPDATE_INTERVAL_MS      10    // Button, FSM and buzzer
+#define LED_UPDATE_INTERVAL_MS          50    // LED blink patterns
+#define COMM_UPDATE_INTERVAL_MS         50    // MQTT loop / reconnect handling
+#define STATUS_PRINT_INTERVAL_MS        60000 // Scheduler statistics report
+
 // ============================================================================
 // LOCATION BLOCK CONFIGURATION
 // ============================================================================
@@ -124,6 +151,8 @@ extern const char* AVAILABLE_DESTINATIONS[];
 
 #define DEBUG_SERIAL            true   // Enabled for debugging
 #define SERIAL_BAUD_RATE        115200
+#define DISPLAY_SNAPSHOTS       false  // Dump each new screen as a PBM frame over serial
+#define ULTRASONIC_TRACE        false  // Log raw samples as "[US] ms,sensor,cm" for replay
 
 // Debug logging macro
 #if DEBUG_SERIAL
@@ -141,6 +170,10 @@ extern const char* AVAILABLE_DESTINATIONS[];
 // ============================================================================
 
 #define ULTRASONIC_FILTER_SIZE  5  // Median of 5 samples
+#define ULTRASONIC_MAX_SENSORS  4  // Transducer slots in UltrasonicSensor
+#define ULTRASONIC_SLOT_MIN_MS  40 // Min gap between triggers (echo timeout + ringdown)
+#define ULTRASONIC_FUSION_WINDOW_CM 30  // Sensors this close to the nearest share its bearing
+#define ULTRASONIC_BEARING_TOLERANCE_DEG 20  // Bearing spread allowed while presence times (rejects sweeps)
 
 // ============================================================================
 // BUZZER TONES
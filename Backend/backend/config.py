@@ -4,3 +4,4 @@ DATABASE_URL = os.getenv("DATABASE_URL", "postgresql://postgres:password@db:5432
 REDIS_URL = os.getenv("REDIS_URL", "redis://redis:6379")
 MQTT_BROKER = os.getenv("MQTT_BROKER", "mqtt")
 MQTT_PORT = int(os.getenv("MQTT_PORT", 1883))
+DEVICE_HMAC_KEY = os.getenv("DEVICE_HMAC_KEY", "")  # Checks confirmation signatures when set
@@ -1,19 +1,38 @@
 import asyncio
+import hashlib
+import hmac
 import uuid
 import json
 import time
 from fastapi import FastAPI, WebSocket, BackgroundTasks
 import redis.asyncio as redis
 from databases import Database
-from config import DATABASE_URL, REDIS_URL, MQTT_BROKER, MQTT_PORT
+from config import DATABASE_URL, REDIS_URL, MQTT_BROKER, MQTT_PORT, DEVICE_HMAC_KEY
 import paho.mqtt.client as mqtt
 
 app = FastAPI()
 db = Database(DATABASE_URL)
 r = redis.Redis.from_url(REDIS_URL, decode_responses=True)
 
+# Confirmations the rickshaw units journal until they are acked
+CONFIRM_TOPICS = ("aeras/ride/pickup", "aeras/ride/drop", "aeras/ride/resume")
+CONFIRM_TTL_SEC = 7 * 24 * 3600
+event_loop = None
+
+def on_mqtt_connect(client, userdata, flags, rc):
+    # Subscriptions are redone on every connect (clean session)
+    for topic in CONFIRM_TOPICS:
+        client.subscribe(topic, qos=1)
+
+def on_mqtt_message(client, userdata, msg):
+    # paho's network thread; the handler runs on the app's event loop
+    if msg.topic in CONFIRM_TOPICS and event_loop is not None:
+        asyncio.run_coroutine_threadsafe(handle_confirmation(msg.topic, msg.payload), event_loop)
+
 # MQTT setup
 mqtt_client = mqtt.Client()
+mqtt_client.on_connect = on_mqtt_connect
+mqtt_client.on_message = on_mqtt_message
 mqtt_client.connect(MQTT_BROKER, int(MQTT_PORT), 60)
 mqtt_client.loop_start()
 
@@ -29,6 +48,8 @@ connections = {}  # WebSocket connections
 # -----------------------
 @app.on_event("startup")
 async def startup():
+    global event_loop
+    event_loop = asyncio.get_running_loop()
     await db.connect()
     global claim_sha
     claim_sha = await r.script_load(claim_script)
@@ -62,6 +83,35 @@ async def notify_ws(user_id, message: dict):
 def mqtt_publish(topic, payload):
     mqtt_client.publish(topic, json.dumps(payload))
 
+# -----------------------
+# Device confirmations (pickup / drop / resume)
+# -----------------------
+async def handle_confirmation(topic, raw):
+    # Envelope: {"data": "<json>", "signature": "<hex HMAC-SHA256 of data>"}
+    try:
+        envelope = json.loads(raw)
+        data_text = envelope["data"]
+        data = json.loads(data_text)
+        key = data["idempotency_key"]
+        driver_id = data["driver_id"]
+    except (ValueError, KeyError, TypeError) as e:
+        print(f"Malformed confirmation on {topic}: {e}")
+        return
+
+    if DEVICE_HMAC_KEY:
+        expected = hmac.new(DEVICE_HMAC_KEY.encode(), data_text.encode(), hashlib.sha256).hexdigest()
+        if not hmac.compare_digest(expected, str(envelope.get("signature", ""))):
+            print(f"Bad signature on confirmation {key}")
+            return
+
+    # Stored once per idempotency key; a redelivery is acked again
+    first = await r.set(f"confirm:{key}", data_text, nx=True, ex=CONFIRM_TTL_SEC)
+    if first:
+        await r.publish("confirmations", data_text)
+
+    ack = {"idempotency_key": key}
+    mqtt_client.publish(f"aeras/driver/{driver_id}/ack", json.dumps(ack), qos=1)
+
 # -----------------------
 # Driver location update
 # -----------------------
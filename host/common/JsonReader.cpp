@@ -0,0 +1,244 @@
+/*
+ * JsonReader.cpp
+ * Recursive-descent parser behind JsonReader.h
+ */
+
+#include "JsonReader.h"
+#include <charconv>
+#include <string.h>
+
+namespace {
+
+const int MAX_DEPTH = 32;
+
+class Parser {
+public:
+    Parser(const char* text, size_t length) : pos(text), end(text + length) {}
+    
+    bool parseDocument(JsonValue& out) {
+        skipWhitespace();
+        if (!parseValue(out, 0)) return false;
+        skipWhitespace();
+        if (pos != end) return fail("trailing characters");
+        return true;
+    }
+    
+    std::string error;
+
+private:
+    const char* pos;
+    const char* end;
+    
+    bool fail(const char* message) {
+        if (error.empty()) error = message;
+        return false;
+    }
+    
+    void skipWhitespace() {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) pos++;
+    }
+    
+    bool literal(const char* word) {
+        size_t length = strlen(word);
+        if ((size_t)(end - pos) < length || memcmp(pos, word, length) != 0) return fail("bad literal");
+        pos += length;
+        return true;
+    }
+    
+    bool parseValue(JsonValue& out, int depth) {
+        if (depth > MAX_DEPTH) return fail("nesting too deep");
+        if (pos >= end) return fail("unexpected end");
+        
+        switch (*pos) {
+            case '{': return parseObject(out, depth);
+            case '[': return parseArray(out, depth);
+            case '"':
+                out.type = JsonValue::STRING;
+                return parseString(out.string);
+            case 't':
+                out.type = JsonValue::BOOLEAN;
+                out.boolean = true;
+                return literal("true");
+            case 'f':
+                out.type = JsonValue::BOOLEAN;
+                out.boolean = false;
+                return literal("false");
+            case 'n':
+                out.type = JsonValue::NUL;
+                return literal("null");
+            default:
+                return parseNumber(out);
+        }
+    }
+    
+    bool parseObject(JsonValue& out, int depth) {
+        out.type = JsonValue::OBJECT;
+        pos++;
+        skipWhitespace();
+        if (pos < end && *pos == '}') {
+            pos++;
+            return true;
+        }
+        
+        for (;;) {
+            skipWhitespace();
+            std::pair<std::string, JsonValue> member;
+            if (pos >= end || *pos != '"') return fail("expected member name");
+            if (!parseString(member.first)) return false;
+            skipWhitespace();
+            if (pos >= end || *pos != ':') return fail("expected ':'");
+            pos++;
+            skipWhitespace();
+            if (!parseValue(member.second, depth + 1)) return false;
+            out.members.push_back(std::move(member));
+            
+            skipWhitespace();
+            if (pos < end && *pos == ',') {
+                pos++;
+                continue;
+            }
+            if (pos < end && *pos == '}') {
+                pos++;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+    
+    bool parseArray(JsonValue& out, int depth) {
+        out.type = JsonValue::ARRAY;
+        pos++;
+        skipWhitespace();
+        if (pos < end && *pos == ']') {
+            pos++;
+            return true;
+        }
+        
+        for (;;) {
+            skipWhitespace();
+            JsonValue item;
+            if (!parseValue(item, depth + 1)) return false;
+            out.items.push_back(std::move(item));
+            
+            skipWhitespace();
+            if (pos < end && *pos == ',') {
+                pos++;
+                continue;
+            }
+            if (pos < end && *pos == ']') {
+                pos++;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+    
+    bool parseHex4(uint32_t& value) {
+        if (end - pos < 4) return fail("short \\u escape");
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = *pos++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return fail("bad \\u escape");
+        }
+        return true;
+    }
+    
+    static void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += (char)cp;
+        } else if (cp < 0x800) {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+    
+    bool parseString(std::string& out) {
+        pos++;  // Opening quote
+        out.clear();
+        
+        for (;;) {
+            // Copy the run up to the next quote or escape in one go
+            const char* run = pos;
+            while (pos < end && *pos != '"' && *pos != '\\') {
+                if ((unsigned char)*pos < 0x20) return fail("control character in string");
+                pos++;
+            }
+            out.append(run, pos - run);
+            if (pos >= end) return fail("unterminated string");
+            if (*pos++ == '"') return true;
+            
+            if (pos >= end) return fail("unterminated escape");
+            char c = *pos++;
+            switch (c) {
+                case '"':  out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/'; break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!parseHex4(cp)) return false;
+                    if (cp >= 0xD800 && cp < 0xDC00) {
+                        uint32_t low;
+                        if (end - pos < 2 || pos[0] != '\\' || pos[1] != 'u') return fail("lone surrogate");
+                        pos += 2;
+                        if (!parseHex4(low) || low < 0xDC00 || low >= 0xE000) return fail("bad surrogate pair");
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default:
+                    return fail("bad escape");
+            }
+        }
+    }
+    
+    bool parseNumber(JsonValue& out) {
+        const char* start = pos;
+        if (pos < end && *pos == '-') pos++;
+        while (pos < end && ((*pos >= '0' && *pos <= '9') || *pos == '.' || *pos == 'e' ||
+                             *pos == 'E' || *pos == '+' || *pos == '-')) {
+            pos++;
+        }
+        
+        out.type = JsonValue::NUMBER;
+        std::from_chars_result result = std::from_chars(start, pos, out.number);
+        if (start == pos || result.ec != std::errc() || result.ptr != pos) return fail("bad number");
+        return true;
+    }
+};
+
+}  // namespace
+
+const JsonValue* JsonValue::get(const char* key) const {
+    if (type != OBJECT) return nullptr;
+    for (const auto& member : members) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+bool parseJson(const char* text, size_t length, JsonValue& out, std::string* error) {
+    Parser parser(text, length);
+    out = JsonValue();
+    bool ok = parser.parseDocument(out);
+    if (!ok && error) *error = parser.error;
+    return ok;
+}
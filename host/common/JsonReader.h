@@ -0,0 +1,41 @@
+/*
+ * JsonReader.h
+ * Small JSON DOM for host tools reading recorded MQTT payloads
+ *
+ * Enough of RFC 8259 for what ArduinoJson produces on the devices: objects,
+ * arrays, strings with escapes, numbers, booleans and null. Strings are
+ * decoded to UTF-8, so a signed "data" string comes back byte-identical to
+ * what the device fed into its HMAC.
+ */
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <stddef.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct JsonValue {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, OBJECT, ARRAY };
+    
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<std::pair<std::string, JsonValue>> members;    // OBJECT, in document order
+    std::vector<JsonValue> items;                               // ARRAY
+    
+    // Object member lookup; nullptr when absent or not an object
+    const JsonValue* get(const char* key) const;
+    
+    bool isNumber() const { return type == NUMBER; }
+    bool isString() const { return type == STRING; }
+    bool isObject() const { return type == OBJECT; }
+};
+
+// Parses exactly one value (surrounding whitespace allowed); false with a
+// message in error otherwise
+bool parseJson(const char* text, size_t length, JsonValue& out, std::string* error = nullptr);
+
+#endif // JSON_READER_H
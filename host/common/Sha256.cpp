@@ -0,0 +1,144 @@
+/*
+ * Sha256.cpp
+ * FIPS 180-4 SHA-256 and RFC 2104 HMAC
+ */
+
+#include "Sha256.h"
+#include <string.h>
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotr(uint32_t x, unsigned n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+Sha256::Sha256() : blockLength(0), totalLength(0) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(state, initial, sizeof(state));
+}
+
+void Sha256::update(const uint8_t* data, size_t length) {
+    totalLength += length;
+    
+    // Top up a partial block first, then hash whole blocks in place
+    if (blockLength > 0) {
+        size_t take = BLOCK_SIZE - blockLength < length ? BLOCK_SIZE - blockLength : length;
+        memcpy(block + blockLength, data, take);
+        blockLength += take;
+        data += take;
+        length -= take;
+        if (blockLength < BLOCK_SIZE) return;
+        transform(block);
+        blockLength = 0;
+    }
+    
+    while (length >= BLOCK_SIZE) {
+        transform(data);
+        data += BLOCK_SIZE;
+        length -= BLOCK_SIZE;
+    }
+    
+    memcpy(block, data, length);
+    blockLength = length;
+}
+
+void Sha256::finish(uint8_t digest[DIGEST_SIZE]) {
+    uint64_t bits = totalLength * 8;
+    
+    block[blockLength++] = 0x80;
+    if (blockLength > BLOCK_SIZE - 8) {
+        memset(block + blockLength, 0, BLOCK_SIZE - blockLength);
+        transform(block);
+        blockLength = 0;
+    }
+    memset(block + blockLength, 0, BLOCK_SIZE - 8 - blockLength);
+    for (int i = 0; i < 8; i++) {
+        block[BLOCK_SIZE - 1 - i] = (uint8_t)(bits >> (8 * i));
+    }
+    transform(block);
+    
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i]     = (uint8_t)(state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)state[i];
+    }
+}
+
+void Sha256::transform(const uint8_t* chunk) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)chunk[4 * i] << 24) | ((uint32_t)chunk[4 * i + 1] << 16) |
+               ((uint32_t)chunk[4 * i + 2] << 8) | chunk[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void hmacSha256(const uint8_t* key, size_t keyLength, const uint8_t* data, size_t length,
+                uint8_t digest[Sha256::DIGEST_SIZE]) {
+    uint8_t keyBlock[Sha256::BLOCK_SIZE] = {0};
+    if (keyLength > Sha256::BLOCK_SIZE) {
+        Sha256 keyHash;
+        keyHash.update(key, keyLength);
+        keyHash.finish(keyBlock);
+    } else {
+        memcpy(keyBlock, key, keyLength);
+    }
+    
+    uint8_t pad[Sha256::BLOCK_SIZE];
+    for (size_t i = 0; i < Sha256::BLOCK_SIZE; i++) pad[i] = keyBlock[i] ^ 0x36;
+    Sha256 inner;
+    inner.update(pad, sizeof(pad));
+    inner.update(data, length);
+    uint8_t innerDigest[Sha256::DIGEST_SIZE];
+    inner.finish(innerDigest);
+    
+    for (size_t i = 0; i < Sha256::BLOCK_SIZE; i++) pad[i] = keyBlock[i] ^ 0x5c;
+    Sha256 outer;
+    outer.update(pad, sizeof(pad));
+    outer.update(innerDigest, sizeof(innerDigest));
+    outer.finish(digest);
+}
+
+std::string toHex(const uint8_t* data, size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        hex[2 * i] = digits[data[i] >> 4];
+        hex[2 * i + 1] = digits[data[i] & 0x0F];
+    }
+    return hex;
+}
@@ -0,0 +1,40 @@
+/*
+ * Sha256.h
+ * SHA-256 and HMAC-SHA256 for host tools
+ *
+ * Matches the mbedtls HMAC the firmware uses in CommManager::signMessage(),
+ * without pulling a crypto library into the host build.
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class Sha256 {
+public:
+    static const size_t DIGEST_SIZE = 32;
+    static const size_t BLOCK_SIZE = 64;
+    
+    Sha256();
+    void update(const uint8_t* data, size_t length);
+    void finish(uint8_t digest[DIGEST_SIZE]);
+
+private:
+    uint32_t state[8];
+    uint8_t block[BLOCK_SIZE];
+    size_t blockLength;
+    uint64_t totalLength;
+    
+    void transform(const uint8_t* chunk);
+};
+
+void hmacSha256(const uint8_t* key, size_t keyLength, const uint8_t* data, size_t length,
+                uint8_t digest[Sha256::DIGEST_SIZE]);
+
+// Lowercase hex, as the firmware prints signatures
+std::string toHex(const uint8_t* data, size_t length);
+
+#endif // SHA256_H
@@ -0,0 +1,89 @@
+/*
+ * HostFlash.cpp
+ * RAM flash behind the esp_partition stand-in
+ */
+
+#include "esp_partition.h"
+
+#include <string.h>
+#include <vector>
+
+static esp_partition_t partition;
+static bool present = false;
+static std::vector<uint8_t> flash;
+static uint32_t erases = 0;
+static uint32_t eraseFailures = 0;
+static size_t tearAt = 0;
+static bool tearPending = false;
+
+void HostFlash::reset(const char* label, uint32_t size) {
+    memset(&partition, 0, sizeof(partition));
+    partition.type = ESP_PARTITION_TYPE_DATA;
+    partition.subtype = 0x40;
+    partition.size = size;
+    strncpy(partition.label, label ? label : "", sizeof(partition.label) - 1);
+    present = size > 0;
+    flash.assign(size, 0xFF);
+    erases = 0;
+    eraseFailures = 0;
+    tearPending = false;
+}
+
+uint32_t HostFlash::getErases() {
+    return erases;
+}
+
+void HostFlash::tearNextWrite(size_t bytes) {
+    tearAt = bytes;
+    tearPending = true;
+}
+
+void HostFlash::failNextErases(uint32_t count) {
+    eraseFailures = count;
+}
+
+static bool inRange(const esp_partition_t* p, size_t offset, size_t size) {
+    return p == &partition && present && offset <= partition.size && size <= partition.size - offset;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    if (!present || type != partition.type) return nullptr;
+    if (subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != partition.subtype) return nullptr;
+    if (label != nullptr && strcmp(label, partition.label) != 0) return nullptr;
+    return &partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* p, size_t srcOffset, void* dst, size_t size) {
+    if (dst == nullptr || !inRange(p, srcOffset, size)) return ESP_ERR_INVALID_ARG;
+    memcpy(dst, &flash[srcOffset], size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* p, size_t dstOffset, const void* src, size_t size) {
+    if (src == nullptr || !inRange(p, dstOffset, size)) return ESP_ERR_INVALID_ARG;
+
+    // NOR programming clears bits only
+    size_t programmed = size;
+    if (tearPending) {
+        tearPending = false;
+        if (tearAt < size) programmed = tearAt;
+    }
+    const uint8_t* bytes = (const uint8_t*)src;
+    for (size_t i = 0; i < programmed; i++) {
+        flash[dstOffset + i] &= bytes[i];
+    }
+    return programmed == size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t offset, size_t size) {
+    if (!inRange(p, offset, size)) return ESP_ERR_INVALID_ARG;
+    if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) return ESP_ERR_INVALID_SIZE;
+    if (eraseFailures > 0) {
+        eraseFailures--;
+        return ESP_FAIL;
+    }
+    memset(&flash[offset], 0xFF, size);
+    erases += size / SPI_FLASH_SEC_SIZE;
+    return ESP_OK;
+}
@@ -0,0 +1,216 @@
+/*
+ * Preferences.cpp
+ * RAM-backed NVS for the host builds (Preferences and the nvs_* handle API)
+ */
+
+#include "Preferences.h"
+#include "nvs.h"
+
+#include <map>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+
+static std::map<std::string, Namespace> store;
+static uint32_t writes = 0;
+static uint32_t failures = 0;
+
+// Handles from nvs_open(), numbered from 1
+struct NvsHandle {
+    std::string space;
+    bool readOnly;
+    bool open;
+};
+
+static std::vector<NvsHandle> handles;
+
+// Values are raw bytes as in NVS; the typed getters check the stored length
+static bool consumeWrite() {
+    if (failures > 0) {
+        failures--;
+        return false;
+    }
+    writes++;
+    return true;
+}
+
+void HostNvs::erase() {
+    store.clear();
+    handles.clear();
+    writes = 0;
+    failures = 0;
+}
+
+uint32_t HostNvs::getWrites() {
+    return writes;
+}
+
+void HostNvs::failNextWrites(uint32_t count) {
+    failures = count;
+}
+
+Preferences::Preferences() : opened(false), readOnly(false) {}
+
+Preferences::~Preferences() {}
+
+bool Preferences::begin(const char* name, bool ro) {
+    if (name == nullptr || strlen(name) > 15) return false;
+    space = name;
+    opened = true;
+    readOnly = ro;
+    return true;
+}
+
+void Preferences::end() {
+    opened = false;
+}
+
+bool Preferences::clear() {
+    if (!opened || readOnly || !consumeWrite()) return false;
+    store[space].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!opened || readOnly) return false;
+    Namespace& values = store[space];
+    if (values.find(key) == values.end() || !consumeWrite()) return false;
+    values.erase(key);
+    return true;
+}
+
+bool Preferences::isKey(const char* key) {
+    if (!opened) return false;
+    Namespace& values = store[space];
+    return values.find(key) != values.end();
+}
+
+size_t Preferences::put(const char* key, const void* value, size_t length) {
+    if (!opened || readOnly || key == nullptr || strlen(key) > 15 || !consumeWrite()) return 0;
+    const uint8_t* bytes = (const uint8_t*)value;
+    store[space][key].assign(bytes, bytes + length);
+    return length;
+}
+
+bool Preferences::get(const char* key, void* buffer, size_t length) {
+    if (!opened) return false;
+    Namespace& values = store[space];
+    Namespace::const_iterator it = values.find(key);
+    if (it == values.end() || it->second.size() != length) return false;
+    memcpy(buffer, it->second.data(), length);
+    return true;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    // Like nvs_set_str: the terminator is stored, the returned length excludes it
+    size_t stored = put(key, value.c_str(), value.length() + 1);
+    return stored ? stored - 1 : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    if (!opened) return defaultValue;
+    Namespace& values = store[space];
+    Namespace::const_iterator it = values.find(key);
+    if (it == values.end() || it->second.empty()) return defaultValue;
+    return String(std::string((const char*)it->second.data(), it->second.size() - 1));
+}
+
+size_t Preferences::putFloat(const char* key, float value) {
+    return put(key, &value, sizeof(value));
+}
+
+float Preferences::getFloat(const char* key, float defaultValue) {
+    float value;
+    return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+size_t Preferences::putDouble(const char* key, double value) {
+    return put(key, &value, sizeof(value));
+}
+
+double Preferences::getDouble(const char* key, double defaultValue) {
+    double value;
+    return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return put(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    uint32_t value;
+    return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    return put(key, value, length);
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    if (!opened) return 0;
+    Namespace& values = store[space];
+    Namespace::const_iterator it = values.find(key);
+    if (it == values.end() || it->second.size() > maxLength) return 0;
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!opened) return 0;
+    Namespace& values = store[space];
+    Namespace::const_iterator it = values.find(key);
+    return it == values.end() ? 0 : it->second.size();
+}
+
+// ---------------------------------------------------------------------------
+// nvs_* handle API on the same store
+// ---------------------------------------------------------------------------
+
+static NvsHandle* findHandle(nvs_handle_t handle) {
+    if (handle == 0 || handle > handles.size() || !handles[handle - 1].open) return nullptr;
+    return &handles[handle - 1];
+}
+
+// Values are visible immediately, as with NVS; nvs_commit only validates
+static esp_err_t setValue(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    NvsHandle* h = findHandle(handle);
+    if (h == nullptr) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (h->readOnly) return ESP_ERR_NVS_READ_ONLY;
+    if (key == nullptr || strlen(key) > 15) return ESP_ERR_NVS_KEY_TOO_LONG;
+    if (!consumeWrite()) return ESP_FAIL;
+    const uint8_t* bytes = (const uint8_t*)value;
+    store[h->space][key].assign(bytes, bytes + length);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle) {
+    if (name == nullptr || handle == nullptr) return ESP_ERR_INVALID_ARG;
+    if (strlen(name) > 15) return ESP_ERR_NVS_KEY_TOO_LONG;
+    if (mode == NVS_READONLY && store.find(name) == store.end()) return ESP_ERR_NVS_NOT_FOUND;
+    handles.push_back({name, mode == NVS_READONLY, true});
+    *handle = handles.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    if (value == nullptr) return ESP_ERR_INVALID_ARG;
+    return setValue(handle, key, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value) {
+    return setValue(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    if (value == nullptr && length > 0) return ESP_ERR_INVALID_ARG;
+    return setValue(handle, key, value, length);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return findHandle(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    NvsHandle* h = findHandle(handle);
+    if (h) h->open = false;
+}
@@ -0,0 +1,54 @@
+/*
+ * Preferences.h
+ * Host stand-in for the Arduino NVS wrapper, backed by a RAM key/value store
+ *
+ * Namespaces outlive the Preferences objects that open them, so a test can
+ * "reset" the unit by constructing the firmware object again and calling
+ * begin(). HostNvs lets the harness erase everything, count value writes
+ * and make the next writes fail.
+ */
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include "Arduino.h"
+
+namespace HostNvs {
+    void erase();                       // Every namespace, as after a flash erase
+    uint32_t getWrites();               // Successful put/remove calls since erase()
+    void failNextWrites(uint32_t count);
+}
+
+class Preferences {
+public:
+    Preferences();
+    ~Preferences();
+
+    bool begin(const char* name, bool readOnly = false);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putString(const char* key, const String& value);
+    String getString(const char* key, const String& defaultValue = String());
+    size_t putFloat(const char* key, float value);
+    float getFloat(const char* key, float defaultValue = 0);
+    size_t putDouble(const char* key, double value);
+    double getDouble(const char* key, double defaultValue = 0);
+    size_t putUInt(const char* key, uint32_t value);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    size_t putBytes(const char* key, const void* value, size_t length);
+    size_t getBytes(const char* key, void* buffer, size_t maxLength);
+    size_t getBytesLength(const char* key);
+
+private:
+    std::string space;
+    bool opened;
+    bool readOnly;
+
+    size_t put(const char* key, const void* value, size_t length);
+    bool get(const char* key, void* buffer, size_t length);
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,13 @@
+/*
+ * esp32/rom/crc.h
+ * Host stand-in for the ROM CRC32 (IEEE 802.3, same results as crc32_le)
+ */
+
+#ifndef HOST_ESP32_ROM_CRC_H
+#define HOST_ESP32_ROM_CRC_H
+
+#include <stdint.h>
+
+uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
+
+#endif // HOST_ESP32_ROM_CRC_H
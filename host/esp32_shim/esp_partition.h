@@ -0,0 +1,53 @@
+/*
+ * esp_partition.h
+ * Host stand-in for the ESP-IDF partition API, backed by RAM flash
+ *
+ * The flash behaves like NOR: erase sets whole 4 KB sectors to 0xFF and a
+ * write can only clear bits, so programming over old data without an erase
+ * corrupts it as it would on the chip. HostFlash sets up the partition,
+ * counts erases and can tear the next write part-way, as a reset during
+ * programming would.
+ */
+
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define SPI_FLASH_SEC_SIZE      4096
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff
+} esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    uint8_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    bool encrypted;
+} esp_partition_t;
+
+namespace HostFlash {
+    // One erased data partition replaces any previous one; size 0 = none
+    void reset(const char* label, uint32_t size);
+    uint32_t getErases();                   // Sectors erased since reset()
+    void tearNextWrite(size_t bytes);       // Programs only the first bytes, then fails
+    void failNextErases(uint32_t count);
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label);
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size);
+
+#endif // HOST_ESP_PARTITION_H
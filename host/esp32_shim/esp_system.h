@@ -0,0 +1,16 @@
+/*
+ * esp_system.h
+ * Host stand-in for the ESP-IDF system API
+ */
+
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include "esp_err.h"
+
+typedef void (*shutdown_handler_t)(void);
+
+// Accepted but never run; the host does not restart
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler);
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,62 @@
+/*
+ * FakeCommManager.cpp
+ * The FSM-facing part of CommManager for the replay
+ */
+
+#include "FakeCommManager.h"
+
+static bool wifiUp = true;
+static bool mqttUp = true;
+static uint32_t requestFailures = 0;
+
+static const char* const TYPE_NAMES[] = {
+    "ACCEPT", "REJECT", "CANCEL", "PICKUP", "DROP", "STATUS", "LOCATION", "RESUME"
+};
+
+void HostComm::setLinks(bool wifi, bool mqtt) {
+    wifiUp = wifi;
+    mqttUp = wifi && mqtt;
+}
+
+void HostComm::failNextRequests(uint32_t count) {
+    requestFailures = count;
+}
+
+SharedSessionStats::SharedSessionStats()
+    : connects(0), disconnects(0), subscribeRequests(0), messagesReceived(0),
+      lastGapMs(0), longestGapMs(0) {}
+
+CommManager::CommManager()
+    : mqttClient(wifiClient),
+      inboundNotify(nullptr),
+      lastReconnectAttempt(0),
+      lastHeartbeat(0),
+      retryDelay(OFFLINE_RETRY_INITIAL),
+      wifiLinkUp(false),
+      mqttLinkUp(false),
+      bufferedEvents(0),
+      pendingConfirms(0),
+      lastDeliveryMs(0),
+      maxDeliveryMs(0),
+      queueHead(0),
+      queueTail(0),
+      queueSize(0) {}
+
+bool CommManager::postRequest(const OutboundRequest& request) {
+    if (requestFailures > 0) {
+        requestFailures--;
+        Serial.println("[COMM] Outbound queue full, request dropped");
+        return false;
+    }
+    Serial.printf("[COMM] Request: %s %s%s%s\n", TYPE_NAMES[request.type], request.rideId,
+                  request.text[0] ? " " : "", request.text);
+    return true;
+}
+
+bool CommManager::isWiFiLinkUp() const {
+    return wifiUp;
+}
+
+bool CommManager::isMQTTLinkUp() const {
+    return mqttUp;
+}
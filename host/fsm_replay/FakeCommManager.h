@@ -0,0 +1,25 @@
+/*
+ * FakeCommManager.h
+ * Link-time stand-in for the rickshaw CommManager, as the FSM sees it
+ *
+ * FSMController only talks to the FSM/UI side of CommManager: the cached
+ * link flags and postRequest(). The fake takes the link state from the
+ * script and logs every request it accepts as
+ *
+ *   [COMM] Request: <TYPE> <ride id>[ <text>]
+ *
+ * through Serial, so it lands in the capture in order with the FSM's own
+ * transition lines. Nothing is ever sent.
+ */
+
+#ifndef FAKE_COMM_MANAGER_H
+#define FAKE_COMM_MANAGER_H
+
+#include "CommManager.h"
+
+namespace HostComm {
+    void setLinks(bool wifi, bool mqtt);
+    void failNextRequests(uint32_t count);     // Outbox full
+}
+
+#endif // FAKE_COMM_MANAGER_H
@@ -0,0 +1,216 @@
+/*
+ * FsmReplay.cpp
+ * Script runner around one simulated rickshaw unit
+ */
+
+#include "FsmReplay.h"
+#include "FakeCommManager.h"
+#include "FSMController.h"
+#include "PanelModel.h"
+#include "Preferences.h"
+#include "esp_partition.h"
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdio.h>
+
+// Main loop period of the simulated unit
+static const uint32_t LOOP_MS = 10;
+
+// Firmware objects of one boot, in firmware.ino's init order
+struct Unit {
+    GPSManager gps;
+    CommManager comm;
+    UIManager ui;
+    PointsManager points;
+    LocalStore store;
+    FSMController fsm;
+
+    Unit() : fsm(gps, comm, ui, points, store) {}
+
+    void begin() {
+        store.begin();
+        gps.begin();
+        ui.begin();
+        fsm.begin();
+    }
+
+    // GPS, FSM and UI tasks of one pass (the network task's share is the fake's)
+    void loop() {
+        gps.update();
+        fsm.update();
+        ui.setOffline(!comm.isWiFiLinkUp() || !comm.isMQTTLinkUp());
+        ui.update();
+        store.update();
+    }
+};
+
+struct Step {
+    int line;
+    std::string text;                   // Command, or a comment/blank line kept as is
+    std::vector<std::string> words;     // Empty for kept lines
+    std::vector<std::string> expected;
+};
+
+static std::vector<std::string> splitWords(const std::string& text) {
+    std::vector<std::string> words;
+    std::istringstream in(text);
+    std::string word;
+    while (in >> word) words.push_back(word);
+    return words;
+}
+
+static bool loadScript(const std::string& path, std::vector<Step>& steps, ScriptReport& report) {
+    std::ifstream in(path);
+    if (!in) {
+        report.errors.push_back(path + ": cannot open");
+        return false;
+    }
+
+    std::string text;
+    int line = 0;
+    while (std::getline(in, text)) {
+        line++;
+        size_t start = text.find_first_not_of(" \t");
+        if (start == std::string::npos || text[start] == '#') {
+            steps.push_back({line, text, {}, {}});
+            continue;
+        }
+        text = text.substr(start, text.find_last_not_of(" \t\r") + 1 - start);
+        if (text[0] == '>' || text[0] == '<' || text[0] == '=') {
+            if (steps.empty() || steps.back().words.empty()) {
+                report.errors.push_back(path + ":" + std::to_string(line) + ": trace line without a command");
+                return false;
+            }
+            steps.back().expected.push_back(text);
+            continue;
+        }
+        steps.push_back({line, text, splitWords(text), {}});
+    }
+    return true;
+}
+
+// Transition and request lines of the captured log, as trace lines
+static void takeTrace(std::string& capture, std::vector<std::string>& trace) {
+    static const std::string TRANSITION = "[FSM] State transition: ";
+    static const std::string REQUEST = "[COMM] Request: ";
+
+    size_t start = 0;
+    size_t end;
+    while ((end = capture.find('\n', start)) != std::string::npos) {
+        std::string line = capture.substr(start, end - start);
+        if (line.compare(0, TRANSITION.size(), TRANSITION) == 0) {
+            trace.push_back("> " + line.substr(TRANSITION.size()));
+        } else if (line.compare(0, REQUEST.size(), REQUEST) == 0) {
+            trace.push_back("< " + line.substr(REQUEST.size()));
+        }
+        start = end + 1;
+    }
+    capture.erase(0, start);
+}
+
+static std::string offerPayload(const std::vector<std::string>& w) {
+    char payload[256];
+    snprintf(payload, sizeof(payload),
+             "{\"ride_id\":\"%s\",\"pickup_address\":\"Pickup %s\",\"drop_address\":\"Drop %s\","
+             "\"pickup_lat\":%s,\"pickup_lon\":%s,\"drop_lat\":%s,\"drop_lon\":%s}",
+             w[1].c_str(), w[1].c_str(), w[1].c_str(), w[2].c_str(), w[3].c_str(), w[4].c_str(), w[5].c_str());
+    return payload;
+}
+
+static bool isUpDown(const std::vector<std::string>& w) {
+    return w.size() == 2 && (w[1] == "up" || w[1] == "down");
+}
+
+bool runScript(const std::string& path, ScriptReport& report) {
+    std::vector<Step> steps;
+    if (!loadScript(path, steps, report)) return false;
+
+    // Power-on: blank flash, no fix yet, network up
+    static PanelModel panel;
+    Wire.attach(OLED_I2C_ADDRESS, &panel);
+    HostNvs::erase();
+    HostFlash::reset(RIDE_HISTORY_PARTITION, 0x10000);
+    HostGps::loseFix();
+    bool wifi = true;
+    bool mqtt = true;
+    HostComm::setLinks(wifi, mqtt);
+    HostComm::failNextRequests(0);
+
+    std::string capture;
+    Serial.setCapture(&capture);
+    std::unique_ptr<Unit> unit(new Unit());
+    unit->begin();
+    capture.clear();
+
+    bool ok = true;
+    for (const Step& step : steps) {
+        report.recorded += step.text + "\n";
+        if (step.words.empty()) continue;
+
+        const std::vector<std::string>& w = step.words;
+        const std::string& cmd = w[0];
+        std::vector<std::string> trace;
+        std::string where = path + ":" + std::to_string(step.line) + ": ";
+        report.commands++;
+
+        if (cmd == "gps" && w.size() == 2 && w[1] == "lost") {
+            HostGps::loseFix();
+        } else if (cmd == "gps" && (w.size() == 3 || w.size() == 4)) {
+            HostGps::setFix(atof(w[1].c_str()), atof(w[2].c_str()), w.size() == 4 ? atof(w[3].c_str()) : 0);
+        } else if (cmd == "wifi" && isUpDown(w)) {
+            wifi = mqtt = w[1] == "up";
+            HostComm::setLinks(wifi, mqtt);
+        } else if (cmd == "mqtt" && isUpDown(w)) {
+            mqtt = w[1] == "up";
+            HostComm::setLinks(wifi, mqtt);
+        } else if (cmd == "offer" && w.size() == 6) {
+            unit->fsm.handleRideNotification(offerPayload(w).c_str());
+        } else if (cmd == "accept" && w.size() == 1) {
+            unit->fsm.handleAcceptButton();
+        } else if (cmd == "reject" && w.size() == 1) {
+            unit->fsm.handleRejectButton();
+        } else if (cmd == "pickup" && w.size() == 1) {
+            unit->fsm.handlePickupButton();
+        } else if (cmd == "drop" && w.size() == 1) {
+            unit->fsm.handleDropButton();
+        } else if (cmd == "wait" && w.size() == 2) {
+            uint32_t ms = (uint32_t)strtoul(w[1].c_str(), nullptr, 10);
+            for (uint32_t t = 0; t < ms; t += LOOP_MS) {
+                hostAdvanceMicros(LOOP_MS * 1000ULL);
+                unit->loop();
+            }
+        } else if (cmd == "reboot" && w.size() == 1) {
+            unit.reset();
+            unit.reset(new Unit());
+            unit->begin();
+        } else if (cmd == "ride" && w.size() == 1) {
+            const RideInfo* ride = unit->fsm.getActiveRide();
+            trace.push_back(std::string("= ride ") + (ride ? ride->rideId.c_str() : "none"));
+        } else {
+            report.errors.push_back(where + "unknown command: " + step.text);
+            ok = false;
+            break;
+        }
+
+        takeTrace(capture, trace);
+        for (const std::string& line : trace) {
+            report.recorded += line + "\n";
+        }
+        if (trace != step.expected) {
+            std::string message = where + step.text + "\n    expected:";
+            for (const std::string& line : step.expected) message += "\n      " + line;
+            if (step.expected.empty()) message += " (nothing)";
+            message += "\n    got:";
+            for (const std::string& line : trace) message += "\n      " + line;
+            if (trace.empty()) message += " (nothing)";
+            report.errors.push_back(message);
+            ok = false;
+        }
+    }
+
+    Serial.setCapture(nullptr);
+    unit.reset();
+    return ok;
+}
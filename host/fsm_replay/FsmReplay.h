@@ -0,0 +1,42 @@
+/*
+ * FsmReplay.h
+ * Event scripts driven through the rickshaw FSMController
+ *
+ * A script is a list of commands, one per line, each optionally followed
+ * by the trace it must produce:
+ *
+ *   gps LAT LON [SPEED]     Fix streamed by the GPS module from now on
+ *   gps lost                Sentences stop (GPSManager times the fix out)
+ *   wifi up|down            WiFi and MQTT links together
+ *   mqtt up|down            MQTT link only
+ *   offer ID PLAT PLON DLAT DLON   Ride notification payload
+ *   accept|reject|pickup|drop      Button press
+ *   wait MS                 Main loop every 10 ms of virtual time
+ *   reboot                  New unit objects on the same NVS and flash
+ *   ride                    Prints the FSM's active ride
+ *
+ *   > FROM -> TO            State transition logged by the FSM
+ *   < TYPE RIDE [TEXT]      Request handed to CommManager
+ *   = ride ID|none          Output of "ride"
+ *
+ * Blank lines and lines starting with '#' are ignored. The trace of every
+ * command must match its expectation lines exactly and in order; a command
+ * without any expects no transition and no request.
+ */
+
+#ifndef FSM_REPLAY_H
+#define FSM_REPLAY_H
+
+#include <string>
+#include <vector>
+
+struct ScriptReport {
+    unsigned commands = 0;
+    std::vector<std::string> errors;    // "script:line: ..." per mismatch
+    std::string recorded;               // Script with the actual traces
+};
+
+// Runs one script from power-on (erased NVS and flash, no fix, links up)
+bool runScript(const std::string& path, ScriptReport& report);
+
+#endif // FSM_REPLAY_H
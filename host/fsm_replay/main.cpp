@@ -0,0 +1,55 @@
+/*
+ * main.cpp
+ * fsm_replay: drive the rickshaw FSMController from event scripts
+ *
+ *   fsm_replay [--record] [--verbose] SCRIPT...
+ *       Runs each script (see FsmReplay.h) from power-on and checks the
+ *       state transitions and backend requests after every command.
+ *       Exit status 1 on any mismatch. --record prints each script back
+ *       with the traces it actually produced instead of checking them;
+ *       --verbose echoes the firmware log to stderr.
+ */
+
+#include "FsmReplay.h"
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char** argv) {
+    bool record = false;
+    std::vector<std::string> scripts;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0) {
+            record = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            Serial.setEcho(true);
+        } else if (argv[i][0] == '-') {
+            scripts.clear();
+            break;
+        } else {
+            scripts.push_back(argv[i]);
+        }
+    }
+    if (scripts.empty()) {
+        fprintf(stderr, "usage: fsm_replay [--record] [--verbose] SCRIPT...\n");
+        return 2;
+    }
+
+    unsigned failed = 0;
+    for (const std::string& script : scripts) {
+        ScriptReport report;
+        bool ok = runScript(script, report);
+        if (record) {
+            fputs(report.recorded.c_str(), stdout);
+            continue;
+        }
+        for (const std::string& error : report.errors) {
+            fprintf(stderr, "%s\n", error.c_str());
+        }
+        printf("%-40s %4u commands  %s\n", script.substr(script.find_last_of('/') + 1).c_str(),
+               report.commands, ok ? "ok" : "FAILED");
+        if (!ok) failed++;
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,24 @@
+/*
+ * ArduinoJson.cpp
+ * Document parsing for the ArduinoJson stand-in
+ */
+
+#include "ArduinoJson.h"
+
+const char* DeserializationError::c_str() const {
+    switch (code) {
+        case Ok:            return "Ok";
+        case EmptyInput:    return "EmptyInput";
+        default:            return "InvalidInput";
+    }
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input) {
+    doc.root = JsonValue();
+    if (input == nullptr || *input == '\0') return DeserializationError::EmptyInput;
+    if (!parseJson(input, strlen(input), doc.root)) {
+        doc.root = JsonValue();
+        return DeserializationError::InvalidInput;
+    }
+    return DeserializationError::Ok;
+}
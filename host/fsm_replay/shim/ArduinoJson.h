@@ -0,0 +1,72 @@
+/*
+ * ArduinoJson.h
+ * Host stand-in for the ArduinoJson reading API, backed by JsonReader
+ *
+ * Covers what FSMController::parseRideNotification uses: deserializeJson
+ * into a StaticJsonDocument, member lookup and conversion to String or a
+ * number. Missing members read as 0 or "null", as in ArduinoJson 6.
+ */
+
+#ifndef HOST_ARDUINO_JSON_H
+#define HOST_ARDUINO_JSON_H
+
+#include "Arduino.h"
+#include "JsonReader.h"
+
+class JsonVariantConst {
+public:
+    explicit JsonVariantConst(const JsonValue* value) : value(value) {}
+
+    template <typename T>
+    T as() const;
+
+    bool isNull() const { return value == nullptr || value->type == JsonValue::NUL; }
+
+    operator double() const { return value && value->isNumber() ? value->number : 0.0; }
+
+private:
+    const JsonValue* value;
+};
+
+template <>
+inline String JsonVariantConst::as<String>() const {
+    if (value == nullptr || value->type == JsonValue::NUL) return String("null");
+    if (value->isString()) return String(value->string);
+    if (value->type == JsonValue::BOOLEAN) return String(value->boolean ? "true" : "false");
+    if (value->isNumber()) return String(value->number, 6);
+    return String();
+}
+
+template <>
+inline double JsonVariantConst::as<double>() const {
+    return *this;
+}
+
+class DeserializationError {
+public:
+    enum Code { Ok, InvalidInput, EmptyInput };
+
+    DeserializationError(Code code) : code(code) {}
+    explicit operator bool() const { return code != Ok; }
+    const char* c_str() const;
+
+private:
+    Code code;
+};
+
+class JsonDocument {
+public:
+    JsonVariantConst operator[](const char* key) const { return JsonVariantConst(root.get(key)); }
+
+private:
+    JsonValue root;
+
+    friend DeserializationError deserializeJson(JsonDocument& doc, const char* input);
+};
+
+template <size_t capacity>
+class StaticJsonDocument : public JsonDocument {};
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input);
+
+#endif // HOST_ARDUINO_JSON_H
@@ -0,0 +1,13 @@
+/*
+ * HTTPClient.h
+ * Host stand-in for the ESP32 HTTP client: the type only
+ */
+
+#ifndef HOST_HTTP_CLIENT_H
+#define HOST_HTTP_CLIENT_H
+
+#include "Arduino.h"
+
+class HTTPClient {};
+
+#endif // HOST_HTTP_CLIENT_H
@@ -0,0 +1,17 @@
+/*
+ * PubSubClient.h
+ * Host stand-in for the MQTT client: the type only
+ */
+
+#ifndef HOST_PUB_SUB_CLIENT_H
+#define HOST_PUB_SUB_CLIENT_H
+
+#include "WiFi.h"
+
+class PubSubClient {
+public:
+    PubSubClient() {}
+    explicit PubSubClient(WiFiClient&) {}
+};
+
+#endif // HOST_PUB_SUB_CLIENT_H
@@ -0,0 +1,66 @@
+/*
+ * TinyGPS++.h
+ * Host stand-in for the NMEA parser, fed by the harness instead of a UART
+ *
+ * HostGps sets the fix every parser reports. While a fix is set each read
+ * looks like a fresh sentence, as with the module streaming at its update
+ * rate; GPSManager's own interval and timeout logic then run unchanged.
+ */
+
+#ifndef HOST_TINY_GPS_PLUS_H
+#define HOST_TINY_GPS_PLUS_H
+
+#include "Arduino.h"
+
+namespace HostGps {
+    void setFix(double lat, double lon, double speedMps = 0, uint8_t satellites = 8, double hdop = 1.0);
+    void loseFix();             // Sentences stop; GPSManager times the fix out
+    bool hasFix();
+}
+
+class TinyGPSLocation {
+public:
+    bool isValid() const;
+    bool isUpdated() const;
+    double lat() const;
+    double lng() const;
+};
+
+class TinyGPSAltitude {
+public:
+    double meters() const { return 0; }
+};
+
+class TinyGPSSpeed {
+public:
+    double mps() const;
+};
+
+class TinyGPSCourse {
+public:
+    double deg() const { return 0; }
+};
+
+class TinyGPSInteger {
+public:
+    uint32_t value() const;
+};
+
+class TinyGPSHDOP {
+public:
+    double hdop() const;
+};
+
+class TinyGPSPlus {
+public:
+    bool encode(char) { return false; }
+
+    TinyGPSLocation location;
+    TinyGPSAltitude altitude;
+    TinyGPSSpeed speed;
+    TinyGPSCourse course;
+    TinyGPSInteger satellites;
+    TinyGPSHDOP hdop;
+};
+
+#endif // HOST_TINY_GPS_PLUS_H
@@ -0,0 +1,59 @@
+/*
+ * TinyGPS.cpp
+ * Fix source behind the TinyGPS++ stand-in
+ */
+
+#include "TinyGPS++.h"
+
+static bool present = false;
+static double fixLat = 0;
+static double fixLon = 0;
+static double fixSpeed = 0;
+static uint8_t fixSatellites = 0;
+static double fixHdop = 0;
+
+void HostGps::setFix(double lat, double lon, double speedMps, uint8_t satellites, double hdop) {
+    present = true;
+    fixLat = lat;
+    fixLon = lon;
+    fixSpeed = speedMps;
+    fixSatellites = satellites;
+    fixHdop = hdop;
+}
+
+void HostGps::loseFix() {
+    present = false;
+    fixSatellites = 0;
+}
+
+bool HostGps::hasFix() {
+    return present;
+}
+
+bool TinyGPSLocation::isValid() const {
+    return present;
+}
+
+bool TinyGPSLocation::isUpdated() const {
+    return present;
+}
+
+double TinyGPSLocation::lat() const {
+    return fixLat;
+}
+
+double TinyGPSLocation::lng() const {
+    return fixLon;
+}
+
+double TinyGPSSpeed::mps() const {
+    return fixSpeed;
+}
+
+uint32_t TinyGPSInteger::value() const {
+    return fixSatellites;
+}
+
+double TinyGPSHDOP::hdop() const {
+    return fixHdop;
+}
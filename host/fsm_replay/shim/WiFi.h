@@ -0,0 +1,15 @@
+/*
+ * WiFi.h
+ * Host stand-in for the ESP32 WiFi library: the client type only
+ *
+ * The FSM replay links a fake CommManager, so no socket is ever opened.
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+class WiFiClient {};
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,423 @@
+/*
+ * FlapSim.cpp
+ * Broker model, environment timeline and the simulated CommManager loop
+ */
+
+#include "FlapSim.h"
+#include "MqttSession.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <math.h>
+#include <string.h>
+#include <thread>
+
+static const char* const NOTIFY_TOPIC = MQTT_TOPIC_RIDE_NOTIFY;
+static const char* const ACK_TOPIC = "aeras/driver/sim/ack";
+static const uint64_t DRAIN_MS = 3600000;   // Offers stop this long before the end
+
+struct Random {
+    uint64_t state;
+    explicit Random(uint64_t seed) : state(seed * 2654435761ULL + 1) {}
+    uint32_t next() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (uint32_t)(state >> 33);
+    }
+    double uniform(double low, double high) { return low + (high - low) * (next() / 2147483648.0); }
+    bool chance(double p) { return uniform(0, 1) < p; }
+    double exponential(double mean) { return -mean * log(uniform(1e-12, 1)); }
+};
+
+struct Outage {
+    uint64_t startMs;
+    uint64_t endMs;
+    bool keepsSessions;
+};
+
+static uint64_t flapLength(Random& random) {
+    double r = random.uniform(0, 1);
+    if (r < 0.70) return (uint64_t)random.uniform(1000, 10000);
+    if (r < 0.95) return (uint64_t)random.uniform(10000, 120000);
+    return (uint64_t)random.uniform(120000, 1800000);
+}
+
+// Non-overlapping outages with exponential gaps between them
+template <typename Length>
+static std::vector<Outage> makeOutages(Random& random, uint64_t untilMs, double perHour,
+                                       double keepsSessions, Length length) {
+    std::vector<Outage> outages;
+    if (perHour <= 0) return outages;
+    uint64_t t = 0;
+    for (;;) {
+        t += (uint64_t)random.exponential(3600000.0 / perHour);
+        if (t >= untilMs) break;
+        Outage outage{t, t + length(), random.chance(keepsSessions)};
+        outages.push_back(outage);
+        t = outage.endMs;
+    }
+    return outages;
+}
+
+// Walks a sorted outage list with a monotonic clock
+struct Timeline {
+    const std::vector<Outage>& outages;
+    size_t index = 0;
+
+    explicit Timeline(const std::vector<Outage>& list) : outages(list) {}
+
+    // The outage covering t, if any
+    const Outage* at(uint64_t t) {
+        while (index < outages.size() && outages[index].endMs <= t) index++;
+        if (index < outages.size() && outages[index].startMs <= t) return &outages[index];
+        return nullptr;
+    }
+
+    // Start of the first outage after the one covering (or following) t
+    uint64_t nextStartAfter(uint64_t t) {
+        at(t);
+        for (size_t i = index; i < outages.size(); i++) {
+            if (outages[i].startMs > t) return outages[i].startMs;
+        }
+        return UINT64_MAX;
+    }
+};
+
+// One persistent session on a Mosquitto-like broker
+struct Broker {
+    bool up = true;
+    bool sessionExists = false;
+    bool subscribed = false;            // NOTIFY_TOPIC in the session
+    bool clientConnected = false;       // The broker's view; lags a dead link by 1.5 x keepalive
+    uint64_t lastHeardMs = 0;
+    uint64_t offlineSinceMs = 0;
+    std::deque<uint64_t> queued;        // Publish times of QoS 1 offers waiting for the client
+    std::vector<uint64_t> inflight;     // Sent on a link that is already dead, not acked
+
+    // Unacked in-flight messages are redelivered when the session resumes
+    void requeueInflight() {
+        queued.insert(queued.begin(), inflight.begin(), inflight.end());
+        inflight.clear();
+    }
+
+    size_t wipe() {
+        size_t lost = queued.size() + inflight.size();
+        queued.clear();
+        inflight.clear();
+        sessionExists = false;
+        subscribed = false;
+        return lost;
+    }
+};
+
+class Device {
+public:
+    Device(const FlapConfig& config, FlapResult& result) : config(config), result(result) {
+        session.add(NOTIFY_TOPIC, 1);
+        session.add(ACK_TOPIC, 1);
+        retryDelay = config.retryInitialMs;
+    }
+
+    const FlapConfig& config;
+    FlapResult& result;
+    Broker broker;
+    MqttSession session;
+
+    bool link = false;              // TCP connection to the broker alive
+    bool wifiLinked = false;
+    uint64_t assocAt = 0;           // WiFi auto-reconnect completes at this time
+    uint64_t lastAttempt = 0;
+    uint64_t retryDelay = 0;
+    uint64_t lastHeartbeat = 0;
+    uint64_t busyUntil = 0;         // Blocked in connectWiFi()
+    bool wifiResultPending = false;
+    bool wifiResultOk = false;
+    bool legacyHeld = false;        // GapExpiry: what the previous firmware believed
+
+    void deliver(uint64_t publishedMs, uint64_t now) {
+        uint32_t latency = (uint32_t)(now - publishedMs);
+        result.latenciesMs.push_back(latency);
+        if (latency <= config.offerTtlMs) {
+            result.delivered++;
+        } else {
+            result.late++;
+        }
+        session.onMessage();
+    }
+
+    void publishOffer(uint64_t publishedMs, uint64_t now) {
+        result.offers++;
+        if (!broker.up) {
+            result.lostBrokerDown++;
+        } else if (!broker.sessionExists) {
+            result.lostNoSession++;
+        } else if (!broker.subscribed) {
+            result.missedUnsubscribed++;
+        } else if (broker.clientConnected) {
+            if (link) {
+                deliver(publishedMs, now);
+            } else {
+                broker.inflight.push_back(publishedMs);
+            }
+        } else if (broker.queued.size() >= config.maxQueued) {
+            result.queueOverflow++;
+        } else {
+            broker.queued.push_back(publishedMs);
+        }
+    }
+
+    bool subscribe(const char* topic, uint8_t qos) {
+        (void)qos;
+        result.subscribes++;
+        if (strcmp(topic, NOTIFY_TOPIC) == 0) {
+            broker.subscribed = true;
+        }
+        return true;
+    }
+
+    bool connectMQTT(uint64_t now) {
+        if (!broker.up || !wifiLinked) {
+            return false;
+        }
+
+        // Session takeover: the broker drops the stale connection, keeps the session
+        if (broker.clientConnected) {
+            broker.requeueInflight();
+        }
+        if (!broker.sessionExists) {
+            broker.sessionExists = true;
+            broker.subscribed = false;
+        }
+        broker.clientConnected = true;
+        broker.lastHeardMs = now;
+        link = true;
+        result.connects++;
+
+        session.onConnected(now);
+        if (config.policy == ResubscribePolicy::EveryConnect) {
+            session.subscribePending([this](const char* topic, uint8_t qos) { return subscribe(topic, qos); });
+        } else {
+            const MqttSessionStats& stats = session.getStats();
+            if (!legacyHeld || (stats.connects > 1 && stats.lastGapMs >= config.sessionExpiryMs)) {
+                subscribe(NOTIFY_TOPIC, 1);
+                subscribe(ACK_TOPIC, 1);
+                legacyHeld = true;
+            }
+        }
+
+        while (!broker.queued.empty()) {
+            deliver(broker.queued.front(), now);
+            broker.queued.pop_front();
+        }
+        retryDelay = config.retryInitialMs;
+        return true;
+    }
+
+    void increaseRetryDelay() {
+        retryDelay = std::min<uint64_t>(retryDelay * 2, config.retryMaxMs);
+    }
+
+    // connectWiFi() blocks until associated or WIFI_TIMEOUT_MS
+    void startConnectWiFi(uint64_t now, Timeline& wifi) {
+        const Outage* outage = wifi.at(now);
+        uint64_t done = outage ? outage->endMs + config.associateMs : std::max(assocAt, now);
+        wifiResultOk = done <= now + config.wifiTimeoutMs && wifi.nextStartAfter(now) > done;
+        busyUntil = wifiResultOk ? done : now + config.wifiTimeoutMs;
+        wifiResultPending = true;
+    }
+
+    // CommManager::update()
+    void update(uint64_t now, Timeline& wifi) {
+        if (now < busyUntil) return;
+
+        if (wifiResultPending) {
+            wifiResultPending = false;
+            if (wifiResultOk && !wifi.at(now)) {
+                wifiLinked = true;
+                retryDelay = config.retryInitialMs;
+                connectMQTT(now);
+            } else {
+                increaseRetryDelay();
+            }
+            return;
+        }
+
+        if (session.isConnected() && !link) {
+            session.onDisconnected(now);
+        }
+
+        if (!wifiLinked) {
+            if (now - lastAttempt >= retryDelay) {
+                startConnectWiFi(now, wifi);
+                lastAttempt = now;
+            }
+            return;
+        }
+
+        if (!session.isConnected()) {
+            if (now - lastAttempt >= retryDelay) {
+                if (!connectMQTT(now)) {
+                    increaseRetryDelay();
+                }
+                lastAttempt = now;
+            }
+            return;
+        }
+
+        if (now - lastHeartbeat >= config.heartbeatMs) {
+            broker.lastHeardMs = now;
+            if (config.policy == ResubscribePolicy::EveryConnect && session.hasPending()) {
+                session.subscribePending([this](const char* topic, uint8_t qos) { return subscribe(topic, qos); });
+            }
+            lastHeartbeat = now;
+        }
+    }
+};
+
+void FlapResult::merge(const FlapResult& other) {
+    hours += other.hours;
+    offers += other.offers;
+    delivered += other.delivered;
+    late += other.late;
+    lostBrokerDown += other.lostBrokerDown;
+    lostNoSession += other.lostNoSession;
+    missedUnsubscribed += other.missedUnsubscribed;
+    queueOverflow += other.queueOverflow;
+    wiped += other.wiped;
+    flaps += other.flaps;
+    restarts += other.restarts;
+    sessionsWiped += other.sessionsWiped;
+    connects += other.connects;
+    subscribes += other.subscribes;
+    latenciesMs.insert(latenciesMs.end(), other.latenciesMs.begin(), other.latenciesMs.end());
+}
+
+FlapResult simulate(const FlapConfig& config) {
+    FlapResult result;
+    result.hours = config.hours;
+    uint64_t offersUntil = (uint64_t)(config.hours * 3600000.0);
+    uint64_t endMs = offersUntil + DRAIN_MS;
+
+    Random random(config.seed);
+    std::vector<Outage> wifiOutages = makeOutages(random, offersUntil, config.flapsPerHour, 0.0,
+                                                  [&] { return flapLength(random); });
+    std::vector<Outage> brokerOutages = makeOutages(random, offersUntil, config.restartsPerDay / 24.0,
+                                                    config.restartKeepsSessions, [&] {
+        return (uint64_t)random.uniform(config.restartDownMinMs, config.restartDownMaxMs);
+    });
+    std::vector<uint64_t> offers;
+    if (config.offersPerHour > 0) {
+        for (double t = random.exponential(3600000.0 / config.offersPerHour); t < offersUntil;
+             t += random.exponential(3600000.0 / config.offersPerHour)) {
+            offers.push_back((uint64_t)t);
+        }
+    }
+    result.flaps = wifiOutages.size();
+    result.restarts = brokerOutages.size();
+
+    Device device(config, result);
+    Broker& broker = device.broker;
+    Timeline wifi(wifiOutages);
+    Timeline restarts(brokerOutages);
+    device.assocAt = config.associateMs;
+    bool wifiWasUp = true;
+    size_t nextOffer = 0;
+    uint64_t deadAfterMs = config.keepAliveS * 1500ULL;
+
+    for (uint64_t now = 0; now < endMs; now += config.tickMs) {
+        // WiFi drops kill the TCP link silently; auto-reconnect starts when the AP is back
+        bool wifiUp = wifi.at(now) == nullptr;
+        if (!wifiUp && wifiWasUp) {
+            device.wifiLinked = false;
+            device.link = false;
+        } else if (wifiUp && !wifiWasUp) {
+            device.assocAt = now + config.associateMs;
+        }
+        if (wifiUp && !device.wifiLinked && now >= device.assocAt && now > 0) {
+            device.wifiLinked = true;
+        }
+        wifiWasUp = wifiUp;
+
+        // Broker restarts reset every connection; without persistence the sessions go too
+        const Outage* restart = restarts.at(now);
+        if (restart && broker.up) {
+            broker.up = false;
+            if (broker.clientConnected) {
+                broker.clientConnected = false;
+                broker.offlineSinceMs = now;
+                broker.requeueInflight();
+            }
+            device.link = false;
+            if (!restart->keepsSessions && broker.sessionExists) {
+                result.wiped += broker.wipe();
+                result.sessionsWiped++;
+            }
+        } else if (!restart && !broker.up) {
+            broker.up = true;
+        }
+
+        // Keepalive timeout of a client whose link died without a FIN
+        if (broker.clientConnected && !device.link && now - broker.lastHeardMs > deadAfterMs) {
+            broker.clientConnected = false;
+            broker.offlineSinceMs = now;
+            broker.requeueInflight();
+        }
+        if (broker.up && broker.sessionExists && !broker.clientConnected &&
+            now - broker.offlineSinceMs >= config.sessionExpiryMs) {
+            result.wiped += broker.wipe();
+            result.sessionsWiped++;
+        }
+
+        while (nextOffer < offers.size() && offers[nextOffer] <= now) {
+            device.publishOffer(offers[nextOffer++], now);
+        }
+
+        device.update(now, wifi);
+    }
+    return result;
+}
+
+FlapResult simulateRuns(const FlapConfig& config, unsigned runs, unsigned threads) {
+    std::vector<FlapResult> results(runs);
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<unsigned>(threads, std::max(runs, 1u));
+
+    // Seeds are independent; workers take the next one until done
+    std::atomic<unsigned> next(0);
+    auto worker = [&]() {
+        for (unsigned i = next++; i < runs; i = next++) {
+            FlapConfig run = config;
+            run.seed = config.seed + i;
+            results[i] = simulate(run);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    FlapResult total;
+    for (const FlapResult& result : results) {
+        total.merge(result);
+    }
+    return total;
+}
+
+uint32_t latencyQuantile(const FlapResult& result, double q) {
+    if (result.latenciesMs.empty()) return 0;
+    std::vector<uint32_t> sorted = result.latenciesMs;
+    size_t index = std::min(sorted.size() - 1, (size_t)(q * (sorted.size() - 1) + 0.5));
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+const char* policyName(ResubscribePolicy policy) {
+    return policy == ResubscribePolicy::EveryConnect ? "every-connect" : "gap-expiry";
+}
@@ -0,0 +1,89 @@
+/*
+ * FlapSim.h
+ * Missed ride offers of the rickshaw unit's MQTT session under WiFi flaps
+ *
+ * Simulates the CommManager::update() reconnect loop (WiFi/MQTT backoff,
+ * persistent session, heartbeat) with the firmware's MqttSession against a
+ * broker model, on a virtual clock. The environment throws WiFi outages
+ * (short, medium and long) and broker restarts at the device. A restart
+ * either keeps the persistent sessions or wipes them. Ride offers arrive
+ * as a Poisson process and are published at QoS 1. The outcome of each
+ * offer is counted, so the reconnect policy can be compared by the offers
+ * it misses.
+ */
+
+#ifndef FLAP_SIM_H
+#define FLAP_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+enum class ResubscribePolicy {
+    EveryConnect,       // MqttSession: SUBSCRIBE after every CONNECT (shipped)
+    GapExpiry           // Previous rule: only after a gap of at least the session expiry
+};
+
+struct FlapConfig {
+    double hours = 72.0;
+    uint64_t seed = 1;
+    ResubscribePolicy policy = ResubscribePolicy::EveryConnect;
+
+    // Environment
+    double flapsPerHour = 4.0;          // WiFi outages; 70% 1-10 s, 25% 10-120 s, 5% 2-30 min
+    double restartsPerDay = 1.0;        // Broker restarts
+    double restartKeepsSessions = 0.5;  // Probability a restart keeps persistent sessions
+    uint32_t restartDownMinMs = 5000;
+    uint32_t restartDownMaxMs = 30000;
+    double offersPerHour = 30.0;
+    uint32_t associateMs = 3000;        // WiFi association once the AP is back
+
+    // Broker
+    uint64_t sessionExpiryMs = 86400000ULL;  // persistent_client_expiration
+    size_t maxQueued = 1000;                 // max_queued_messages
+
+    // Firmware (Config.h)
+    uint32_t retryInitialMs = OFFLINE_RETRY_INITIAL;
+    uint32_t retryMaxMs = OFFLINE_RETRY_MAX;
+    uint32_t wifiTimeoutMs = WIFI_TIMEOUT_MS;
+    uint32_t keepAliveS = MQTT_KEEPALIVE;
+    uint32_t heartbeatMs = HEARTBEAT_INTERVAL;
+    uint32_t offerTtlMs = ACCEPT_TIMEOUT_MS;    // Later than this the offer is useless
+
+    uint32_t tickMs = 100;              // CommManager::update() period on the virtual clock
+};
+
+// Offer outcomes, plus what happened to the link
+struct FlapResult {
+    double hours = 0.0;
+    size_t offers = 0;
+    size_t delivered = 0;           // Within offerTtlMs of being published
+    size_t late = 0;                // Delivered, but after offerTtlMs
+    size_t lostBrokerDown = 0;      // Published while the broker was restarting
+    size_t lostNoSession = 0;       // Published while no session existed (wiped or expired)
+    size_t missedUnsubscribed = 0;  // Session existed without the subscription: the policy's fault
+    size_t queueOverflow = 0;       // Broker queue full
+    size_t wiped = 0;               // Queued or in flight when the session was wiped/expired
+
+    size_t flaps = 0;
+    size_t restarts = 0;
+    size_t sessionsWiped = 0;
+    size_t connects = 0;
+    size_t subscribes = 0;          // SUBSCRIBE packets sent
+    std::vector<uint32_t> latenciesMs;  // Publish -> device, delivered and late offers
+
+    size_t missed() const { return offers - delivered; }
+    void merge(const FlapResult& other);
+};
+
+FlapResult simulate(const FlapConfig& config);
+
+// Runs `runs` seeds (config.seed, +1, ...) on up to `threads` threads (0 = one per hardware thread)
+FlapResult simulateRuns(const FlapConfig& config, unsigned runs, unsigned threads);
+
+// Latency at fraction q (0..1) of a result's sorted latencies; 0 if none
+uint32_t latencyQuantile(const FlapResult& result, double q);
+
+const char* policyName(ResubscribePolicy policy);
+
+#endif // FLAP_SIM_H
@@ -0,0 +1,105 @@
+/*
+ * main.cpp
+ * mqtt_flap: missed ride offers of the MQTT reconnect policy under WiFi flaps
+ *
+ *   mqtt_flap [--hours H] [--runs N] [--seed S] [--threads N]
+ *             [--flaps-per-hour R] [--restarts-per-day R] [--keep-sessions P]
+ *             [--offers-per-hour R] [--policy every-connect|gap-expiry]
+ *             [--max-unsubscribed N]
+ *       Simulates N runs of H hours (seeds S, S+1, ...) and prints what
+ *       happened to every offer. With --max-unsubscribed, exit status 1 if
+ *       more offers than that hit a session without the subscription.
+ */
+
+#include "FlapSim.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int usage() {
+    fprintf(stderr,
+            "usage: mqtt_flap [--hours H] [--runs N] [--seed S] [--threads N]\n"
+            "                 [--flaps-per-hour R] [--restarts-per-day R] [--keep-sessions P]\n"
+            "                 [--offers-per-hour R] [--policy every-connect|gap-expiry]\n"
+            "                 [--max-unsubscribed N]\n");
+    return 2;
+}
+
+static void printRow(const char* name, size_t count, size_t offers) {
+    printf("  %-20s %8zu  %6.2f%%\n", name, count, offers ? 100.0 * count / offers : 0.0);
+}
+
+int main(int argc, char** argv) {
+    FlapConfig config;
+    unsigned runs = 20;
+    unsigned threads = 0;
+    long maxUnsubscribed = -1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) return usage();
+        if (strcmp(arg, "--hours") == 0) {
+            config.hours = atof(value);
+        } else if (strcmp(arg, "--runs") == 0) {
+            runs = (unsigned)atoi(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            config.seed = strtoull(value, nullptr, 10);
+        } else if (strcmp(arg, "--threads") == 0) {
+            threads = (unsigned)atoi(value);
+        } else if (strcmp(arg, "--flaps-per-hour") == 0) {
+            config.flapsPerHour = atof(value);
+        } else if (strcmp(arg, "--restarts-per-day") == 0) {
+            config.restartsPerDay = atof(value);
+        } else if (strcmp(arg, "--keep-sessions") == 0) {
+            config.restartKeepsSessions = atof(value);
+        } else if (strcmp(arg, "--offers-per-hour") == 0) {
+            config.offersPerHour = atof(value);
+        } else if (strcmp(arg, "--policy") == 0) {
+            if (strcmp(value, "every-connect") == 0) {
+                config.policy = ResubscribePolicy::EveryConnect;
+            } else if (strcmp(value, "gap-expiry") == 0) {
+                config.policy = ResubscribePolicy::GapExpiry;
+            } else {
+                return usage();
+            }
+        } else if (strcmp(arg, "--max-unsubscribed") == 0) {
+            maxUnsubscribed = atol(value);
+        } else {
+            return usage();
+        }
+        i++;
+    }
+    if (config.hours <= 0 || runs == 0) return usage();
+
+    auto start = std::chrono::steady_clock::now();
+    FlapResult result = simulateRuns(config, runs, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("policy %s: %u run(s) x %.1f h, seed %llu (%.2f s)\n", policyName(config.policy), runs,
+           config.hours, (unsigned long long)config.seed, seconds);
+    printf("WiFi flaps %zu (%.1f/h), broker restarts %zu, sessions wiped %zu\n", result.flaps,
+           result.flaps / result.hours, result.restarts, result.sessionsWiped);
+    printf("connects %zu, SUBSCRIBE packets %zu\n", result.connects, result.subscribes);
+    printf("offers %zu, missed %zu (%.2f%%)\n", result.offers, result.missed(),
+           result.offers ? 100.0 * result.missed() / result.offers : 0.0);
+    printRow("delivered", result.delivered, result.offers);
+    printRow("late", result.late, result.offers);
+    printRow("lost_broker_down", result.lostBrokerDown, result.offers);
+    printRow("lost_no_session", result.lostNoSession, result.offers);
+    printRow("missed_unsubscribed", result.missedUnsubscribed, result.offers);
+    printRow("queue_overflow", result.queueOverflow, result.offers);
+    printRow("session_wiped", result.wiped, result.offers);
+    printf("latency publish -> device: p50 %u ms, p95 %u ms, p99 %u ms, max %u ms (ttl %u ms)\n",
+           latencyQuantile(result, 0.5), latencyQuantile(result, 0.95), latencyQuantile(result, 0.99),
+           latencyQuantile(result, 1.0), config.offerTtlMs);
+
+    if (maxUnsubscribed >= 0 && result.missedUnsubscribed > (size_t)maxUnsubscribed) {
+        fprintf(stderr, "FAIL: %zu offer(s) missed for lack of a subscription (max %ld)\n",
+                result.missedUnsubscribed, maxUnsubscribed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * mqtt_flap_test.cpp
+ * MqttSession subscription handling and the flap simulation
+ */
+
+#include "FlapSim.h"
+#include "MqttSession.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+static void testSubscriptionTable() {
+    MqttSession session;
+    CHECK(session.add("a", 1));
+    CHECK(session.add("a", 1));                 // Already tracked
+    CHECK(session.getCount() == 1);
+    CHECK(session.add("b", 0) && session.add("c", 1) && session.add("d", 1));
+    CHECK(!session.add("e", 1));                // Table full
+    CHECK(session.getCount() == MQTT_MAX_SUBSCRIPTIONS);
+    CHECK(strcmp(session.getSubscription(1).topic, "b") == 0 && session.getSubscription(1).qos == 0);
+}
+
+static void testResubscribeEveryConnect() {
+    MqttSession session;
+    session.add("ride", 1);
+    session.add("ack", 1);
+    CHECK(session.hasPending());
+
+    int sent = 0;
+    auto ok = [&](const char*, uint8_t) { sent++; return true; };
+    session.onConnected(1000);
+    CHECK(session.subscribePending(ok) == 0);
+    CHECK(sent == 2 && !session.hasPending());
+    CHECK(session.subscribePending(ok) == 0 && sent == 2);     // Nothing left to send
+
+    // A 5 s gap, far inside any session expiry, still redoes both
+    session.onDisconnected(2000);
+    session.onDisconnected(2100);               // Counted once
+    session.onConnected(7000);
+    CHECK(session.hasPending());
+    CHECK(session.subscribePending(ok) == 0 && sent == 4);
+
+    const MqttSessionStats& stats = session.getStats();
+    CHECK(stats.connects == 2 && stats.disconnects == 1);
+    CHECK(stats.lastGapMs == 5000 && stats.longestGapMs == 5000);
+    CHECK(stats.subscribeRequests == 4);
+
+    // A failed SUBSCRIBE stays pending for the retry
+    session.onDisconnected(8000);
+    session.onConnected(9000);
+    auto ackFails = [&](const char* topic, uint8_t) { return strcmp(topic, "ack") != 0; };
+    CHECK(session.subscribePending(ackFails) == 1);
+    CHECK(session.hasPending());
+    CHECK(session.subscribePending(ok) == 0 && !session.hasPending());
+    CHECK(session.getStats().lastGapMs == 1000 && session.getStats().longestGapMs == 5000);
+}
+
+static FlapConfig quiet() {
+    FlapConfig config;
+    config.hours = 6;
+    config.flapsPerHour = 0;
+    config.restartsPerDay = 0;
+    return config;
+}
+
+static void testStableLink() {
+    FlapResult result = simulate(quiet());
+    CHECK(result.offers > 100);
+    CHECK(result.delivered == result.offers && result.missed() == 0);
+    CHECK(result.connects == 1 && result.subscribes == 2);
+    CHECK(latencyQuantile(result, 1.0) <= quiet().tickMs);
+}
+
+static void testFlapsQueueOnBroker() {
+    FlapConfig config = quiet();
+    config.flapsPerHour = 6;
+    FlapResult result = simulate(config);
+    CHECK(result.flaps > 10);
+    CHECK(result.connects > result.flaps / 2);
+    CHECK(result.missedUnsubscribed == 0 && result.lostNoSession == 0);
+    CHECK(result.delivered + result.late == result.offers);     // The persistent session holds them
+    CHECK(latencyQuantile(result, 1.0) > config.tickMs);
+
+    FlapResult again = simulate(config);
+    CHECK(again.offers == result.offers && again.delivered == result.delivered);
+}
+
+static void testWipedSession() {
+    // Broker restarts without persistence: only resubscribing on every connect recovers
+    FlapConfig config = quiet();
+    config.hours = 48;
+    config.flapsPerHour = 2;
+    config.restartsPerDay = 2;
+    config.restartKeepsSessions = 0.0;
+
+    FlapResult every = simulateRuns(config, 4, 0);
+    CHECK(every.sessionsWiped > 0);
+    CHECK(every.missedUnsubscribed == 0);
+    CHECK(every.subscribes >= 2 * every.connects);
+
+    config.policy = ResubscribePolicy::GapExpiry;
+    FlapResult legacy = simulateRuns(config, 4, 0);
+    CHECK(legacy.sessionsWiped > 0);
+    CHECK(legacy.missedUnsubscribed > legacy.offers / 10);
+    CHECK(legacy.subscribes < every.subscribes);
+}
+
+int main() {
+    testSubscriptionTable();
+    testResubscribeEveryConnect();
+    testStableLink();
+    testFlapsQueueOnBroker();
+    testWipedSession();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("mqtt_flap_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,306 @@
+/*
+ * PresenceReplay.cpp
+ * Trace parsing, virtual-clock replay, scoring and the parallel sweep
+ */
+
+#include "PresenceReplay.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void setError(std::string* error, const std::string& text) {
+    if (error) *error = text;
+}
+
+static bool parseHeader(const char* text, Trace& trace) {
+    char word[16];
+    int used = 0;
+    if (sscanf(text, "%15s%n", word, &used) != 1) return true;
+    text += used;
+
+    if (strcmp(word, "bearings") == 0) {
+        trace.bearingsDeg.clear();
+        int bearing;
+        while (sscanf(text, "%d%n", &bearing, &used) == 1) {
+            if (bearing < -90 || bearing > 90) return false;
+            trace.bearingsDeg.push_back((int8_t)bearing);
+            text += used;
+        }
+        return !trace.bearingsDeg.empty() && trace.bearingsDeg.size() <= PRESENCE_MAX_CHANNELS;
+    }
+    if (strcmp(word, "user") == 0) {
+        unsigned long start, end;
+        if (sscanf(text, "%lu %lu", &start, &end) != 2 || end < start) return false;
+        trace.users.push_back({(uint32_t)start, (uint32_t)end});
+        return true;
+    }
+    return true;    // Free-form comment
+}
+
+bool parseTrace(const std::string& text, const std::string& name, Trace& trace, std::string* error) {
+    trace = Trace();
+    trace.name = name;
+    std::istringstream lines(text);
+    std::string line;
+    size_t lineNumber = 0;
+
+    while (std::getline(lines, line)) {
+        lineNumber++;
+        const char* p = line.c_str();
+        while (*p == ' ' || *p == '\t') p++;
+
+        if (*p == '#') {
+            if (!parseHeader(p + 1, trace)) {
+                setError(error, name + ":" + std::to_string(lineNumber) + ": bad header");
+                return false;
+            }
+            continue;
+        }
+
+        // Samples as ULTRASONIC_TRACE prints them, with or without the tag;
+        // anything else in a serial capture is other log output
+        const char* sample = strstr(p, "[US]");
+        if (sample) {
+            sample += 4;
+        } else if (*p >= '0' && *p <= '9') {
+            sample = p;
+        } else {
+            continue;
+        }
+
+        unsigned long timeMs;
+        unsigned channel;
+        float distance;
+        if (sscanf(sample, " %lu,%u,%f", &timeMs, &channel, &distance) != 3 ||
+            channel >= PRESENCE_MAX_CHANNELS) {
+            setError(error, name + ":" + std::to_string(lineNumber) + ": bad sample");
+            return false;
+        }
+        if (!trace.samples.empty() && timeMs < trace.samples.back().timeMs) {
+            setError(error, name + ":" + std::to_string(lineNumber) + ": time goes backwards");
+            return false;
+        }
+        trace.samples.push_back({(uint32_t)timeMs, (uint8_t)channel, distance});
+    }
+
+    size_t channels = trace.bearingsDeg.empty() ? 1 : trace.bearingsDeg.size();
+    for (const TraceSample& sample : trace.samples) {
+        if (sample.channel >= channels) {
+            setError(error, name + ": sample for sensor " + std::to_string(sample.channel) +
+                     " but " + std::to_string(channels) + " bearing(s)");
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool loadTrace(const std::string& path, std::vector<Trace>& corpus, std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        setError(error, "cannot read " + path);
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+
+    Trace trace;
+    if (!parseTrace(buffer.str(), std::filesystem::path(path).filename().string(), trace, error)) {
+        return false;
+    }
+    corpus.push_back(std::move(trace));
+    return true;
+}
+
+bool loadCorpus(const std::string& path, std::vector<Trace>& corpus, std::string* error) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (!fs::is_directory(path, ec)) {
+        return loadTrace(path, corpus, error);
+    }
+
+    std::vector<std::string> files;
+    for (const fs::directory_entry& entry : fs::directory_iterator(path, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".trace") {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    for (const std::string& file : files) {
+        if (!loadTrace(file, corpus, error)) return false;
+    }
+    if (files.empty()) {
+        setError(error, "no .trace files in " + path);
+        return false;
+    }
+    return true;
+}
+
+std::string formatTrace(const Trace& trace, const std::string& comment) {
+    std::string out;
+    char line[64];
+    if (!comment.empty()) {
+        out += "# " + comment + "\n";
+    }
+    if (!trace.bearingsDeg.empty()) {
+        out += "# bearings";
+        for (int8_t bearing : trace.bearingsDeg) {
+            snprintf(line, sizeof(line), " %d", bearing);
+            out += line;
+        }
+        out += "\n";
+    }
+    for (const UserLabel& user : trace.users) {
+        snprintf(line, sizeof(line), "# user %u %u\n", user.startMs, user.endMs);
+        out += line;
+    }
+    for (const TraceSample& sample : trace.samples) {
+        // Same format as the firmware's ULTRASONIC_TRACE output
+        snprintf(line, sizeof(line), "[US] %u,%u,%.1f\n", sample.timeMs, sample.channel, sample.distanceCm);
+        out += line;
+    }
+    return out;
+}
+
+TraceScore replayTrace(const Trace& trace, const PresenceParams& params, const ReplayConfig& config) {
+    TraceScore score;
+    score.users = trace.users.size();
+    if (trace.samples.empty()) {
+        score.missed = score.users;
+        return score;
+    }
+
+    PresenceTracker tracker(params);
+    if (!trace.bearingsDeg.empty()) {
+        tracker.configure(trace.bearingsDeg.data(), (uint8_t)trace.bearingsDeg.size());
+    }
+
+    std::vector<bool> userDetected(trace.users.size(), false);
+    uint32_t pollMs = config.pollMs > 0 ? config.pollMs : 1;
+    uint32_t now = trace.samples.front().timeMs;
+    score.durationMs = trace.samples.back().timeMs - now;
+    size_t next = 0;
+    bool confirmed = false;     // The FSM has moved past USER_DETECTED
+
+    while (next < trace.samples.size()) {
+        // Samples that arrived since the last poll, as update() would drain them
+        while (next < trace.samples.size() && trace.samples[next].timeMs <= now) {
+            const TraceSample& sample = trace.samples[next++];
+            tracker.addSample(sample.channel, sample.distanceCm);
+            tracker.update(sample.timeMs);
+        }
+
+        // FSM poll: once confirmed it stays on this user until they leave
+        if (confirmed && !tracker.isUserInZone()) {
+            confirmed = false;
+        }
+        if (!confirmed && tracker.isPresenceConfirmed(now)) {
+            confirmed = true;
+            score.confirmationsMs.push_back(now);
+
+            bool matched = false;
+            for (size_t i = 0; i < trace.users.size(); i++) {
+                const UserLabel& user = trace.users[i];
+                if (now >= user.startMs && now <= user.endMs && !userDetected[i]) {
+                    userDetected[i] = true;
+                    score.latenciesMs.push_back(now - user.startMs);
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched) {
+                score.falseTriggers++;
+            }
+        }
+        now += pollMs;
+    }
+
+    score.detected = score.latenciesMs.size();
+    score.missed = score.users - score.detected;
+    return score;
+}
+
+CorpusScore scoreCorpus(const std::vector<Trace>& corpus, const PresenceParams& params, const ReplayConfig& config) {
+    CorpusScore total;
+    std::vector<uint32_t> latencies;
+    uint64_t durationMs = 0;
+
+    for (const Trace& trace : corpus) {
+        TraceScore score = replayTrace(trace, params, config);
+        total.traces++;
+        total.users += score.users;
+        total.detected += score.detected;
+        total.missed += score.missed;
+        total.falseTriggers += score.falseTriggers;
+        durationMs += score.durationMs;
+        latencies.insert(latencies.end(), score.latenciesMs.begin(), score.latenciesMs.end());
+    }
+
+    total.hours = durationMs / 3600000.0;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        double sum = 0;
+        for (uint32_t latency : latencies) sum += latency;
+        total.meanLatencyMs = sum / latencies.size();
+        total.medianLatencyMs = latencies[latencies.size() / 2];
+        total.p95LatencyMs = latencies[(latencies.size() * 95 + 99) / 100 - 1];
+    }
+    return total;
+}
+
+bool betterScore(const CorpusScore& a, const CorpusScore& b) {
+    if (a.errors() != b.errors()) return a.errors() < b.errors();
+    if (a.missed != b.missed) return a.missed < b.missed;
+    return a.meanLatencyMs < b.meanLatencyMs;
+}
+
+std::vector<SweepResult> sweepParams(const std::vector<Trace>& corpus, const std::vector<PresenceParams>& grid,
+                                     const ReplayConfig& config, unsigned threads) {
+    std::vector<SweepResult> results(grid.size());
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<unsigned>(threads, std::max<size_t>(grid.size(), 1));
+
+    // Parameter sets are independent; workers take the next one until done
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < grid.size(); i = next++) {
+            results[i].params = grid[i];
+            results[i].score = scoreCorpus(corpus, grid[i], config);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    std::stable_sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b) {
+        return betterScore(a.score, b.score);
+    });
+    return results;
+}
+
+PresenceParams defaultParams() {
+    PresenceParams params;
+    params.presenceTimeMs = ULTRASONIC_PRESENCE_TIME;
+    params.toleranceCm = ULTRASONIC_ACCURACY_TOLERANCE;
+    params.minRangeCm = ULTRASONIC_MIN_RANGE_CM;
+    params.maxRangeCm = ULTRASONIC_MAX_RANGE_CM;
+    params.filterSize = ULTRASONIC_FILTER_SIZE;
+    params.fusionWindowCm = ULTRASONIC_FUSION_WINDOW_CM;
+    params.bearingToleranceDeg = ULTRASONIC_BEARING_TOLERANCE_DEG;
+    return params;
+}
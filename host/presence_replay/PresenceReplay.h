@@ -0,0 +1,103 @@
+/*
+ * PresenceReplay.h
+ * Replay of labelled ultrasonic traces through the firmware PresenceTracker
+ *
+ * A trace is the "[US] ms,sensor,cm" log the user-side unit prints with
+ * ULTRASONIC_TRACE, plus "#" header lines giving the transducer bearings and
+ * the intervals in which a real user was waiting at the block. Replay runs
+ * the samples through PresenceTracker on a virtual clock that is polled
+ * like the FSM loop, and scores each confirmation against the labels:
+ * detection latency, false triggers and missed users. A parameter sweep
+ * scores many PresenceParams over the same corpus in parallel.
+ */
+
+#ifndef PRESENCE_REPLAY_H
+#define PRESENCE_REPLAY_H
+
+#include "PresenceTracker.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct TraceSample {
+    uint32_t timeMs;
+    uint8_t channel;
+    float distanceCm;           // -1 = timeout
+};
+
+// A user waiting at the block, from arrival (standing still) to leaving
+struct UserLabel {
+    uint32_t startMs;
+    uint32_t endMs;
+};
+
+struct Trace {
+    std::string name;
+    std::vector<int8_t> bearingsDeg;    // "# bearings"; empty = one transducer straight out
+    std::vector<UserLabel> users;       // "# user START END"; none = nobody should trigger
+    std::vector<TraceSample> samples;
+};
+
+struct ReplayConfig {
+    uint32_t pollMs = 10;       // FSM loop period on the virtual clock
+};
+
+// Result of one trace
+struct TraceScore {
+    size_t users = 0;
+    size_t detected = 0;
+    size_t missed = 0;
+    size_t falseTriggers = 0;   // Confirmations outside a label, or a second one inside it
+    uint32_t durationMs = 0;
+    std::vector<uint32_t> latenciesMs;  // Label start -> confirmation, one per detected user
+    std::vector<uint32_t> confirmationsMs;
+};
+
+// Result over a corpus
+struct CorpusScore {
+    size_t traces = 0;
+    size_t users = 0;
+    size_t detected = 0;
+    size_t missed = 0;
+    size_t falseTriggers = 0;
+    double hours = 0.0;
+    double meanLatencyMs = 0.0;
+    uint32_t medianLatencyMs = 0;
+    uint32_t p95LatencyMs = 0;
+
+    size_t errors() const { return missed + falseTriggers; }
+    double falseTriggersPerHour() const { return hours > 0 ? falseTriggers / hours : 0.0; }
+};
+
+struct SweepResult {
+    PresenceParams params;
+    CorpusScore score;
+};
+
+// Parses one trace; lines that are neither headers nor samples (other log
+// output from a serial capture) are skipped
+bool parseTrace(const std::string& text, const std::string& name, Trace& trace, std::string* error = nullptr);
+
+// Loads a .trace file, or every .trace file of a directory (sorted by name)
+bool loadCorpus(const std::string& path, std::vector<Trace>& corpus, std::string* error = nullptr);
+
+// Writes a trace in the format parseTrace() reads
+std::string formatTrace(const Trace& trace, const std::string& comment);
+
+TraceScore replayTrace(const Trace& trace, const PresenceParams& params, const ReplayConfig& config);
+CorpusScore scoreCorpus(const std::vector<Trace>& corpus, const PresenceParams& params, const ReplayConfig& config);
+
+// Scores every parameter set on up to `threads` threads (0 = one per
+// hardware thread); results are sorted best first
+std::vector<SweepResult> sweepParams(const std::vector<Trace>& corpus, const std::vector<PresenceParams>& grid,
+                                     const ReplayConfig& config, unsigned threads);
+
+// Fewer missed users + false triggers first, then lower mean latency
+bool betterScore(const CorpusScore& a, const CorpusScore& b);
+
+// The shipped ULTRASONIC_* values of config.h
+PresenceParams defaultParams();
+
+#endif // PRESENCE_REPLAY_H
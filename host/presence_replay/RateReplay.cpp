@@ -0,0 +1,121 @@
+/*
+ * RateReplay.cpp
+ * UltrasonicSensor on a virtual clock, pinged on its own schedule
+ */
+
+#include "RateReplay.h"
+#include "UltrasonicSensor.h"
+
+// Presence timing clock handed to the sensor (one replay at a time)
+static uint32_t rateClockMs = 0;
+
+static unsigned long rateClock() {
+    return rateClockMs;
+}
+
+// The FSM states that choose a rate (FSMController::applySensingRate)
+enum FsmModel {
+    FSM_IDLE,
+    FSM_DETECTED,
+    FSM_ACTIVE      // Confirmed; privilege check and the rest run at the normal rate
+};
+
+static void applyRate(UltrasonicSensor& sensor, RateMode mode, FsmModel state) {
+    if (mode == RATE_MODE_FIXED) {
+        sensor.setRate(ULTRASONIC_RATE_NORMAL);
+    } else if (state == FSM_IDLE) {
+        sensor.setRate(ULTRASONIC_RATE_IDLE);
+    } else if (state == FSM_DETECTED) {
+        sensor.setRate(ULTRASONIC_RATE_FAST);
+    } else {
+        sensor.setRate(ULTRASONIC_RATE_NORMAL);
+    }
+}
+
+RateScore replayRates(const RateScene& scene, const PingSource& source, RateMode mode,
+                      const ReplayConfig& config) {
+    RateScore score;
+    score.presence.users = scene.users.size();
+    if (scene.durationMs <= scene.startMs) {
+        score.presence.missed = score.presence.users;
+        return score;
+    }
+
+    std::vector<int8_t> bearings = scene.bearingsDeg;
+    if (bearings.empty()) bearings.push_back(0);
+    uint8_t channels = (uint8_t)std::min<size_t>(bearings.size(), ULTRASONIC_MAX_SENSORS);
+    uint8_t trigPins[ULTRASONIC_MAX_SENSORS];
+    uint8_t echoPins[ULTRASONIC_MAX_SENSORS];
+    for (uint8_t i = 0; i < channels; i++) {
+        trigPins[i] = (uint8_t)(2 * i);
+        echoPins[i] = (uint8_t)(2 * i + 1);
+    }
+
+    rateClockMs = scene.startMs;
+    UltrasonicSensor sensor(trigPins, echoPins, bearings.data(), channels);
+    sensor.setClock(rateClock);
+
+    FsmModel state = FSM_IDLE;
+    applyRate(sensor, mode, state);
+
+    std::vector<bool> userDetected(scene.users.size(), false);
+    uint32_t pollMs = config.pollMs > 0 ? config.pollMs : 1;
+    uint32_t slotMs = 0;
+    uint32_t nextPingMs = scene.startMs;
+    uint8_t channel = 0;
+    score.presence.durationMs = scene.durationMs - scene.startMs;
+
+    for (uint32_t now = scene.startMs; now < scene.durationMs; now++) {
+        rateClockMs = now;
+
+        // A new interval restarts the periodic trigger timer
+        uint32_t slot = std::max<uint32_t>(sensor.getSampleInterval() / channels, 1);
+        if (slot != slotMs) {
+            nextPingMs = slotMs == 0 ? now : now + slot;
+            slotMs = slot;
+        }
+        if (now >= nextPingMs) {
+            sensor.injectSample(channel, source(now, channel), now);
+            score.pings++;
+            if (state == FSM_IDLE) score.idlePings++;
+            channel = (channel + 1) % channels;
+            nextPingMs = now + slotMs;
+        }
+        if (state == FSM_IDLE) score.idleMs++;
+
+        if ((now - scene.startMs) % pollMs != 0) continue;
+
+        FsmModel next = state;
+        if (state == FSM_IDLE) {
+            if (sensor.isUserInZone()) next = FSM_DETECTED;
+        } else if (!sensor.isUserInZone()) {
+            sensor.resetPresence();
+            next = FSM_IDLE;
+        } else if (state == FSM_DETECTED && sensor.isPresenceConfirmed()) {
+            next = FSM_ACTIVE;
+            score.presence.confirmationsMs.push_back(now);
+
+            bool matched = false;
+            for (size_t i = 0; i < scene.users.size(); i++) {
+                const UserLabel& user = scene.users[i];
+                if (now >= user.startMs && now <= user.endMs && !userDetected[i]) {
+                    userDetected[i] = true;
+                    score.presence.latenciesMs.push_back(now - user.startMs);
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched) {
+                score.presence.falseTriggers++;
+            }
+        }
+        if (next != state) {
+            state = next;
+            applyRate(sensor, mode, state);
+        }
+    }
+
+    score.presence.detected = score.presence.latenciesMs.size();
+    score.presence.missed = score.presence.users - score.presence.detected;
+    return score;
+}
@@ -0,0 +1,47 @@
+/*
+ * RateReplay.h
+ * Closed-loop replay of the ultrasonic sampling rate
+ *
+ * A recorded trace already has the firmware's sampling schedule baked in,
+ * so it cannot show what a different schedule would have seen. Here the
+ * firmware UltrasonicSensor (built against the Arduino shim) decides when
+ * to ping: a scene is asked for the reading at each ping, the sample goes
+ * through injectSample(), and a small model of the user-side FSM sets the
+ * UltrasonicRate per state like FSMController::applySensingRate(). The
+ * result is scored like replayTrace() and counts the pings spent, so the
+ * adaptive schedule can be compared against a fixed rate.
+ */
+
+#ifndef RATE_REPLAY_H
+#define RATE_REPLAY_H
+
+#include "PresenceReplay.h"
+
+#include <functional>
+
+enum RateMode {
+    RATE_MODE_ADAPTIVE,     // Idle / fast / normal per FSM state, wake-up burst
+    RATE_MODE_FIXED         // ULTRASONIC_RATE_NORMAL throughout (100 ms)
+};
+
+// Reading of one transducer when it is pinged: cm, or -1 for a timeout
+typedef std::function<float(uint32_t timeMs, uint8_t channel)> PingSource;
+
+struct RateScene {
+    std::vector<int8_t> bearingsDeg;    // Empty = one transducer straight out
+    std::vector<UserLabel> users;
+    uint32_t startMs = 1000;
+    uint32_t durationMs = 0;            // Scene end on the same clock as startMs
+};
+
+struct RateScore {
+    TraceScore presence;        // Detections and false triggers, as replayTrace()
+    uint32_t pings = 0;         // Trigger pulses over the whole scene
+    uint32_t idlePings = 0;     // ...of which while the FSM sat in STATE_IDLE
+    uint32_t idleMs = 0;        // Time spent in STATE_IDLE
+};
+
+RateScore replayRates(const RateScene& scene, const PingSource& source, RateMode mode,
+                      const ReplayConfig& config);
+
+#endif // RATE_REPLAY_H
@@ -0,0 +1,588 @@
+/*
+ * main.cpp
+ * presence_replay: score PresenceTracker on labelled ultrasonic traces
+ *
+ *   presence_replay [--poll-ms N] [--presence-ms SPEC] [--tolerance-cm SPEC]
+ *                   [--filter SPEC] [--bearing-deg SPEC] [--threads N] [--top N]
+ *                   [--max-errors N] CORPUS
+ *       CORPUS is a .trace file or a directory of them. SPEC is a value, a
+ *       list (3,5,7) or a range (2000:4000:500); unset parameters use the
+ *       config.h values. One parameter set prints a per-trace report, more
+ *       than one runs a parallel sweep and prints the best --top sets.
+ *       With --max-errors, exit status 1 if the (best) set has more missed
+ *       users + false triggers than that.
+ *
+ *   presence_replay --synthesize DIR [--seed S] [--variants N]
+ *       Writes the synthetic scenario corpus (see synthesize()).
+ *
+ *   presence_replay --rates [--poll-ms N] [--seed S] [--variants N]
+ *       Runs the same scenes closed-loop through UltrasonicSensor, once with
+ *       the adaptive rate and once at a fixed 100 ms, and compares detection
+ *       latency, false triggers and pings spent (see compareRates()).
+ */
+
+#include "PresenceReplay.h"
+#include "RateReplay.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int usage() {
+    fprintf(stderr,
+            "usage: presence_replay [--poll-ms N] [--presence-ms SPEC] [--tolerance-cm SPEC]\n"
+            "                       [--filter SPEC] [--bearing-deg SPEC] [--threads N] [--top N]\n"
+            "                       [--max-errors N] CORPUS\n"
+            "       presence_replay --synthesize DIR [--seed S] [--variants N]\n"
+            "       presence_replay --rates [--poll-ms N] [--seed S] [--variants N]\n"
+            "SPEC: value, list a,b,c or range lo:hi:step\n");
+    return 2;
+}
+
+// "5", "3,5,7" or "2000:4000:500"
+static bool parseSpec(const char* text, std::vector<double>& values) {
+    values.clear();
+    double low, high, step;
+    if (strchr(text, ':')) {
+        if (sscanf(text, "%lf:%lf:%lf", &low, &high, &step) != 3 || step <= 0 || high < low) return false;
+        for (double value = low; value <= high + step * 1e-6; value += step) {
+            values.push_back(value);
+        }
+        return true;
+    }
+    const char* p = text;
+    while (*p) {
+        char* end;
+        double value = strtod(p, &end);
+        if (end == p) return false;
+        values.push_back(value);
+        p = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0') return false;
+    }
+    return !values.empty();
+}
+
+// ---------------------------------------------------------------------------
+// Synthetic corpus
+//
+// People are point targets moving along keyframed paths (range, bearing).
+// A transducer sees the nearest target inside its beam; readings get
+// Gaussian noise, dropouts (timeouts) and multipath spikes, and nothing
+// beyond the echo timeout (~5 m) comes back. Sampling follows the firmware:
+// transducers take turns, slow while nothing is in the zone, fast otherwise.
+// ---------------------------------------------------------------------------
+
+struct Keyframe {
+    uint32_t timeMs;
+    float rangeCm;
+    float bearingDeg;
+};
+
+struct Target {
+    std::vector<Keyframe> path;     // Present from the first to the last keyframe
+    float sigmaCm = 1.5f;           // Range noise
+    float swayCm = 0.0f;            // Slow sway amplitude while standing
+    float dropout = 0.05f;          // Probability of a missed echo
+};
+
+struct Scene {
+    const char* name;
+    const char* description;
+    std::vector<int8_t> bearingsDeg;
+    std::vector<Target> targets;
+    std::vector<UserLabel> users;
+    uint32_t durationMs;
+    float clutter = 0.005f;         // Stray echo probability per ping
+    float beamHalfAngleDeg = 15.0f;
+};
+
+static const float ECHO_LIMIT_CM = 500.0f;      // ULTRASONIC_ECHO_TIMEOUT_US / 58
+static const float SPIKE_PROBABILITY = 0.02f;
+static const uint32_t ACTIVE_HOLD_MS = 1000;    // FSM leaves USER_DETECTED about this late
+
+struct Random {
+    uint64_t state;
+    explicit Random(uint64_t seed) : state(seed * 2654435761ULL + 1) {}
+    uint32_t next() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (uint32_t)(state >> 33);
+    }
+    double uniform(double low, double high) { return low + (high - low) * (next() / 2147483648.0); }
+    bool chance(double p) { return uniform(0, 1) < p; }
+    double gauss() {
+        double u1 = uniform(1e-9, 1), u2 = uniform(0, 1);
+        return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+    }
+};
+
+static bool targetAt(const Target& target, uint32_t timeMs, float& range, float& bearing) {
+    const std::vector<Keyframe>& path = target.path;
+    if (path.empty() || timeMs < path.front().timeMs || timeMs > path.back().timeMs) return false;
+    for (size_t i = 1; i < path.size(); i++) {
+        if (timeMs <= path[i].timeMs) {
+            const Keyframe& a = path[i - 1];
+            const Keyframe& b = path[i];
+            float f = b.timeMs > a.timeMs ? (float)(timeMs - a.timeMs) / (b.timeMs - a.timeMs) : 1.0f;
+            range = a.rangeCm + (b.rangeCm - a.rangeCm) * f;
+            bearing = a.bearingDeg + (b.bearingDeg - a.bearingDeg) * f;
+            return true;
+        }
+    }
+    range = path.back().rangeCm;
+    bearing = path.back().bearingDeg;
+    return true;
+}
+
+// What one transducer reads when pinged at timeMs: cm, or -1 for a timeout
+static float pingScene(const Scene& scene, uint32_t timeMs, size_t channel, Random& random) {
+    float best = -1;
+    const Target* seen = nullptr;
+    for (const Target& target : scene.targets) {
+        float range, bearing;
+        if (!targetAt(target, timeMs, range, bearing)) continue;
+        if (fabsf(bearing - scene.bearingsDeg[channel]) > scene.beamHalfAngleDeg) continue;
+        range += target.swayCm * sinf(timeMs * 2 * (float)M_PI / 4000.0f);
+        if (best < 0 || range < best) {
+            best = range;
+            seen = &target;
+        }
+    }
+
+    float reading = -1;
+    if (seen && !random.chance(seen->dropout)) {
+        reading = random.chance(SPIKE_PROBABILITY) ? (float)random.uniform(30, best)
+                                                   : best + (float)(random.gauss() * seen->sigmaCm);
+    } else if (random.chance(scene.clutter)) {
+        reading = (float)random.uniform(50, ECHO_LIMIT_CM);
+    }
+    if (reading > ECHO_LIMIT_CM) reading = -1;
+    return reading;
+}
+
+static Trace renderScene(const Scene& scene, Random& random) {
+    Trace trace;
+    trace.name = scene.name;
+    trace.bearingsDeg = scene.bearingsDeg;
+    trace.users = scene.users;
+
+    size_t channels = scene.bearingsDeg.size();
+    uint32_t idleSlot = std::max<uint32_t>(400 / channels, 40);
+    uint32_t timeMs = 1000;
+    size_t channel = 0;
+    uint32_t lastInZoneMs = 0;
+    bool seenInZone = false;
+
+    while (timeMs < scene.durationMs) {
+        float reading = pingScene(scene, timeMs, channel, random);
+        trace.samples.push_back({timeMs, (uint8_t)channel, reading});
+        if (reading >= ULTRASONIC_MIN_RANGE_CM) {
+            lastInZoneMs = timeMs;
+            seenInZone = true;
+        }
+        channel = (channel + 1) % channels;
+
+        // Idle rate until something is in the zone, then the fast rate of the
+        // wake-up burst and USER_DETECTED until the zone has been empty a while
+        bool active = seenInZone && timeMs - lastInZoneMs < ACTIVE_HOLD_MS;
+        timeMs += active ? 40 : idleSlot;
+    }
+    return trace;
+}
+
+// Walk in from beyond range, stand, walk off
+static Target waitingUser(uint32_t arriveMs, uint32_t leaveMs, float rangeCm, float bearingDeg) {
+    Target user;
+    user.path = {{arriveMs - 2500, 520, bearingDeg}, {arriveMs, rangeCm, bearingDeg},
+                 {leaveMs, rangeCm, bearingDeg}, {leaveMs + 2500, 520, bearingDeg}};
+    return user;
+}
+
+static std::vector<Scene> buildScenes(Random& random) {
+    std::vector<Scene> scenes;
+    auto jitter = [&](double spread) { return (float)random.uniform(-spread, spread); };
+    uint32_t arrive = 6000 + (uint32_t)random.uniform(0, 1000);
+
+    {
+        Scene scene{"waiting", "user walks up, waits ~12 s, leaves", {0}, {}, {}, 24000};
+        float range = 150 + jitter(40);
+        scene.targets.push_back(waitingUser(arrive, arrive + 12000, range, 0));
+        scene.users.push_back({arrive, arrive + 12000});
+        scenes.push_back(scene);
+    }
+    {
+        Scene scene{"fidget", "user sways and shuffles forward once while waiting", {0}, {}, {}, 26000};
+        float range = 180 + jitter(40);
+        Target user = waitingUser(arrive, arrive + 14000, range, 0);
+        user.path.insert(user.path.begin() + 2, {{arrive + 6000, range, 0}, {arrive + 6600, range - 25, 0}});
+        user.path[4].rangeCm = range - 25;
+        user.sigmaCm = 2.0f;
+        user.swayCm = 2.5f;
+        scene.targets.push_back(user);
+        scene.users.push_back({arrive, arrive + 14000});
+        scenes.push_back(scene);
+    }
+    {
+        Scene scene{"passerby", "two people cross the beam without stopping", {0}, {}, {}, 20000};
+        for (uint32_t crossMs : {arrive, arrive + 6000}) {
+            Target walker;
+            float range = 120 + jitter(60);
+            walker.path = {{crossMs, range, -45}, {crossMs + 2000, range, 45}};
+            scene.targets.push_back(walker);
+        }
+        scenes.push_back(scene);
+    }
+    {
+        Scene scene{"linger", "someone stops for 1.5-2.7 s and walks on", {0}, {}, {}, 20000};
+        scene.targets.push_back(waitingUser(arrive, arrive + 1500 + (uint32_t)random.uniform(0, 1200),
+                                            170 + jitter(30), 0));
+        scenes.push_back(scene);
+    }
+    {
+        Scene scene{"crowd", "a passer-by cuts in front of a waiting user", {0}, {}, {}, 26000};
+        float range = 200 + jitter(30);
+        scene.targets.push_back(waitingUser(arrive, arrive + 15000, range, 0));
+        Target walker;
+        walker.path = {{arrive + 1500, 90, -45}, {arrive + 3500, 90, 45}};
+        scene.targets.push_back(walker);
+        scene.users.push_back({arrive, arrive + 15000});
+        scenes.push_back(scene);
+    }
+    {
+        Scene scene{"empty", "nobody, stray echoes only", {0}, {}, {}, 60000};
+        scene.clutter = 0.02f;
+        scenes.push_back(scene);
+    }
+    {
+        Scene scene{"far", "user waits near the edge of the echo range", {0}, {}, {}, 26000};
+        Target user = waitingUser(arrive, arrive + 15000, 420 + jitter(30), 0);
+        user.sigmaCm = 2.5f;
+        user.dropout = 0.15f;
+        scene.targets.push_back(user);
+        scene.users.push_back({arrive, arrive + 15000});
+        scenes.push_back(scene);
+    }
+    {
+        Scene scene{"slow", "user shuffles in at ~0.25 m/s, then waits", {0}, {}, {}, 30000};
+        float range = 160 + jitter(30);
+        uint32_t stopMs = arrive + 10000;
+        Target user;
+        user.path = {{arrive, 450, 0}, {stopMs, range, 0}, {stopMs + 12000, range, 0}, {stopMs + 14000, 520, 0}};
+        scene.targets.push_back(user);
+        scene.users.push_back({stopMs, stopMs + 12000});
+        scenes.push_back(scene);
+    }
+    return scenes;
+}
+
+// Three transducers at -30/0/30 whose 20° half-angle beams overlap, so a
+// target between two of them is seen by both
+static Scene arrayScene(const char* name, const char* description, uint32_t durationMs) {
+    Scene scene{name, description, {-30, 0, 30}, {}, {}, durationMs};
+    scene.beamHalfAngleDeg = 20.0f;
+    return scene;
+}
+
+static std::vector<Scene> buildArrayScenes(Random& random) {
+    std::vector<Scene> scenes;
+    auto jitter = [&](double spread) { return (float)random.uniform(-spread, spread); };
+    uint32_t arrive = 6000 + (uint32_t)random.uniform(0, 1000);
+
+    {
+        // Steady range, bearing sweeping -35..35°: only the bearing gate rejects it
+        Scene scene = arrayScene("pacing", "someone paces across the array at a steady range", 34000);
+        float range = 150 + jitter(30);
+        float speedCmS = (float)random.uniform(55, 75);
+        uint32_t legMs = (uint32_t)(range * 70.0f * (float)M_PI / 180.0f / speedCmS * 1000.0f);
+        Target pacer;
+        pacer.path = {{arrive - 2500, 520, -35}, {arrive, range, -35}};
+        for (int leg = 0; leg < 5; leg++) {
+            pacer.path.push_back({arrive + (leg + 1) * legMs, range, leg % 2 ? -35.0f : 35.0f});
+        }
+        uint32_t leaveMs = pacer.path.back().timeMs;
+        pacer.path.push_back({leaveMs + 2500, 520, pacer.path.back().bearingDeg});
+        scene.targets.push_back(pacer);
+        scenes.push_back(scene);
+    }
+    {
+        Scene scene = arrayScene("offaxis", "user waits between two transducers", 24000);
+        scene.targets.push_back(waitingUser(arrive, arrive + 12000, 170 + jitter(30), 15 + jitter(3)));
+        scene.users.push_back({arrive, arrive + 12000});
+        scenes.push_back(scene);
+    }
+    {
+        // The walker is nearer, but at bearings away from the waiting user
+        Scene scene = arrayScene("crossing", "a passer-by crosses in front while a user waits to one side", 26000);
+        float range = 220 + jitter(30);
+        scene.targets.push_back(waitingUser(arrive, arrive + 15000, range, -30 + jitter(4)));
+        Target walker;
+        walker.path = {{arrive + 1500, 100, 0}, {arrive + 3500, 100, 50}};
+        scene.targets.push_back(walker);
+        scene.users.push_back({arrive, arrive + 15000});
+        scenes.push_back(scene);
+    }
+    return scenes;
+}
+
+static int synthesize(const std::string& directory, uint64_t seed, unsigned variants) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    for (unsigned variant = 1; variant <= variants; variant++) {
+        // The array scenes draw from their own stream so the single-transducer
+        // traces of a seed stay as they were
+        Random random(seed * 1000 + variant);
+        Random arrayRandom((seed * 1000 + variant) ^ 0xA11A7ULL);
+        std::vector<Scene> scenes = buildScenes(random);
+        size_t singleScenes = scenes.size();
+        for (const Scene& scene : buildArrayScenes(arrayRandom)) {
+            scenes.push_back(scene);
+        }
+        for (size_t i = 0; i < scenes.size(); i++) {
+            const Scene& scene = scenes[i];
+            Trace trace = renderScene(scene, i < singleScenes ? random : arrayRandom);
+            char name[64];
+            snprintf(name, sizeof(name), "%s_%u.trace", scene.name, variant);
+            std::string path = directory + "/" + name;
+
+            std::ofstream file(path, std::ios::binary);
+            file << formatTrace(trace, std::string("synthetic: ") + scene.description);
+            if (!file) {
+                fprintf(stderr, "presence_replay: cannot write %s\n", path.c_str());
+                return 2;
+            }
+            printf("%s: %zu samples, %zu user(s)\n", name, trace.samples.size(), trace.users.size());
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Sampling rate comparison
+//
+// The scenes are pinged when UltrasonicSensor's schedule asks for a reading
+// instead of on the synthesizer's approximation of it, so a rate change
+// shows up in what the tracker gets to see.
+// ---------------------------------------------------------------------------
+
+struct RateTotals {
+    size_t users = 0;
+    size_t detected = 0;
+    size_t missed = 0;
+    size_t falseTriggers = 0;
+    uint64_t durationMs = 0;
+    uint64_t idleMs = 0;
+    uint64_t pings = 0;
+    uint64_t idlePings = 0;
+    std::vector<uint32_t> latenciesMs;
+
+    void add(const RateScore& score) {
+        users += score.presence.users;
+        detected += score.presence.detected;
+        missed += score.presence.missed;
+        falseTriggers += score.presence.falseTriggers;
+        durationMs += score.presence.durationMs;
+        idleMs += score.idleMs;
+        pings += score.pings;
+        idlePings += score.idlePings;
+        latenciesMs.insert(latenciesMs.end(), score.presence.latenciesMs.begin(), score.presence.latenciesMs.end());
+    }
+};
+
+static void printRateLine(const char* mode, RateTotals& totals) {
+    double hours = totals.durationMs / 3600000.0;
+    double idleHours = totals.idleMs / 3600000.0;
+    double mean = 0;
+    uint32_t median = 0;
+    if (!totals.latenciesMs.empty()) {
+        std::sort(totals.latenciesMs.begin(), totals.latenciesMs.end());
+        for (uint32_t latency : totals.latenciesMs) mean += latency;
+        mean /= totals.latenciesMs.size();
+        median = totals.latenciesMs[totals.latenciesMs.size() / 2];
+    }
+    printf("%-9s | %6zu %6zu %6zu %8.1f | %8.0f %8u | %8.0f %10.0f\n",
+           mode, totals.detected, totals.missed, totals.falseTriggers,
+           hours > 0 ? totals.falseTriggers / hours : 0.0, mean, median,
+           hours > 0 ? totals.pings / hours : 0.0, idleHours > 0 ? totals.idlePings / idleHours : 0.0);
+}
+
+static int compareRates(uint64_t seed, unsigned variants, const ReplayConfig& config) {
+    RateTotals adaptive, fixed;
+
+    for (unsigned variant = 1; variant <= variants; variant++) {
+        Random random(seed * 1000 + variant);
+        Random arrayRandom((seed * 1000 + variant) ^ 0xA11A7ULL);
+        std::vector<Scene> scenes = buildScenes(random);
+        for (const Scene& scene : buildArrayScenes(arrayRandom)) {
+            scenes.push_back(scene);
+        }
+
+        for (size_t i = 0; i < scenes.size(); i++) {
+            const Scene& scene = scenes[i];
+            RateScene rateScene;
+            rateScene.bearingsDeg = scene.bearingsDeg;
+            rateScene.users = scene.users;
+            rateScene.durationMs = scene.durationMs;
+
+            // Same echo noise stream for both schedules
+            uint64_t noiseSeed = (seed * 1000 + variant) * 64 + i;
+            Random noise(noiseSeed);
+            PingSource source = [&](uint32_t timeMs, uint8_t channel) {
+                return pingScene(scene, timeMs, channel, noise);
+            };
+            RateScore withRates = replayRates(rateScene, source, RATE_MODE_ADAPTIVE, config);
+            noise = Random(noiseSeed);
+            RateScore withFixed = replayRates(rateScene, source, RATE_MODE_FIXED, config);
+            adaptive.add(withRates);
+            fixed.add(withFixed);
+
+            printf("%-12s adaptive: found %zu false %zu pings %5u idle %5u | fixed: found %zu false %zu pings %5u idle %5u\n",
+                   (std::string(scene.name) + "_" + std::to_string(variant)).c_str(),
+                   withRates.presence.detected, withRates.presence.falseTriggers, withRates.pings, withRates.idlePings,
+                   withFixed.presence.detected, withFixed.presence.falseTriggers, withFixed.pings, withFixed.idlePings);
+        }
+    }
+
+    printf("\n%-9s | %6s %6s %6s %8s | %8s %8s | %8s %10s\n",
+           "rate", "found", "missed", "false", "false/h", "mean_ms", "p50_ms", "pings/h", "idle_pings/h");
+    printRateLine("adaptive", adaptive);
+    printRateLine("fixed100", fixed);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+static void printReport(const std::vector<Trace>& corpus, const PresenceParams& params, const ReplayConfig& config) {
+    for (const Trace& trace : corpus) {
+        TraceScore score = replayTrace(trace, params, config);
+        printf("%-20s users %zu  detected %zu  missed %zu  false %zu  latency",
+               trace.name.c_str(), score.users, score.detected, score.missed, score.falseTriggers);
+        for (uint32_t latency : score.latenciesMs) {
+            printf(" %u", latency);
+        }
+        printf(score.latenciesMs.empty() ? " -\n" : " ms\n");
+    }
+}
+
+static void printScoreLine(const PresenceParams& params, const CorpusScore& score) {
+    printf("%8u %8.1f %6u %8.0f | %6zu %6zu %6zu %8.1f | %8.0f %8u %8u\n",
+           params.presenceTimeMs, params.toleranceCm, params.filterSize, params.bearingToleranceDeg,
+           score.detected, score.missed, score.falseTriggers, score.falseTriggersPerHour(),
+           score.meanLatencyMs, score.medianLatencyMs, score.p95LatencyMs);
+}
+
+int main(int argc, char** argv) {
+    ReplayConfig config;
+    PresenceParams base = defaultParams();
+    std::vector<double> presenceTimes = {(double)base.presenceTimeMs};
+    std::vector<double> tolerances = {base.toleranceCm};
+    std::vector<double> filterSizes = {(double)base.filterSize};
+    std::vector<double> bearingTolerances = {base.bearingToleranceDeg};
+    const char* path = nullptr;
+    const char* synthesizeDir = nullptr;
+    unsigned threads = 0;
+    size_t top = 10;
+    long maxErrors = -1;
+    uint64_t seed = 1;
+    unsigned variants = 3;
+    bool rates = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--poll-ms") == 0 && hasValue) {
+            config.pollMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--presence-ms") == 0 && hasValue) {
+            if (!parseSpec(argv[++i], presenceTimes)) return usage();
+        } else if (strcmp(arg, "--tolerance-cm") == 0 && hasValue) {
+            if (!parseSpec(argv[++i], tolerances)) return usage();
+        } else if (strcmp(arg, "--filter") == 0 && hasValue) {
+            if (!parseSpec(argv[++i], filterSizes)) return usage();
+        } else if (strcmp(arg, "--bearing-deg") == 0 && hasValue) {
+            if (!parseSpec(argv[++i], bearingTolerances)) return usage();
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            threads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--top") == 0 && hasValue) {
+            top = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--max-errors") == 0 && hasValue) {
+            maxErrors = strtol(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--synthesize") == 0 && hasValue) {
+            synthesizeDir = argv[++i];
+        } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--variants") == 0 && hasValue) {
+            variants = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--rates") == 0) {
+            rates = true;
+        } else if (arg[0] != '-') {
+            path = arg;
+        } else {
+            return usage();
+        }
+    }
+
+    if (synthesizeDir) {
+        return synthesize(synthesizeDir, seed, variants);
+    }
+    if (rates) {
+        return compareRates(seed, variants, config);
+    }
+    if (path == nullptr) {
+        return usage();
+    }
+
+    std::vector<Trace> corpus;
+    std::string error;
+    if (!loadCorpus(path, corpus, &error)) {
+        fprintf(stderr, "presence_replay: %s\n", error.c_str());
+        return 2;
+    }
+
+    std::vector<PresenceParams> grid;
+    for (double presenceTime : presenceTimes) {
+        for (double tolerance : tolerances) {
+            for (double filterSize : filterSizes) {
+                if (filterSize < 1 || filterSize > PRESENCE_MAX_FILTER) {
+                    fprintf(stderr, "presence_replay: filter size must be 1..%d\n", PRESENCE_MAX_FILTER);
+                    return 2;
+                }
+                for (double bearingTolerance : bearingTolerances) {
+                    PresenceParams params = base;
+                    params.presenceTimeMs = (uint32_t)presenceTime;
+                    params.toleranceCm = (float)tolerance;
+                    params.filterSize = (uint8_t)filterSize;
+                    params.bearingToleranceDeg = (float)bearingTolerance;
+                    grid.push_back(params);
+                }
+            }
+        }
+    }
+
+    if (grid.size() == 1) {
+        printReport(corpus, grid[0], config);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results = sweepParams(corpus, grid, config, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("\n%8s %8s %6s %8s | %6s %6s %6s %8s | %8s %8s %8s\n",
+           "presence", "tol_cm", "filter", "bear_deg", "found", "missed", "false", "false/h", "mean_ms", "p50_ms", "p95_ms");
+    for (size_t i = 0; i < results.size() && i < top; i++) {
+        printScoreLine(results[i].params, results[i].score);
+    }
+
+    fflush(stdout);
+    const CorpusScore& best = results.front().score;
+    fprintf(stderr, "%zu trace(s), %zu user(s), %.2f h; %zu parameter set(s) in %.2f s\n",
+            corpus.size(), best.users, best.hours, grid.size(), seconds);
+
+    if (maxErrors >= 0 && best.errors() > (size_t)maxErrors) {
+        fprintf(stderr, "presence_replay: %zu missed + false > %ld\n", best.errors(), maxErrors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * median_bench.cpp
+ * Cost of the ultrasonic median filter, new against old
+ *
+ *   median_bench [--windows N] [--reads R]
+ *       Per window: PresenceTracker::median5 (the default path), the
+ *       insertion sort of a copy (other window sizes), and the copy plus
+ *       bubble sort the sensor used before, which also ran on every
+ *       getDistance()/isUserInZone() call instead of once per sample.
+ *       The "per sample" rows charge the old path R reads (the FSM made
+ *       about 3 per loop) against one median of the cached path.
+ *
+ * Desktop numbers; they rank the paths, not the ESP32's absolute rate.
+ */
+
+#include "PresenceTracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// The filter before it cached its output (copy of the window, bubble sort)
+static float bubbleMedian(const float* window, uint8_t size) {
+    float sorted[PRESENCE_MAX_FILTER];
+    memcpy(sorted, window, size * sizeof(float));
+    for (uint8_t i = 0; i < size - 1; i++) {
+        for (uint8_t j = 0; j < size - i - 1; j++) {
+            if (sorted[j] > sorted[j + 1]) {
+                float temp = sorted[j];
+                sorted[j] = sorted[j + 1];
+                sorted[j + 1] = temp;
+            }
+        }
+    }
+    return sorted[size / 2];
+}
+
+static float insertionMedian(const float* window, uint8_t size) {
+    float sorted[PRESENCE_MAX_FILTER];
+    memcpy(sorted, window, size * sizeof(float));
+    PresenceTracker::sortArray(sorted, size);
+    return sorted[size / 2];
+}
+
+static float network5(const float* w, uint8_t) {
+    return PresenceTracker::median5(w[0], w[1], w[2], w[3], w[4]);
+}
+
+// Windows cycled through, small enough to stay in cache like the filter's
+static const size_t POOL_WINDOWS = 4096;
+
+// Nanoseconds per window; the sum keeps the work alive
+template <typename Median>
+static double timeMedian(const std::vector<float>& pool, size_t count, uint8_t size, unsigned calls, Median median) {
+    float sum = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        const float* window = &pool[(i % POOL_WINDOWS) * size];
+        for (unsigned c = 0; c < calls; c++) {
+            sum += median(window, size);
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (sum == -1) printf("%f\n", sum);
+    return seconds * 1e9 / count;
+}
+
+int main(int argc, char** argv) {
+    size_t windows = 2000000;
+    unsigned reads = 3;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--windows") == 0 && i + 1 < argc) {
+            windows = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--reads") == 0 && i + 1 < argc) {
+            reads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: median_bench [--windows N] [--reads R]\n");
+            return 2;
+        }
+    }
+
+    // Readings of someone standing: a few centimetres of noise, many duplicates
+    std::mt19937 random(47);
+    std::vector<float> samples(POOL_WINDOWS * PRESENCE_MAX_FILTER);
+    for (float& sample : samples) {
+        sample = 150.0f + (float)(random() % 11) * 0.5f;
+    }
+
+    timeMedian(samples, windows, 5, 1, network5);  // Warm up clocks and caches
+    printf("%-26s %6s %10s\n", "path", "window", "ns/median");
+    printf("%-26s %6u %10.1f\n", "median5 network", 5, timeMedian(samples, windows, 5, 1, network5));
+    for (uint8_t size : {3, 5, 7, 9}) {
+        printf("%-26s %6u %10.1f\n", "copy + insertion sort", size, timeMedian(samples, windows, size, 1, insertionMedian));
+        printf("%-26s %6u %10.1f\n", "copy + bubble sort (old)", size, timeMedian(samples, windows, size, 1, bubbleMedian));
+    }
+
+    printf("\n%-26s %6s %10s\n", "per sample", "window", "ns");
+    printf("%-26s %6u %10.1f\n", "median5, once", 5, timeMedian(samples, windows, 5, 1, network5));
+    char label[32];
+    snprintf(label, sizeof(label), "bubble sort x %u reads", reads);
+    printf("%-26s %6u %10.1f\n", label, 5, timeMedian(samples, windows, 5, reads, bubbleMedian));
+    return 0;
+}
@@ -0,0 +1,423 @@
+/*
+ * presence_replay_test.cpp
+ * PresenceTracker behaviour, trace parsing, replay scoring and the
+ * UltrasonicSensor sampling rate
+ */
+
+#include "PresenceReplay.h"
+#include "RateReplay.h"
+#include "UltrasonicSensor.h"
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+// A user standing at `range` from `fromMs` to `toMs`, sampled every 40 ms
+static void addStanding(Trace& trace, uint32_t fromMs, uint32_t toMs, float range) {
+    for (uint32_t t = fromMs; t < toMs; t += 40) {
+        trace.samples.push_back({t, 0, range + ((t / 40) % 3) * 0.5f});
+    }
+}
+
+// Nothing within range (timeouts), at the same rate
+static void addEmpty(Trace& trace, uint32_t fromMs, uint32_t toMs) {
+    for (uint32_t t = fromMs; t < toMs; t += 40) {
+        trace.samples.push_back({t, 0, -1});
+    }
+}
+
+static void testMedianFilter() {
+    PresenceTracker tracker(defaultParams());
+    const float readings[] = {150, 151, 420, 149, 150};
+    for (float reading : readings) {
+        tracker.addSample(0, reading);
+    }
+    tracker.update(0);
+    CHECK(tracker.getDistance() == 150);        // The spike is voted out
+    CHECK(tracker.isUserInZone());
+
+    PresenceParams params = defaultParams();
+    params.filterSize = 3;
+    tracker.setParams(params);
+    const float three[] = {300, 10, 305};
+    for (float reading : three) {
+        tracker.addSample(0, reading);
+    }
+    tracker.update(0);
+    CHECK(tracker.getDistance() == 300);
+}
+
+// Few distinct values, so windows are full of duplicates
+static float randomReading(std::mt19937& random) {
+    return 150.0f + (float)(random() % 7) * 0.5f;
+}
+
+static float nthMedian(std::vector<float> window) {
+    std::nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+    return window[window.size() / 2];
+}
+
+static void testMedianSelection() {
+    std::mt19937 random(47);
+
+    for (int i = 0; i < 200000; i++) {
+        std::vector<float> w(5);
+        for (float& value : w) value = randomReading(random);
+        CHECK(PresenceTracker::median5(w[0], w[1], w[2], w[3], w[4]) == nthMedian(w));
+    }
+
+    for (uint8_t size = 1; size <= PRESENCE_MAX_FILTER; size++) {
+        for (int i = 0; i < 20000; i++) {
+            std::vector<float> w(size);
+            for (float& value : w) value = randomReading(random);
+            std::vector<float> sorted = w;
+            PresenceTracker::sortArray(sorted.data(), size);
+            CHECK(std::is_sorted(sorted.begin(), sorted.end()));
+            CHECK(sorted[size / 2] == nthMedian(w));
+        }
+    }
+
+    // Through the filter: each new sample's window is the last filterSize readings
+    for (uint8_t size : {3, 5, 7, 9}) {
+        PresenceParams params = defaultParams();
+        params.filterSize = size;
+        PresenceTracker tracker(params);
+        std::vector<float> history;
+        for (int i = 0; i < 20000; i++) {
+            float reading = randomReading(random);
+            tracker.addSample(0, reading);
+            history.push_back(reading);
+            if (history.size() < size) continue;
+            std::vector<float> window(history.end() - size, history.end());
+            CHECK(tracker.getChannelDistance(0) == nthMedian(window));
+        }
+    }
+}
+
+static void testPresenceTiming() {
+    PresenceParams params = defaultParams();
+    PresenceTracker tracker(params);
+    uint32_t t = 1000;
+    for (int i = 0; i < 5; i++, t += 40) {
+        tracker.addSample(0, 150);
+    }
+    CHECK(tracker.update(t) == PRESENCE_STARTED);
+    uint32_t start = t;
+    CHECK(!tracker.isPresenceConfirmed(start + params.presenceTimeMs - 1));
+    CHECK(tracker.isPresenceConfirmed(start + params.presenceTimeMs));
+
+    // Within tolerance keeps the timer, beyond it restarts
+    for (int i = 0; i < 5; i++, t += 40) {
+        tracker.addSample(0, 150 + params.toleranceCm);
+    }
+    CHECK(tracker.update(t) == PRESENCE_NONE);
+    CHECK(tracker.getPresenceTime(t) == t - start);
+    for (int i = 0; i < 5; i++, t += 40) {
+        tracker.addSample(0, 180);
+    }
+    CHECK(tracker.update(t) == PRESENCE_MOVED);
+    CHECK(tracker.getPresenceTime(t) == 0);
+}
+
+static void testTimeouts() {
+    PresenceTracker tracker(defaultParams());
+    for (int i = 0; i < 5; i++) {
+        tracker.addSample(0, 150);
+    }
+    tracker.update(0);
+
+    // Scattered dropouts never reach the filter
+    for (int i = 0; i < 10; i++) {
+        tracker.addSample(0, (i % 2) ? -1 : 150);
+        tracker.addSample(0, -1);
+        tracker.addSample(0, 150);
+        CHECK(tracker.update(i) == PRESENCE_NONE);
+    }
+    CHECK(tracker.isUserInZone());
+
+    // A run long enough to outvote the median empties the zone at once
+    tracker.addSample(0, -1);
+    tracker.addSample(0, -1);
+    CHECK(tracker.update(20) == PRESENCE_NONE);
+    tracker.addSample(0, -1);
+    CHECK(tracker.update(21) == PRESENCE_LEFT);
+    CHECK(!tracker.isUserInZone());
+    tracker.addSample(0, -1);
+    CHECK(tracker.update(22) == PRESENCE_NONE);
+}
+
+static void testFusion() {
+    PresenceTracker tracker(defaultParams());
+    const int8_t bearings[] = {-30, 0, 30};
+    tracker.configure(bearings, 3);
+    for (int i = 0; i < 5; i++) {
+        tracker.addSample(0, 240);
+        tracker.addSample(1, 160);
+        tracker.addSample(2, 175);
+    }
+    tracker.update(0);
+    CHECK(tracker.getDistance() == 160);        // Nearest in zone
+    CHECK(fabsf(tracker.getBearing() - 15) < 0.01f);   // Shared with the sensor within the window
+}
+
+// Five samples of each reading, one per transducer, then an update
+static PresenceEvent step(PresenceTracker& tracker, uint32_t& t, float left, float middle, float right) {
+    for (int i = 0; i < 5; i++) {
+        tracker.addSample(0, left);
+        tracker.addSample(1, middle);
+        tracker.addSample(2, right);
+    }
+    t += 200;
+    return tracker.update(t);
+}
+
+static void testBearingGate() {
+    PresenceParams params = defaultParams();
+    PresenceTracker tracker(params);
+    const int8_t bearings[] = {-30, 0, 30};
+    tracker.configure(bearings, 3);
+    const float none = -1;
+
+    // Someone walking across the array at a steady 150 cm: each time they
+    // leave the transducers near the window's bearing the timer restarts
+    uint32_t t = 1000;
+    CHECK(step(tracker, t, 150, none, none) == PRESENCE_STARTED);
+    CHECK(step(tracker, t, 150, 150, none) == PRESENCE_NONE);      // Still seen at -30°
+    CHECK(tracker.getBearing() == -30);
+    CHECK(step(tracker, t, none, 150, none) == PRESENCE_MOVED);    // 0°: 30° swept
+    CHECK(tracker.getStableBearing() == 0);
+    CHECK(step(tracker, t, none, 150, 150) == PRESENCE_NONE);
+    CHECK(step(tracker, t, none, none, 150) == PRESENCE_MOVED);
+    CHECK(!tracker.isPresenceConfirmed(t + params.presenceTimeMs - 400));
+
+    // Standing between two transducers: losing one of them is not a sweep
+    tracker.reset();
+    t = 1000;
+    CHECK(step(tracker, t, none, 150, 151) == PRESENCE_STARTED);
+    CHECK(fabsf(tracker.getBearing() - 15) < 0.01f);
+    uint32_t start = t;
+    CHECK(step(tracker, t, none, none, 151) == PRESENCE_NONE);
+    CHECK(step(tracker, t, none, 150, none) == PRESENCE_NONE);
+    CHECK(step(tracker, t, none, 150, 151) == PRESENCE_NONE);
+    CHECK(tracker.getPresenceTime(t) == t - start);
+
+    // One transducer: the bearing is constant and the gate never fires
+    PresenceTracker single(params);
+    t = 1000;
+    for (int i = 0; i < 5; i++) single.addSample(0, 150);
+    CHECK(single.update(t) == PRESENCE_STARTED);
+    CHECK(single.getStableBearing() == 0 && single.isPresenceConfirmed(t + params.presenceTimeMs));
+}
+
+static void testTrackPreference() {
+    PresenceTracker tracker(defaultParams());
+    const int8_t bearings[] = {-30, 0, 30};
+    tracker.configure(bearings, 3);
+    const float none = -1;
+
+    // A user waits at +30°; someone nearer passes at -30°/0°
+    uint32_t t = 1000;
+    CHECK(step(tracker, t, none, none, 220) == PRESENCE_STARTED);
+    uint32_t start = t;
+    CHECK(step(tracker, t, 90, none, 220) == PRESENCE_NONE);
+    CHECK(tracker.getDistance() == 220 && tracker.getBearing() == 30);
+    CHECK(step(tracker, t, none, 90, 221) == PRESENCE_NONE);
+    CHECK(tracker.getPresenceTime(t) == t - start);
+
+    // Nobody tracked yet: the nearest reading wins as before
+    tracker.reset();
+    t = 1000;
+    CHECK(step(tracker, t, 90, none, 220) == PRESENCE_STARTED);
+    CHECK(tracker.getDistance() == 90 && tracker.getBearing() == -30);
+}
+
+static void testParse() {
+    const char* text =
+        "# synthetic\n"
+        "# bearings -20 20\n"
+        "# user 2000 9000\n"
+        "[ULTRASONIC] S0 Raw: 150.0 cm\n"
+        "[US] 1000,0,150.5\n"
+        "1040,1,-1.0\n"
+        "  [US] 1080,1,149.0\n";
+    Trace trace;
+    std::string error;
+    CHECK(parseTrace(text, "t", trace, &error));
+    CHECK(trace.bearingsDeg.size() == 2 && trace.bearingsDeg[0] == -20);
+    CHECK(trace.users.size() == 1 && trace.users[0].startMs == 2000 && trace.users[0].endMs == 9000);
+    CHECK(trace.samples.size() == 3);
+    CHECK(trace.samples[1].channel == 1 && trace.samples[1].distanceCm == -1);
+
+    // Round trip through the writer
+    Trace again;
+    CHECK(parseTrace(formatTrace(trace, "copy"), "t2", again));
+    CHECK(again.samples.size() == 3 && again.users.size() == 1 && again.bearingsDeg.size() == 2);
+
+    CHECK(!parseTrace("[US] 1000,0\n", "bad", trace, &error));
+    CHECK(!parseTrace("[US] 1000,0,150\n[US] 900,0,150\n", "backwards", trace, &error));
+    CHECK(!parseTrace("[US] 1000,1,150\n", "no bearing", trace, &error));
+    CHECK(!parseTrace("# user 5000 4000\n", "label", trace, &error));
+}
+
+static void testReplay() {
+    PresenceParams params = defaultParams();
+    ReplayConfig config;
+
+    // One user, confirmed presenceTimeMs after the filter settles
+    Trace user;
+    addEmpty(user, 0, 2000);
+    addStanding(user, 2000, 12000, 150);
+    addEmpty(user, 12000, 15000);
+    user.users.push_back({2000, 12000});
+    TraceScore score = replayTrace(user, params, config);
+    CHECK(score.detected == 1 && score.missed == 0 && score.falseTriggers == 0);
+    CHECK(score.latenciesMs.size() == 1);
+    CHECK(score.latenciesMs[0] >= params.presenceTimeMs && score.latenciesMs[0] <= params.presenceTimeMs + 400);
+
+    // The same trace unlabelled is a false trigger; too short a stay is not
+    user.users.clear();
+    score = replayTrace(user, params, config);
+    CHECK(score.detected == 0 && score.falseTriggers == 1);
+
+    Trace linger;
+    addEmpty(linger, 0, 2000);
+    addStanding(linger, 2000, 2000 + params.presenceTimeMs / 2, 150);
+    addEmpty(linger, 2000 + params.presenceTimeMs / 2, 8000);
+    score = replayTrace(linger, params, config);
+    CHECK(score.falseTriggers == 0);
+
+    // Labelled but never stable: missed
+    Trace walking;
+    for (uint32_t t = 1000; t < 9000; t += 40) {
+        walking.samples.push_back({t, 0, 400.0f - (t - 1000) * 0.04f});
+    }
+    walking.users.push_back({1000, 9000});
+    score = replayTrace(walking, params, config);
+    CHECK(score.missed == 1 && score.detected == 0);
+}
+
+static void testSweep() {
+    std::vector<Trace> corpus(2);
+    addEmpty(corpus[0], 0, 2000);
+    addStanding(corpus[0], 2000, 12000, 150);
+    corpus[0].users.push_back({2000, 12000});
+    addEmpty(corpus[1], 0, 2000);
+    addStanding(corpus[1], 2000, 4500, 200);
+    addEmpty(corpus[1], 4500, 8000);
+
+    std::vector<PresenceParams> grid;
+    for (uint32_t presenceMs : {1000u, 2000u, 3000u, 11000u}) {
+        PresenceParams params = defaultParams();
+        params.presenceTimeMs = presenceMs;
+        grid.push_back(params);
+    }
+
+    ReplayConfig config;
+    std::vector<SweepResult> serial = sweepParams(corpus, grid, config, 1);
+    std::vector<SweepResult> parallel = sweepParams(corpus, grid, config, 4);
+    CHECK(serial.size() == grid.size() && parallel.size() == grid.size());
+    for (size_t i = 0; i + 1 < serial.size(); i++) {
+        CHECK(!betterScore(serial[i + 1].score, serial[i].score));
+    }
+    for (size_t i = 0; i < serial.size() && i < parallel.size(); i++) {
+        CHECK(serial[i].params.presenceTimeMs == parallel[i].params.presenceTimeMs);
+        CHECK(serial[i].score.errors() == parallel[i].score.errors());
+    }
+
+    // 3 s finds the user without triggering on the 2.5 s stay; 1-2 s trigger
+    // on it, 11 s outlasts the user
+    CHECK(serial[0].params.presenceTimeMs == 3000 && serial[0].score.errors() == 0);
+    CHECK(serial.back().params.presenceTimeMs == 11000 && serial.back().score.missed == 1);
+}
+
+static unsigned long testClockMs = 0;
+
+static unsigned long testClock() {
+    return testClockMs;
+}
+
+static void testBurstEndsOnTimeouts() {
+    UltrasonicSensor sensor(25, 26);
+    sensor.setClock(testClock);
+    sensor.setRate(ULTRASONIC_RATE_IDLE);
+    CHECK(sensor.getSampleInterval() == ULTRASONIC_IDLE_INTERVAL);
+
+    // A stray echo on an empty block starts the wake-up burst...
+    sensor.injectSample(0, 150, 1000);
+    CHECK(sensor.getSampleInterval() == ULTRASONIC_FAST_INTERVAL);
+
+    // ...and the timeouts that follow use it up
+    for (int i = 0; i < ULTRASONIC_BURST_SAMPLES - 1; i++) {
+        sensor.injectSample(0, -1, 1040 + i * 40);
+    }
+    CHECK(sensor.getSampleInterval() == ULTRASONIC_FAST_INTERVAL);
+    sensor.injectSample(0, -1, 1040 + (ULTRASONIC_BURST_SAMPLES - 1) * 40);
+    CHECK(sensor.getSampleInterval() == ULTRASONIC_IDLE_INTERVAL);
+    CHECK(!sensor.isUserInZone());
+}
+
+static void testRateReplay() {
+    ReplayConfig config;
+
+    // Empty block with one stray echo: back to the idle rate after the burst
+    RateScene empty;
+    empty.durationMs = 61000;
+    bool echoed = false;
+    PingSource stray = [&](uint32_t timeMs, uint8_t) {
+        if (timeMs < 5000 || echoed) return -1.0f;
+        echoed = true;
+        return 300.0f;
+    };
+    RateScore adaptive = replayRates(empty, stray, RATE_MODE_ADAPTIVE, config);
+    echoed = false;
+    RateScore fixed = replayRates(empty, stray, RATE_MODE_FIXED, config);
+    CHECK(adaptive.presence.falseTriggers == 0 && fixed.presence.falseTriggers == 0);
+    CHECK(fixed.pings == 600 && fixed.idlePings == 600);
+    CHECK(adaptive.pings == adaptive.idlePings);
+    CHECK(adaptive.pings <= 60000 / ULTRASONIC_IDLE_INTERVAL + ULTRASONIC_BURST_SAMPLES + 1);
+
+    // A user standing still from 6 s to 20 s is confirmed at either rate;
+    // the burst and fast window keep the idle rate from costing more than
+    // one idle interval
+    RateScene waiting;
+    waiting.durationMs = 24000;
+    waiting.users.push_back({6000, 20000});
+    PingSource user = [](uint32_t timeMs, uint8_t) {
+        return timeMs >= 6000 && timeMs < 20000 ? 150.0f : -1.0f;
+    };
+    adaptive = replayRates(waiting, user, RATE_MODE_ADAPTIVE, config);
+    fixed = replayRates(waiting, user, RATE_MODE_FIXED, config);
+    CHECK(adaptive.presence.detected == 1 && adaptive.presence.falseTriggers == 0);
+    CHECK(fixed.presence.detected == 1 && fixed.presence.falseTriggers == 0);
+    CHECK(adaptive.presence.latenciesMs[0] <= fixed.presence.latenciesMs[0] + ULTRASONIC_IDLE_INTERVAL);
+    CHECK(adaptive.idlePings < fixed.idlePings);
+}
+
+int main() {
+    testMedianFilter();
+    testMedianSelection();
+    testPresenceTiming();
+    testTimeouts();
+    testFusion();
+    testBearingGate();
+    testTrackPreference();
+    testParse();
+    testReplay();
+    testSweep();
+    testBurstEndsOnTimeouts();
+    testRateReplay();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("presence_replay_test: all checks passed\n");
+    return 0;
+}
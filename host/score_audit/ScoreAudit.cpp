@@ -0,0 +1,293 @@
+/*
+ * ScoreAudit.cpp
+ * Implementation of the drop_confirm batch audit
+ */
+
+#include "ScoreAudit.h"
+#include "JsonReader.h"
+#include "Sha256.h"
+#include "GeoDistance.h"
+#include "PointsFormula.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+static const size_t LINES_PER_CHUNK = 1024;    // Work unit handed to a thread
+
+const char* findingName(FindingKind kind) {
+    switch (kind) {
+        case FINDING_MALFORMED:     return "malformed";
+        case FINDING_BAD_SIGNATURE: return "bad_signature";
+        case FINDING_NO_SCORING:    return "no_scoring";
+        case FINDING_FORMULA:       return "formula";
+        case FINDING_DISTANCE:      return "distance";
+        case FINDING_AWARD_FIELDS:  return "award_fields";
+        default:                    return "unknown";
+    }
+}
+
+static void addFinding(std::vector<Finding>& findings, size_t line, FindingKind kind,
+                       const std::string& rideId, const char* format, ...)
+    __attribute__((format(printf, 5, 6)));
+
+static void addFinding(std::vector<Finding>& findings, size_t line, FindingKind kind,
+                       const std::string& rideId, const char* format, ...) {
+    char detail[160];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(detail, sizeof(detail), format, args);
+    va_end(args);
+    findings.push_back(Finding{line, kind, rideId, detail});
+}
+
+static bool signatureMatches(const std::string& data, const std::string& signature, const std::string& key) {
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    hmacSha256((const uint8_t*)key.data(), key.size(), (const uint8_t*)data.data(), data.size(), digest);
+    std::string expected = toHex(digest, sizeof(digest));
+    
+    if (signature.size() != expected.size()) return false;
+    for (size_t i = 0; i < expected.size(); i++) {
+        char c = signature[i];
+        if (c >= 'A' && c <= 'F') c += 'a' - 'A';
+        if (c != expected[i]) return false;
+    }
+    return true;
+}
+
+static bool number(const JsonValue& object, const char* key, double& value) {
+    const JsonValue* member = object.get(key);
+    if (member == nullptr || !member->isNumber()) return false;
+    value = member->number;
+    return true;
+}
+
+bool auditEnvelope(const char* text, size_t length, size_t line, const AuditConfig& config,
+                   std::vector<Finding>& findings) {
+    std::string error;
+    JsonValue envelope;
+    if (!parseJson(text, length, envelope, &error)) {
+        addFinding(findings, line, FINDING_MALFORMED, "", "envelope: %s", error.c_str());
+        return true;
+    }
+    
+    const JsonValue* data = envelope.get("data");
+    const JsonValue* signature = envelope.get("signature");
+    if (data == nullptr || !data->isString() || signature == nullptr || !signature->isString()) {
+        addFinding(findings, line, FINDING_MALFORMED, "", "envelope without data/signature");
+        return true;
+    }
+    
+    JsonValue doc;
+    if (!parseJson(data->string.data(), data->string.size(), doc, &error) || !doc.isObject()) {
+        addFinding(findings, line, FINDING_MALFORMED, "", "data: %s", error.empty() ? "not an object" : error.c_str());
+        return true;
+    }
+    
+    const JsonValue* event = doc.get("event");
+    if (event == nullptr || !event->isString() || event->string != "drop_confirm") {
+        return false;
+    }
+    
+    const JsonValue* rideMember = doc.get("ride_id");
+    std::string rideId = rideMember && rideMember->isString() ? rideMember->string : "";
+    
+    // An unsigned or re-signed payload can't be trusted for anything else
+    if (!signatureMatches(data->string, signature->string, config.key)) {
+        addFinding(findings, line, FINDING_BAD_SIGNATURE, rideId, "HMAC mismatch");
+        return true;
+    }
+    
+    const JsonValue* scoring = doc.get("scoring");
+    double lat, lon, expectedLat, expectedLon, dropErrorCm, accuracyCenti, centiPoints, review;
+    if (scoring == nullptr || !scoring->isObject() ||
+        !number(doc, "latitude", lat) || !number(doc, "longitude", lon) ||
+        !number(*scoring, "expected_latitude", expectedLat) || !number(*scoring, "expected_longitude", expectedLon) ||
+        !number(*scoring, "drop_error_cm", dropErrorCm) || !number(*scoring, "accuracy_centi", accuracyCenti) ||
+        !number(*scoring, "centi_points", centiPoints) || !number(*scoring, "review", review)) {
+        addFinding(findings, line, FINDING_NO_SCORING, rideId, "scoring inputs missing");
+        return true;
+    }
+    
+    // 1. The formula applied to the reported inputs
+    PointsFormula::Award award = PointsFormula::score((int32_t)dropErrorCm, (int32_t)accuracyCenti);
+    if (award.centiPoints != (int32_t)centiPoints || award.review != (int32_t)review) {
+        addFinding(findings, line, FINDING_FORMULA, rideId,
+                   "reported %d/review %d, formula gives %d/review %d for %d cm, accuracy %d",
+                   (int)centiPoints, (int)review, award.centiPoints, (int)award.review,
+                   (int)dropErrorCm, (int)accuracyCenti);
+    }
+    
+    // 2. The drop error against the reported coordinates
+    int32_t measuredCm = PointsFormula::toCentimetres(
+        GeoDistance::haversine(expectedLat, expectedLon, lat, lon));
+    if (abs(measuredCm - (int32_t)dropErrorCm) > config.toleranceCm) {
+        PointsFormula::Award remeasured = PointsFormula::score(measuredCm, (int32_t)accuracyCenti);
+        addFinding(findings, line, FINDING_DISTANCE, rideId,
+                   "reported %d cm, coordinates give %d cm (award %d/review %d)",
+                   (int)dropErrorCm, measuredCm, remeasured.centiPoints, (int)remeasured.review);
+    }
+    
+    // 3. The human-readable award fields
+    double pointsAwarded;
+    const JsonValue* needsReview = doc.get("needs_review");
+    if (!number(doc, "points_awarded", pointsAwarded) || needsReview == nullptr ||
+        needsReview->type != JsonValue::BOOLEAN ||
+        PointsFormula::toCenti(pointsAwarded) != (int32_t)centiPoints ||
+        needsReview->boolean != (review != 0)) {
+        addFinding(findings, line, FINDING_AWARD_FIELDS, rideId,
+                   "points_awarded/needs_review disagree with centi_points %d/review %d",
+                   (int)centiPoints, (int)review);
+    }
+    
+    return true;
+}
+
+AuditSummary auditBuffer(const std::string& text, const AuditConfig& config, std::vector<Finding>& findings) {
+    // Line index first, so threads can take chunks without scanning
+    std::vector<size_t> starts;
+    starts.reserve(text.size() / 512 + 1);
+    size_t pos = 0;
+    while (pos < text.size()) {
+        starts.push_back(pos);
+        const void* newline = memchr(text.data() + pos, '\n', text.size() - pos);
+        pos = newline ? (const char*)newline - text.data() + 1 : text.size();
+    }
+    
+    unsigned threads = config.threads ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t chunks = (starts.size() + LINES_PER_CHUNK - 1) / LINES_PER_CHUNK;
+    threads = (unsigned)std::min<size_t>(threads, std::max<size_t>(chunks, 1));
+    
+    std::vector<AuditSummary> partials(threads);
+    std::vector<std::vector<Finding>> found(threads);
+    std::atomic<size_t> nextChunk(0);
+    
+    auto worker = [&](unsigned id) {
+        AuditSummary& summary = partials[id];
+        std::vector<Finding>& local = found[id];
+        for (size_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+            size_t first = chunk * LINES_PER_CHUNK;
+            size_t last = std::min(first + LINES_PER_CHUNK, starts.size());
+            for (size_t i = first; i < last; i++) {
+                size_t begin = starts[i];
+                size_t end = i + 1 < starts.size() ? starts[i + 1] : text.size();
+                while (end > begin && (text[end - 1] == '\n' || text[end - 1] == '\r')) end--;
+                
+                summary.lines++;
+                if (end == begin) {
+                    summary.skipped++;
+                    continue;
+                }
+                
+                size_t before = local.size();
+                if (!auditEnvelope(text.data() + begin, end - begin, i + 1, config, local)) {
+                    summary.skipped++;
+                    continue;
+                }
+                summary.drops++;
+                if (local.size() > before) summary.flagged++;
+                for (size_t f = before; f < local.size(); f++) summary.byKind[local[f].kind]++;
+            }
+        }
+    };
+    
+    std::vector<std::thread> pool;
+    for (unsigned id = 1; id < threads; id++) pool.emplace_back(worker, id);
+    worker(0);
+    for (std::thread& thread : pool) thread.join();
+    
+    AuditSummary total;
+    for (const AuditSummary& partial : partials) {
+        total.lines += partial.lines;
+        total.drops += partial.drops;
+        total.skipped += partial.skipped;
+        total.flagged += partial.flagged;
+        for (int k = 0; k < FINDING_KIND_COUNT; k++) total.byKind[k] += partial.byKind[k];
+    }
+    
+    size_t base = findings.size();
+    for (std::vector<Finding>& local : found) {
+        findings.insert(findings.end(), local.begin(), local.end());
+    }
+    std::stable_sort(findings.begin() + base, findings.end(),
+                     [](const Finding& a, const Finding& b) { return a.line < b.line; });
+    return total;
+}
+
+// ----------------------------------------------------------------------------
+// Device-side counterpart (corpus generation)
+// ----------------------------------------------------------------------------
+
+static double wireRound(double value) {
+    // Coordinates go over the wire with 7 decimals; score what the verifier will read
+    char text[32];
+    snprintf(text, sizeof(text), "%.7f", value);
+    return strtod(text, nullptr);
+}
+
+void scoreDrop(DropRecord& drop, double accuracy) {
+    drop.latitude = wireRound(drop.latitude);
+    drop.longitude = wireRound(drop.longitude);
+    drop.expectedLat = wireRound(drop.expectedLat);
+    drop.expectedLon = wireRound(drop.expectedLon);
+    
+    // Same steps as PointsManager::calculateFinalPoints
+    drop.dropErrorCm = PointsFormula::toCentimetres(
+        GeoDistance::haversine(drop.expectedLat, drop.expectedLon, drop.latitude, drop.longitude));
+    drop.accuracyCenti = PointsFormula::toCenti(accuracy);
+    PointsFormula::Award award = PointsFormula::score(drop.dropErrorCm, drop.accuracyCenti);
+    drop.centiPoints = award.centiPoints;
+    drop.review = award.review;
+}
+
+static void appendEscaped(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:   out += c; break;
+        }
+    }
+    out += '"';
+}
+
+std::string makeDropEnvelope(const DropRecord& drop, const std::string& key) {
+    // Member order and names as CommManager::publishDropConfirm/createJsonPayload
+    bool needsReview = drop.review != 0;
+    char number[160];
+    std::string data = "{\"ride_id\":";
+    appendEscaped(data, drop.rideId);
+    snprintf(number, sizeof(number), ",\"latitude\":%.7f,\"longitude\":%.7f,\"points_awarded\":%.2f",
+             drop.latitude, drop.longitude, drop.centiPoints / 100.0);
+    data += number;
+    data += needsReview ? ",\"needs_review\":true,\"status\":\"pending_review\"" :
+                          ",\"needs_review\":false,\"status\":\"completed\"";
+    data += ",\"idempotency_key\":";
+    appendEscaped(data, "RU_HOST/" + drop.rideId + "/drop");
+    snprintf(number, sizeof(number),
+             ",\"scoring\":{\"expected_latitude\":%.7f,\"expected_longitude\":%.7f,"
+             "\"drop_error_cm\":%d,\"accuracy_centi\":%d,\"centi_points\":%d,\"review\":%u}",
+             drop.expectedLat, drop.expectedLon, (int)drop.dropErrorCm, (int)drop.accuracyCenti,
+             (int)drop.centiPoints, (unsigned)drop.review);
+    data += number;
+    snprintf(number, sizeof(number),
+             ",\"event\":\"drop_confirm\",\"device_id\":\"RU_HOST\",\"driver_id\":\"DRIVER_HOST\",\"timestamp\":%u}",
+             (unsigned)drop.timestamp);
+    data += number;
+    
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    hmacSha256((const uint8_t*)key.data(), key.size(), (const uint8_t*)data.data(), data.size(), digest);
+    
+    std::string envelope = "{\"data\":";
+    appendEscaped(envelope, data);
+    envelope += ",\"signature\":\"" + toHex(digest, sizeof(digest)) + "\"}";
+    return envelope;
+}
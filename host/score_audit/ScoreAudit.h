@@ -0,0 +1,79 @@
+/*
+ * ScoreAudit.h
+ * Batch verification of recorded drop_confirm envelopes
+ *
+ * Each line of the input is one signed envelope as published by the
+ * rickshaw unit ({"data": "<json>", "signature": "<hex>"}). For every drop
+ * the audit checks the HMAC, re-runs PointsFormula on the reported inputs,
+ * re-measures the drop error from the reported coordinates with the same
+ * haversine as GPSManager, and cross-checks the award fields. Lines are
+ * audited in parallel; findings come back in input order.
+ */
+
+#ifndef SCORE_AUDIT_H
+#define SCORE_AUDIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+enum FindingKind {
+    FINDING_MALFORMED,          // Not an envelope, or data is not JSON
+    FINDING_BAD_SIGNATURE,      // HMAC does not match the data
+    FINDING_NO_SCORING,         // drop_confirm without the scoring inputs
+    FINDING_FORMULA,            // centi_points/review differ from PointsFormula on the inputs
+    FINDING_DISTANCE,           // drop_error_cm differs from the coordinates
+    FINDING_AWARD_FIELDS,       // points_awarded/needs_review disagree with scoring
+    FINDING_KIND_COUNT
+};
+
+struct Finding {
+    size_t line;                // 1-based
+    FindingKind kind;
+    std::string rideId;
+    std::string detail;
+};
+
+struct AuditConfig {
+    std::string key;            // HMAC key (Config.h HMAC_KEY)
+    int32_t toleranceCm = 2;    // Allowed drop error difference (coordinates are rounded on the wire)
+    unsigned threads = 0;       // 0 = one per hardware thread
+};
+
+struct AuditSummary {
+    size_t lines = 0;
+    size_t drops = 0;           // drop_confirm envelopes audited
+    size_t skipped = 0;         // Blank lines and other events
+    size_t flagged = 0;         // Envelopes with at least one finding
+    size_t byKind[FINDING_KIND_COUNT] = {};
+};
+
+// Drop as the device reports it; scoreDrop() fills in the award fields
+struct DropRecord {
+    std::string rideId;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    double expectedLat = 0.0;
+    double expectedLon = 0.0;
+    int32_t dropErrorCm = 0;
+    int32_t accuracyCenti = 0;
+    int32_t centiPoints = 0;
+    uint8_t review = 0;
+    uint32_t timestamp = 0;
+};
+
+// Audits one envelope; returns false if it was not a drop (nothing checked)
+bool auditEnvelope(const char* text, size_t length, size_t line, const AuditConfig& config,
+                   std::vector<Finding>& findings);
+
+// Audits every line of a buffer
+AuditSummary auditBuffer(const std::string& text, const AuditConfig& config, std::vector<Finding>& findings);
+
+// Device-side scoring and signing, for generating test corpora
+void scoreDrop(DropRecord& drop, double accuracy);
+std::string makeDropEnvelope(const DropRecord& drop, const std::string& key);
+
+const char* findingName(FindingKind kind);
+
+#endif // SCORE_AUDIT_H
@@ -0,0 +1,178 @@
+/*
+ * main.cpp
+ * score_audit: verify recorded drop_confirm envelopes
+ *
+ *   score_audit [--key KEY] [--threads N] [--tolerance-cm N] FILE|-
+ *       One envelope per line (JSONL). Findings go to stdout as
+ *       "line<TAB>kind<TAB>ride<TAB>detail", the summary to stderr.
+ *       Exit status 1 if anything was flagged.
+ *
+ *   score_audit --generate N [--tamper EVERY] [--seed S] [--key KEY]
+ *       Writes N signed drops (every EVERY-th one tampered) for testing
+ *       and benchmarking.
+ */
+
+#include "ScoreAudit.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef AUDIT_DEFAULT_KEY
+#define AUDIT_DEFAULT_KEY ""
+#endif
+
+// CUET area, like the firmware's demo coordinates
+static const double ORIGIN_LAT = 22.4598;
+static const double ORIGIN_LON = 91.9698;
+
+static int usage() {
+    fprintf(stderr,
+            "usage: score_audit [--key KEY] [--threads N] [--tolerance-cm N] FILE|-\n"
+            "       score_audit --generate N [--tamper EVERY] [--seed S] [--key KEY]\n");
+    return 2;
+}
+
+static uint32_t nextRandom(uint64_t& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(state >> 33);
+}
+
+static double uniform(uint64_t& state, double low, double high) {
+    return low + (high - low) * (nextRandom(state) / 2147483648.0);
+}
+
+static int generate(size_t count, size_t tamperEvery, uint64_t seed, const std::string& key) {
+    uint64_t state = seed;
+    std::string out;
+    
+    for (size_t i = 1; i <= count; i++) {
+        DropRecord drop;
+        char rideId[24];
+        snprintf(rideId, sizeof(rideId), "RIDE_%08zu", i);
+        drop.rideId = rideId;
+        drop.expectedLat = ORIGIN_LAT + uniform(state, -0.02, 0.02);
+        drop.expectedLon = ORIGIN_LON + uniform(state, -0.02, 0.02);
+        
+        // Most drops land within a few tens of meters; some go to review
+        double spread = (nextRandom(state) % 20 == 0) ? 0.002 : 0.0004;
+        drop.latitude = drop.expectedLat + uniform(state, -spread, spread);
+        drop.longitude = drop.expectedLon + uniform(state, -spread, spread);
+        drop.timestamp = 1760000000u + (uint32_t)(i * 29);
+        double accuracy = uniform(state, 0.6, (nextRandom(state) % 50 == 0) ? 150.0 : 4.0);
+        scoreDrop(drop, accuracy);
+        
+        std::string envelope;
+        if (tamperEvery > 0 && i % tamperEvery == 0) {
+            switch ((i / tamperEvery) % 3) {
+                case 0:     // Inflated award, re-signed with the key
+                    drop.centiPoints += 250;
+                    envelope = makeDropEnvelope(drop, key);
+                    break;
+                case 1:     // Moved drop point, re-signed with the old score
+                    drop.latitude += 0.0005;
+                    envelope = makeDropEnvelope(drop, key);
+                    break;
+                default:    // Edited without the key
+                    envelope = makeDropEnvelope(drop, key + "x");
+                    break;
+            }
+        } else {
+            envelope = makeDropEnvelope(drop, key);
+        }
+        
+        out += envelope;
+        out += '\n';
+        if (out.size() > (1 << 20)) {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+    
+    fwrite(out.data(), 1, out.size(), stdout);
+    return 0;
+}
+
+static bool readInput(const char* path, std::string& text) {
+    std::ostringstream buffer;
+    if (strcmp(path, "-") == 0) {
+        buffer << std::cin.rdbuf();
+    } else {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        buffer << file.rdbuf();
+    }
+    text = buffer.str();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    AuditConfig config;
+    config.key = AUDIT_DEFAULT_KEY;
+    const char* path = nullptr;
+    size_t generateCount = 0;
+    size_t tamperEvery = 0;
+    uint64_t seed = 1;
+    
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--key") == 0 && hasValue) {
+            config.key = argv[++i];
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            config.threads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--tolerance-cm") == 0 && hasValue) {
+            config.toleranceCm = (int32_t)strtol(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--generate") == 0 && hasValue) {
+            generateCount = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--tamper") == 0 && hasValue) {
+            tamperEvery = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (arg[0] != '-' || strcmp(arg, "-") == 0) {
+            path = arg;
+        } else {
+            return usage();
+        }
+    }
+    
+    if (generateCount > 0) {
+        return generate(generateCount, tamperEvery, seed, config.key);
+    }
+    if (path == nullptr) {
+        return usage();
+    }
+    
+    std::string text;
+    if (!readInput(path, text)) {
+        fprintf(stderr, "score_audit: cannot read %s\n", path);
+        return 2;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Finding> findings;
+    AuditSummary summary = auditBuffer(text, config, findings);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    for (const Finding& finding : findings) {
+        printf("%zu\t%s\t%s\t%s\n", finding.line, findingName(finding.kind),
+               finding.rideId.c_str(), finding.detail.c_str());
+    }
+    
+    fprintf(stderr, "%zu lines, %zu drops audited, %zu skipped, %zu flagged\n",
+            summary.lines, summary.drops, summary.skipped, summary.flagged);
+    for (int k = 0; k < FINDING_KIND_COUNT; k++) {
+        if (summary.byKind[k] > 0) {
+            fprintf(stderr, "  %-14s %zu\n", findingName((FindingKind)k), summary.byKind[k]);
+        }
+    }
+    fprintf(stderr, "%.3f s, %.0f envelopes/s (%.1f MB/s)\n", seconds,
+            seconds > 0 ? summary.lines / seconds : 0.0,
+            seconds > 0 ? text.size() / seconds / 1e6 : 0.0);
+    
+    return summary.flagged > 0 ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * score_audit_test.cpp
+ * Known-answer and tamper tests for the drop_confirm audit
+ */
+
+#include "ScoreAudit.h"
+#include "JsonReader.h"
+#include "Sha256.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+static const char* KEY = "AERAS_SECRET_KEY_2025";
+
+static std::string sha256Hex(const char* text) {
+    Sha256 hash;
+    hash.update((const uint8_t*)text, strlen(text));
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    hash.finish(digest);
+    return toHex(digest, sizeof(digest));
+}
+
+static void testSha256() {
+    CHECK(sha256Hex("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK(sha256Hex("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    CHECK(sha256Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    
+    // RFC 4231 test case 2
+    const char* key = "Jefe";
+    const char* data = "what do ya want for nothing?";
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    hmacSha256((const uint8_t*)key, strlen(key), (const uint8_t*)data, strlen(data), digest);
+    CHECK(toHex(digest, sizeof(digest)) == "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+}
+
+static void testJson() {
+    const char* text = "{\"s\":\"a\\\"b\\\\c\\u00e9\\ud83d\\ude00\",\"n\":-1.5e2,\"t\":true,\"o\":{\"x\":[1,2]}}";
+    JsonValue doc;
+    CHECK(parseJson(text, strlen(text), doc));
+    CHECK(doc.get("s") && doc.get("s")->string == "a\"b\\c\xc3\xa9\xf0\x9f\x98\x80");
+    CHECK(doc.get("n") && doc.get("n")->number == -150.0);
+    CHECK(doc.get("t") && doc.get("t")->boolean);
+    CHECK(doc.get("o") && doc.get("o")->get("x") && doc.get("o")->get("x")->items.size() == 2);
+    
+    const char* broken = "{\"s\":\"unterminated}";
+    CHECK(!parseJson(broken, strlen(broken), doc));
+}
+
+static DropRecord sampleDrop(double offsetLat, double accuracy) {
+    DropRecord drop;
+    drop.rideId = "RIDE_TEST";
+    drop.expectedLat = 22.4598;
+    drop.expectedLon = 91.9698;
+    drop.latitude = drop.expectedLat + offsetLat;
+    drop.longitude = drop.expectedLon;
+    drop.timestamp = 1760000000u;
+    scoreDrop(drop, accuracy);
+    return drop;
+}
+
+static std::vector<Finding> audit(const std::string& envelope, bool* wasDrop = nullptr) {
+    AuditConfig config;
+    config.key = KEY;
+    std::vector<Finding> findings;
+    bool drop = auditEnvelope(envelope.data(), envelope.size(), 1, config, findings);
+    if (wasDrop) *wasDrop = drop;
+    return findings;
+}
+
+static void testAudit() {
+    // ~22 m off: a normal award, nothing flagged
+    DropRecord drop = sampleDrop(0.0002, 1.2);
+    CHECK(drop.review == 0 && drop.centiPoints > 0 && drop.dropErrorCm > 2000);
+    CHECK(audit(makeDropEnvelope(drop, KEY)).empty());
+    
+    // Far drop and poor fix go to review and still audit clean
+    CHECK(audit(makeDropEnvelope(sampleDrop(0.002, 1.2), KEY)).empty());
+    CHECK(audit(makeDropEnvelope(sampleDrop(0.0001, 150.0), KEY)).empty());
+    
+    // Inflated award, signed with the real key
+    DropRecord inflated = drop;
+    inflated.centiPoints += 100;
+    std::vector<Finding> findings = audit(makeDropEnvelope(inflated, KEY));
+    CHECK(findings.size() == 1 && findings[0].kind == FINDING_FORMULA);
+    
+    // Drop error that doesn't match the coordinates
+    DropRecord moved = drop;
+    moved.latitude += 0.0005;
+    findings = audit(makeDropEnvelope(moved, KEY));
+    CHECK(findings.size() == 1 && findings[0].kind == FINDING_DISTANCE);
+    
+    // Wrong key
+    findings = audit(makeDropEnvelope(drop, "not the key"));
+    CHECK(findings.size() == 1 && findings[0].kind == FINDING_BAD_SIGNATURE);
+    CHECK(findings[0].rideId == "RIDE_TEST");
+    
+    // Garbage and other events
+    findings = audit("not json");
+    CHECK(findings.size() == 1 && findings[0].kind == FINDING_MALFORMED);
+    bool wasDrop = true;
+    findings = audit("{\"data\":\"{\\\"event\\\":\\\"status\\\"}\",\"signature\":\"00\"}", &wasDrop);
+    CHECK(findings.empty() && !wasDrop);
+}
+
+static void testBatch() {
+    // Parallel result must equal the serial one, in input order
+    std::string text;
+    size_t tampered = 0;
+    for (int i = 1; i <= 5000; i++) {
+        DropRecord drop = sampleDrop(0.00001 * (i % 40), 1.0 + (i % 3));
+        if (i % 97 == 0) {
+            drop.centiPoints += 1;
+            tampered++;
+        }
+        text += makeDropEnvelope(drop, KEY);
+        text += (i % 500 == 0) ? "\r\n\n" : "\n";
+    }
+    
+    AuditConfig config;
+    config.key = KEY;
+    config.threads = 1;
+    std::vector<Finding> serial;
+    AuditSummary one = auditBuffer(text, config, serial);
+    
+    config.threads = 4;
+    std::vector<Finding> parallel;
+    AuditSummary four = auditBuffer(text, config, parallel);
+    
+    CHECK(one.drops == 5000 && four.drops == 5000);
+    CHECK(one.flagged == tampered && four.flagged == tampered);
+    CHECK(one.byKind[FINDING_FORMULA] == tampered);
+    CHECK(serial.size() == parallel.size());
+    for (size_t i = 0; i < serial.size() && i < parallel.size(); i++) {
+        CHECK(serial[i].line == parallel[i].line);
+        if (i > 0) CHECK(parallel[i - 1].line < parallel[i].line);
+    }
+}
+
+int main() {
+    testSha256();
+    testJson();
+    testAudit();
+    testBatch();
+    
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("score_audit_test: all checks passed\n");
+    return 0;
+}
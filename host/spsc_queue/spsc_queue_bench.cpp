@@ -0,0 +1,122 @@
+/*
+ * spsc_queue_bench.cpp
+ * SPSCQueue throughput and hand-off latency between two threads
+ *
+ *   spsc_queue_bench [--items N]
+ *       Throughput: a producer pushes N items as fast as the queue takes
+ *       them, a consumer pops them; one row per payload size and capacity,
+ *       including the firmware's queue sizes. Hand-off: one item at a time
+ *       through a request and a reply queue, round trip / 2.
+ *
+ * Desktop numbers; they rank payload sizes and capacities against each
+ * other, not the ESP32's absolute rate.
+ */
+
+#include "SPSCQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Spin briefly, then let the other side run (matters on a single core)
+template <typename Op>
+static void retry(Op op) {
+    for (uint32_t spins = 0; !op(); spins++) {
+        if (spins >= 64) std::this_thread::yield();
+    }
+}
+
+template <size_t Bytes>
+struct Payload {
+    uint32_t words[Bytes / 4];
+};
+
+template <size_t Bytes, uint32_t Capacity>
+static void throughput(const char* name, uint32_t items) {
+    static SPSCQueue<Payload<Bytes>, Capacity> queue;
+    uint32_t startDropped = queue.getDropped();
+
+    Clock::time_point start = Clock::now();
+    std::thread producer([&] {
+        Payload<Bytes> item;
+        for (uint32_t i = 0; i < items; i++) {
+            item.words[0] = i;
+            retry([&] { return queue.push(item); });
+        }
+    });
+    Payload<Bytes> item;
+    uint64_t sum = 0;
+    for (uint32_t received = 0; received < items; received++) {
+        retry([&] { return queue.pop(item); });
+        sum += item.words[0];
+    }
+    producer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (sum != (uint64_t)items * (items - 1) / 2) {
+        fprintf(stderr, "%s: lost items\n", name);
+        exit(1);
+    }
+    printf("  %-10s %5zu B  capacity %5u  %8.2f M items/s  %8.1f MB/s  full/item %6.2f\n", name, Bytes,
+           Capacity, items / seconds / 1e6, items * (double)Bytes / seconds / 1e6,
+           (double)(queue.getDropped() - startDropped) / items);
+}
+
+template <size_t Bytes, uint32_t Capacity>
+static void handoff(const char* name, uint32_t rounds) {
+    static SPSCQueue<Payload<Bytes>, Capacity> request;
+    static SPSCQueue<Payload<Bytes>, Capacity> reply;
+
+    std::thread echo([&] {
+        Payload<Bytes> item;
+        for (uint32_t i = 0; i < rounds; i++) {
+            retry([&] { return request.pop(item); });
+            retry([&] { return reply.push(item); });
+        }
+    });
+
+    std::vector<double> samples;
+    samples.reserve(rounds);
+    Payload<Bytes> item;
+    for (uint32_t i = 0; i < rounds; i++) {
+        item.words[0] = i;
+        Clock::time_point start = Clock::now();
+        retry([&] { return request.push(item); });
+        retry([&] { return reply.pop(item); });
+        samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / 2);
+    }
+    echo.join();
+
+    std::sort(samples.begin(), samples.end());
+    printf("  %-10s %5zu B  hand-off p50 %6.0f ns  p99 %7.0f ns\n", name, Bytes,
+           samples[samples.size() / 2], samples[samples.size() * 99 / 100]);
+}
+
+int main(int argc, char** argv) {
+    uint32_t items = 4000000;
+    if (argc == 3 && strcmp(argv[1], "--items") == 0) {
+        items = (uint32_t)strtoul(argv[2], nullptr, 10);
+    }
+    if (items < 100) items = 100;
+    const size_t inboundBytes = (INBOUND_TOPIC_MAX_LEN + INBOUND_PAYLOAD_MAX_LEN + 4 + 3) / 4 * 4;
+
+    printf("throughput (%u items):\n", items);
+    throughput<inboundBytes, INBOUND_QUEUE_SIZE>("inbound", items);
+    throughput<inboundBytes, 64>("inbound", items);
+    throughput<128, OUTBOUND_QUEUE_SIZE>("outbound", items);
+    throughput<128, 64>("outbound", items);
+    throughput<8, 4>("small", items);
+    throughput<8, 64>("small", items);
+    throughput<8, 1024>("small", items);
+
+    printf("hand-off (%u rounds):\n", items / 40);
+    handoff<inboundBytes, INBOUND_QUEUE_SIZE>("inbound", items / 40);
+    handoff<8, 4>("small", items / 40);
+    return 0;
+}
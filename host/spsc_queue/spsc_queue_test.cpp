@@ -0,0 +1,145 @@
+/*
+ * spsc_queue_test.cpp
+ * SPSCQueue semantics and a producer/consumer/observer stress run
+ *
+ * The stress run is also built with ThreadSanitizer (spsc_queue_tsan), which
+ * reports any slot access the acquire/release pairs of SPSCQueue do not order.
+ * Payloads are the size of the firmware's InboundMessage and carry their
+ * sequence number in every word, so a torn or reordered copy is caught even
+ * without TSan.
+ */
+
+#include "SPSCQueue.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+// Same size as InboundMessage (topic + payload + receivedAt)
+struct Message {
+    uint32_t words[(INBOUND_TOPIC_MAX_LEN + INBOUND_PAYLOAD_MAX_LEN) / 4 + 1];
+
+    void fill(uint32_t seq) {
+        for (uint32_t& word : words) word = seq;
+    }
+    bool intact(uint32_t seq) const {
+        for (uint32_t word : words) {
+            if (word != seq) return false;
+        }
+        return true;
+    }
+};
+
+static void testSingleThread() {
+    SPSCQueue<int, 4> queue;
+    int value = 0;
+    CHECK(queue.isEmpty() && !queue.pop(value));
+    for (int i = 0; i < 4; i++) {
+        CHECK(queue.push(i));
+    }
+    CHECK(!queue.push(99));                     // Full: dropped and counted
+    CHECK(queue.getDropped() == 1 && queue.size() == 4);
+
+    // Many laps around the ring keep FIFO order
+    int expected = 0;
+    for (int i = 4; i < 1000; i++) {
+        CHECK(queue.pop(value) && value == expected++);
+        CHECK(queue.push(i));
+    }
+    while (queue.pop(value)) {
+        CHECK(value == expected++);
+    }
+    CHECK(expected == 1000 && queue.size() == 0);
+}
+
+struct StressResult {
+    uint32_t received = 0;
+    uint32_t outOfOrder = 0;
+    uint32_t torn = 0;
+    uint32_t fullPushes = 0;
+    uint32_t oversize = 0;      // size() above capacity seen by the observer
+};
+
+// One producer, one consumer and a third task reading size() (as the status
+// print does); the producer retries on full so every item must arrive once
+template <uint32_t Capacity>
+static StressResult stress(uint32_t items) {
+    static SPSCQueue<Message, Capacity> queue;
+    StressResult result;
+    std::atomic<bool> done(false);
+    uint32_t startDropped = queue.getDropped();
+
+    std::thread producer([&] {
+        Message message;
+        for (uint32_t seq = 0; seq < items; seq++) {
+            message.fill(seq);
+            while (!queue.push(message)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::thread observer([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            if (queue.size() > Capacity) result.oversize++;
+            std::this_thread::yield();
+        }
+    });
+
+    Message message;
+    uint32_t expected = 0;
+    while (expected < items) {
+        if (!queue.pop(message)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (message.words[0] != expected) result.outOfOrder++;
+        if (!message.intact(message.words[0])) result.torn++;
+        expected = message.words[0] + 1;
+        result.received++;
+    }
+
+    producer.join();
+    done.store(true);
+    observer.join();
+    result.fullPushes = queue.getDropped() - startDropped;
+    return result;
+}
+
+template <uint32_t Capacity>
+static void testStress(const char* name, uint32_t items) {
+    StressResult result = stress<Capacity>(items);
+    CHECK(result.received == items);
+    CHECK(result.outOfOrder == 0);
+    CHECK(result.torn == 0);
+    CHECK(result.oversize == 0);
+    printf("  %-9s capacity %4u: %u items, %u full pushes retried\n", name, Capacity, items,
+           result.fullPushes);
+}
+
+int main(int argc, char** argv) {
+    uint32_t items = 200000;
+    if (argc == 3 && strcmp(argv[1], "--items") == 0) {
+        items = (uint32_t)strtoul(argv[2], nullptr, 10);
+    }
+
+    testSingleThread();
+    testStress<INBOUND_QUEUE_SIZE>("inbound", items);
+    testStress<OUTBOUND_QUEUE_SIZE>("outbound", items);
+    testStress<1>("minimal", items / 4);
+    testStress<256>("wide", items);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("spsc_queue_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,331 @@
+/*
+ * store_test.cpp
+ * Firmware persistence on the RAM-backed NVS and flash shims: the
+ * confirmation journal, the points ledger's sync cursor and the ride-history
+ * log
+ *
+ * A "reset" is a fresh object whose begin() reads what the previous one
+ * left in NVS or flash.
+ */
+
+#include "ConfirmJournal.h"
+#include "LocalStore.h"
+#include "PointsLedger.h"
+#include "RideHistory.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+// The journal stores CommManager's EventType without interpreting it
+static const uint8_t TYPE_PICKUP = 3;
+static const uint8_t TYPE_DROP = 4;
+
+static String confirmKey(int ride) {
+    return String("RU_001/R-") + String(ride) + "/drop";
+}
+
+static int findKey(const ConfirmJournal& journal, const String& key) {
+    for (uint8_t slot = 0; slot < CONFIRM_JOURNAL_SIZE; slot++) {
+        const ConfirmRecord* record = journal.getRecord(slot);
+        if (record && key == record->key) return slot;
+    }
+    return -1;
+}
+
+static void testJournalAck() {
+    HostNvs::erase();
+    ConfirmJournal journal;
+    CHECK(journal.begin());
+    CHECK(journal.add(TYPE_DROP, confirmKey(1), "{}"));
+    CHECK(journal.add(TYPE_DROP, confirmKey(1), "{\"again\":1}"));     // Same key: replaced
+    CHECK(journal.getCount() == 1);
+    
+    // Survives a reset, then the ack retires it for good
+    ConfirmJournal rebooted;
+    CHECK(rebooted.begin() && rebooted.getCount() == 1);
+    CHECK(rebooted.acknowledge(confirmKey(1).c_str()));
+    CHECK(!rebooted.acknowledge(confirmKey(1).c_str()));
+    ConfirmJournal again;
+    CHECK(again.begin() && again.getCount() == 0);
+}
+
+static void testJournalSendLimit() {
+    HostNvs::erase();
+    ConfirmJournal journal;
+    journal.begin();
+    journal.add(TYPE_PICKUP, confirmKey(1), "{}");
+    journal.add(TYPE_DROP, confirmKey(2), "{}");
+    int slot = findKey(journal, confirmKey(1));
+    CHECK(slot >= 0);
+    
+    // No ack ever arrives: the record stops after CONFIRM_MAX_SENDS sends
+    unsigned long now = 0;
+    for (int send = 0; send < CONFIRM_MAX_SENDS; send++) {
+        CHECK(journal.retireStale(0) == 0);
+        CHECK(journal.isDue(slot, now));
+        journal.markSent(slot, now);
+        CHECK(!journal.isDue(slot, now + CONFIRM_RESEND_MS - 1));
+        now += CONFIRM_RESEND_MS;
+    }
+    CHECK(journal.retireStale(0) == 1);
+    CHECK(journal.getCount() == 1 && findKey(journal, confirmKey(1)) < 0);
+    CHECK(findKey(journal, confirmKey(2)) >= 0);
+    
+    // Gone from NVS as well
+    ConfirmJournal rebooted;
+    rebooted.begin();
+    CHECK(rebooted.getCount() == 1 && findKey(rebooted, confirmKey(1)) < 0);
+}
+
+static void testJournalAge() {
+    HostNvs::erase();
+    ConfirmJournal journal;
+    journal.begin();
+    uint32_t written = (uint32_t)time(nullptr);
+    journal.add(TYPE_DROP, confirmKey(1), "{}");
+    
+    CHECK(journal.retireStale(written) == 0);
+    CHECK(journal.retireStale(0) == 0);             // Clock not set: age unknown
+    CHECK(journal.retireStale(written + CONFIRM_MAX_AGE_S - 60) == 0);
+    CHECK(journal.retireStale(written + CONFIRM_MAX_AGE_S + 60) == 1);
+    CHECK(journal.getCount() == 0);
+}
+
+static void testJournalFull() {
+    HostNvs::erase();
+    ConfirmJournal journal;
+    journal.begin();
+    for (int ride = 1; ride <= CONFIRM_JOURNAL_SIZE; ride++) {
+        CHECK(journal.add(TYPE_DROP, confirmKey(ride), "{}"));
+    }
+    
+    // A new confirmation evicts the oldest instead of being refused
+    CHECK(journal.add(TYPE_DROP, confirmKey(100), "{}"));
+    CHECK(journal.getCount() == CONFIRM_JOURNAL_SIZE);
+    CHECK(findKey(journal, confirmKey(1)) < 0 && findKey(journal, confirmKey(100)) >= 0);
+    
+    // Write order survives a reset: the next eviction takes ride 2
+    ConfirmJournal rebooted;
+    rebooted.begin();
+    CHECK(rebooted.add(TYPE_DROP, confirmKey(101), "{}"));
+    CHECK(findKey(rebooted, confirmKey(2)) < 0);
+    CHECK(findKey(rebooted, confirmKey(3)) >= 0 && findKey(rebooted, confirmKey(100)) >= 0);
+    
+    // A failed write leaves the count consistent
+    HostNvs::failNextWrites(1);
+    CHECK(!rebooted.add(TYPE_DROP, confirmKey(102), "{}"));
+    CHECK(rebooted.getCount() == CONFIRM_JOURNAL_SIZE - 1);
+    
+    // Oversized messages are refused outright
+    std::string large(CONFIRM_PAYLOAD_MAX_LEN, 'x');
+    CHECK(!rebooted.add(TYPE_DROP, confirmKey(103), String(large)));
+}
+
+static String rideId(int ride) {
+    return String("R-") + String(ride);
+}
+
+static void testLedgerSyncCursor() {
+    HostNvs::erase();
+    PointsLedger ledger;
+    CHECK(ledger.begin(0));
+    for (int ride = 1; ride <= 3; ride++) {
+        CHECK(ledger.append(rideId(ride), 1000, 0));
+    }
+    CHECK(ledger.getSyncedSequence() == 0 && ledger.getUnsyncedCount() == 3);
+    
+    // Acks (backend or broker echo) may arrive out of order; the cursor
+    // only moves over a contiguous run
+    CHECK(ledger.acknowledge(rideId(2)));
+    CHECK(ledger.getSyncedSequence() == 0);
+    CHECK(ledger.acknowledge(rideId(1)));
+    CHECK(ledger.getSyncedSequence() == 2 && ledger.getUnsyncedCount() == 1);
+    CHECK(ledger.acknowledge(rideId(1)));       // Repeated: backend ack after the echo
+    CHECK(ledger.getSyncedSequence() == 2);
+    CHECK(!ledger.acknowledge(rideId(99)));
+    
+    // An ack flagged before a reset still moves the cursor on boot
+    CHECK(ledger.acknowledge(rideId(3)));
+    PointsLedger rebooted;
+    CHECK(rebooted.begin(0));
+    CHECK(rebooted.getSyncedSequence() == 3 && rebooted.getUnsyncedCount() == 0);
+    CHECK(rebooted.getTotalCenti() == 3000);
+}
+
+static void testLedgerSyncKeepsUp() {
+    // Two ring laps with an ack per drop: nothing unsynced is ever overwritten
+    HostNvs::erase();
+    PointsLedger ledger;
+    ledger.begin(0);
+    uint32_t maxUnsynced = 0;
+    for (int ride = 1; ride <= 2 * LEDGER_CAPACITY; ride++) {
+        CHECK(ledger.append(rideId(ride), 500, 0));
+        if (ledger.getUnsyncedCount() > maxUnsynced) maxUnsynced = ledger.getUnsyncedCount();
+        CHECK(ledger.acknowledge(rideId(ride)));
+    }
+    CHECK(maxUnsynced == 1);
+    CHECK(ledger.getSyncedSequence() == 2 * LEDGER_CAPACITY && ledger.getUnsyncedCount() == 0);
+    
+    // Without acks the backlog only grows
+    for (int ride = 1000; ride < 1010; ride++) {
+        ledger.append(rideId(ride), 500, 0);
+    }
+    CHECK(ledger.getUnsyncedCount() == 10);
+}
+
+static const uint16_t FIRST_DAY = 20454;    // 2026-01-01
+
+static RideRecord rideOn(uint16_t day, int ride) {
+    RideRecord record;
+    memset(&record, 0, sizeof(record));
+    record.rideHash = PointsLedger::hashRideId(rideId(ride));
+    record.dropTime = day * 86400UL + 9 * 3600UL + ride;
+    record.centiPoints = 1000;
+    return record;
+}
+
+// Newest first over the whole log
+static uint16_t readAll(RideHistory& history, std::vector<RideRecord>& records) {
+    records.assign(history.getRecordCount() + 1, RideRecord());
+    uint16_t matched = history.query(0, 0xFFFF, records.data(), records.size());
+    records.resize(std::min<size_t>(matched, records.size()));
+    return matched;
+}
+
+static void testHistoryWrap() {
+    HostFlash::reset(RIDE_HISTORY_PARTITION, 4 * SPI_FLASH_SEC_SIZE);
+    RideHistory history;
+    CHECK(history.begin());
+    CHECK(HostFlash::getErases() == 1);        // Sector 0 opened
+    
+    // A sector holds 63 records behind its header; the 64th opens the next
+    CHECK(RIDE_HISTORY_RECORDS_PER_SECTOR == 63);
+    int ride = 0;
+    while (ride < RIDE_HISTORY_RECORDS_PER_SECTOR) {
+        RideRecord record = rideOn(FIRST_DAY, ++ride);
+        CHECK(history.append(record));
+    }
+    CHECK(HostFlash::getErases() == 1);
+    RideRecord record = rideOn(FIRST_DAY, ++ride);
+    CHECK(history.append(record));
+    CHECK(HostFlash::getErases() == 2);
+    
+    // Filling the last sector, then wrapping onto the oldest
+    while (ride < 4 * RIDE_HISTORY_RECORDS_PER_SECTOR) {
+        record = rideOn(FIRST_DAY, ++ride);
+        CHECK(history.append(record));
+    }
+    CHECK(HostFlash::getErases() == 4 && history.getRecordCount() == 252);
+    record = rideOn(FIRST_DAY, ++ride);
+    CHECK(history.append(record));
+    CHECK(HostFlash::getErases() == 5);
+    CHECK(history.getRecordCount() == 3 * 63 + 1);
+    
+    std::vector<RideRecord> records;
+    CHECK(readAll(history, records) == 190);
+    CHECK(records.front().sequence == 253 && records.back().sequence == 64);
+    for (size_t i = 1; i < records.size(); i++) {
+        CHECK(records[i].sequence + 1 == records[i - 1].sequence);
+    }
+    
+    // A reset rebuilds the directory without erasing and appends after 253
+    RideHistory rebooted;
+    CHECK(rebooted.begin());
+    CHECK(HostFlash::getErases() == 5 && rebooted.getRecordCount() == 190);
+    record = rideOn(FIRST_DAY, ++ride);
+    CHECK(rebooted.append(record) && record.sequence == 254);
+    CHECK(HostFlash::getErases() == 5 && rebooted.getRecordCount() == 191);
+}
+
+static void testHistoryTornRecord() {
+    HostFlash::reset(RIDE_HISTORY_PARTITION, 2 * SPI_FLASH_SEC_SIZE);
+    RideHistory history;
+    history.begin();
+    int ride = 0;
+    while (ride < 10) {
+        RideRecord record = rideOn(FIRST_DAY, ++ride);
+        history.append(record);
+    }
+    
+    // Reset while programming: everything but the CRC reached the flash
+    HostFlash::tearNextWrite(offsetof(RideRecord, crc));
+    RideRecord torn = rideOn(FIRST_DAY, ++ride);
+    CHECK(!history.append(torn));
+    CHECK(history.getStats().appendFailures == 1 && history.getRecordCount() == 10);
+    
+    // On boot the slot counts as used but not as a ride, and is never reprogrammed
+    RideHistory rebooted;
+    CHECK(rebooted.begin());
+    CHECK(rebooted.getRecordCount() == 10);
+    RideRecord record = rideOn(FIRST_DAY, ++ride);
+    CHECK(rebooted.append(record) && record.sequence == 11);
+    std::vector<RideRecord> records;
+    CHECK(readAll(rebooted, records) == 11);
+    CHECK(records[0].rideHash == record.rideHash && records[1].sequence == 10);
+    
+    // 12 slots used, so 51 more fill the sector
+    for (int i = 0; i < RIDE_HISTORY_RECORDS_PER_SECTOR - 12; i++) {
+        record = rideOn(FIRST_DAY, ++ride);
+        CHECK(rebooted.append(record));
+    }
+    CHECK(HostFlash::getErases() == 1);
+    record = rideOn(FIRST_DAY, ++ride);
+    CHECK(rebooted.append(record));
+    CHECK(HostFlash::getErases() == 2 && rebooted.getRecordCount() == 62 + 1);
+}
+
+static void testRidesOnDayAcrossWrap() {
+    // 3 sectors hold 189 rides; 20 a day for 10 days wraps onto sector 0
+    // and drops rides 1-63, so day 3 (rides 61-80) straddles the erase
+    HostNvs::erase();
+    HostFlash::reset(RIDE_HISTORY_PARTITION, 3 * SPI_FLASH_SEC_SIZE);
+    LocalStore store;
+    store.begin();
+    const int perDay = 20;
+    const int days = 10;
+    for (int ride = 1; ride <= perDay * days; ride++) {
+        RideRecord record = rideOn(FIRST_DAY + (ride - 1) / perDay, ride);
+        CHECK(store.appendRideHistory(record));
+    }
+    CHECK(store.getRideHistoryCount() == 200 - 63);
+    
+    for (int pass = 0; pass < 2; pass++) {
+        LocalStore rebooted;
+        LocalStore& s = pass == 0 ? store : rebooted;
+        if (pass == 1) rebooted.begin();
+        for (int day = 0; day < days; day++) {
+            int first = std::max(day * perDay + 1, 64);
+            int expected = std::max(0, (day + 1) * perDay - first + 1);
+            CHECK(s.countRidesOnDay(FIRST_DAY + day) == expected);
+        }
+        CHECK(s.countRidesOnDay(FIRST_DAY + 3) == 17);
+        CHECK(s.countRidesOnDay(FIRST_DAY - 1) == 0 && s.countRidesOnDay(FIRST_DAY + days) == 0);
+    }
+}
+
+int main() {
+    testJournalAck();
+    testJournalSendLimit();
+    testJournalAge();
+    testJournalFull();
+    testLedgerSyncCursor();
+    testLedgerSyncKeepsUp();
+    testHistoryWrap();
+    testHistoryTornRecord();
+    testRidesOnDayAcrossWrap();
+    
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("store_test: all checks passed\n");
+    return 0;
+}
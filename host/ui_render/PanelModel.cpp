@@ -0,0 +1,134 @@
+/*
+ * PanelModel.cpp
+ * SSD1306 command/data decoding into GDDRAM
+ */
+
+#include "PanelModel.h"
+
+PanelModel::PanelModel()
+    : addressingMode(2), colStart(0), colEnd(PANEL_WIDTH - 1), col(0),
+      pageStart(0), pageEnd(PANEL_PAGES - 1), page(0), displayOn(false),
+      pendingCommand(0), argsNeeded(0), argsReceived(0), dataBytes(0), commands(0) {
+    memset(ram, 0, sizeof(ram));
+}
+
+void PanelModel::receive(const uint8_t* data, size_t length) {
+    // Control byte: Co = 1 means one byte follows before the next control
+    // byte, Co = 0 means the rest of the transaction is one stream
+    size_t i = 0;
+    while (i < length) {
+        uint8_t control = data[i++];
+        bool isData = control & 0x40;
+        bool single = control & 0x80;
+        size_t end = single ? (i + 1 < length ? i + 1 : length) : length;
+        for (; i < end; i++) {
+            if (isData) {
+                dataByte(data[i]);
+            } else {
+                commandByte(data[i]);
+            }
+        }
+    }
+}
+
+bool PanelModel::getPixel(int x, int y) const {
+    if (x < 0 || x >= PANEL_WIDTH || y < 0 || y >= PANEL_HEIGHT) return false;
+    return ram[(y / 8) * PANEL_WIDTH + x] & (1 << (y & 7));
+}
+
+uint8_t PanelModel::argumentCount(uint8_t c) {
+    switch (c) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+        case 0x29: case 0x2A:
+            return 5;
+        case 0x26: case 0x27:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+void PanelModel::commandByte(uint8_t c) {
+    if (argsReceived < argsNeeded) {
+        pendingArgs[argsReceived++] = c;
+        if (argsReceived == argsNeeded) {
+            execute(pendingCommand, pendingArgs);
+            argsNeeded = 0;
+            argsReceived = 0;
+        }
+        return;
+    }
+
+    argsNeeded = argumentCount(c);
+    argsReceived = 0;
+    if (argsNeeded == 0) {
+        execute(c, nullptr);
+    } else {
+        pendingCommand = c;
+    }
+}
+
+void PanelModel::execute(uint8_t c, const uint8_t* args) {
+    commands++;
+    switch (c) {
+        case 0x20:
+            addressingMode = args[0] & 0x03;
+            break;
+        case 0x21:
+            colStart = args[0] & 0x7F;
+            colEnd = args[1] & 0x7F;
+            col = colStart;
+            break;
+        case 0x22:
+            pageStart = args[0] & 0x07;
+            pageEnd = args[1] & 0x07;
+            page = pageStart;
+            break;
+        case 0xAE:
+            displayOn = false;
+            break;
+        case 0xAF:
+            displayOn = true;
+            break;
+        default:
+            if (c >= 0xB0 && c <= 0xB7) {
+                page = c & 0x07;            // Page addressing: page select
+            } else if (c <= 0x0F) {
+                col = (col & 0xF0) | c;     // Page addressing: column low nibble
+            } else if (c >= 0x10 && c <= 0x1F) {
+                col = (col & 0x0F) | ((c & 0x0F) << 4);
+            }
+            break;
+    }
+}
+
+void PanelModel::dataByte(uint8_t d) {
+    dataBytes++;
+    ram[page * PANEL_WIDTH + (col & 0x7F)] = d;
+
+    switch (addressingMode) {
+        case 0:     // Horizontal: across the column window, then the next page
+            if (col >= colEnd) {
+                col = colStart;
+                page = page >= pageEnd ? pageStart : page + 1;
+            } else {
+                col++;
+            }
+            break;
+        case 1:     // Vertical: down the page window, then the next column
+            if (page >= pageEnd) {
+                page = pageStart;
+                col = col >= colEnd ? colStart : col + 1;
+            } else {
+                page++;
+            }
+            break;
+        default:    // Page: along the page, wrapping within it
+            col = (col + 1) & 0x7F;
+            break;
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * PanelModel.h
+ * SSD1306 controller model: GDDRAM written through the I2C command/data protocol
+ *
+ * Receives what the firmware sends over the host Wire and applies it the way
+ * the controller does: control bytes (Co, D/C), commands with their argument
+ * bytes (which may arrive in later transactions), the column/page address
+ * window and horizontal, vertical or page addressing. The image it holds is
+ * what the panel would show, independent of the firmware's own buffers.
+ */
+
+#ifndef PANEL_MODEL_H
+#define PANEL_MODEL_H
+
+#include "Wire.h"
+
+#include <stdint.h>
+#include <string>
+
+#define PANEL_WIDTH     128
+#define PANEL_PAGES     8
+#define PANEL_HEIGHT    (PANEL_PAGES * 8)
+
+class PanelModel : public I2cTarget {
+public:
+    PanelModel();
+
+    void receive(const uint8_t* data, size_t length) override;
+
+    bool getPixel(int x, int y) const;
+    bool isOn() const { return displayOn; }
+    const uint8_t* getRam() const { return ram; }
+    uint32_t getDataBytes() const { return dataBytes; }    // GDDRAM writes so far
+    uint32_t getCommands() const { return commands; }
+
+private:
+    uint8_t ram[PANEL_PAGES * PANEL_WIDTH];
+    uint8_t addressingMode;     // 0 horizontal, 1 vertical, 2 page
+    uint8_t colStart, colEnd, col;
+    uint8_t pageStart, pageEnd, page;
+    bool displayOn;
+
+    // Command being assembled across bytes (and transactions)
+    uint8_t pendingCommand;
+    uint8_t pendingArgs[6];
+    uint8_t argsNeeded;
+    uint8_t argsReceived;
+
+    uint32_t dataBytes;
+    uint32_t commands;
+
+    void commandByte(uint8_t c);
+    void execute(uint8_t c, const uint8_t* args);
+    void dataByte(uint8_t d);
+    static uint8_t argumentCount(uint8_t c);
+};
+
+#endif // PANEL_MODEL_H
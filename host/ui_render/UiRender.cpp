@@ -0,0 +1,328 @@
+/*
+ * UiRender.cpp
+ * Screen capture, golden comparison, cost report and budget gate
+ */
+
+#include "UiRender.h"
+#include "Adafruit_GFX.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+static void setError(std::string* error, const std::string& text) {
+    if (error) *error = text;
+}
+
+static bool readFile(const std::string& path, std::string& text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    text = buffer.str();
+    return true;
+}
+
+static bool writeFile(const std::string& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+    return (bool)file;
+}
+
+std::string formatPbm(const PanelModel& panel, const std::string& comment) {
+    // Same layout as dumpSnapshot(): lit OLED pixels are 1 (black in PBM)
+    std::string out = "P1\n# " + comment + "\n" +
+                      std::to_string(PANEL_WIDTH) + " " + std::to_string(PANEL_HEIGHT) + "\n";
+    for (int y = 0; y < PANEL_HEIGHT; y++) {
+        for (int x = 0; x < PANEL_WIDTH; x++) {
+            out += panel.getPixel(x, y) ? '1' : '0';
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+bool parsePbm(const std::string& text, std::vector<bool>& pixels, int& width, int& height, std::string* error) {
+    // P1 with comments anywhere and optional whitespace between pixels
+    size_t pos = 0;
+    auto nextToken = [&](bool singleDigit) -> std::string {
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == '#') {
+                while (pos < text.size() && text[pos] != '\n') pos++;
+            } else if (isspace((unsigned char)c)) {
+                pos++;
+            } else {
+                break;
+            }
+        }
+        size_t start = pos;
+        if (singleDigit) {
+            if (pos < text.size()) pos++;
+        } else {
+            while (pos < text.size() && !isspace((unsigned char)text[pos]) && text[pos] != '#') pos++;
+        }
+        return text.substr(start, pos - start);
+    };
+
+    if (nextToken(false) != "P1") {
+        setError(error, "not a plain PBM (P1)");
+        return false;
+    }
+    width = atoi(nextToken(false).c_str());
+    height = atoi(nextToken(false).c_str());
+    if (width <= 0 || height <= 0 || width > 4096 || height > 4096) {
+        setError(error, "bad PBM size");
+        return false;
+    }
+
+    pixels.assign((size_t)width * height, false);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        std::string bit = nextToken(true);
+        if (bit != "0" && bit != "1") {
+            setError(error, "PBM ends early or has a bad pixel");
+            return false;
+        }
+        pixels[i] = bit == "1";
+    }
+    return true;
+}
+
+bool parseBudget(const std::string& text, std::map<std::string, ScreenBudget>& budget, std::string* error) {
+    std::istringstream lines(text);
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(lines, line)) {
+        lineNumber++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        char name[64];
+        unsigned long bytes, calls, pixels;
+        int fields = sscanf(line.c_str(), "%63s %lu %lu %lu", name, &bytes, &calls, &pixels);
+        if (fields <= 0) continue;
+        if (fields != 4) {
+            setError(error, "budget line " + std::to_string(lineNumber) + ": expected screen i2c_bytes draw_calls pixel_writes");
+            return false;
+        }
+        budget[name] = {(uint32_t)bytes, (uint32_t)calls, (uint32_t)pixels};
+    }
+    return true;
+}
+
+std::string formatBudget(const std::string& sketch, const std::vector<ScreenMetrics>& screens) {
+    std::string out = "# " + sketch + " render budget, written by --update\n"
+                      "# A screen that needs more than any figure fails the ui_render gate\n"
+                      "# screen i2c_bytes draw_calls pixel_writes\n";
+    char line[128];
+    for (const ScreenMetrics& screen : screens) {
+        snprintf(line, sizeof(line), "%-20s %6u %6u %7u\n", screen.name.c_str(),
+                 screen.i2cBytes, screen.drawCalls, screen.pixelWrites);
+        out += line;
+    }
+    return out;
+}
+
+UiRender::UiRender(const std::string& sketchName, uint8_t panelAddress)
+    : sketch(sketchName), goldenDir("golden/" + sketchName), actualDir("."), update(false), failures(0) {
+    Wire.attach(panelAddress, &panel);
+}
+
+bool UiRender::parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--golden" && i + 1 < argc) {
+            goldenDir = argv[++i];
+        } else if (arg == "--actual" && i + 1 < argc) {
+            actualDir = argv[++i];
+        } else if (arg == "--update") {
+            update = true;
+        } else if (arg == "--verbose") {
+            Serial.setEcho(true);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--golden DIR] [--update] [--actual DIR] [--verbose]\n"
+                    "  --golden DIR  golden PBMs and budget.txt (default golden/%s)\n"
+                    "  --update      rewrite the goldens and the budget from this run\n"
+                    "  --actual DIR  where mismatching screens are written (default .)\n"
+                    "  --verbose     echo the firmware's serial output to stderr\n",
+                    argv[0], sketch.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+void UiRender::screen(const std::string& name, const std::function<void()>& draw) {
+    uint8_t before[PANEL_PAGES * PANEL_WIDTH];
+    memcpy(before, panel.getRam(), sizeof(before));
+    Adafruit_GFX::resetStats();
+    Wire.resetStats();
+
+    draw();
+
+    ScreenMetrics metrics;
+    metrics.name = name;
+    metrics.drawCalls = Adafruit_GFX::stats.drawCalls;
+    metrics.pixelWrites = Adafruit_GFX::stats.pixelWrites;
+    metrics.clears = Adafruit_GFX::stats.clears;
+    const uint8_t* after = panel.getRam();
+    for (size_t i = 0; i < sizeof(before); i++) {
+        uint8_t changed = before[i] ^ after[i];
+        if (changed) {
+            metrics.changedBytes++;
+            metrics.changedPixels += __builtin_popcount(changed);
+        }
+    }
+    const I2cStats& bus = Wire.getStats();
+    metrics.i2cTransactions = bus.transactions;
+    metrics.i2cBytes = bus.bytes;
+    metrics.i2cUs = bus.busTimeUs;
+
+    if (!checkGolden(metrics)) {
+        failures++;
+    }
+    screens.push_back(metrics);
+    hostAdvanceMicros(1000000);
+}
+
+bool UiRender::checkGolden(ScreenMetrics& metrics) {
+    std::string path = goldenDir + "/" + metrics.name + ".pbm";
+    std::string image = formatPbm(panel, sketch + " " + metrics.name);
+
+    if (update) {
+        std::filesystem::create_directories(goldenDir);
+        if (!writeFile(path, image)) {
+            fprintf(stderr, "%s: cannot write\n", path.c_str());
+            return false;
+        }
+        metrics.goldenDiff = 0;
+        return true;
+    }
+
+    std::string text, error;
+    std::vector<bool> golden;
+    int width, height;
+    if (!readFile(path, text)) {
+        fprintf(stderr, "%s: no golden (run with --update to create it)\n", path.c_str());
+        return false;
+    }
+    if (!parsePbm(text, golden, width, height, &error)) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+        return false;
+    }
+    if (width != PANEL_WIDTH || height != PANEL_HEIGHT) {
+        fprintf(stderr, "%s: golden is %dx%d, panel is %dx%d\n", path.c_str(),
+                width, height, PANEL_WIDTH, PANEL_HEIGHT);
+        return false;
+    }
+
+    metrics.goldenDiff = 0;
+    for (int y = 0; y < PANEL_HEIGHT; y++) {
+        for (int x = 0; x < PANEL_WIDTH; x++) {
+            if (golden[y * PANEL_WIDTH + x] != panel.getPixel(x, y)) metrics.goldenDiff++;
+        }
+    }
+    if (metrics.goldenDiff == 0) return true;
+
+    std::string actual = actualDir + "/" + sketch + "_" + metrics.name + ".pbm";
+    writeFile(actual, image);
+    fprintf(stderr, "%s: %d pixel(s) differ from %s (rendered: %s)\n", metrics.name.c_str(),
+            metrics.goldenDiff, path.c_str(), actual.c_str());
+    return false;
+}
+
+bool UiRender::checkBudget() {
+    std::string path = goldenDir + "/budget.txt";
+    if (update) {
+        if (!writeFile(path, formatBudget(sketch, screens))) {
+            fprintf(stderr, "%s: cannot write\n", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::string text, error;
+    std::map<std::string, ScreenBudget> budget;
+    if (!readFile(path, text)) {
+        fprintf(stderr, "%s: no budget (run with --update to create it)\n", path.c_str());
+        return false;
+    }
+    if (!parseBudget(text, budget, &error)) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+        return false;
+    }
+
+    bool ok = true;
+    for (const ScreenMetrics& screen : screens) {
+        auto it = budget.find(screen.name);
+        if (it == budget.end()) {
+            fprintf(stderr, "%s: not in %s\n", screen.name.c_str(), path.c_str());
+            ok = false;
+            continue;
+        }
+        const ScreenBudget& limit = it->second;
+        if (screen.i2cBytes > limit.i2cBytes) {
+            fprintf(stderr, "%s: %u I2C bytes, budget %u\n", screen.name.c_str(), screen.i2cBytes, limit.i2cBytes);
+            ok = false;
+        }
+        if (screen.drawCalls > limit.drawCalls) {
+            fprintf(stderr, "%s: %u draw calls, budget %u\n", screen.name.c_str(), screen.drawCalls, limit.drawCalls);
+            ok = false;
+        }
+        if (screen.pixelWrites > limit.pixelWrites) {
+            fprintf(stderr, "%s: %u pixel writes, budget %u\n", screen.name.c_str(), screen.pixelWrites, limit.pixelWrites);
+            ok = false;
+        }
+        budget.erase(it);
+    }
+    for (const auto& stale : budget) {
+        fprintf(stderr, "%s: in %s but not rendered\n", stale.first.c_str(), path.c_str());
+        ok = false;
+    }
+    return ok;
+}
+
+int UiRender::finish() {
+    printf("%-20s %6s %7s %6s %10s %11s %6s %7s %8s  %s\n", "screen", "draws", "pixels", "clears",
+           "changed B", "changed px", "i2c tx", "i2c B", "i2c ms", "golden");
+    ScreenMetrics total;
+    for (const ScreenMetrics& screen : screens) {
+        char golden[24];
+        if (screen.goldenDiff < 0) {
+            snprintf(golden, sizeof(golden), "missing");
+        } else if (screen.goldenDiff == 0) {
+            snprintf(golden, sizeof(golden), update ? "written" : "ok");
+        } else {
+            snprintf(golden, sizeof(golden), "%d px differ", screen.goldenDiff);
+        }
+        printf("%-20s %6u %7u %6u %10u %11u %6u %7u %8.2f  %s\n", screen.name.c_str(),
+               screen.drawCalls, screen.pixelWrites, screen.clears, screen.changedBytes,
+               screen.changedPixels, screen.i2cTransactions, screen.i2cBytes, screen.i2cUs / 1000.0, golden);
+        total.drawCalls += screen.drawCalls;
+        total.pixelWrites += screen.pixelWrites;
+        total.clears += screen.clears;
+        total.changedBytes += screen.changedBytes;
+        total.changedPixels += screen.changedPixels;
+        total.i2cTransactions += screen.i2cTransactions;
+        total.i2cBytes += screen.i2cBytes;
+        total.i2cUs += screen.i2cUs;
+    }
+    printf("%-20s %6u %7u %6u %10u %11u %6u %7u %8.2f\n", "total", total.drawCalls, total.pixelWrites,
+           total.clears, total.changedBytes, total.changedPixels, total.i2cTransactions, total.i2cBytes,
+           total.i2cUs / 1000.0);
+
+    if (!checkBudget()) {
+        failures++;
+    }
+    if (failures > 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", sketch.c_str(), failures);
+        return 1;
+    }
+    std::string outcome = update ? "written to " + goldenDir : "match their goldens and budget";
+    printf("%s: %zu screens %s\n", sketch.c_str(), screens.size(), outcome.c_str());
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * UiRender.h
+ * Golden-image and render-cost harness for the firmware UI on the host
+ *
+ * A driver program builds one sketch's display code against the shims in
+ * shim/ and renders a fixed sequence of screens. For every screen the
+ * harness records what it cost (GFX draw calls and pixel writes, GDDRAM
+ * bytes and pixels that changed on the panel, I2C transactions, bytes and
+ * bus time) and compares the panel image, decoded from the I2C traffic by
+ * PanelModel, with a checked-in golden PBM. finish() then holds the costs
+ * to a checked-in budget, so a change that redraws or resends more than
+ * before fails like a changed image does.
+ */
+
+#ifndef UI_RENDER_H
+#define UI_RENDER_H
+
+#include "PanelModel.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+struct ScreenMetrics {
+    std::string name;
+    uint32_t drawCalls = 0;
+    uint32_t pixelWrites = 0;
+    uint32_t clears = 0;
+    uint32_t changedBytes = 0;      // GDDRAM bytes that differ from the previous screen
+    uint32_t changedPixels = 0;
+    uint32_t i2cTransactions = 0;
+    uint32_t i2cBytes = 0;          // Address + payload bytes on the bus
+    double i2cUs = 0.0;             // Bus time at the clock the firmware set
+    int goldenDiff = -1;            // Pixels differing from the golden, -1 = no golden
+};
+
+// Per-screen ceilings of the benchmark gate
+struct ScreenBudget {
+    uint32_t i2cBytes;
+    uint32_t drawCalls;
+    uint32_t pixelWrites;
+};
+
+// Plain PBM (P1), the format of the firmware's DISPLAY_SNAPSHOTS dumps
+std::string formatPbm(const PanelModel& panel, const std::string& comment);
+bool parsePbm(const std::string& text, std::vector<bool>& pixels, int& width, int& height,
+              std::string* error = nullptr);
+
+// "screen i2c_bytes draw_calls pixel_writes" lines, "#" comments
+bool parseBudget(const std::string& text, std::map<std::string, ScreenBudget>& budget,
+                 std::string* error = nullptr);
+std::string formatBudget(const std::string& sketch, const std::vector<ScreenMetrics>& screens);
+
+class UiRender {
+public:
+    UiRender(const std::string& sketch, uint8_t panelAddress);
+
+    // --golden DIR, --update, --actual DIR, --verbose; false after printing usage
+    bool parseArgs(int argc, char** argv);
+
+    // Render one screen and check it; the virtual clock then moves on a second
+    void screen(const std::string& name, const std::function<void()>& draw);
+
+    // Print the report, apply the budget (or rewrite goldens and budget with
+    // --update); returns the process exit status
+    int finish();
+
+    const PanelModel& getPanel() const { return panel; }
+
+private:
+    std::string sketch;
+    std::string goldenDir;
+    std::string actualDir;
+    bool update;
+    PanelModel panel;
+    std::vector<ScreenMetrics> screens;
+    int failures;
+
+    bool checkGolden(ScreenMetrics& metrics);
+    bool checkBudget();
+};
+
+#endif // UI_RENDER_H
@@ -0,0 +1,131 @@
+/*
+ * display_service_test.cpp
+ * Rickshaw DisplayService: only the changed page windows reach the panel
+ */
+
+#include "DisplayService.h"
+#include "PanelModel.h"
+
+#include <stdio.h>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+struct Window {
+    uint8_t page;
+    uint8_t firstCol;
+    uint8_t lastCol;
+};
+
+// Panel that also notes the address windows sendWindow() sets up
+class WindowRecorder : public I2cTarget {
+public:
+    PanelModel panel;
+    std::vector<Window> windows;
+    uint32_t dataBytes = 0;
+
+    void receive(const uint8_t* data, size_t length) override {
+        if (length == 7 && data[0] == 0x00 && data[1] == SSD1306_COLUMNADDR && data[4] == SSD1306_PAGEADDR) {
+            windows.push_back({data[5], data[2], data[3]});
+        } else if (length > 0 && data[0] == 0x40) {
+            dataBytes += length - 1;
+        }
+        panel.receive(data, length);
+    }
+
+    void clear() {
+        windows.clear();
+        dataBytes = 0;
+    }
+};
+
+static bool panelMatches(const WindowRecorder& target, Adafruit_SSD1306& display) {
+    return memcmp(target.panel.getRam(), display.getBuffer(), DISPLAY_FRAME_BYTES) == 0;
+}
+
+static void testDirtyPages() {
+    WindowRecorder target;
+    Wire.attach(OLED_I2C_ADDRESS, &target);
+
+    Adafruit_SSD1306 display(OLED_SCREEN_WIDTH, OLED_SCREEN_HEIGHT, &Wire, -1);
+    CHECK(display.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS));
+    DisplayService service;
+    service.begin(display, OLED_I2C_ADDRESS);   // No flush task on the host: flushes inline
+
+    // Nothing is known about the panel yet, so the first frame goes out whole
+    target.clear();
+    display.clearDisplay();
+    display.fillRect(0, 0, 20, 8, SSD1306_WHITE);
+    service.submit();
+    CHECK(target.windows.size() == OLED_PAGE_COUNT);
+    CHECK(target.dataBytes == DISPLAY_FRAME_BYTES);
+    CHECK(panelMatches(target, display));
+
+    // One pixel: one window of one column on its page
+    target.clear();
+    display.drawPixel(40, 21, SSD1306_WHITE);
+    FrameDiff diff = service.submit();
+    CHECK(diff.bytes == 1 && diff.pixels == 1);
+    CHECK(target.windows.size() == 1);
+    CHECK(target.windows[0].page == 2 && target.windows[0].firstCol == 40 && target.windows[0].lastCol == 40);
+    CHECK(target.dataBytes == 1);
+    CHECK(panelMatches(target, display));
+
+    // Changes far apart on one page are sent as the span between them
+    target.clear();
+    display.drawPixel(5, 50, SSD1306_WHITE);
+    display.drawPixel(100, 52, SSD1306_WHITE);
+    service.submit();
+    CHECK(target.windows.size() == 1);
+    CHECK(target.windows[0].page == 6 && target.windows[0].firstCol == 5 && target.windows[0].lastCol == 100);
+    CHECK(target.dataBytes == 96);
+    CHECK(panelMatches(target, display));
+
+    // Top and bottom page: the six pages between them are skipped
+    target.clear();
+    display.fillRect(0, 0, 20, 8, SSD1306_BLACK);
+    display.drawFastHLine(60, 63, 10, SSD1306_WHITE);
+    service.submit();
+    CHECK(target.windows.size() == 2);
+    CHECK(target.windows[0].page == 0 && target.windows[0].firstCol == 0 && target.windows[0].lastCol == 19);
+    CHECK(target.windows[1].page == 7 && target.windows[1].firstCol == 60 && target.windows[1].lastCol == 69);
+    CHECK(target.dataBytes == 30);
+    CHECK(panelMatches(target, display));
+
+    // An unchanged frame, or one whose change was undone before the submit, sends nothing
+    target.clear();
+    Wire.resetStats();
+    service.submit();
+    display.drawPixel(64, 32, SSD1306_WHITE);
+    display.drawPixel(64, 32, SSD1306_BLACK);
+    diff = service.submit();
+    CHECK(diff.bytes == 0);
+    CHECK(target.windows.empty() && target.dataBytes == 0);
+    CHECK(Wire.getStats().transactions == 0);
+
+    // A window wider than OLED_I2C_CHUNK is split across data transactions
+    target.clear();
+    Wire.resetStats();
+    display.drawFastHLine(0, 30, OLED_SCREEN_WIDTH, SSD1306_WHITE);
+    service.submit();
+    CHECK(target.windows.size() == 1 && target.dataBytes == OLED_SCREEN_WIDTH);
+    CHECK(Wire.getStats().transactions == 1 + (OLED_SCREEN_WIDTH + OLED_I2C_CHUNK - 1) / OLED_I2C_CHUNK);
+    CHECK(panelMatches(target, display));
+
+    Wire.attach(0, nullptr);
+}
+
+int main() {
+    testDirtyPages();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("display_service_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * rickshaw_render.cpp
+ * Renders the rickshaw unit's UIManager screens through a ride
+ *
+ * The sequence follows a ride the way FSMController drives the display:
+ * refreshes of retained screens (en route, ride) only redraw their fields,
+ * so their rows show what a refresh costs on the bus.
+ */
+
+#include "UiRender.h"
+#include "UIManager.h"
+
+#include <stdio.h>
+
+int main(int argc, char** argv) {
+    UiRender render("rickshaw", OLED_I2C_ADDRESS);
+    if (!render.parseArgs(argc, argv)) return 2;
+
+    UIManager ui;
+
+    RideInfo ride;
+    ride.rideId = "R-20481";
+    ride.pickupAddress = "CUET Campus Gate 2, Pahartoli";
+    ride.dropAddress = "Noapara Bazar";
+    ride.pickupLat = 22.4633;
+    ride.pickupLon = 91.9714;
+    ride.dropLat = 22.4580;
+    ride.dropLon = 91.9920;
+    ride.distanceToPickup = 850;
+    ride.estimatedPoints = 12.5;
+    ride.eta = 240;
+
+    RideInfo next = ride;
+    next.rideId = "R-20482";
+    next.pickupAddress = "Raojan Bus Stand";
+    next.estimatedPoints = 9.0;
+
+    render.screen("boot", [&] { ui.begin(); });
+    render.screen("idle", [&] { ui.showIdleScreen("Karim Uddin", 7, 124.5f); });
+    render.screen("notify", [&] { ui.showRideNotification(ride); });
+    render.screen("enroute", [&] { ui.showEnrouteToPickup(ride, 850); });
+    render.screen("enroute_refresh", [&] { ui.showEnrouteToPickup(ride, 420); });
+    render.screen("enroute_same", [&] { ui.showEnrouteToPickup(ride, 420); });
+    render.screen("arrived", [&] { ui.showArrivedAtPickup(ride); });
+    render.screen("ride", [&] { ui.showRideActive(ride, 2400); });
+    render.screen("ride_refresh", [&] { ui.showRideActive(ride, 1350); });
+    render.screen("ride_offline", [&] {
+        ui.setOffline(true);
+        ui.setPendingSync(2);
+        ui.showRideActive(ride, 1350);
+    });
+    render.screen("ride_online", [&] {
+        ui.setOffline(false);
+        ui.setPendingSync(0);
+        ui.showRideActive(ride, 900);
+    });
+    render.screen("next", [&] { ui.showNextRideOffer(next, 300); });
+    render.screen("completed", [&] { ui.showCompletedScreen(12.5f, false); });
+    render.screen("completed_review", [&] { ui.showCompletedScreen(4.0f, true); });
+    render.screen("error", [&] { ui.showErrorScreen("GPS fix lost"); });
+    render.screen("message", [&] { ui.showMessage("Syncing...", 0); });
+
+    int status = render.finish();
+
+    // DisplayService flush and ScreenTemplate field counters over the sequence
+    std::string stats;
+    Serial.setCapture(&stats);
+    ui.printDisplayStats();
+    Serial.setCapture(nullptr);
+    fputs(stats.c_str(), stdout);
+    return status;
+}
@@ -0,0 +1,80 @@
+/*
+ * Adafruit_GFX.h
+ * Host subset of Adafruit_GFX: primitives and the classic 5x7 text font
+ *
+ * Text follows the library's rules for the built-in font: 6x8 cells scaled
+ * by the text size, wrapping at the right edge unless disabled, transparent
+ * background when setTextColor() gets one colour. Every primitive the UI
+ * calls is counted as one draw call (nested calls are not counted again);
+ * pixel writes are counted by the display's drawPixel().
+ */
+
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include "Arduino.h"
+
+struct GfxStats {
+    uint32_t drawCalls;     // Primitives called by the UI (clears included)
+    uint32_t pixelWrites;   // drawPixel() calls inside the panel area, overdraw included
+    uint32_t clears;        // clearDisplay()/fillScreen()
+};
+
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h);
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+    virtual void fillScreen(uint16_t color);
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size);
+
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    int16_t getCursorX() const { return cursorX; }
+    int16_t getCursorY() const { return cursorY; }
+    void setTextSize(uint8_t size) { textSize = size > 0 ? size : 1; }
+    void setTextColor(uint16_t color) { textColor = color; textBg = color; }
+    void setTextColor(uint16_t color, uint16_t bg) { textColor = color; textBg = bg; }
+    void setTextWrap(bool enabled) { wrap = enabled; }
+    void getTextBounds(const char* text, int16_t x, int16_t y,
+                       int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h);
+    void getTextBounds(const String& text, int16_t x, int16_t y,
+                       int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h);
+
+    int16_t width() const { return panelWidth; }
+    int16_t height() const { return panelHeight; }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // Harness side: counters over every GFX instance
+    static GfxStats stats;
+    static void resetStats();
+
+protected:
+    int16_t panelWidth;
+    int16_t panelHeight;
+    int16_t cursorX;
+    int16_t cursorY;
+    uint16_t textColor;
+    uint16_t textBg;
+    uint8_t textSize;
+    bool wrap;
+
+    // Counts a draw call when the UI (not another primitive) makes it
+    class DrawCall {
+    public:
+        DrawCall();
+        ~DrawCall();
+    private:
+        static int depth;
+    };
+    friend class DrawCall;
+};
+
+#endif // HOST_ADAFRUIT_GFX_H
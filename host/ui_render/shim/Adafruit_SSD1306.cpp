@@ -0,0 +1,377 @@
+/*
+ * Adafruit_SSD1306.cpp
+ * Host Adafruit_GFX primitives, classic font and SSD1306 driver
+ */
+
+#include "Adafruit_SSD1306.h"
+
+// Printable ASCII of the library's classic 5x7 font (glcdfont), one byte per
+// column, LSB at the top. Other codes draw as a box.
+static const uint8_t FONT_FIRST = 0x20;
+static const uint8_t FONT_LAST = 0x7E;
+static const uint8_t FONT[][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x08, 0x07, 0x03, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x80, 0x70, 0x30, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x00, 0x60, 0x60, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x72, 0x49, 0x49, 0x49, 0x46}, {0x21, 0x41, 0x49, 0x4D, 0x33}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x31}, {0x41, 0x21, 0x11, 0x09, 0x07},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x46, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x00, 0x14, 0x00, 0x00},
+    {0x00, 0x40, 0x34, 0x00, 0x00}, {0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x59, 0x09, 0x06}, {0x3E, 0x41, 0x5D, 0x59, 0x4E},
+    {0x7C, 0x12, 0x11, 0x12, 0x7C}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x41, 0x3E}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},
+    {0x3E, 0x41, 0x41, 0x51, 0x73}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x1C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x26, 0x49, 0x49, 0x49, 0x32}, {0x03, 0x01, 0x7F, 0x01, 0x03}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x59, 0x49, 0x4D, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x41},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x41, 0x7F}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x03, 0x07, 0x08, 0x00}, {0x20, 0x54, 0x54, 0x78, 0x40},
+    {0x7F, 0x28, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x28}, {0x38, 0x44, 0x44, 0x28, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x00, 0x08, 0x7E, 0x09, 0x02}, {0x18, 0xA4, 0xA4, 0x9C, 0x78},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x40, 0x3D, 0x00},
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x78, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0xFC, 0x18, 0x24, 0x24, 0x18},
+    {0x18, 0x24, 0x24, 0x18, 0xFC}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x24},
+    {0x04, 0x04, 0x3F, 0x44, 0x24}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x4C, 0x90, 0x90, 0x90, 0x7C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x77, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x02, 0x01, 0x02, 0x04, 0x02},
+};
+static const uint8_t UNKNOWN_GLYPH[5] = {0x7F, 0x41, 0x41, 0x41, 0x7F};
+
+static_assert(sizeof(FONT) / sizeof(FONT[0]) == FONT_LAST - FONT_FIRST + 1, "font covers printable ASCII");
+
+// ---------------------------------------------------------------------------
+// Adafruit_GFX
+// ---------------------------------------------------------------------------
+
+GfxStats Adafruit_GFX::stats = {0, 0, 0};
+int Adafruit_GFX::DrawCall::depth = 0;
+
+Adafruit_GFX::DrawCall::DrawCall() {
+    if (depth++ == 0) {
+        stats.drawCalls++;
+    }
+}
+
+Adafruit_GFX::DrawCall::~DrawCall() {
+    depth--;
+}
+
+void Adafruit_GFX::resetStats() {
+    stats.drawCalls = 0;
+    stats.pixelWrites = 0;
+    stats.clears = 0;
+}
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h)
+    : panelWidth(w), panelHeight(h), cursorX(0), cursorY(0),
+      textColor(0xFFFF), textBg(0xFFFF), textSize(1), wrap(true) {
+}
+
+void Adafruit_GFX::fillScreen(uint16_t color) {
+    DrawCall call;
+    stats.clears++;
+    for (int16_t y = 0; y < panelHeight; y++) {
+        for (int16_t x = 0; x < panelWidth; x++) {
+            drawPixel(x, y, color);
+        }
+    }
+}
+
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    DrawCall call;
+    for (int16_t i = 0; i < w; i++) {
+        drawPixel(x + i, y, color);
+    }
+}
+
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    DrawCall call;
+    for (int16_t i = 0; i < h; i++) {
+        drawPixel(x, y + i, color);
+    }
+}
+
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    DrawCall call;
+    // Bresenham, as in the library
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) {
+        int16_t t = x0; x0 = y0; y0 = t;
+        t = x1; x1 = y1; y1 = t;
+    }
+    if (x0 > x1) {
+        int16_t t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    int16_t dx = x1 - x0;
+    int16_t dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = y0 < y1 ? 1 : -1;
+    for (; x0 <= x1; x0++) {
+        if (steep) {
+            drawPixel(y0, x0, color);
+        } else {
+            drawPixel(x0, y0, color);
+        }
+        err -= dy;
+        if (err < 0) {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    DrawCall call;
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    DrawCall call;
+    for (int16_t i = x; i < x + w; i++) {
+        drawFastVLine(i, y, h, color);
+    }
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {
+    DrawCall call;
+    if (x >= panelWidth || y >= panelHeight || x + 6 * size - 1 < 0 || y + 8 * size - 1 < 0) return;
+
+    const uint8_t* glyph = (c >= FONT_FIRST && c <= FONT_LAST) ? FONT[c - FONT_FIRST] : UNKNOWN_GLYPH;
+    for (int8_t i = 0; i < 6; i++) {
+        uint8_t line = i < 5 ? glyph[i] : 0;    // Sixth column is spacing
+        for (int8_t j = 0; j < 8; j++, line >>= 1) {
+            if (line & 1) {
+                if (size == 1) {
+                    drawPixel(x + i, y + j, color);
+                } else {
+                    fillRect(x + i * size, y + j * size, size, size, color);
+                }
+            } else if (bg != color) {
+                if (size == 1) {
+                    drawPixel(x + i, y + j, bg);
+                } else {
+                    fillRect(x + i * size, y + j * size, size, size, bg);
+                }
+            }
+        }
+    }
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+    if (c == '\n') {
+        cursorX = 0;
+        cursorY += textSize * 8;
+    } else if (c != '\r') {
+        if (wrap && cursorX + textSize * 6 > panelWidth) {
+            cursorX = 0;
+            cursorY += textSize * 8;
+        }
+        drawChar(cursorX, cursorY, c, textColor, textBg, textSize);
+        cursorX += textSize * 6;
+    }
+    return 1;
+}
+
+void Adafruit_GFX::getTextBounds(const char* text, int16_t x, int16_t y,
+                                 int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+    int16_t minX = 0x7FFF, minY = 0x7FFF, maxX = -1, maxY = -1;
+    *x1 = x;
+    *y1 = y;
+    *w = 0;
+    *h = 0;
+
+    for (; text && *text; text++) {
+        char c = *text;
+        if (c == '\n') {
+            x = 0;
+            y += textSize * 8;
+            continue;
+        }
+        if (c == '\r') continue;
+        if (wrap && x + textSize * 6 > panelWidth) {
+            x = 0;
+            y += textSize * 8;
+        }
+        int16_t right = x + textSize * 6 - 1;
+        int16_t bottom = y + textSize * 8 - 1;
+        if (x < minX) minX = x;
+        if (y < minY) minY = y;
+        if (right > maxX) maxX = right;
+        if (bottom > maxY) maxY = bottom;
+        x += textSize * 6;
+    }
+
+    if (maxX >= minX) {
+        *x1 = minX;
+        *w = maxX - minX + 1;
+    }
+    if (maxY >= minY) {
+        *y1 = minY;
+        *h = maxY - minY + 1;
+    }
+}
+
+void Adafruit_GFX::getTextBounds(const String& text, int16_t x, int16_t y,
+                                 int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+    getTextBounds(text.c_str(), x, y, x1, y1, w, h);
+}
+
+// ---------------------------------------------------------------------------
+// Adafruit_SSD1306
+// ---------------------------------------------------------------------------
+
+// Bytes per transaction including the control byte (WIRE_MAX in the library)
+static const size_t WIRE_MAX = I2C_BUFFER_LENGTH;
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t,
+                                   uint32_t clkDuring, uint32_t clkAfter)
+    : Adafruit_GFX(w, h), wire(twi), buffer(nullptr), address(0),
+      clockDuring(clkDuring), clockAfter(clkAfter) {
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+    free(buffer);
+}
+
+bool Adafruit_SSD1306::begin(uint8_t switchvcc, uint8_t i2caddr, bool, bool periphBegin) {
+    if (buffer == nullptr) {
+        buffer = (uint8_t*)malloc(panelWidth * ((panelHeight + 7) / 8));
+        if (buffer == nullptr) return false;
+    }
+    clearDisplay();
+    address = i2caddr;
+    if (periphBegin) {
+        wire->begin();
+    }
+    wire->setClock(clockDuring);
+
+    // The library's init sequence for a 128x64 panel
+    bool external = switchvcc == SSD1306_EXTERNALVCC;
+    static const uint8_t init1[] = {SSD1306_DISPLAYOFF, SSD1306_SETDISPLAYCLOCKDIV, 0x80, SSD1306_SETMULTIPLEX};
+    commandList(init1, sizeof(init1));
+    command(panelHeight - 1);
+    static const uint8_t init2[] = {SSD1306_SETDISPLAYOFFSET, 0x00, SSD1306_SETSTARTLINE | 0x0, SSD1306_CHARGEPUMP};
+    commandList(init2, sizeof(init2));
+    command(external ? 0x10 : 0x14);
+    static const uint8_t init3[] = {SSD1306_MEMORYMODE, 0x00, SSD1306_SEGREMAP | 0x1, SSD1306_COMSCANDEC};
+    commandList(init3, sizeof(init3));
+    command(SSD1306_SETCOMPINS);
+    command(panelHeight == 64 ? 0x12 : 0x02);
+    command(SSD1306_SETCONTRAST);
+    command(external ? 0x9F : 0xCF);
+    command(SSD1306_SETPRECHARGE);
+    command(external ? 0x22 : 0xF1);
+    static const uint8_t init5[] = {SSD1306_SETVCOMDETECT, 0x40, SSD1306_DISPLAYALLON_RESUME,
+                                    SSD1306_NORMALDISPLAY, SSD1306_DEACTIVATE_SCROLL, SSD1306_DISPLAYON};
+    commandList(init5, sizeof(init5));
+
+    wire->setClock(clockAfter);
+    return true;
+}
+
+void Adafruit_SSD1306::display() {
+    if (buffer == nullptr) return;
+    wire->setClock(clockDuring);
+
+    static const uint8_t window[] = {SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0};
+    commandList(window, sizeof(window));
+    command(panelWidth - 1);
+
+    size_t count = panelWidth * ((panelHeight + 7) / 8);
+    const uint8_t* data = buffer;
+    wire->beginTransmission(address);
+    wire->write((uint8_t)0x40);
+    size_t bytesOut = 1;
+    while (count--) {
+        if (bytesOut >= WIRE_MAX) {
+            wire->endTransmission();
+            wire->beginTransmission(address);
+            wire->write((uint8_t)0x40);
+            bytesOut = 1;
+        }
+        wire->write(*data++);
+        bytesOut++;
+    }
+    wire->endTransmission();
+
+    wire->setClock(clockAfter);
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+    DrawCall call;
+    stats.clears++;
+    if (buffer) {
+        memset(buffer, 0, panelWidth * ((panelHeight + 7) / 8));
+    }
+}
+
+void Adafruit_SSD1306::invertDisplay(bool invert) {
+    command(invert ? SSD1306_INVERTDISPLAY : SSD1306_NORMALDISPLAY);
+}
+
+void Adafruit_SSD1306::fillScreen(uint16_t color) {
+    DrawCall call;
+    stats.clears++;
+    if (buffer) {
+        memset(buffer, color ? 0xFF : 0x00, panelWidth * ((panelHeight + 7) / 8));
+    }
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    DrawCall call;
+    if (buffer == nullptr || x < 0 || x >= panelWidth || y < 0 || y >= panelHeight) return;
+
+    stats.pixelWrites++;
+    uint8_t& cell = buffer[x + (y / 8) * panelWidth];
+    uint8_t bit = 1 << (y & 7);
+    switch (color) {
+        case SSD1306_WHITE:   cell |= bit;  break;
+        case SSD1306_BLACK:   cell &= ~bit; break;
+        case SSD1306_INVERSE: cell ^= bit;  break;
+    }
+}
+
+bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y) const {
+    if (buffer == nullptr || x < 0 || x >= panelWidth || y < 0 || y >= panelHeight) return false;
+    return buffer[x + (y / 8) * panelWidth] & (1 << (y & 7));
+}
+
+uint8_t* Adafruit_SSD1306::getBuffer() {
+    return buffer;
+}
+
+void Adafruit_SSD1306::command(uint8_t c) {
+    wire->beginTransmission(address);
+    wire->write((uint8_t)0x00);
+    wire->write(c);
+    wire->endTransmission();
+}
+
+void Adafruit_SSD1306::commandList(const uint8_t* commands, size_t count) {
+    wire->beginTransmission(address);
+    wire->write((uint8_t)0x00);
+    size_t bytesOut = 1;
+    while (count--) {
+        if (bytesOut >= WIRE_MAX) {
+            wire->endTransmission();
+            wire->beginTransmission(address);
+            wire->write((uint8_t)0x00);
+            bytesOut = 1;
+        }
+        wire->write(*commands++);
+        bytesOut++;
+    }
+    wire->endTransmission();
+}
@@ -0,0 +1,75 @@
+/*
+ * Adafruit_SSD1306.h
+ * Host SSD1306 driver: 1-bpp page-major back buffer sent over the host Wire
+ *
+ * begin() sends the library's init sequence and display() the whole buffer
+ * in Wire-buffer-sized data transactions, as the real driver does, so the
+ * panel model sees the same traffic. There is no splash screen (as with
+ * SSD1306_NO_SPLASH); the buffer starts blank.
+ */
+
+#ifndef HOST_ADAFRUIT_SSD1306_H
+#define HOST_ADAFRUIT_SSD1306_H
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+
+#define SSD1306_BLACK               0
+#define SSD1306_WHITE               1
+#define SSD1306_INVERSE             2
+#define BLACK                       SSD1306_BLACK
+#define WHITE                       SSD1306_WHITE
+#define INVERSE                     SSD1306_INVERSE
+
+#define SSD1306_EXTERNALVCC         0x01
+#define SSD1306_SWITCHCAPVCC        0x02
+
+#define SSD1306_MEMORYMODE          0x20
+#define SSD1306_COLUMNADDR          0x21
+#define SSD1306_PAGEADDR            0x22
+#define SSD1306_SETCONTRAST         0x81
+#define SSD1306_CHARGEPUMP          0x8D
+#define SSD1306_SEGREMAP            0xA0
+#define SSD1306_DISPLAYALLON_RESUME 0xA4
+#define SSD1306_NORMALDISPLAY       0xA6
+#define SSD1306_INVERTDISPLAY       0xA7
+#define SSD1306_SETMULTIPLEX        0xA8
+#define SSD1306_DISPLAYOFF          0xAE
+#define SSD1306_DISPLAYON           0xAF
+#define SSD1306_COMSCANDEC          0xC8
+#define SSD1306_SETDISPLAYOFFSET    0xD3
+#define SSD1306_SETDISPLAYCLOCKDIV  0xD5
+#define SSD1306_SETPRECHARGE        0xD9
+#define SSD1306_SETCOMPINS          0xDA
+#define SSD1306_SETVCOMDETECT       0xDB
+#define SSD1306_SETSTARTLINE        0x40
+#define SSD1306_DEACTIVATE_SCROLL   0x2E
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi = &Wire, int8_t resetPin = -1,
+                     uint32_t clkDuring = 400000UL, uint32_t clkAfter = 100000UL);
+    ~Adafruit_SSD1306();
+
+    bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = 0x3C,
+               bool reset = true, bool periphBegin = true);
+    void display();
+    void clearDisplay();
+    void invertDisplay(bool invert);
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+    bool getPixel(int16_t x, int16_t y) const;
+    uint8_t* getBuffer();
+
+private:
+    TwoWire* wire;
+    uint8_t* buffer;
+    uint8_t address;
+    uint32_t clockDuring;
+    uint32_t clockAfter;
+
+    void command(uint8_t c);
+    void commandList(const uint8_t* commands, size_t count);
+};
+
+#endif // HOST_ADAFRUIT_SSD1306_H
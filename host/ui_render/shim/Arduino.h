@@ -0,0 +1,252 @@
+/*
+ * Arduino.h
+ * Host stand-in for the parts of the ESP32 Arduino core the UI code uses
+ *
+ * Only what the UI, storage and sensor code need: String, Print,
+ * a silent Serial, a virtual clock, GPIO stubs and the FreeRTOS/portMUX
+ * names DisplayService and PatternSequencer refer to. Task creation fails,
+ * so DisplayService flushes inline and every frame reaches the panel
+ * model deterministically.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+// ---------------------------------------------------------------------------
+// Core macros
+// ---------------------------------------------------------------------------
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define CHANGE          0x03
+
+#define DEC             10
+#define HEX             16
+
+#define IRAM_ATTR
+#define F(text)         (text)
+
+typedef uint8_t byte;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// newlib has strlcpy; older glibc does not
+inline size_t hostStrlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t n = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return length;
+}
+#define strlcpy hostStrlcpy
+
+// ---------------------------------------------------------------------------
+// String
+// ---------------------------------------------------------------------------
+
+class String {
+public:
+    String() {}
+    String(const char* text) : value(text ? text : "") {}
+    String(const std::string& text) : value(text) {}
+    explicit String(char c) : value(1, c) {}
+    explicit String(unsigned char number, unsigned char base = DEC) { setUnsigned(number, base); }
+    explicit String(int number, unsigned char base = DEC) { setSigned(number, base); }
+    explicit String(unsigned int number, unsigned char base = DEC) { setUnsigned(number, base); }
+    explicit String(long number, unsigned char base = DEC) { setSigned(number, base); }
+    explicit String(unsigned long number, unsigned char base = DEC) { setUnsigned(number, base); }
+    explicit String(float number, unsigned int decimals = 2) { setFloat(number, decimals); }
+    explicit String(double number, unsigned int decimals = 2) { setFloat(number, decimals); }
+
+    unsigned int length() const { return (unsigned int)value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    const char* c_str() const { return value.c_str(); }
+    char operator[](unsigned int index) const { return index < value.size() ? value[index] : 0; }
+
+    String substring(unsigned int from) const { return substring(from, length()); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) { unsigned int t = from; from = to; to = t; }
+        if (from >= value.size()) return String();
+        if (to > value.size()) to = (unsigned int)value.size();
+        return String(value.substr(from, to - from));
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t at = value.find(c, from);
+        return at == std::string::npos ? -1 : (int)at;
+    }
+    int indexOf(const String& text, unsigned int from = 0) const {
+        size_t at = value.find(text.value, from);
+        return at == std::string::npos ? -1 : (int)at;
+    }
+    bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+    bool equals(const String& other) const { return value == other.value; }
+    long toInt() const { return strtol(value.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(value.c_str(), nullptr); }
+
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    String& operator+=(const char* text) { value += text ? text : ""; return *this; }
+    String& operator+=(char c) { value += c; return *this; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+    friend bool operator==(const String& a, const String& b) { return a.value == b.value; }
+    friend bool operator!=(const String& a, const String& b) { return a.value != b.value; }
+    friend bool operator<(const String& a, const String& b) { return a.value < b.value; }
+
+private:
+    std::string value;
+
+    void setUnsigned(unsigned long number, unsigned char base) {
+        char text[33];
+        snprintf(text, sizeof(text), base == HEX ? "%lx" : "%lu", number);
+        value = text;
+    }
+    void setSigned(long number, unsigned char base) {
+        if (base != DEC) {
+            setUnsigned((unsigned long)number, base);
+            return;
+        }
+        char text[24];
+        snprintf(text, sizeof(text), "%ld", number);
+        value = text;
+    }
+    void setFloat(double number, unsigned int decimals) {
+        char text[48];
+        snprintf(text, sizeof(text), "%.*f", (int)decimals, number);
+        value = text;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Print and Serial
+// ---------------------------------------------------------------------------
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t length);
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char number, int base = DEC) { return print((unsigned long)number, base); }
+    size_t print(int number, int base = DEC) { return print((long)number, base); }
+    size_t print(unsigned int number, int base = DEC) { return print((unsigned long)number, base); }
+    size_t print(long number, int base = DEC);
+    size_t print(unsigned long number, int base = DEC);
+    size_t print(double number, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// Debug output of the firmware; discarded unless enabled (--verbose) or
+// captured by a harness that reads the firmware's log
+class HostSerial : public Print {
+public:
+    HostSerial() : echo(false), capture(nullptr) {}
+    void begin(unsigned long) {}
+    void setEcho(bool enabled) { echo = enabled; }
+    void setCapture(std::string* sink) { capture = sink; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    using Print::write;
+
+private:
+    bool echo;
+    std::string* capture;
+};
+
+extern HostSerial Serial;
+
+// GPS UART: accepts configuration and UBX commands, never receives. Host
+// GPS stand-ins feed fixes to the parser directly.
+#define SERIAL_8N1      0x800001c
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t*, size_t length) override { return length; }
+    using Print::write;
+};
+
+extern HardwareSerial Serial2;
+
+// ---------------------------------------------------------------------------
+// Virtual clock and GPIO
+// ---------------------------------------------------------------------------
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Harness side: move the virtual clock forward without a delay() call
+void hostAdvanceMicros(uint64_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);       // Inputs idle HIGH (pull-ups, nothing pressed)
+
+// Interrupts are never raised on the host
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+
+// ---------------------------------------------------------------------------
+// FreeRTOS names used by the UI code (no scheduler: task creation fails)
+// ---------------------------------------------------------------------------
+
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE          1
+#define pdFALSE         0
+#define pdPASS          1
+#define pdFAIL          0
+#define portMAX_DELAY   0xFFFFFFFFu
+
+struct portMUX_TYPE {
+    int owner;
+};
+#define portMUX_INITIALIZER_UNLOCKED portMUX_TYPE{0}
+#define portENTER_CRITICAL(mux)     ((void)(mux))
+#define portEXIT_CRITICAL(mux)      ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux)  ((void)(mux))
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t entry, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+void xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+
+#endif // HOST_ARDUINO_H
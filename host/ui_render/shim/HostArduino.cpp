@@ -0,0 +1,244 @@
+/*
+ * HostArduino.cpp
+ * Print, Serial, virtual clock, GPIO, FreeRTOS and esp_timer stand-ins, Wire
+ */
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+
+// ---------------------------------------------------------------------------
+// Print
+// ---------------------------------------------------------------------------
+
+size_t Print::write(const uint8_t* data, size_t length) {
+    size_t n = 0;
+    while (length--) {
+        n += write(*data++);
+    }
+    return n;
+}
+
+size_t Print::print(long number, int base) {
+    if (base == DEC) {
+        char text[24];
+        snprintf(text, sizeof(text), "%ld", number);
+        return write(text);
+    }
+    return print((unsigned long)number, base);
+}
+
+size_t Print::print(unsigned long number, int base) {
+    char text[36];
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", number);
+    return write(text);
+}
+
+size_t Print::print(double number, int digits) {
+    // Same output as Print::printFloat for the values a screen shows
+    if (isnan(number)) return write("nan");
+    if (isinf(number)) return write("inf");
+    if (number > 4294967040.0 || number < -4294967040.0) return write("ovf");
+    char text[48];
+    snprintf(text, sizeof(text), "%.*f", digits, number);
+    return write(text);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if ((size_t)length >= sizeof(text)) length = sizeof(text) - 1;
+    return write((const uint8_t*)text, length);
+}
+
+HostSerial Serial;
+HardwareSerial Serial2;
+
+size_t HostSerial::write(uint8_t c) {
+    if (echo) fputc(c, stderr);
+    if (capture) capture->push_back((char)c);
+    return 1;
+}
+
+size_t HostSerial::write(const uint8_t* data, size_t length) {
+    if (echo) fwrite(data, 1, length, stderr);
+    if (capture) capture->append((const char*)data, length);
+    return length;
+}
+
+// ---------------------------------------------------------------------------
+// Virtual clock and GPIO
+// ---------------------------------------------------------------------------
+
+static uint64_t clockUs = 0;
+static uint8_t pinLevels[64];
+
+unsigned long millis() {
+    return (unsigned long)(clockUs / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)clockUs;
+}
+
+void delay(unsigned long ms) {
+    clockUs += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+    clockUs += us;
+}
+
+void hostAdvanceMicros(uint64_t us) {
+    clockUs += us;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < sizeof(pinLevels) && (mode == INPUT || mode == INPUT_PULLUP)) {
+        pinLevels[pin] = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    if (pin < sizeof(pinLevels)) pinLevels[pin] = level ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < sizeof(pinLevels) ? pinLevels[pin] : HIGH;
+}
+
+void attachInterruptArg(uint8_t, void (*)(void*), void*, int) {
+}
+
+int gpio_get_level(gpio_num_t pin) {
+    return digitalRead((uint8_t)pin);
+}
+
+// ---------------------------------------------------------------------------
+// FreeRTOS and esp_timer
+// ---------------------------------------------------------------------------
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*,
+                                   UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+    if (handle) *handle = nullptr;
+    return pdFAIL;
+}
+
+void xTaskNotifyGive(TaskHandle_t) {
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) {
+    return 0;
+}
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle) {
+    static esp_timer timers[8];
+    static size_t used = 0;
+    if (args == nullptr || handle == nullptr || used == sizeof(timers) / sizeof(timers[0])) {
+        return ESP_FAIL;
+    }
+    timers[used].callback = args->callback;
+    timers[used].arg = args->arg;
+    *handle = &timers[used++];
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t) {
+    return timer ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t) {
+    return timer ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    return timer ? ESP_OK : ESP_FAIL;
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)clockUs;
+}
+
+// ---------------------------------------------------------------------------
+// Wire
+// ---------------------------------------------------------------------------
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+    : clockHz(100000), targetAddress(0), target(nullptr),
+      txAddress(0), txLength(0), transmitting(false) {
+    resetStats();
+}
+
+bool TwoWire::begin(int, int, uint32_t frequency) {
+    if (frequency > 0) clockHz = frequency;
+    return true;
+}
+
+void TwoWire::setClock(uint32_t frequency) {
+    clockHz = frequency;
+}
+
+uint32_t TwoWire::getClock() const {
+    return clockHz;
+}
+
+void TwoWire::beginTransmission(uint16_t address) {
+    txAddress = address;
+    txLength = 0;
+    transmitting = true;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (!transmitting || txLength >= I2C_BUFFER_LENGTH) return 0;
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t length) {
+    size_t n = 0;
+    while (n < length && write(data[n])) {
+        n++;
+    }
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool) {
+    if (!transmitting) return 4;
+    transmitting = false;
+
+    // Start + address/payload bytes with their ACK bits + stop
+    stats.transactions++;
+    stats.bytes += 1 + txLength;
+    stats.busTimeUs += (2.0 + 9.0 * (1 + txLength)) * 1e6 / clockHz;
+
+    if (target == nullptr || txAddress != targetAddress) return 2;
+    target->receive(txBuffer, txLength);
+    return 0;
+}
+
+void TwoWire::attach(uint8_t address, I2cTarget* device) {
+    targetAddress = address;
+    target = device;
+}
+
+const I2cStats& TwoWire::getStats() const {
+    return stats;
+}
+
+void TwoWire::resetStats() {
+    stats.transactions = 0;
+    stats.bytes = 0;
+    stats.busTimeUs = 0.0;
+}
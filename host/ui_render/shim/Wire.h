@@ -0,0 +1,62 @@
+/*
+ * Wire.h
+ * Host I2C bus: delivers transmissions to a modelled device and counts them
+ *
+ * A transmission holds at most the 128 payload bytes of the ESP32 Wire
+ * buffer, like on the device. Every completed transmission is counted with
+ * its payload and address byte, and its bus time at the current clock is
+ * estimated as 9 bits per byte plus start and stop.
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+#define I2C_BUFFER_LENGTH 128
+
+// A device on the bus (the SSD1306 panel model)
+class I2cTarget {
+public:
+    virtual ~I2cTarget() {}
+    virtual void receive(const uint8_t* data, size_t length) = 0;
+};
+
+struct I2cStats {
+    uint32_t transactions;
+    uint32_t bytes;         // Address byte + payload
+    double busTimeUs;       // At the clock each transaction was sent with
+};
+
+class TwoWire {
+public:
+    TwoWire();
+
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    void setClock(uint32_t frequency);
+    uint32_t getClock() const;
+
+    void beginTransmission(uint16_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    uint8_t endTransmission(bool sendStop = true);     // 0 = ack, 2 = no device
+
+    // Harness side
+    void attach(uint8_t address, I2cTarget* target);
+    const I2cStats& getStats() const;
+    void resetStats();
+
+private:
+    uint32_t clockHz;
+    uint8_t targetAddress;
+    I2cTarget* target;
+    uint16_t txAddress;
+    uint8_t txBuffer[I2C_BUFFER_LENGTH];
+    size_t txLength;
+    bool transmitting;
+    I2cStats stats;
+};
+
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,13 @@
+/*
+ * driver/gpio.h
+ * Host stand-in for the ESP-IDF GPIO level read used by button ISRs
+ */
+
+#ifndef HOST_DRIVER_GPIO_H
+#define HOST_DRIVER_GPIO_H
+
+typedef int gpio_num_t;
+
+int gpio_get_level(gpio_num_t pin);     // Same level as digitalRead()
+
+#endif // HOST_DRIVER_GPIO_H
@@ -0,0 +1,38 @@
+/*
+ * esp_timer.h
+ * Host stand-in for esp_timer: timers are created but never fire
+ *
+ * LED/buzzer patterns (PatternSequencer) only drive GPIO stubs on the host,
+ * so their edges are not simulated. The ultrasonic rate replay injects
+ * samples on the sensor's own schedule instead of its trigger timer.
+ */
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef void (*esp_timer_cb_t)(void* arg);
+typedef struct esp_timer* esp_timer_handle_t;
+
+typedef enum {
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodUs);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+int64_t esp_timer_get_time();
+
+#endif // HOST_ESP_TIMER_H
@@ -0,0 +1,198 @@
+/*
+ * ui_render_test.cpp
+ * Panel model, host Wire/SSD1306 shims, PBM and budget parsing
+ */
+
+#include "UiRender.h"
+#include "Adafruit_SSD1306.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+static void send(PanelModel& panel, std::initializer_list<uint8_t> bytes) {
+    std::vector<uint8_t> data(bytes);
+    panel.receive(data.data(), data.size());
+}
+
+static void testPanelWindow() {
+    PanelModel panel;
+    send(panel, {0x00, 0x20, 0x00});                // Horizontal addressing
+    send(panel, {0x00, 0x21, 10, 11, 0x22, 2, 3});  // 2 columns x 2 pages
+    send(panel, {0x40, 0x01, 0x02, 0x03, 0x04, 0x05});
+    const uint8_t* ram = panel.getRam();
+    CHECK(ram[2 * PANEL_WIDTH + 10] == 0x05);       // Fifth byte wraps to the window start
+    CHECK(ram[2 * PANEL_WIDTH + 11] == 0x02);
+    CHECK(ram[3 * PANEL_WIDTH + 10] == 0x03);
+    CHECK(ram[3 * PANEL_WIDTH + 11] == 0x04);
+    CHECK(ram[2 * PANEL_WIDTH + 12] == 0x00);
+    CHECK(panel.getDataBytes() == 5);
+    CHECK(panel.getPixel(10, 16) && !panel.getPixel(10, 17));
+}
+
+static void testPanelCommands() {
+    PanelModel panel;
+    // Arguments in later transactions, as ssd1306_command1() sends them
+    send(panel, {0x00, 0x20});
+    send(panel, {0x00, 0x00});
+    send(panel, {0x00, 0x21});
+    send(panel, {0x00, 5});
+    send(panel, {0x00, 6});
+    send(panel, {0x00, 0x22, 0, 0, 0xAF});
+    CHECK(panel.isOn());
+    send(panel, {0x40, 0xAA, 0xBB});
+    CHECK(panel.getRam()[5] == 0xAA && panel.getRam()[6] == 0xBB);
+
+    // Co = 1: one byte per control byte, data and commands mixed
+    send(panel, {0xC0, 0x11, 0x80, 0xAE, 0x40, 0x22});
+    CHECK(!panel.isOn());
+    CHECK(panel.getRam()[5] == 0x11 && panel.getRam()[6] == 0x22);
+}
+
+static void testWire() {
+    PanelModel panel;
+    Wire.attach(0x3C, &panel);
+    Wire.setClock(400000);
+    Wire.resetStats();
+
+    Wire.beginTransmission(0x3C);
+    for (int i = 0; i < I2C_BUFFER_LENGTH + 10; i++) {
+        Wire.write((uint8_t)0x40);
+    }
+    CHECK(Wire.endTransmission() == 0);
+    CHECK(Wire.getStats().transactions == 1);
+    CHECK(Wire.getStats().bytes == 1 + I2C_BUFFER_LENGTH);     // Writes past the buffer are dropped
+    CHECK(Wire.getStats().busTimeUs > 2800 && Wire.getStats().busTimeUs < 2950);
+
+    Wire.beginTransmission(0x3D);
+    Wire.write((uint8_t)0x00);
+    CHECK(Wire.endTransmission() == 2);                         // Nobody at that address
+    Wire.attach(0, nullptr);
+}
+
+static void testDisplayTraffic() {
+    PanelModel panel;
+    Wire.attach(0x3C, &panel);
+    Wire.resetStats();
+
+    Adafruit_SSD1306 display(128, 64, &Wire, -1, 400000, 400000);
+    CHECK(display.getBuffer() == nullptr);
+    CHECK(display.begin(SSD1306_SWITCHCAPVCC, 0x3C));
+    CHECK(panel.isOn());
+
+    display.fillRect(3, 5, 4, 9, SSD1306_WHITE);
+    display.drawPixel(4, 6, SSD1306_INVERSE);
+    display.display();
+    CHECK(memcmp(panel.getRam(), display.getBuffer(), 1024) == 0);
+    CHECK(panel.getPixel(3, 5) && panel.getPixel(6, 13) && !panel.getPixel(4, 6) && !panel.getPixel(3, 14));
+    CHECK(panel.getDataBytes() == 1024);
+
+    // 1024 data bytes at 127 per transaction after the control byte
+    Wire.resetStats();
+    display.display();
+    CHECK(Wire.getStats().transactions == 2 + 9);
+    Wire.attach(0, nullptr);
+}
+
+static void testText() {
+    Adafruit_SSD1306 display(128, 64, &Wire);
+    display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+    display.setTextSize(1);
+
+    int16_t x1, y1;
+    uint16_t w, h;
+    display.getTextBounds("Hello", 0, 0, &x1, &y1, &w, &h);
+    CHECK(w == 30 && h == 8);
+    display.setTextSize(2);
+    display.getTextBounds(String("AB"), 4, 10, &x1, &y1, &w, &h);
+    CHECK(x1 == 4 && y1 == 10 && w == 24 && h == 16);
+
+    // 22 cells of 6 px wrap after 21 on a 128 px line
+    display.setTextSize(1);
+    display.getTextBounds("0123456789012345678901", 0, 0, &x1, &y1, &w, &h);
+    CHECK(w == 126 && h == 16);
+    display.setTextWrap(false);
+    display.getTextBounds("0123456789012345678901", 0, 0, &x1, &y1, &w, &h);
+    CHECK(w == 132 && h == 8);
+
+    // '1' of the classic font: column 1 = 0x42, column 2 = 0x7F
+    Adafruit_GFX::resetStats();
+    display.clearDisplay();
+    display.setTextColor(SSD1306_WHITE);
+    display.setCursor(0, 0);
+    display.print('1');
+    CHECK(display.getPixel(1, 1) && display.getPixel(1, 6) && !display.getPixel(1, 0));
+    CHECK(display.getPixel(2, 0) && display.getPixel(2, 6));
+    CHECK(!display.getPixel(0, 3) && !display.getPixel(5, 3));
+    CHECK(Adafruit_GFX::stats.drawCalls == 2);      // Clear + one glyph
+    CHECK(Adafruit_GFX::stats.pixelWrites == 10);
+
+    // Opaque text also writes the background cells
+    Adafruit_GFX::resetStats();
+    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+    display.print('1');
+    CHECK(Adafruit_GFX::stats.pixelWrites == 48);
+
+    CHECK(String(12.345, 1) == "12.3");
+    CHECK(String((uint8_t)42) == "42");
+    CHECK((String(3) + "min") == "3min");
+    CHECK(String("Pahartoli Road").substring(0, 9) == "Pahartoli");
+}
+
+static void testPbm() {
+    PanelModel panel;
+    send(panel, {0x00, 0x20, 0x00, 0x21, 0, 127, 0x22, 0, 7});
+    send(panel, {0x40, 0x81, 0x00, 0xFF});
+    std::string text = formatPbm(panel, "test");
+
+    std::vector<bool> pixels;
+    int width, height;
+    CHECK(parsePbm(text, pixels, width, height));
+    CHECK(width == PANEL_WIDTH && height == PANEL_HEIGHT);
+    CHECK(pixels[0] && pixels[7 * PANEL_WIDTH] && !pixels[1 * PANEL_WIDTH]);
+    CHECK(pixels[2] && pixels[7 * PANEL_WIDTH + 2] && !pixels[1]);
+
+    // Whitespace-separated pixels, as most tools write them
+    CHECK(parsePbm("P1\n# c\n3 2\n1 0 1\n0 1 0\n", pixels, width, height));
+    CHECK(width == 3 && height == 2 && pixels[0] && !pixels[1] && pixels[4]);
+    CHECK(!parsePbm("P1\n3 2\n101\n01\n", pixels, width, height));
+    CHECK(!parsePbm("P4\n3 2\n", pixels, width, height));
+}
+
+static void testBudget() {
+    std::map<std::string, ScreenBudget> budget;
+    CHECK(parseBudget("# header\nidle 1200 30 900  # note\n\nride 40 3 100\n", budget));
+    CHECK(budget.size() == 2);
+    CHECK(budget["idle"].i2cBytes == 1200 && budget["idle"].drawCalls == 30 && budget["idle"].pixelWrites == 900);
+    CHECK(!parseBudget("idle 1200 30\n", budget));
+
+    ScreenMetrics screen;
+    screen.name = "idle";
+    screen.i2cBytes = 7;
+    screen.drawCalls = 8;
+    screen.pixelWrites = 9;
+    std::map<std::string, ScreenBudget> again;
+    CHECK(parseBudget(formatBudget("test", {screen}), again));
+    CHECK(again.size() == 1 && again["idle"].i2cBytes == 7 && again["idle"].pixelWrites == 9);
+}
+
+int main() {
+    testPanelWindow();
+    testPanelCommands();
+    testWire();
+    testDisplayTraffic();
+    testText();
+    testPbm();
+    testBudget();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("ui_render_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * userside_render.cpp
+ * Renders the user-side block unit's OLEDDisplay screens through a request
+ *
+ * The sequence follows a ride request the way the FSM drives the display,
+ * including the periodic update() refresh and distance refreshes of the
+ * retained user-detected screen.
+ */
+
+#include "UiRender.h"
+#include "OLEDDisplay.h"
+
+int main(int argc, char** argv) {
+    UiRender render("userside", OLED_ADDRESS);
+    if (!render.parseArgs(argc, argv)) return 2;
+
+    OLEDDisplay oled;
+
+    render.screen("boot", [&] { oled.begin(); });
+    render.screen("idle", [&] { oled.showIdle(); });
+    render.screen("idle_refresh", [&] { oled.update(); });
+    render.screen("user_detected", [&] { oled.showUserDetected(152.3f); });
+    render.screen("user_detected_moved", [&] { oled.showUserDetected(148.0f); });
+    render.screen("user_detected_same", [&] { oled.showUserDetected(148.0f); });
+    render.screen("privilege_check", [&] { oled.showPrivilegeCheck(); });
+    render.screen("privilege_ok", [&] { oled.showPrivilegeResult(true); });
+    render.screen("privilege_denied", [&] { oled.showPrivilegeResult(false, "Token not seen"); });
+    render.screen("confirm", [&] { oled.showWaitingForConfirm("Pahartoli"); });
+    render.screen("request_sent", [&] { oled.showRequestSent(); });
+    render.screen("offer", [&] { oled.showOfferIncoming(); });
+    render.screen("accepted", [&] { oled.showRideAccepted(); });
+    render.screen("rejected", [&] { oled.showRideRejected("No rickshaw free"); });
+    render.screen("error", [&] { oled.showError("MQTT offline"); });
+    render.screen("message", [&] { oled.showMessage("Block", "CUET_CAMPUS", "ready"); });
+
+    return render.finish();
+}